@@ -31,7 +31,10 @@ do
 		echo -n ,$s
 		for dom in "$@"
 		do
-			rkm=$(with_timeout 10m ./check $f $s --domain=$dom 2> /dev/null)
+			# The crab domains give up on their own, which keeps the time and memory they used.
+			opts=()
+			[[ $dom == *Crab ]] && opts=(--timeout 600)
+			rkm=$(with_timeout 11m ./check $f $s --domain=$dom "${opts[@]}" 2> /dev/null)
 			echo -n ",${rkm:=0,-1,-1}"
 		done
 		echo
@@ -104,13 +104,6 @@ static Condition::Op reverse(Condition::Op op) {
 /// Get the inverse of a given comparison condition.
 static Condition reverse(Condition cond) { return {.op = reverse(cond.op), .left = cond.left, .right = cond.right}; }
 
-template <typename T>
-static vector<label_t> unique(const std::pair<T, T>& be) {
-    vector<label_t> res;
-    std::unique_copy(be.first, be.second, std::back_inserter(res));
-    return res;
-}
-
 /// Get a non-deterministic version of a control-flow graph,
 /// i.e., where instead of using if/else, both branches are taken
 /// simultaneously, and are replaced by Assume instructions
@@ -203,16 +196,15 @@ std::vector<std::string> stats_headers() {
     };
 }
 
-std::map<std::string, int> collect_stats(const cfg_t& cfg) {
+std::map<std::string, int> collect_stats(const flat_cfg_t& cfg) {
     std::map<std::string, int> res;
     for (const auto& h : stats_headers()) {
         res[h] = 0;
     }
-    for (const auto& this_label : cfg.labels()) {
+    for (block_id_t id = 0; id < cfg.size(); id++) {
         res["basic_blocks"]++;
-        basic_block_t const& bb = cfg.get_node(this_label);
 
-        for (Instruction ins : bb) {
+        for (const Instruction& ins : cfg.instructions(id)) {
             if (std::holds_alternative<LoadMapFd>(ins)) {
                 if (std::get<LoadMapFd>(ins).mapfd == -1) {
                     res["map_in_map"] = 1;
@@ -227,17 +219,19 @@ std::map<std::string, int> collect_stats(const cfg_t& cfg) {
                 auto const& bin = std::get<Bin>(ins);
                 res[bin.is64 ? "arith64" : "arith32"]++;
             }
+            if (std::holds_alternative<Jmp>(ins) || std::holds_alternative<Assume>(ins)) {
+                // Once jumps are made nondeterministic, each branch of a conditional jump starts with an Assume.
+                res["jumps"]++;
+            }
             res[instype(ins)]++;
         }
-        if (unique(bb.prev_blocks()).size() > 1)
+        if (cfg.in_degree(id) > 1)
             res["joins"]++;
-        if (unique(bb.prev_blocks()).size() > 1)
-            res["jumps"]++;
     }
     return res;
 }
 
-cfg_t prepare_cfg(const InstructionSeq& prog, const program_info& info, bool simplify, bool must_have_exit) {
+flat_cfg_t prepare_cfg(const InstructionSeq& prog, const program_info& info, bool simplify, bool must_have_exit) {
     // Convert the instruction sequence to a deterministic control-flow graph.
     cfg_t det_cfg = instruction_seq_to_cfg(prog, must_have_exit);
 
@@ -257,5 +251,6 @@ cfg_t prepare_cfg(const InstructionSeq& prog, const program_info& info, bool sim
         cfg.simplify();
     }
 
-    return cfg;
+    // Freeze the result into the form that the analysis runs on.
+    return flat_cfg_t(cfg);
 }
@@ -12,6 +12,7 @@
 #include "asm_files.hpp"
 #include "btf_parser.h"
 #include "platform.hpp"
+#include "verification_context.hpp"
 
 #include "elfio/elfio.hpp"
 
@@ -31,15 +32,16 @@ static vector<T> vector_of(const ELFIO::section& sec) {
 
 int create_map_crab(const EbpfMapType& map_type, uint32_t key_size, uint32_t value_size, uint32_t max_entries, ebpf_verifier_options_t options) {
     EquivalenceKey equiv{map_type.value_type, key_size, value_size, map_type.is_array ? max_entries : 0};
-    if (!global_program_info.cache.count(equiv)) {
+    std::map<EquivalenceKey, int>& cache = verification_context_t::current().info.cache;
+    if (!cache.count(equiv)) {
         // +1 so 0 is the null FD
-        global_program_info.cache[equiv] = (int)global_program_info.cache.size() + 1;
+        cache[equiv] = (int)cache.size() + 1;
     }
-    return global_program_info.cache.at(equiv);
+    return cache.at(equiv);
 }
 
 EbpfMapDescriptor* find_map_descriptor(int map_fd) {
-    for (EbpfMapDescriptor& map : global_program_info.map_descriptors) {
+    for (EbpfMapDescriptor& map : verification_context_t::current().info.map_descriptors) {
         if (map.original_fd == map_fd) {
             return &map;
         }
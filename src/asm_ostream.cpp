@@ -430,26 +430,26 @@ void print_map_descriptors(const std::vector<EbpfMapDescriptor>& descriptors, st
     }
 }
 
-void print_dot(const cfg_t& cfg, std::ostream& out) {
+void print_dot(const flat_cfg_t& cfg, std::ostream& out) {
     out << "digraph program {\n";
     out << "    node [shape = rectangle];\n";
-    for (const auto& label : cfg.labels()) {
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        const label_t& label = cfg.label(id);
         out << "    \"" << label << "\"[xlabel=\"" << label << "\",label=\"";
 
-        const auto& bb = cfg.get_node(label);
-        for (const auto& ins : bb) {
+        for (const auto& ins : cfg.instructions(id)) {
             out << ins << "\\l";
         }
 
         out << "\"];\n";
-        for (const label_t& next : bb.next_blocks_set())
-            out << "    \"" << label << "\" -> \"" << next << "\";\n";
+        for (block_id_t next : cfg.next_nodes(id))
+            out << "    \"" << label << "\" -> \"" << cfg.label(next) << "\";\n";
         out << "\n";
     }
     out << "}\n";
 }
 
-void print_dot(const cfg_t& cfg, const std::string& outfile) {
+void print_dot(const flat_cfg_t& cfg, const std::string& outfile) {
     std::ofstream out{outfile};
     if (out.fail())
         throw std::runtime_error(std::string("Could not open file ") + outfile);
@@ -499,6 +499,35 @@ std::ostream& operator<<(std::ostream& o, const cfg_t& cfg) {
     return o;
 }
 
+void print_block(std::ostream& o, const flat_cfg_t& cfg, block_id_t id) {
+    o << cfg.label(id) << ":\n";
+    for (auto const& s : cfg.instructions(id)) {
+        o << "  " << s << ";\n";
+    }
+    auto next = cfg.next_nodes(id);
+    if (!next.empty()) {
+        o << "  "
+          << "goto ";
+        for (auto it = next.begin(); it != next.end();) {
+            o << cfg.label(*it);
+            ++it;
+            if (it == next.end()) {
+                o << ";";
+            } else {
+                o << ",";
+            }
+        }
+    }
+    o << "\n";
+}
+
+std::ostream& operator<<(std::ostream& o, const flat_cfg_t& cfg) {
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        print_block(o, cfg, id);
+    }
+    return o;
+}
+
 std::ostream& operator<<(std::ostream& os, const btf_line_info_t& line_info) {
     os << "; " << line_info.file_name << ":" << line_info.line_number << "\n";
     os << "; " << line_info.source_line << "\n";
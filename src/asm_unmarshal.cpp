@@ -9,6 +9,7 @@
 #include "ebpf_vm_isa.hpp"
 
 #include "asm_unmarshal.hpp"
+#include "verification_context.hpp"
 
 using std::string;
 using std::vector;
@@ -447,7 +448,7 @@ struct Unmarshaller {
 };
 
 std::variant<InstructionSeq, std::string> unmarshal(const raw_program& raw_prog, vector<vector<string>>& notes) {
-    global_program_info = raw_prog.info;
+    verification_context_t::current().info = raw_prog.info;
     try {
         return Unmarshaller{notes, raw_prog.info}.unmarshal(raw_prog.prog, raw_prog.line_info);
     } catch (InvalidInstruction& arg) {
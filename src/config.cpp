@@ -12,4 +12,9 @@ const ebpf_verifier_options_t ebpf_verifier_default_options = {
     .mock_map_fds = true,
     .strict = false,
     .print_line_info = false,
+    .numeric_domain = numeric_domain_t::zones,
+    .tiered = false,
+    .widening_delay = 1,
+    .descending_iterations = 2000000,
+    .adaptive_narrowing = false,
 };
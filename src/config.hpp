@@ -2,6 +2,16 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The numeric domain that tracks the values of registers, stack cells, types and offsets.
+enum class numeric_domain_t { zones, intervals };
+
 struct ebpf_verifier_options_t {
     bool check_termination;
     bool assume_assertions;
@@ -16,13 +26,57 @@ struct ebpf_verifier_options_t {
     bool strict;
 
     bool print_line_info;
+
+    // Ignored by tiered verifications, which pick the numeric domain.
+    numeric_domain_t numeric_domain;
+
+    // Analyze with intervals first, and with zones only if that leaves some assertion unproven.
+    bool tiered;
+
+    // Number of iterations of a loop that join the invariants of its head before widening them.
+    // Defaulted here so that options that only set a few fields keep the usual iteration policy.
+    unsigned int widening_delay{1};
+
+    // Maximal number of narrowing iterations of a loop; 0 disables narrowing.
+    unsigned int descending_iterations{2000000};
+
+    // Stop narrowing a loop as soon as an iteration changes the outcome of no assertion that was checked in it.
+    bool adaptive_narrowing{};
+
+    // Give up, reporting a timeout, once the deadline passes or once *cancelled becomes true, e.g., when set by
+    // another thread. Both are checked between the visits of blocks and within the expensive zone operations.
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    const std::atomic<bool>* cancelled{};
+};
+
+// The cost of the fixpoint computation of a loop.
+struct loop_stats_t {
+    std::string head; // Label of the loop head.
+    // Summed over all the times the loop was analyzed, e.g., once per iteration of an enclosing loop.
+    int ascending_iterations;
+    int descending_iterations;
 };
 
 struct ebpf_verifier_stats_t {
     int total_unreachable;
     int total_warnings;
     int max_instruction_count;
+    int reused_blocks; // Blocks whose invariants were reused from a snapshot of a previous version.
+    numeric_domain_t tier; // The numeric domain of the analysis that decided the result.
+
+    // Use of the scratch arena that the domain operations take their temporaries from.
+    size_t scratch_allocations;
+    size_t scratch_bytes;
+    size_t scratch_peak_bytes;
+    size_t system_allocations; // Arena chunks and retained buffers obtained from the system allocator.
+
+    // In the order of the heads; empty for results taken from a verification cache.
+    std::vector<loop_stats_t> loops;
+
+    // The verification was given up because of its deadline or its cancellation, and the program is not
+    // known to be either safe or unsafe. The other stats are those of the work done until then.
+    bool timed_out;
+    std::string timeout_loop_head; // The innermost loop being analyzed when it was given up, if any.
 };
 
 extern const ebpf_verifier_options_t ebpf_verifier_default_options;
-extern thread_local ebpf_verifier_options_t thread_local_options;
@@ -11,13 +11,17 @@
 
 #include "radix_tree/radix_tree.hpp"
 #include "crab/array_domain.hpp"
+#include "crab/interval_domain.hpp"
+#include "crab/packed_split_dbm.hpp"
 
 #include "asm_ostream.hpp"
 #include "dsl_syntax.hpp"
 #include "spec_type_descriptors.hpp"
+#include "verification_context.hpp"
 
 namespace crab::domains {
 
+template <typename NumAbsDomain>
 static bool maybe_between(const NumAbsDomain& dom, const bound_t& x,
                           const linear_expression_t& symb_lb,
                           const linear_expression_t& symb_ub) {
@@ -144,6 +148,7 @@ class cell_t final {
 
     // Return true if [symb_lb, symb_ub] may overlap with the cell,
     // where symb_lb and symb_ub are not constant expressions.
+    template <typename NumAbsDomain>
     [[nodiscard]]
     bool symbolic_overlap(const linear_expression_t& symb_lb,
                      const linear_expression_t& symb_ub,
@@ -154,6 +159,7 @@ class cell_t final {
 
 // Return true if [symb_lb, symb_ub] may overlap with the cell,
 // where symb_lb and symb_ub are not constant expressions.
+template <typename NumAbsDomain>
 bool cell_t::symbolic_overlap(const linear_expression_t& symb_lb, const linear_expression_t& symb_ub,
                               const NumAbsDomain& dom) const {
     interval_t x = to_interval();
@@ -165,6 +171,7 @@ bool cell_t::symbolic_overlap(const linear_expression_t& symb_lb, const linear_e
 class offset_map_t final {
   private:
     friend class array_domain_t;
+    friend void add_array_cell(data_kind_t kind, int offset, unsigned size);
 
     using cell_set_t = std::set<cell_t>;
 
@@ -216,6 +223,7 @@ class offset_map_t final {
     // Return in out all cells that might overlap with (o, size).
     std::vector<cell_t> get_overlap_cells(offset_t o, unsigned size);
 
+    template <typename NumAbsDomain>
     [[nodiscard]] std::vector<cell_t> get_overlap_cells_symbolic_offset(const NumAbsDomain& dom,
                                                                         const linear_expression_t& symb_lb,
                                                                         const linear_expression_t& symb_ub);
@@ -240,6 +248,7 @@ void offset_map_t::remove_cell(const cell_t& c) {
     _map[key].erase(c);
 }
 
+template <typename NumAbsDomain>
 [[nodiscard]]
 std::vector<cell_t> offset_map_t::get_overlap_cells_symbolic_offset(const NumAbsDomain& dom,
                                                                     const linear_expression_t& symb_lb,
@@ -397,28 +406,28 @@ std::vector<cell_t> offset_map_t::get_overlap_cells(offset_t o, unsigned size) {
     return out;
 }
 
-// We use a global array map
-using array_map_t = std::unordered_map<data_kind_t, offset_map_t>;
+// The array map of the current verification context.
+struct array_map_t {
+    std::unordered_map<data_kind_t, offset_map_t> maps;
+};
 
-thread_local array_map_t global_array_map;
+std::shared_ptr<array_map_t> make_array_map() { return std::make_shared<array_map_t>(); }
 
-static offset_map_t& lookup_array_map(data_kind_t kind) {
-    return global_array_map[kind];
-}
-
-/**
-    Ugly this needs to be fixed: needed if multiple analyses are
-    run so we can clear the array map from one run to another.
-**/
-void clear_global_state() {
-    if (!global_array_map.empty()) {
+void clear_array_map(array_map_t& array_map) {
+    if (!array_map.maps.empty()) {
         if constexpr (crab::CrabSanityCheckFlag) {
-            CRAB_WARN("array_expansion static variable map is being cleared");
+            CRAB_WARN("array_expansion variable map is being cleared");
         }
-        global_array_map.clear();
+        array_map.maps.clear();
     }
 }
 
+static offset_map_t& lookup_array_map(data_kind_t kind) {
+    return verification_context_t::current().array_map->maps[kind];
+}
+
+void add_array_cell(data_kind_t kind, int offset, unsigned size) { lookup_array_map(kind).mk_cell(offset, size); }
+
 std::ostream& operator<<(std::ostream& o, offset_map_t& m) {
     if (m._map.empty()) {
         o << "empty";
@@ -439,6 +448,7 @@ std::ostream& operator<<(std::ostream& o, offset_map_t& m) {
 }
 
 // we can only treat this as non-member because we use global state
+template <typename NumAbsDomain>
 static std::optional<std::pair<offset_t, unsigned>>
 kill_and_find_var(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& i, const linear_expression_t& elem_size) {
     std::optional<std::pair<offset_t, unsigned>> res;
@@ -463,16 +473,20 @@ kill_and_find_var(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t
                                                              linear_expression_t(i + elem_size));
     }
     if (!cells.empty()) {
-        // Forget the scalars from the numerical domain
+        // Forget the scalars from the numerical domain, all at once
+        std::vector<variable_t> scalars;
+        scalars.reserve(cells.size());
         for (auto const& c : cells) {
-            inv -= c.get_scalar(kind);
+            scalars.push_back(c.get_scalar(kind));
         }
+        inv.forget(scalars);
         // Remove the cells. If needed again they they will be re-created.
         offset_map -= cells;
     }
     return res;
 }
 
+template <typename NumAbsDomain>
 bool array_domain_t::all_num(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub) {
     auto min_lb = inv.eval_interval(lb).lb().number();
     auto max_ub = inv.eval_interval(ub).ub().number();
@@ -482,6 +496,7 @@ bool array_domain_t::all_num(NumAbsDomain& inv, const linear_expression_t& lb, c
 }
 
 // Get the number of bytes, starting at offset, that are known to be numbers.
+template <typename NumAbsDomain>
 int array_domain_t::min_all_num_size(const NumAbsDomain& inv, variable_t offset) const {
     auto min_lb = inv.eval_interval(offset).lb().number();
     auto max_ub = inv.eval_interval(offset).ub().number();
@@ -492,6 +507,7 @@ int array_domain_t::min_all_num_size(const NumAbsDomain& inv, variable_t offset)
     return std::max(0, this->num_bytes.all_num_width(lb) - (ub - lb));
 }
 
+template <typename NumAbsDomain>
 std::optional<linear_expression_t> array_domain_t::load(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& i, int width) {
     interval_t ii = inv.eval_interval(i);
     if (std::optional<number_t> n = ii.singleton()) {
@@ -545,6 +561,7 @@ std::optional<linear_expression_t> array_domain_t::load(NumAbsDomain& inv, data_
     return {};
 }
 
+template <typename NumAbsDomain>
 std::optional<variable_t> array_domain_t::store(NumAbsDomain& inv, data_kind_t kind,
                                                 const linear_expression_t& idx,
                                                 const linear_expression_t& elem_size,
@@ -566,6 +583,7 @@ std::optional<variable_t> array_domain_t::store(NumAbsDomain& inv, data_kind_t k
     return {};
 }
 
+template <typename NumAbsDomain>
 std::optional<variable_t> array_domain_t::store_type(NumAbsDomain& inv,
                                                      const linear_expression_t& idx,
                                                      const linear_expression_t& elem_size,
@@ -586,6 +604,7 @@ std::optional<variable_t> array_domain_t::store_type(NumAbsDomain& inv,
     return {};
 }
 
+template <typename NumAbsDomain>
 std::optional<variable_t> array_domain_t::store_type(NumAbsDomain& inv,
                                                      const linear_expression_t& idx,
                                                      const linear_expression_t& elem_size,
@@ -593,6 +612,7 @@ std::optional<variable_t> array_domain_t::store_type(NumAbsDomain& inv,
     return store_type(inv, idx, elem_size, variable_t::reg(data_kind_t::types, reg.v));
 }
 
+template <typename NumAbsDomain>
 void array_domain_t::havoc(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& idx, const linear_expression_t& elem_size) {
     auto maybe_cell = kill_and_find_var(inv, kind, idx, elem_size);
     if (maybe_cell && kind == data_kind_t::types) {
@@ -601,6 +621,7 @@ void array_domain_t::havoc(NumAbsDomain& inv, data_kind_t kind, const linear_exp
     }
 }
 
+template <typename NumAbsDomain>
 void array_domain_t::store_numbers(NumAbsDomain& inv, variable_t _idx, variable_t _width) {
 
     // TODO: this should be an user parameter.
@@ -678,4 +699,34 @@ array_domain_t array_domain_t::narrow(const array_domain_t& other) const {
 std::ostream& operator<<(std::ostream& o, const array_domain_t& dom) {
     return o << dom.num_bytes;
 }
+
+// The numeric domains that ebpf_domain_t is instantiated with.
+template bool array_domain_t::all_num(PackedSplitDBM&, const linear_expression_t&, const linear_expression_t&);
+template int array_domain_t::min_all_num_size(const PackedSplitDBM&, variable_t) const;
+template std::optional<linear_expression_t> array_domain_t::load(PackedSplitDBM&, data_kind_t, const linear_expression_t&,
+                                                                  int);
+template std::optional<variable_t> array_domain_t::store(PackedSplitDBM&, data_kind_t, const linear_expression_t&,
+                                                         const linear_expression_t&, const linear_expression_t&);
+template std::optional<variable_t> array_domain_t::store_type(PackedSplitDBM&, const linear_expression_t&,
+                                                              const linear_expression_t&, const linear_expression_t&);
+template std::optional<variable_t> array_domain_t::store_type(PackedSplitDBM&, const linear_expression_t&,
+                                                              const linear_expression_t&, const Reg&);
+template void array_domain_t::havoc(PackedSplitDBM&, data_kind_t, const linear_expression_t&,
+                                    const linear_expression_t&);
+template void array_domain_t::store_numbers(PackedSplitDBM&, variable_t, variable_t);
+
+template bool array_domain_t::all_num(IntervalDomain&, const linear_expression_t&, const linear_expression_t&);
+template int array_domain_t::min_all_num_size(const IntervalDomain&, variable_t) const;
+template std::optional<linear_expression_t> array_domain_t::load(IntervalDomain&, data_kind_t, const linear_expression_t&,
+                                                                  int);
+template std::optional<variable_t> array_domain_t::store(IntervalDomain&, data_kind_t, const linear_expression_t&,
+                                                         const linear_expression_t&, const linear_expression_t&);
+template std::optional<variable_t> array_domain_t::store_type(IntervalDomain&, const linear_expression_t&,
+                                                              const linear_expression_t&, const linear_expression_t&);
+template std::optional<variable_t> array_domain_t::store_type(IntervalDomain&, const linear_expression_t&,
+                                                              const linear_expression_t&, const Reg&);
+template void array_domain_t::havoc(IntervalDomain&, data_kind_t, const linear_expression_t&,
+                                    const linear_expression_t&);
+template void array_domain_t::store_numbers(IntervalDomain&, variable_t, variable_t);
+
 } // namespace crab::domains
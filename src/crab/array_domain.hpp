@@ -24,6 +24,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <utility>
 
@@ -34,10 +35,13 @@
 
 namespace crab::domains {
 
-// Numerical abstract domain.
-using NumAbsDomain = SplitDBM;
-
-void clear_global_state();
+// Cells of each array, shared by all array_domain_t values of one verification context.
+struct array_map_t;
+std::shared_ptr<array_map_t> make_array_map();
+void clear_array_map(array_map_t& array_map);
+// Make a cell known to the array of a kind, e.g., when it is mentioned by an invariant that is parsed,
+// so that the stores that overlap it forget its contents.
+void add_array_cell(data_kind_t kind, int offset, unsigned size);
 
 class array_domain_t final {
     bitset_domain_t num_bytes;
@@ -66,23 +70,31 @@ class array_domain_t final {
     friend std::ostream& operator<<(std::ostream& o, const array_domain_t& dom);
     [[nodiscard]] string_invariant to_set() const;
 
+    template <typename NumAbsDomain>
     bool all_num(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub);
+    template <typename NumAbsDomain>
     [[nodiscard]] int min_all_num_size(const NumAbsDomain& inv, variable_t offset) const;
 
+    template <typename NumAbsDomain>
     std::optional<linear_expression_t> load(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& i, int width);
+    template <typename NumAbsDomain>
     std::optional<variable_t> store(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& idx, const linear_expression_t& elem_size,
                                     const linear_expression_t& val);
+    template <typename NumAbsDomain>
     std::optional<variable_t> store_type(NumAbsDomain& inv,
                                          const linear_expression_t& idx,
                                          const linear_expression_t& elem_size,
                                          const linear_expression_t& val);
+    template <typename NumAbsDomain>
     std::optional<variable_t> store_type(NumAbsDomain& inv,
                                          const linear_expression_t& idx,
                                          const linear_expression_t& elem_size,
                                          const Reg& reg);
+    template <typename NumAbsDomain>
     void havoc(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& idx, const linear_expression_t& elem_size);
 
     // Perform array stores over an array segment
+    template <typename NumAbsDomain>
     void store_numbers(NumAbsDomain& inv, variable_t _idx, variable_t _width);
 
     void initialize_numbers(int lb, int width) { num_bytes.reset(lb, width); }
@@ -12,6 +12,9 @@
  * variable.
  *
  */
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <set>
@@ -507,22 +510,118 @@ inline void cfg_t::remove_unreachable_blocks() {
     }
 }
 
+using block_id_t = uint32_t;
+
+/// Immutable control-flow graph that the analysis runs on, built from a cfg_t once it is final.
+///
+/// Blocks are numbered densely in the order of their labels, so the entry is block 0, the exit is the last block,
+/// and tables about blocks can be plain vectors indexed by block id. The successors and predecessors of all the
+/// blocks are stored in two compressed sparse row arrays, and their instructions in one contiguous buffer.
+class flat_cfg_t final {
+  public:
+    using neighbour_const_range = boost::iterator_range<const block_id_t*>;
+    using neighbour_const_reverse_range = boost::iterator_range<std::reverse_iterator<const block_id_t*>>;
+    using instruction_range = boost::iterator_range<const Instruction*>;
+
+  private:
+    std::vector<label_t> _labels;
+    // Block i has the successors _next[_next_offsets[i]] to _next[_next_offsets[i + 1] - 1], and similarly for
+    // its predecessors and its instructions.
+    std::vector<uint32_t> _next_offsets, _prev_offsets, _instruction_offsets;
+    std::vector<block_id_t> _next, _prev;
+    std::vector<Instruction> _instructions;
+
+    template <class T>
+    static boost::iterator_range<const T*> slice(const std::vector<T>& v, const std::vector<uint32_t>& offsets,
+                                                 block_id_t id) {
+        return boost::make_iterator_range(v.data() + offsets[id], v.data() + offsets[id + 1]);
+    }
+
+  public:
+    explicit flat_cfg_t(const cfg_t& cfg);
+
+    flat_cfg_t(const flat_cfg_t&) = delete;
+    flat_cfg_t(flat_cfg_t&&) noexcept = default;
+
+    [[nodiscard]] size_t size() const { return _labels.size(); }
+
+    [[nodiscard]] block_id_t entry() const { return 0; }
+    [[nodiscard]] block_id_t exit() const { return static_cast<block_id_t>(_labels.size() - 1); }
+
+    [[nodiscard]] const label_t& label(block_id_t id) const { return _labels[id]; }
+
+    /// The labels of the blocks, sorted, i.e., indexed by block id.
+    [[nodiscard]] const std::vector<label_t>& labels() const { return _labels; }
+
+    [[nodiscard]] block_id_t id(const label_t& label) const {
+        auto it = std::lower_bound(_labels.begin(), _labels.end(), label);
+        if (it == _labels.end() || *it != label) {
+            CRAB_ERROR("Basic block ", label, " not found in the CFG: ", __LINE__);
+        }
+        return static_cast<block_id_t>(it - _labels.begin());
+    }
+
+    [[nodiscard]] neighbour_const_range next_nodes(block_id_t id) const { return slice(_next, _next_offsets, id); }
+    [[nodiscard]] neighbour_const_reverse_range next_nodes_reversed(block_id_t id) const {
+        neighbour_const_range next = next_nodes(id);
+        return boost::make_iterator_range(std::make_reverse_iterator(next.end()),
+                                          std::make_reverse_iterator(next.begin()));
+    }
+    [[nodiscard]] neighbour_const_range prev_nodes(block_id_t id) const { return slice(_prev, _prev_offsets, id); }
+
+    [[nodiscard]] size_t in_degree(block_id_t id) const { return _prev_offsets[id + 1] - _prev_offsets[id]; }
+    [[nodiscard]] size_t out_degree(block_id_t id) const { return _next_offsets[id + 1] - _next_offsets[id]; }
+
+    [[nodiscard]] instruction_range instructions(block_id_t id) const {
+        return slice(_instructions, _instruction_offsets, id);
+    }
+};
+
+inline flat_cfg_t::flat_cfg_t(const cfg_t& cfg) : _labels(cfg.labels()) {
+    // The blocks of a cfg_t are kept in label order, and so are the neighbours of each block.
+    assert(std::is_sorted(_labels.begin(), _labels.end()));
+    assert(_labels.front() == cfg.entry_label() && _labels.back() == cfg.exit_label());
+    const size_t n = _labels.size();
+    _next_offsets.reserve(n + 1);
+    _prev_offsets.reserve(n + 1);
+    _instruction_offsets.reserve(n + 1);
+    for (const auto& [label, bb] : cfg) {
+        _next_offsets.push_back(static_cast<uint32_t>(_next.size()));
+        _prev_offsets.push_back(static_cast<uint32_t>(_prev.size()));
+        _instruction_offsets.push_back(static_cast<uint32_t>(_instructions.size()));
+        for (const label_t& next : bb.next_blocks_set()) {
+            _next.push_back(id(next));
+        }
+        for (const label_t& prev : bb.prev_blocks_set()) {
+            _prev.push_back(id(prev));
+        }
+        _instructions.insert(_instructions.end(), bb.begin(), bb.end());
+    }
+    _next_offsets.push_back(static_cast<uint32_t>(_next.size()));
+    _prev_offsets.push_back(static_cast<uint32_t>(_prev.size()));
+    _instruction_offsets.push_back(static_cast<uint32_t>(_instructions.size()));
+}
+
 } // end namespace crab
 
 using crab::basic_block_t;
+using crab::block_id_t;
 using crab::cfg_t;
+using crab::flat_cfg_t;
 
 std::vector<std::string> stats_headers();
 
-std::map<std::string, int> collect_stats(const cfg_t&);
+std::map<std::string, int> collect_stats(const flat_cfg_t&);
 
-cfg_t prepare_cfg(const InstructionSeq& prog, const program_info& info, bool simplify, bool must_have_exit=true);
+flat_cfg_t prepare_cfg(const InstructionSeq& prog, const program_info& info, bool simplify, bool must_have_exit=true);
 
 void explicate_assertions(cfg_t& cfg, const program_info& info);
 
-void print_dot(const cfg_t& cfg, std::ostream& out);
-void print_dot(const cfg_t& cfg, const std::string& outfile);
+void print_dot(const flat_cfg_t& cfg, std::ostream& out);
+void print_dot(const flat_cfg_t& cfg, const std::string& outfile);
 
 std::ostream& operator<<(std::ostream& o, const crab::basic_block_t& bb);
 std::ostream& operator<<(std::ostream& o, const crab::basic_block_rev_t& bb);
 std::ostream& operator<<(std::ostream& o, const cfg_t& cfg);
+void print_block(std::ostream& o, const flat_cfg_t& cfg, block_id_t id);
+std::ostream& operator<<(std::ostream& o, const flat_cfg_t& cfg);
@@ -23,8 +23,8 @@
 #include "dsl_syntax.hpp"
 #include "platform.hpp"
 #include "string_constraints.hpp"
+#include "verification_context.hpp"
 
-using crab::domains::NumAbsDomain;
 using crab::data_kind_t;
 
 struct reg_pack_t {
@@ -46,6 +46,19 @@ reg_pack_t reg_pack(int i) {
 }
 reg_pack_t reg_pack(Reg r) { return reg_pack(r.v); }
 
+// The variables of the offsets of a register, which are forgotten together.
+static void add_offset_variables(std::vector<variable_t>& variables, const reg_pack_t& r) {
+    variables.insert(variables.end(), {r.ctx_offset, r.map_fd, r.packet_offset, r.shared_offset, r.shared_region_size,
+                                       r.stack_offset, r.stack_numeric_size});
+}
+
+// All the variables of a register, for forgetting everything about it in the same forget as other registers.
+static void add_register_variables(std::vector<variable_t>& variables, const reg_pack_t& r) {
+    add_offset_variables(variables, r);
+    variables.push_back(r.value);
+    variables.push_back(r.type);
+}
+
 static linear_constraint_t eq(variable_t a, variable_t b) {
     using namespace crab::dsl_syntax;
     return {a - b, constraint_kind_t::EQUALS_ZERO};
@@ -142,7 +155,8 @@ static bool is_unsigned_cmp(Condition::Op op) {
     return {};
 }
 
-std::optional<variable_t> ebpf_domain_t::get_type_offset_variable(const Reg& reg, int type) {
+template <typename NumAbsDomain>
+std::optional<variable_t> ebpf_domain_t<NumAbsDomain>::get_type_offset_variable(const Reg& reg, int type) {
     reg_pack_t r = reg_pack(reg);
     switch (type) {
     case T_CTX: return r.ctx_offset;
@@ -155,71 +169,66 @@ std::optional<variable_t> ebpf_domain_t::get_type_offset_variable(const Reg& reg
     }
 }
 
-std::optional<variable_t> ebpf_domain_t::get_type_offset_variable(const Reg& reg, const NumAbsDomain& inv) const {
+template <typename NumAbsDomain>
+std::optional<variable_t> ebpf_domain_t<NumAbsDomain>::get_type_offset_variable(const Reg& reg, const NumAbsDomain& inv) const {
     return get_type_offset_variable(reg, type_inv.get_type(inv, reg_pack(reg).type));
 }
 
-std::optional<variable_t> ebpf_domain_t::get_type_offset_variable(const Reg& reg) const {
+template <typename NumAbsDomain>
+std::optional<variable_t> ebpf_domain_t<NumAbsDomain>::get_type_offset_variable(const Reg& reg) const {
     return get_type_offset_variable(reg, m_inv);
 }
 
-void ebpf_domain_t::set_require_check(std::function<check_require_func_t> f) { check_require = std::move(f); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::set_require_check(std::function<check_require_func_t> f) { check_require = std::move(f); }
 
-ebpf_domain_t ebpf_domain_t::top() {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::top() {
     ebpf_domain_t abs;
     abs.set_to_top();
     return abs;
 }
 
-ebpf_domain_t ebpf_domain_t::bottom() {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::bottom() {
     ebpf_domain_t abs;
     abs.set_to_bottom();
     return abs;
 }
 
-ebpf_domain_t::ebpf_domain_t() : m_inv(NumAbsDomain::top()) {}
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain>::ebpf_domain_t() : m_inv(NumAbsDomain::top()) {}
 
-ebpf_domain_t::ebpf_domain_t(NumAbsDomain inv, crab::domains::array_domain_t stack) : m_inv(std::move(inv)), stack(stack) {}
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain>::ebpf_domain_t(NumAbsDomain inv, crab::domains::array_domain_t stack) : m_inv(std::move(inv)), stack(stack) {}
 
-void ebpf_domain_t::set_to_top() {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::set_to_top() {
     m_inv.set_to_top();
     stack.set_to_top();
 }
 
-void ebpf_domain_t::set_to_bottom() { m_inv.set_to_bottom(); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::set_to_bottom() { m_inv.set_to_bottom(); }
 
-bool ebpf_domain_t::is_bottom() const { return m_inv.is_bottom(); }
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::is_bottom() const { return m_inv.is_bottom(); }
 
-bool ebpf_domain_t::is_top() const { return m_inv.is_top() && stack.is_top(); }
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::is_top() const { return m_inv.is_top() && stack.is_top(); }
 
-bool ebpf_domain_t::operator<=(const ebpf_domain_t& other) {
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::operator<=(const ebpf_domain_t& other) {
     return m_inv <= other.m_inv && stack <= other.stack;
 }
 
-bool ebpf_domain_t::operator==(const ebpf_domain_t& other) const {
-    return stack == other.stack && m_inv <= other.m_inv && other.m_inv <= m_inv;
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::operator==(const ebpf_domain_t& other) const {
+    return stack == other.stack && m_inv == other.m_inv;
 }
 
-void ebpf_domain_t::TypeDomain::add_extra_invariant(NumAbsDomain& dst,
-                                                    std::map<crab::variable_t,
-                                                    crab::interval_t>& extra_invariants,
-                                                    variable_t type_variable,
-                                                    type_encoding_t type,
-                                                    data_kind_t kind,
-                                                    const NumAbsDomain& src) const {
-    bool dst_has_type = has_type(dst, type_variable, type);
-    bool src_has_type = has_type(src, type_variable, type);
-    variable_t v = variable_t::kind_var(kind, type_variable);
-
-    // If type is contained in exactly one of dst or src,
-    // we need to remember the value.
-    if (dst_has_type && !src_has_type)
-        extra_invariants.emplace(v, dst.eval_interval(v));
-    else if (!dst_has_type && src_has_type)
-        extra_invariants.emplace(v, src.eval_interval(v));
-}
-
-void ebpf_domain_t::TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain& src) const {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain& src) const {
     // Some variables are type-specific.  Type-specific variables
     // for a register can exist in the domain whenever the associated
     // type value is present in the register's types interval (and the
@@ -244,17 +253,40 @@ void ebpf_domain_t::TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst
     // Output:
     //   r1.type={stack,packet}, r1.stack_offset=100, r1.packet_offset=4
 
-    std::map<crab::variable_t, crab::interval_t> extra_invariants;
+    static constexpr std::pair<type_encoding_t, data_kind_t> type_specific_kinds[] = {
+        {T_CTX, data_kind_t::ctx_offsets},          {T_MAP, data_kind_t::map_fds},
+        {T_MAP_PROGRAMS, data_kind_t::map_fds},     {T_PACKET, data_kind_t::packet_offsets},
+        {T_SHARED, data_kind_t::shared_offsets},    {T_STACK, data_kind_t::stack_offsets},
+        {T_SHARED, data_kind_t::shared_region_sizes}, {T_STACK, data_kind_t::stack_numeric_sizes},
+    };
+    std::vector<std::pair<variable_t, crab::interval_t>> extra_invariants;
     if (!dst.is_bottom()) {
-        for (variable_t v : variable_t::get_type_variables()) {
-            add_extra_invariant(dst, extra_invariants, v, T_CTX, data_kind_t::ctx_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_MAP, data_kind_t::map_fds, src);
-            add_extra_invariant(dst, extra_invariants, v, T_MAP_PROGRAMS, data_kind_t::map_fds, src);
-            add_extra_invariant(dst, extra_invariants, v, T_PACKET, data_kind_t::packet_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_SHARED, data_kind_t::shared_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_STACK, data_kind_t::stack_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_SHARED, data_kind_t::shared_region_sizes, src);
-            add_extra_invariant(dst, extra_invariants, v, T_STACK, data_kind_t::stack_numeric_sizes, src);
+        // Only the type variables whose types differ matter, and those are among the ones whose bounds differ.
+        // A bottom src has no types, so all the type variables differ.
+        const std::vector<variable_t> type_variables =
+            src.is_bottom() ? variable_t::get_type_variables()
+                            : dst.bound_differences(src, [](variable_t v) { return v.is_type(); });
+        for (variable_t v : type_variables) {
+            const crab::type_set_t dst_types = get_types(dst, v);
+            const crab::type_set_t src_types = get_types(src, v);
+            if (dst_types == src_types) {
+                continue;
+            }
+            // If type is contained in exactly one of dst or src, we need to remember the value.
+            const crab::type_set_t only_dst = dst_types - src_types;
+            const crab::type_set_t only_src = src_types - dst_types;
+            for (const auto& [type, kind] : type_specific_kinds) {
+                const variable_t kind_variable = variable_t::kind_var(kind, v);
+                if (!extra_invariants.empty() && extra_invariants.back().first == kind_variable) {
+                    // Both map types use the map_fds variable, which gets the value of the first that applies.
+                    continue;
+                }
+                if (only_dst.contains(type)) {
+                    extra_invariants.emplace_back(kind_variable, dst.eval_interval(kind_variable));
+                } else if (only_src.contains(type)) {
+                    extra_invariants.emplace_back(kind_variable, src.eval_interval(kind_variable));
+                }
+            }
         }
     }
 
@@ -262,12 +294,11 @@ void ebpf_domain_t::TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst
     dst |= std::move(src);
 
     // Now add in the extra invariants saved above.
-    for (auto& [variable, interval] : extra_invariants) {
-        dst.set(variable, interval);
-    }
+    dst.set(extra_invariants);
 }
 
-void ebpf_domain_t::operator|=(ebpf_domain_t&& other) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator|=(ebpf_domain_t&& other) {
     if (is_bottom()) {
         *this = other;
         return;
@@ -281,71 +312,91 @@ void ebpf_domain_t::operator|=(ebpf_domain_t&& other) {
     stack |= other.stack;
 }
 
-void ebpf_domain_t::operator|=(const ebpf_domain_t& other) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator|=(const ebpf_domain_t& other) {
     ebpf_domain_t tmp{other};
     operator|=(std::move(tmp));
 }
 
-ebpf_domain_t ebpf_domain_t::operator|(ebpf_domain_t&& other) const {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::operator|(ebpf_domain_t&& other) const {
     return ebpf_domain_t(m_inv | std::move(other.m_inv), stack | other.stack);
 }
 
-ebpf_domain_t ebpf_domain_t::operator|(const ebpf_domain_t& other) const& {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::operator|(const ebpf_domain_t& other) const& {
     return ebpf_domain_t(m_inv | other.m_inv, stack | other.stack);
 }
 
-ebpf_domain_t ebpf_domain_t::operator|(const ebpf_domain_t& other) && {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::operator|(const ebpf_domain_t& other) && {
     return ebpf_domain_t(other.m_inv | std::move(m_inv), other.stack | std::move(stack));
 }
 
-ebpf_domain_t ebpf_domain_t::operator&(const ebpf_domain_t& other) const {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::operator&(const ebpf_domain_t& other) const {
     return ebpf_domain_t(m_inv & other.m_inv, stack & other.stack);
 }
 
-ebpf_domain_t ebpf_domain_t::widen(const ebpf_domain_t& other) {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::widen(const ebpf_domain_t& other) {
     return ebpf_domain_t(m_inv.widen(other.m_inv), stack | other.stack);
 }
 
-ebpf_domain_t ebpf_domain_t::widening_thresholds(const ebpf_domain_t& other, const crab::iterators::thresholds_t& ts) {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::widening_thresholds(const ebpf_domain_t& other, const crab::iterators::thresholds_t& ts) {
     return ebpf_domain_t(m_inv.widening_thresholds(other.m_inv, ts), stack | other.stack);
 }
 
-ebpf_domain_t ebpf_domain_t::narrow(const ebpf_domain_t& other) {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::narrow(const ebpf_domain_t& other) {
     return ebpf_domain_t(m_inv.narrow(other.m_inv), stack & other.stack);
 }
 
-void ebpf_domain_t::operator+=(const linear_constraint_t& cst) { m_inv += cst; }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator+=(const linear_constraint_t& cst) { m_inv += cst; }
 
-void ebpf_domain_t::operator-=(variable_t var) { m_inv -= var; }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator-=(variable_t var) { m_inv -= var; }
 
-void ebpf_domain_t::assign(variable_t x, const linear_expression_t& e) { m_inv.assign(x, e); }
-void ebpf_domain_t::assign(variable_t x, long e) { m_inv.set(x, crab::interval_t(number_t(e))); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::assign(variable_t x, const linear_expression_t& e) { m_inv.assign(x, e); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::assign(variable_t x, long e) { m_inv.set(x, crab::interval_t(number_t(e))); }
 
-void ebpf_domain_t::apply(crab::arith_binop_t op, variable_t x, variable_t y, const number_t& z) { m_inv.apply(op, x, y, z); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::arith_binop_t op, variable_t x, variable_t y, const number_t& z) { m_inv.apply(op, x, y, z); }
 
-void ebpf_domain_t::apply(crab::arith_binop_t op, variable_t x, variable_t y, variable_t z) { m_inv.apply(op, x, y, z); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::arith_binop_t op, variable_t x, variable_t y, variable_t z) { m_inv.apply(op, x, y, z); }
 
-void ebpf_domain_t::apply(crab::bitwise_binop_t op, variable_t x, variable_t y, variable_t z) { m_inv.apply(op, x, y, z); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::bitwise_binop_t op, variable_t x, variable_t y, variable_t z) { m_inv.apply(op, x, y, z); }
 
-void ebpf_domain_t::apply(crab::bitwise_binop_t op, variable_t x, variable_t y, const number_t& k) { m_inv.apply(op, x, y, k); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::bitwise_binop_t op, variable_t x, variable_t y, const number_t& k) { m_inv.apply(op, x, y, k); }
 
-void ebpf_domain_t::apply(crab::binop_t op, variable_t x, variable_t y, const number_t& z) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::binop_t op, variable_t x, variable_t y, const number_t& z) {
     std::visit([&](auto top) { apply(top, x, y, z); }, op);
 }
 
-void ebpf_domain_t::apply(crab::binop_t op, variable_t x, variable_t y, variable_t z) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(crab::binop_t op, variable_t x, variable_t y, variable_t z) {
     std::visit([&](auto top) { apply(top, x, y, z); }, op);
 }
 
-void ebpf_domain_t::scratch_caller_saved_registers() {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::scratch_caller_saved_registers() {
+    std::vector<variable_t> variables;
     for (int i = R1_ARG; i <= R5_ARG; i++) {
-        Reg r{(uint8_t)i};
-        havoc_register(m_inv, r);
-        type_inv.havoc_type(m_inv, r);
+        add_register_variables(variables, reg_pack(i));
     }
+    m_inv.forget(variables);
 }
 
-void ebpf_domain_t::forget_packet_pointers() {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::forget_packet_pointers() {
     using namespace crab::dsl_syntax;
 
     for (variable_t type_variable : variable_t::get_type_variables()) {
@@ -359,86 +410,170 @@ void ebpf_domain_t::forget_packet_pointers() {
     initialize_packet(*this);
 }
 
-void ebpf_domain_t::apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, const number_t& z, bool finite_width) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::forget_dead(const crab::live_set_t& live) {
+    if (is_bottom())
+        return;
+    std::vector<variable_t> dead;
+    for (uint8_t i = R0_RETURN_VALUE; i < live.registers.size(); i++) {
+        if (!live.registers.test(i)) {
+            add_register_variables(dead, reg_pack(i));
+        }
+    }
+    m_inv.forget(dead);
+
+    // Forget each maximal range of dead bytes at once.
+    for (int start = 0; start < EBPF_STACK_SIZE;) {
+        if (live.stack.test(start)) {
+            start++;
+            continue;
+        }
+        int end = start + 1;
+        while (end < EBPF_STACK_SIZE && !live.stack.test(end)) {
+            end++;
+        }
+        for (data_kind_t kind : {data_kind_t::types, data_kind_t::values, data_kind_t::ctx_offsets,
+                                 data_kind_t::map_fds, data_kind_t::packet_offsets, data_kind_t::shared_offsets,
+                                 data_kind_t::stack_offsets, data_kind_t::shared_region_sizes,
+                                 data_kind_t::stack_numeric_sizes}) {
+            stack.havoc(m_inv, kind, start, end - start);
+        }
+        start = end;
+    }
+}
+
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, const number_t& z, bool finite_width) {
     inv.apply(op, x, y, z);
     if (finite_width)
         overflow(x);
 }
 
-void ebpf_domain_t::apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, variable_t z, bool finite_width) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, variable_t z, bool finite_width) {
     inv.apply(op, x, y, z);
     if (finite_width)
         overflow(x);
 }
 
-void ebpf_domain_t::add(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2); }
-void ebpf_domain_t::add(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2); }
-void ebpf_domain_t::sub(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2); }
-void ebpf_domain_t::sub(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2); }
-void ebpf_domain_t::add_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2, true); }
-void ebpf_domain_t::add_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2, true); }
-void ebpf_domain_t::sub_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2, true); }
-void ebpf_domain_t::sub_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2, true); }
-void ebpf_domain_t::neg(variable_t lhs) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, (number_t)-1, true); }
-void ebpf_domain_t::mul(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, op2, true); }
-void ebpf_domain_t::mul(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, op2, true); }
-void ebpf_domain_t::div(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SDIV, lhs, lhs, op2, true); }
-void ebpf_domain_t::div(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SDIV, lhs, lhs, op2, true); }
-void ebpf_domain_t::udiv(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::UDIV, lhs, lhs, op2, true); }
-void ebpf_domain_t::udiv(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::UDIV, lhs, lhs, op2, true); }
-void ebpf_domain_t::rem(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SREM, lhs, lhs, op2, true); }
-void ebpf_domain_t::rem(variable_t lhs, const number_t& op2, bool mod) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::add(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::add(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::sub(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::sub(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::add_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::add_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::ADD, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::sub_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::sub_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SUB, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::neg(variable_t lhs) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, (number_t)-1, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::mul(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::mul(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::MUL, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::div(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SDIV, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::div(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::SDIV, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::udiv(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::UDIV, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::udiv(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::UDIV, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::rem(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::SREM, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::rem(variable_t lhs, const number_t& op2, bool mod) {
     apply(m_inv, crab::arith_binop_t::SREM, lhs, lhs, op2, mod);
 }
-void ebpf_domain_t::urem(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::UREM, lhs, lhs, op2, true); }
-void ebpf_domain_t::urem(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::UREM, lhs, lhs, op2, true); }
-
-void ebpf_domain_t::bitwise_and(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::AND, lhs, lhs, op2); }
-void ebpf_domain_t::bitwise_and(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::AND, lhs, lhs, op2); }
-void ebpf_domain_t::bitwise_or(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::OR, lhs, lhs, op2); }
-void ebpf_domain_t::bitwise_or(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::OR, lhs, lhs, op2); }
-void ebpf_domain_t::bitwise_xor(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::XOR, lhs, lhs, op2); }
-void ebpf_domain_t::bitwise_xor(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::XOR, lhs, lhs, op2); }
-void ebpf_domain_t::shl_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::SHL, lhs, lhs, op2, true); }
-void ebpf_domain_t::shl_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::SHL, lhs, lhs, op2, true); }
-void ebpf_domain_t::lshr(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::LSHR, lhs, lhs, op2); }
-void ebpf_domain_t::lshr(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::LSHR, lhs, lhs, op2); }
-void ebpf_domain_t::ashr(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::ASHR, lhs, lhs, op2); }
-void ebpf_domain_t::ashr(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::ASHR, lhs, lhs, op2); }
-
-
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::urem(variable_t lhs, variable_t op2) { apply(m_inv, crab::arith_binop_t::UREM, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::urem(variable_t lhs, const number_t& op2) { apply(m_inv, crab::arith_binop_t::UREM, lhs, lhs, op2, true); }
+
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_and(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::AND, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_and(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::AND, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_or(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::OR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_or(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::OR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_xor(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::XOR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::bitwise_xor(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::XOR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::shl_overflow(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::SHL, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::shl_overflow(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::SHL, lhs, lhs, op2, true); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::lshr(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::LSHR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::lshr(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::LSHR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::ashr(variable_t lhs, variable_t op2) { apply(m_inv, crab::bitwise_binop_t::ASHR, lhs, lhs, op2); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::ashr(variable_t lhs, const number_t& op2) { apply(m_inv, crab::bitwise_binop_t::ASHR, lhs, lhs, op2); }
+
+
+template <typename NumAbsDomain>
 static void assume(NumAbsDomain& inv, const linear_constraint_t& cst) { inv += cst; }
-void ebpf_domain_t::assume(const linear_constraint_t& cst) { ::assume(m_inv, cst); }
+template <typename NumAbsDomain>
+static void assume(NumAbsDomain& inv, const std::vector<linear_constraint_t>& csts) { inv.add_constraints(csts); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::assume(const linear_constraint_t& cst) { ::assume(m_inv, cst); }
 
-void ebpf_domain_t::require(NumAbsDomain& inv, const linear_constraint_t& cst, const std::string& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::require(NumAbsDomain& inv, const linear_constraint_t& cst, const std::string& s) {
     if (check_require)
         check_require(inv, cst, s + " (" + this->current_assertion + ")");
-    if (thread_local_options.assume_assertions) {
+    if (verification_context_t::current().options.assume_assertions) {
         // avoid redundant errors
         ::assume(inv, cst);
     }
 }
 
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::require_over_types(const Reg& reg,
+                                                    const std::function<void(NumAbsDomain&, type_encoding_t)>& check) {
+    if (verification_context_t::current().options.assume_assertions) {
+        m_inv = type_inv.join_over_types(m_inv, reg, check);
+    } else {
+        // The checks run on every visit of the fixpoint, where joining the copies for each type would cost
+        // as much as a join of the invariant per assertion, only to give back the same invariant.
+        type_inv.check_over_types(m_inv, reg, check);
+    }
+}
+
 /// Forget everything we know about the value of a variable.
-void ebpf_domain_t::havoc(variable_t v) { m_inv -= v; }
-void ebpf_domain_t::havoc_offsets(NumAbsDomain& inv, const Reg& reg) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::havoc(variable_t v) { m_inv -= v; }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::havoc_offsets(NumAbsDomain& inv, const Reg& reg) {
+    std::vector<variable_t> variables;
+    add_offset_variables(variables, reg_pack(reg));
+    inv.forget(variables);
+}
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::havoc_offsets(const Reg& reg) { havoc_offsets(m_inv, reg); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::havoc_register(NumAbsDomain& inv, const Reg& reg) {
     reg_pack_t r = reg_pack(reg);
-    inv -= r.ctx_offset;
-    inv -= r.map_fd;
-    inv -= r.packet_offset;
-    inv -= r.shared_offset;
-    inv -= r.shared_region_size;
-    inv -= r.stack_offset;
-    inv -= r.stack_numeric_size;
-}
-void ebpf_domain_t::havoc_offsets(const Reg& reg) { havoc_offsets(m_inv, reg); }
-void ebpf_domain_t::havoc_register(NumAbsDomain& inv, const Reg& reg) {
-    reg_pack_t r = reg_pack(reg);
-    havoc_offsets(inv, reg);
-    inv -= r.value;
+    std::vector<variable_t> variables;
+    add_offset_variables(variables, r);
+    variables.push_back(r.value);
+    inv.forget(variables);
 }
 
-void ebpf_domain_t::assign(variable_t lhs, variable_t rhs) { m_inv.assign(lhs, rhs); }
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::assign(variable_t lhs, variable_t rhs) { m_inv.assign(lhs, rhs); }
 
 static linear_constraint_t type_is_pointer(const reg_pack_t& r) {
     using namespace crab::dsl_syntax;
@@ -455,64 +590,86 @@ static linear_constraint_t type_is_not_stack(const reg_pack_t& r) {
     return r.type != T_STACK;
 }
 
-void ebpf_domain_t::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, type_encoding_t t) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, type_encoding_t t) {
     inv.assign(reg_pack(lhs).type, t);
 }
 
-void ebpf_domain_t::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, const Reg& rhs) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, const Reg& rhs) {
     inv.assign(reg_pack(lhs).type, reg_pack(rhs).type);
 }
 
-void ebpf_domain_t::TypeDomain::assign_type(NumAbsDomain& inv, std::optional<variable_t> lhs, const Reg& rhs) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::assign_type(NumAbsDomain& inv, std::optional<variable_t> lhs, const Reg& rhs) {
     inv.assign(lhs, reg_pack(rhs).type);
 }
 
-void ebpf_domain_t::TypeDomain::assign_type(NumAbsDomain& inv, std::optional<variable_t> lhs, int rhs) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::assign_type(NumAbsDomain& inv, std::optional<variable_t> lhs, int rhs) {
     inv.assign(lhs, rhs);
 }
 
-void ebpf_domain_t::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, const std::optional<linear_expression_t>& rhs) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::assign_type(NumAbsDomain& inv, const Reg& lhs, const std::optional<linear_expression_t>& rhs) {
     inv.assign(reg_pack(lhs).type, rhs);
 }
 
-void ebpf_domain_t::TypeDomain::havoc_type(NumAbsDomain& inv, const Reg& r) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::havoc_type(NumAbsDomain& inv, const Reg& r) {
     inv -= reg_pack(r).type;
 }
 
-int ebpf_domain_t::TypeDomain::get_type(const NumAbsDomain& inv, const Reg& r) const {
+template <typename NumAbsDomain>
+int ebpf_domain_t<NumAbsDomain>::TypeDomain::get_type(const NumAbsDomain& inv, const Reg& r) const {
     auto res = inv[reg_pack(r).type].singleton();
     if (!res)
         return T_UNINIT;
     return (int)*res;
 }
 
-int ebpf_domain_t::TypeDomain::get_type(const NumAbsDomain& inv, variable_t v) const {
+template <typename NumAbsDomain>
+int ebpf_domain_t<NumAbsDomain>::TypeDomain::get_type(const NumAbsDomain& inv, variable_t v) const {
     auto res = inv[v].singleton();
     if (!res)
         return T_UNINIT;
     return (int)*res;
 }
 
-int ebpf_domain_t::TypeDomain::get_type(const NumAbsDomain& inv, int t) const { return t; }
+template <typename NumAbsDomain>
+int ebpf_domain_t<NumAbsDomain>::TypeDomain::get_type(const NumAbsDomain& inv, int t) const { return t; }
+
+template <typename NumAbsDomain>
+crab::type_set_t ebpf_domain_t<NumAbsDomain>::TypeDomain::get_types(const NumAbsDomain& inv, variable_t v) const {
+    return crab::type_set_t::of(inv[v]);
+}
+
+template <typename NumAbsDomain>
+crab::type_set_t ebpf_domain_t<NumAbsDomain>::TypeDomain::get_types(const NumAbsDomain& inv, const Reg& r) const {
+    return get_types(inv, reg_pack(r).type);
+}
+
+template <typename NumAbsDomain>
+crab::type_set_t ebpf_domain_t<NumAbsDomain>::TypeDomain::get_types(const NumAbsDomain& inv, int t) const {
+    return crab::type_set_t::of((type_encoding_t)t);
+}
 
 // Check whether a given type value is within the range of a given type variable's value.
-bool ebpf_domain_t::TypeDomain::has_type(const NumAbsDomain& inv, const Reg& r, type_encoding_t type) const {
-    crab::interval_t interval = inv[reg_pack(r).type];
-    if (interval.is_top())
-        return true;
-    return (interval.lb().number().value_or(INT_MIN) <= type) && (interval.ub().number().value_or(INT_MAX) >= type);
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::has_type(const NumAbsDomain& inv, const Reg& r, type_encoding_t type) const {
+    return get_types(inv, r).contains(type);
 }
 
-bool ebpf_domain_t::TypeDomain::has_type(const NumAbsDomain& inv, variable_t v, type_encoding_t type) const {
-    crab::interval_t interval = inv[v];
-    if (interval.is_top())
-        return true;
-    return (interval.lb().number().value_or(INT_MIN) <= type) && (interval.ub().number().value_or(INT_MAX) >= type);
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::has_type(const NumAbsDomain& inv, variable_t v, type_encoding_t type) const {
+    return get_types(inv, v).contains(type);
 }
 
-bool ebpf_domain_t::TypeDomain::has_type(const NumAbsDomain& inv, int t, type_encoding_t type) const { return t == type; }
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::has_type(const NumAbsDomain& inv, int t, type_encoding_t type) const { return t == type; }
 
-NumAbsDomain ebpf_domain_t::TypeDomain::join_over_types(const NumAbsDomain& inv, const Reg& reg,
+template <typename NumAbsDomain>
+NumAbsDomain ebpf_domain_t<NumAbsDomain>::TypeDomain::join_over_types(const NumAbsDomain& inv, const Reg& reg,
                                                         const std::function<void(NumAbsDomain&, type_encoding_t)>& transition) const {
     crab::interval_t types = inv.eval_interval(reg_pack(reg).type);
     if (types.is_bottom())
@@ -522,18 +679,46 @@ NumAbsDomain ebpf_domain_t::TypeDomain::join_over_types(const NumAbsDomain& inv,
         transition(res, static_cast<type_encoding_t>(T_UNINIT));
         return res;
     }
+    crab::type_set_t type_set = crab::type_set_t::of(types);
+    if (!types.lb().is_finite()) {
+        // An unbounded type is the result of a widening, not of an uninitialized register.
+        type_set = type_set - crab::type_set_t::of(T_UNINIT);
+    }
+    if (const std::optional<type_encoding_t> type = type_set.singleton()) {
+        // Nothing to join, so the transition can be applied to the only copy.
+        NumAbsDomain res(inv);
+        transition(res, *type);
+        return res;
+    }
     NumAbsDomain res(true);
-    auto lb = types.lb().is_finite() ? (type_encoding_t)(int)(types.lb().number().value()) : T_MAP_PROGRAMS;
-    auto ub = types.ub().is_finite() ? (type_encoding_t)(int)(types.ub().number().value()) : T_SHARED;
-    for (type_encoding_t type = lb; type <= ub; type = (type_encoding_t)((int)type + 1)) {
+    type_set.for_each([&](type_encoding_t type) {
         NumAbsDomain tmp(inv);
         transition(tmp, type);
         selectively_join_based_on_type(res, tmp); // res |= tmp;
-    }
+    });
     return res;
 }
 
-NumAbsDomain ebpf_domain_t::TypeDomain::join_by_if_else(const NumAbsDomain& inv, const linear_constraint_t& condition,
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::TypeDomain::check_over_types(
+    const NumAbsDomain& inv, const Reg& reg, const std::function<void(NumAbsDomain&, type_encoding_t)>& check) const {
+    crab::interval_t types = inv.eval_interval(reg_pack(reg).type);
+    if (types.is_bottom())
+        return;
+    NumAbsDomain copy(inv);
+    if (types.is_top()) {
+        check(copy, static_cast<type_encoding_t>(T_UNINIT));
+        return;
+    }
+    crab::type_set_t type_set = crab::type_set_t::of(types);
+    if (!types.lb().is_finite()) {
+        type_set = type_set - crab::type_set_t::of(T_UNINIT);
+    }
+    type_set.for_each([&](type_encoding_t type) { check(copy, type); });
+}
+
+template <typename NumAbsDomain>
+NumAbsDomain ebpf_domain_t<NumAbsDomain>::TypeDomain::join_by_if_else(const NumAbsDomain& inv, const linear_constraint_t& condition,
                                                         const std::function<void(NumAbsDomain&)>& if_true,
                                                         const std::function<void(NumAbsDomain&)>& if_false) const {
     NumAbsDomain true_case(inv.when(condition));
@@ -545,41 +730,45 @@ NumAbsDomain ebpf_domain_t::TypeDomain::join_by_if_else(const NumAbsDomain& inv,
     return true_case | false_case;
 }
 
-bool ebpf_domain_t::TypeDomain::same_type(const NumAbsDomain& inv, const Reg& a, const Reg& b) const {
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::same_type(const NumAbsDomain& inv, const Reg& a, const Reg& b) const {
     return inv.entail(eq_types(a, b));
 }
 
-bool ebpf_domain_t::TypeDomain::implies_type(const NumAbsDomain& inv, const linear_constraint_t& a, const linear_constraint_t& b) const {
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::implies_type(const NumAbsDomain& inv, const linear_constraint_t& a, const linear_constraint_t& b) const {
     return inv.when(a).entail(b);
 }
 
-bool ebpf_domain_t::TypeDomain::is_in_group(const NumAbsDomain& m_inv, const Reg& r, TypeGroup group) const {
-    using namespace crab::dsl_syntax;
-    variable_t t = reg_pack(r).type;
+static crab::type_set_t types_of(TypeGroup group) {
+    using crab::type_set_t;
     switch (group) {
-    case TypeGroup::number: return m_inv.entail(t == T_NUM);
-    case TypeGroup::map_fd: return m_inv.entail(t == T_MAP);
-    case TypeGroup::map_fd_programs: return m_inv.entail(t == T_MAP_PROGRAMS);
-    case TypeGroup::ctx: return m_inv.entail(t == T_CTX);
-    case TypeGroup::packet: return m_inv.entail(t == T_PACKET);
-    case TypeGroup::stack: return m_inv.entail(t == T_STACK);
-    case TypeGroup::shared: return m_inv.entail(t == T_SHARED);
-    case TypeGroup::non_map_fd: return m_inv.entail(t >= T_NUM);
-    case TypeGroup::mem: return m_inv.entail(t >= T_PACKET);
-    case TypeGroup::mem_or_num:
-        return m_inv.entail(t >= T_NUM) && m_inv.entail(t != T_CTX);
-    case TypeGroup::pointer: return m_inv.entail(t >= T_CTX);
-    case TypeGroup::ptr_or_num: return m_inv.entail(t >= T_NUM);
-    case TypeGroup::stack_or_packet:
-        return m_inv.entail(t >= T_PACKET) && m_inv.entail(t <= T_STACK);
-    case TypeGroup::singleton_ptr:
-        return m_inv.entail(t >= T_CTX) && m_inv.entail(t <= T_STACK);
+    case TypeGroup::number: return type_set_t::of(T_NUM);
+    case TypeGroup::map_fd: return type_set_t::of(T_MAP);
+    case TypeGroup::map_fd_programs: return type_set_t::of(T_MAP_PROGRAMS);
+    case TypeGroup::ctx: return type_set_t::of(T_CTX);
+    case TypeGroup::packet: return type_set_t::of(T_PACKET);
+    case TypeGroup::stack: return type_set_t::of(T_STACK);
+    case TypeGroup::shared: return type_set_t::of(T_SHARED);
+    case TypeGroup::non_map_fd: return type_set_t::range(T_NUM, T_SHARED);
+    case TypeGroup::mem: return type_set_t::range(T_PACKET, T_SHARED);
+    case TypeGroup::mem_or_num: return type_set_t::of(T_NUM) | type_set_t::range(T_PACKET, T_SHARED);
+    case TypeGroup::pointer: return type_set_t::range(T_CTX, T_SHARED);
+    case TypeGroup::ptr_or_num: return type_set_t::range(T_NUM, T_SHARED);
+    case TypeGroup::stack_or_packet: return type_set_t::range(T_PACKET, T_STACK);
+    case TypeGroup::singleton_ptr: return type_set_t::range(T_CTX, T_STACK);
     }
     assert(false);
-    return false;
+    return {};
+}
+
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::TypeDomain::is_in_group(const NumAbsDomain& m_inv, const Reg& r, TypeGroup group) const {
+    return get_types(m_inv, r) <= types_of(group);
 }
 
-void ebpf_domain_t::overflow(variable_t lhs) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::overflow(variable_t lhs) {
     using namespace crab::dsl_syntax;
     auto interval = m_inv[lhs];
     // handle overflow, assuming 64 bit
@@ -589,35 +778,40 @@ void ebpf_domain_t::overflow(variable_t lhs) {
         havoc(lhs);
 }
 
-void ebpf_domain_t::operator()(const basic_block_t& bb, bool check_termination) {
-    for (const Instruction& statement : bb) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const flat_cfg_t::instruction_range& block, bool check_termination) {
+    for (const Instruction& statement : block) {
         std::visit(*this, statement);
     }
     if (check_termination) {
         // +1 to avoid being tricked by empty loops
-        add(variable_t::instruction_count(), crab::number_t((unsigned)bb.size() + 1));
+        add(variable_t::instruction_count(), crab::number_t((unsigned)block.size() + 1));
     }
 }
 
-int ebpf_domain_t::get_instruction_count_upper_bound() {
+template <typename NumAbsDomain>
+int ebpf_domain_t<NumAbsDomain>::get_instruction_count_upper_bound() {
     const auto& ub = m_inv[variable_t::instruction_count()].ub();
     return (ub.is_finite() && ub.number().value().fits_sint()) ? (int)ub.number().value() : INT_MAX;
 }
 
-void ebpf_domain_t::check_access_stack(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::check_access_stack(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub) {
     using namespace crab::dsl_syntax;
     require(inv, lb >= 0, "Lower bound must be at least 0");
     require(inv, ub <= EBPF_STACK_SIZE, "Upper bound must be at most EBPF_STACK_SIZE");
 }
 
-void ebpf_domain_t::check_access_context(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::check_access_context(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub) {
     using namespace crab::dsl_syntax;
     require(inv, lb >= 0, "Lower bound must be at least 0");
-    require(inv, ub <= global_program_info.type.context_descriptor->size,
-            std::string("Upper bound must be at most ") + std::to_string(global_program_info.type.context_descriptor->size));
+    const int context_size = verification_context_t::current().info.type.context_descriptor->size;
+    require(inv, ub <= context_size, std::string("Upper bound must be at most ") + std::to_string(context_size));
 }
 
-void ebpf_domain_t::check_access_packet(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub,
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::check_access_packet(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub,
                                         std::optional<variable_t> packet_size) {
     using namespace crab::dsl_syntax;
     require(inv, lb >= variable_t::meta_offset(), "Lower bound must be at least meta_offset");
@@ -627,14 +821,16 @@ void ebpf_domain_t::check_access_packet(NumAbsDomain& inv, const linear_expressi
         require(inv, ub <= MAX_PACKET_SIZE, std::string{"Upper bound must be at most "} + std::to_string(MAX_PACKET_SIZE));
 }
 
-void ebpf_domain_t::check_access_shared(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub,
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::check_access_shared(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub,
                                         variable_t region_size) {
     using namespace crab::dsl_syntax;
     require(inv, lb >= 0, "Lower bound must be at least 0");
     require(inv, ub <= region_size, std::string("Upper bound must be at most ") + region_size.name());
 }
 
-void ebpf_domain_t::operator()(const Assume& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Assume& s) {
     Condition cond = s.cond;
     auto dst = reg_pack(cond.left);
     if (std::holds_alternative<Reg>(cond.right)) {
@@ -644,8 +840,7 @@ void ebpf_domain_t::operator()(const Assume& s) {
             m_inv = type_inv.join_over_types(m_inv, cond.left, [&](NumAbsDomain& inv, type_encoding_t type) {
                 if (type == T_NUM) {
                     if (!is_unsigned_cmp(cond.op))
-                        for (const linear_constraint_t& cst : jmp_to_cst_reg(cond.op, dst.value, src.value))
-                            inv += cst;
+                        ::assume(inv, jmp_to_cst_reg(cond.op, dst.value, src.value));
                 } else {
                     // Either pointers to a singleton region,
                     // or an equality comparison on map descriptors/pointers to non-singleton locations
@@ -656,20 +851,21 @@ void ebpf_domain_t::operator()(const Assume& s) {
             });
         } else {
             // We should only reach here if `--assume-assert` is off
-            assert(!thread_local_options.assume_assertions || is_bottom());
+            assert(!verification_context_t::current().options.assume_assertions || is_bottom());
             // be sound in any case, it happens to flush out bugs:
             m_inv.set_to_top();
         }
     } else {
         int imm = static_cast<int>(std::get<Imm>(cond.right).v);
-        for (const linear_constraint_t& cst : jmp_to_cst_imm(cond.op, dst.value, imm))
-            assume(cst);
+        ::assume(m_inv, jmp_to_cst_imm(cond.op, dst.value, imm));
     }
 }
 
-void ebpf_domain_t::operator()(const Undefined& a) {}
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Undefined& a) {}
 
-void ebpf_domain_t::operator()(const Un& stmt) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Un& stmt) {
     auto dst = reg_pack(stmt.dst);
     switch (stmt.op) {
     case Un::Op::BE16:
@@ -688,11 +884,14 @@ void ebpf_domain_t::operator()(const Un& stmt) {
     }
 }
 
-void ebpf_domain_t::operator()(const Exit& a) {}
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Exit& a) {}
 
-void ebpf_domain_t::operator()(const Jmp& a) {}
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Jmp& a) {}
 
-void ebpf_domain_t::operator()(const Comparable& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Comparable& s) {
     using namespace crab::dsl_syntax;
     if (type_inv.same_type(m_inv, s.r1, s.r2)) {
         // Same type. If both are numbers, that's okay. Otherwise:
@@ -712,22 +911,26 @@ void ebpf_domain_t::operator()(const Comparable& s) {
     };
 }
 
-void ebpf_domain_t::operator()(const Addable& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Addable& s) {
     if (!type_inv.implies_type(m_inv, type_is_pointer(reg_pack(s.ptr)),type_is_number(s.num)))
         require(m_inv, linear_constraint_t::FALSE(), "Only numbers can be added to pointers");
 }
 
-void ebpf_domain_t::operator()(const ValidStore& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const ValidStore& s) {
     if (!type_inv.implies_type(m_inv, type_is_not_stack(reg_pack(s.mem)), type_is_number(s.val)))
         require(m_inv, linear_constraint_t::FALSE(), "Only numbers can be stored to externally-visible regions");
 }
 
-void ebpf_domain_t::operator()(const TypeConstraint& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const TypeConstraint& s) {
     if (!type_inv.is_in_group(m_inv, s.reg, s.types))
         require(m_inv, linear_constraint_t::FALSE(), "");
 }
 
-void ebpf_domain_t::operator()(const ValidSize& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const ValidSize& s) {
     using namespace crab::dsl_syntax;
     auto r = reg_pack(s.reg);
     require(m_inv, s.can_be_zero ? r.value >= 0 : r.value > 0, "");
@@ -736,7 +939,8 @@ void ebpf_domain_t::operator()(const ValidSize& s) {
 // Get the start and end of the range of possible map fd values.
 // In the future, it would be cleaner to use a set rather than an interval
 // for map fds.
-bool ebpf_domain_t::get_map_fd_range(const Reg& map_fd_reg, int* start_fd, int* end_fd) const {
+template <typename NumAbsDomain>
+bool ebpf_domain_t<NumAbsDomain>::get_map_fd_range(const Reg& map_fd_reg, int* start_fd, int* end_fd) const {
     const crab::interval_t& map_fd_interval = m_inv[reg_pack(map_fd_reg).map_fd];
     auto lb = map_fd_interval.lb().number();
     auto ub = map_fd_interval.ub().number();
@@ -751,14 +955,15 @@ bool ebpf_domain_t::get_map_fd_range(const Reg& map_fd_reg, int* start_fd, int*
 }
 
 // All maps in the range must have the same type for us to use it.
-std::optional<uint32_t> ebpf_domain_t::get_map_type(const Reg& map_fd_reg) const {
+template <typename NumAbsDomain>
+std::optional<uint32_t> ebpf_domain_t<NumAbsDomain>::get_map_type(const Reg& map_fd_reg) const {
     int start_fd, end_fd;
     if (!get_map_fd_range(map_fd_reg, &start_fd, &end_fd))
         return std::optional<uint32_t>();
 
     std::optional<uint32_t> type;
     for (int map_fd = start_fd; map_fd <= end_fd; map_fd++) {
-        EbpfMapDescriptor* map = &global_program_info.platform->get_map_descriptor(map_fd);
+        EbpfMapDescriptor* map = &verification_context_t::current().info.platform->get_map_descriptor(map_fd);
         if (map == nullptr)
             return std::optional<uint32_t>();
         if (!type.has_value())
@@ -770,14 +975,15 @@ std::optional<uint32_t> ebpf_domain_t::get_map_type(const Reg& map_fd_reg) const
 }
 
 // All maps in the range must have the same inner map fd for us to use it.
-std::optional<uint32_t> ebpf_domain_t::get_map_inner_map_fd(const Reg& map_fd_reg) const {
+template <typename NumAbsDomain>
+std::optional<uint32_t> ebpf_domain_t<NumAbsDomain>::get_map_inner_map_fd(const Reg& map_fd_reg) const {
     int start_fd, end_fd;
     if (!get_map_fd_range(map_fd_reg, &start_fd, &end_fd))
         return {};
 
     std::optional<uint32_t> inner_map_fd;
     for (int map_fd = start_fd; map_fd <= end_fd; map_fd++) {
-        EbpfMapDescriptor* map = &global_program_info.platform->get_map_descriptor(map_fd);
+        EbpfMapDescriptor* map = &verification_context_t::current().info.platform->get_map_descriptor(map_fd);
         if (map == nullptr)
             return {};
         if (!inner_map_fd.has_value())
@@ -789,14 +995,15 @@ std::optional<uint32_t> ebpf_domain_t::get_map_inner_map_fd(const Reg& map_fd_re
 }
 
 // We can deal with a range of key sizes.
-crab::interval_t ebpf_domain_t::get_map_key_size(const Reg& map_fd_reg) const {
+template <typename NumAbsDomain>
+crab::interval_t ebpf_domain_t<NumAbsDomain>::get_map_key_size(const Reg& map_fd_reg) const {
     int start_fd, end_fd;
     if (!get_map_fd_range(map_fd_reg, &start_fd, &end_fd))
         return crab::interval_t::top();
 
     crab::interval_t result = crab::interval_t::bottom();
     for (int map_fd = start_fd; map_fd <= end_fd; map_fd++) {
-        if (EbpfMapDescriptor* map = &global_program_info.platform->get_map_descriptor(map_fd))
+        if (EbpfMapDescriptor* map = &verification_context_t::current().info.platform->get_map_descriptor(map_fd))
             result = result | crab::interval_t(number_t(map->key_size));
         else
             return crab::interval_t::top();
@@ -805,14 +1012,15 @@ crab::interval_t ebpf_domain_t::get_map_key_size(const Reg& map_fd_reg) const {
 }
 
 // We can deal with a range of value sizes.
-crab::interval_t ebpf_domain_t::get_map_value_size(const Reg& map_fd_reg) const {
+template <typename NumAbsDomain>
+crab::interval_t ebpf_domain_t<NumAbsDomain>::get_map_value_size(const Reg& map_fd_reg) const {
     int start_fd, end_fd;
     if (!get_map_fd_range(map_fd_reg, &start_fd, &end_fd))
         return crab::interval_t::top();
 
     crab::interval_t result = crab::interval_t::bottom();
     for (int map_fd = start_fd; map_fd <= end_fd; map_fd++) {
-        if (EbpfMapDescriptor* map = &global_program_info.platform->get_map_descriptor(map_fd))
+        if (EbpfMapDescriptor* map = &verification_context_t::current().info.platform->get_map_descriptor(map_fd))
             result = result | crab::interval_t(number_t(map->value_size));
         else
             return crab::interval_t::top();
@@ -821,14 +1029,15 @@ crab::interval_t ebpf_domain_t::get_map_value_size(const Reg& map_fd_reg) const
 }
 
 // We can deal with a range of max_entries values.
-crab::interval_t ebpf_domain_t::get_map_max_entries(const Reg& map_fd_reg) const {
+template <typename NumAbsDomain>
+crab::interval_t ebpf_domain_t<NumAbsDomain>::get_map_max_entries(const Reg& map_fd_reg) const {
     int start_fd, end_fd;
     if (!get_map_fd_range(map_fd_reg, &start_fd, &end_fd))
         return crab::interval_t::top();
 
     crab::interval_t result = crab::interval_t::bottom();
     for (int map_fd = start_fd; map_fd <= end_fd; map_fd++) {
-        if (EbpfMapDescriptor* map = &global_program_info.platform->get_map_descriptor(map_fd))
+        if (EbpfMapDescriptor* map = &verification_context_t::current().info.platform->get_map_descriptor(map_fd))
             result = result | crab::interval_t(number_t(map->max_entries));
         else
             return crab::interval_t::top();
@@ -836,7 +1045,8 @@ crab::interval_t ebpf_domain_t::get_map_max_entries(const Reg& map_fd_reg) const
     return result;
 }
 
-void ebpf_domain_t::operator()(const ValidMapKeyValue& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const ValidMapKeyValue& s) {
     using namespace crab::dsl_syntax;
 
     auto fd_type = get_map_type(s.map_fd_reg);
@@ -859,7 +1069,7 @@ void ebpf_domain_t::operator()(const ValidMapKeyValue& s) {
         width = (int)value_size.value();
     }
 
-    m_inv = type_inv.join_over_types(m_inv, s.access_reg, [&](NumAbsDomain& inv, type_encoding_t access_reg_type) {
+    require_over_types(s.access_reg, [&](NumAbsDomain& inv, type_encoding_t access_reg_type) {
         if (access_reg_type == T_STACK) {
             variable_t lb = access_reg.stack_offset;
             linear_expression_t ub = lb + width;
@@ -869,8 +1079,8 @@ void ebpf_domain_t::operator()(const ValidMapKeyValue& s) {
                 auto ub_is = inv.eval_interval(ub).ub().number();
                 std::string ub_s = ub_is && ub_is->fits_sint() ? std::to_string((int)*ub_is) : "oo";
                 require(inv, linear_constraint_t::FALSE(), "Illegal map update with a non-numerical value [" + lb_s + "-" + ub_s + ")");
-            } else if (thread_local_options.strict && fd_type.has_value()) {
-                EbpfMapType map_type = global_program_info.platform->get_map_type(*fd_type);
+            } else if (verification_context_t::current().options.strict && fd_type.has_value()) {
+                EbpfMapType map_type = verification_context_t::current().info.platform->get_map_type(*fd_type);
                 if (map_type.is_array) {
                     // Get offset value.
                     variable_t key_ptr = access_reg.stack_offset;
@@ -901,14 +1111,14 @@ void ebpf_domain_t::operator()(const ValidMapKeyValue& s) {
     });
 }
 
-void ebpf_domain_t::operator()(const ValidAccess& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const ValidAccess& s) {
     using namespace crab::dsl_syntax;
 
     bool is_comparison_check = s.width == (Value)Imm{0};
 
     auto reg = reg_pack(s.reg);
-    // join_over_types instead of simple iteration is only needed for assume-assert
-    m_inv = type_inv.join_over_types(m_inv, s.reg, [&](NumAbsDomain& inv, type_encoding_t type) {
+    require_over_types(s.reg, [&](NumAbsDomain& inv, type_encoding_t type) {
         switch (type) {
         case T_PACKET: {
             linear_expression_t lb = reg.packet_offset + s.offset;
@@ -985,21 +1195,24 @@ void ebpf_domain_t::operator()(const ValidAccess& s) {
     });
 }
 
-void ebpf_domain_t::operator()(const ZeroCtxOffset& s) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const ZeroCtxOffset& s) {
     using namespace crab::dsl_syntax;
     auto reg = reg_pack(s.reg);
     require(m_inv, reg.ctx_offset == 0, "");
 }
 
-void ebpf_domain_t::operator()(const Assert& stmt) {
-    if (check_require || thread_local_options.assume_assertions) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Assert& stmt) {
+    if (check_require || verification_context_t::current().options.assume_assertions) {
         this->current_assertion = to_string(stmt.cst);
         std::visit(*this, stmt.cst);
         this->current_assertion.clear();
     }
 }
 
-void ebpf_domain_t::operator()(const Packet& a) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Packet& a) {
     auto reg = reg_pack(R0_RETURN_VALUE);
     Reg r0_reg{(uint8_t)R0_RETURN_VALUE};
     type_inv.assign_type(m_inv, r0_reg, T_NUM);
@@ -1008,7 +1221,8 @@ void ebpf_domain_t::operator()(const Packet& a) {
     scratch_caller_saved_registers();
 }
 
-void ebpf_domain_t::do_load_stack(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr, int width, const Reg& src_reg) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::do_load_stack(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr, int width, const Reg& src_reg) {
     type_inv.assign_type(inv, target_reg, stack.load(inv, data_kind_t::types, addr, width));
     using namespace crab::dsl_syntax;
     if (inv.entail(width <= reg_pack(src_reg).stack_numeric_size))
@@ -1019,29 +1233,31 @@ void ebpf_domain_t::do_load_stack(NumAbsDomain& inv, const Reg& target_reg, cons
     if (width == 1 || width == 2 || width == 4 || width == 8) {
         inv.assign(target.value, stack.load(inv,  data_kind_t::values, addr, width));
 
-        if (type_inv.has_type(m_inv, target.type, T_CTX))
+        const crab::type_set_t types = type_inv.get_types(m_inv, target.type);
+        if (types.contains(T_CTX))
             inv.assign(target.ctx_offset, stack.load(inv, data_kind_t::ctx_offsets, addr, width));
-        if (type_inv.has_type(m_inv, target.type, T_MAP) || type_inv.has_type(m_inv, target.type, T_MAP_PROGRAMS))
+        if (types.contains(T_MAP) || types.contains(T_MAP_PROGRAMS))
             inv.assign(target.map_fd, stack.load(inv, data_kind_t::map_fds, addr, width));
-        if (type_inv.has_type(m_inv, target.type, T_PACKET))
+        if (types.contains(T_PACKET))
             inv.assign(target.packet_offset, stack.load(inv, data_kind_t::packet_offsets, addr, width));
-        if (type_inv.has_type(m_inv, target.type, T_SHARED)) {
+        if (types.contains(T_SHARED)) {
             inv.assign(target.shared_offset, stack.load(inv, data_kind_t::shared_offsets, addr, width));
             inv.assign(target.shared_region_size, stack.load(inv, data_kind_t::shared_region_sizes, addr, width));
         }
-        if (type_inv.has_type(m_inv, target.type, T_STACK)) {
+        if (types.contains(T_STACK)) {
             inv.assign(target.stack_offset, stack.load(inv, data_kind_t::stack_offsets, addr, width));
             inv.assign(target.stack_numeric_size, stack.load(inv, data_kind_t::stack_numeric_sizes, addr, width));
         }
     }
 }
 
-void ebpf_domain_t::do_load_ctx(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr_vague, int width) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::do_load_ctx(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr_vague, int width) {
     using namespace crab::dsl_syntax;
     if (inv.is_bottom())
         return;
 
-    const ebpf_context_descriptor_t* desc = global_program_info.type.context_descriptor;
+    const ebpf_context_descriptor_t* desc = verification_context_t::current().info.type.context_descriptor;
 
     const reg_pack_t& target = reg_pack(target_reg);
 
@@ -1081,11 +1297,11 @@ void ebpf_domain_t::do_load_ctx(NumAbsDomain& inv, const Reg& target_reg, const
         return;
     }
     type_inv.assign_type(inv, target_reg, T_PACKET);
-    inv += 4098 <= target.value;
-    inv += target.value <= PTR_MAX;
+    inv.add_constraints({4098 <= target.value, target.value <= PTR_MAX});
 }
 
-void ebpf_domain_t::do_load_packet_or_shared(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr, int width) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::do_load_packet_or_shared(NumAbsDomain& inv, const Reg& target_reg, const linear_expression_t& addr, int width) {
     if (inv.is_bottom())
         return;
     const reg_pack_t& target = reg_pack(target_reg);
@@ -1101,7 +1317,8 @@ void ebpf_domain_t::do_load_packet_or_shared(NumAbsDomain& inv, const Reg& targe
     }
 }
 
-void ebpf_domain_t::do_load(const Mem& b, const Reg& target_reg) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::do_load(const Mem& b, const Reg& target_reg) {
     using namespace crab::dsl_syntax;
 
     auto mem_reg = reg_pack(b.access.basereg);
@@ -1144,34 +1361,35 @@ void ebpf_domain_t::do_load(const Mem& b, const Reg& target_reg) {
     });
 }
 
+template <typename NumAbsDomain>
 template <typename A, typename X, typename Y>
-void ebpf_domain_t::do_store_stack(NumAbsDomain& inv, int width, const A& addr, X val_type, Y val_value,
+void ebpf_domain_t<NumAbsDomain>::do_store_stack(NumAbsDomain& inv, int width, const A& addr, X val_type, Y val_value,
                                    const std::optional<reg_pack_t>& opt_val_reg) {
     std::optional<variable_t> var = stack.store_type(inv, addr, width, val_type);
     type_inv.assign_type(inv, var, val_type);
     if (width == 8) {
         inv.assign(stack.store(inv, data_kind_t::values, addr, width, val_value), val_value);
 
-        if (opt_val_reg && type_inv.has_type(m_inv, val_type, T_CTX)) {
+        const crab::type_set_t types = type_inv.get_types(m_inv, val_type);
+        if (opt_val_reg && types.contains(T_CTX)) {
             inv.assign(stack.store(inv, data_kind_t::ctx_offsets, addr, width, opt_val_reg->ctx_offset), opt_val_reg->ctx_offset);
         } else {
             stack.havoc(inv, data_kind_t::ctx_offsets, addr, width);
         }
 
-        if (opt_val_reg && (type_inv.has_type(m_inv, val_type, T_MAP) ||
-                                   type_inv.has_type(m_inv, val_type, T_MAP_PROGRAMS))) {
+        if (opt_val_reg && (types.contains(T_MAP) || types.contains(T_MAP_PROGRAMS))) {
             inv.assign(stack.store(inv, data_kind_t::map_fds, addr, width, opt_val_reg->map_fd), opt_val_reg->map_fd);
         } else {
             stack.havoc(inv, data_kind_t::map_fds, addr, width);
         }
 
-        if (opt_val_reg && type_inv.has_type(m_inv, val_type, T_PACKET)) {
+        if (opt_val_reg && types.contains(T_PACKET)) {
             inv.assign(stack.store(inv, data_kind_t::packet_offsets, addr, width, opt_val_reg->packet_offset), opt_val_reg->packet_offset);
         } else {
             stack.havoc(inv, data_kind_t::packet_offsets, addr, width);
         }
 
-        if (opt_val_reg && type_inv.has_type(m_inv, val_type, T_SHARED)) {
+        if (opt_val_reg && types.contains(T_SHARED)) {
             inv.assign(stack.store(inv, data_kind_t::shared_offsets, addr, width, opt_val_reg->shared_offset), opt_val_reg->shared_offset);
             inv.assign(stack.store(inv, data_kind_t::shared_region_sizes, addr, width, opt_val_reg->shared_region_size),
                        opt_val_reg->shared_region_size);
@@ -1180,7 +1398,7 @@ void ebpf_domain_t::do_store_stack(NumAbsDomain& inv, int width, const A& addr,
             stack.havoc(inv, data_kind_t::shared_offsets, addr, width);
         }
 
-        if (opt_val_reg && type_inv.has_type(m_inv, val_type, T_STACK)) {
+        if (opt_val_reg && types.contains(T_STACK)) {
             inv.assign(stack.store(inv, data_kind_t::stack_offsets, addr, width, opt_val_reg->stack_offset), opt_val_reg->stack_offset);
             inv.assign(stack.store(inv, data_kind_t::stack_numeric_sizes, addr, width, opt_val_reg->stack_numeric_size),
                        opt_val_reg->stack_numeric_size);
@@ -1225,7 +1443,8 @@ void ebpf_domain_t::do_store_stack(NumAbsDomain& inv, int width, const A& addr,
     }
 }
 
-void ebpf_domain_t::operator()(const Mem& b) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Mem& b) {
     if (m_inv.is_bottom())
         return;
     if (std::holds_alternative<Reg>(b.value)) {
@@ -1241,8 +1460,9 @@ void ebpf_domain_t::operator()(const Mem& b) {
     }
 }
 
+template <typename NumAbsDomain>
 template <typename Type, typename Value>
-void ebpf_domain_t::do_mem_store(const Mem& b, Type val_type, Value val_value, const std::optional<reg_pack_t>& val_reg) {
+void ebpf_domain_t<NumAbsDomain>::do_mem_store(const Mem& b, Type val_type, Value val_value, const std::optional<reg_pack_t>& val_reg) {
     if (m_inv.is_bottom())
         return;
     using namespace crab::dsl_syntax;
@@ -1262,11 +1482,13 @@ void ebpf_domain_t::do_mem_store(const Mem& b, Type val_type, Value val_value, c
     });
 }
 
-void ebpf_domain_t::operator()(const LockAdd& a) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const LockAdd& a) {
     // nothing to do here
 }
 
-void ebpf_domain_t::operator()(const Call& call) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Call& call) {
     using namespace crab::dsl_syntax;
     if (m_inv.is_bottom())
         return;
@@ -1329,7 +1551,7 @@ void ebpf_domain_t::operator()(const Call& call) {
         // This is the only way to get a null pointer
         if (maybe_fd_reg) {
             if (auto map_type = get_map_type(*maybe_fd_reg)) {
-                if (global_program_info.platform->get_map_type(*map_type).value_type == EbpfMapValueType::MAP) {
+                if (verification_context_t::current().info.platform->get_map_type(*map_type).value_type == EbpfMapValueType::MAP) {
                     if (auto inner_map_fd = get_map_inner_map_fd(*maybe_fd_reg)) {
                         do_load_mapfd(r0_reg, (int)*inner_map_fd, true);
                         goto out;
@@ -1358,9 +1580,11 @@ out:
     }
 }
 
-void ebpf_domain_t::do_load_mapfd(const Reg& dst_reg, int mapfd, bool maybe_null) {
-    const EbpfMapDescriptor& desc = global_program_info.platform->get_map_descriptor(mapfd);
-    const EbpfMapType& type = global_program_info.platform->get_map_type(desc.type);
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::do_load_mapfd(const Reg& dst_reg, int mapfd, bool maybe_null) {
+    const ebpf_platform_t* platform = verification_context_t::current().info.platform;
+    const EbpfMapDescriptor& desc = platform->get_map_descriptor(mapfd);
+    const EbpfMapType& type = platform->get_map_type(desc.type);
     if (type.value_type == EbpfMapValueType::PROGRAM) {
         type_inv.assign_type(m_inv, dst_reg, T_MAP_PROGRAMS);
     } else {
@@ -1371,25 +1595,23 @@ void ebpf_domain_t::do_load_mapfd(const Reg& dst_reg, int mapfd, bool maybe_null
     assign_valid_ptr(dst_reg, maybe_null);
 }
 
-void ebpf_domain_t::operator()(const LoadMapFd& ins) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const LoadMapFd& ins) {
     do_load_mapfd(ins.dst, ins.mapfd, false);
 }
 
-void ebpf_domain_t::assign_valid_ptr(const Reg& dst_reg, bool maybe_null) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::assign_valid_ptr(const Reg& dst_reg, bool maybe_null) {
     using namespace crab::dsl_syntax;
     const reg_pack_t& reg = reg_pack(dst_reg);
     havoc(reg.value);
-    if (maybe_null) {
-        m_inv += 0 <= reg.value;
-    } else {
-        m_inv += 0 < reg.value;
-    }
-    m_inv += reg.value <= PTR_MAX;
+    m_inv.add_constraints({maybe_null ? 0 <= reg.value : 0 < reg.value, reg.value <= PTR_MAX});
 }
 
 // If nothing is known of the stack_numeric_size,
 // try to recompute the stack_numeric_size.
-void ebpf_domain_t::recompute_stack_numeric_size(NumAbsDomain& inv, variable_t type_variable) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::recompute_stack_numeric_size(NumAbsDomain& inv, variable_t type_variable) {
     variable_t stack_numeric_size_variable = variable_t::kind_var(data_kind_t::stack_numeric_sizes, type_variable);
 
     if (!inv.eval_interval(stack_numeric_size_variable).is_top())
@@ -1403,11 +1625,13 @@ void ebpf_domain_t::recompute_stack_numeric_size(NumAbsDomain& inv, variable_t t
     }
 }
 
-void ebpf_domain_t::recompute_stack_numeric_size(NumAbsDomain& inv, const Reg& reg) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::recompute_stack_numeric_size(NumAbsDomain& inv, const Reg& reg) {
     recompute_stack_numeric_size(inv, reg_pack(reg).type);
 }
 
-void ebpf_domain_t::add(const Reg& reg, int imm) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::add(const Reg& reg, int imm) {
     auto dst = reg_pack(reg);
     auto offset = get_type_offset_variable(reg);
     add_overflow(dst.value, imm);
@@ -1423,7 +1647,8 @@ void ebpf_domain_t::add(const Reg& reg, int imm) {
     }
 }
 
-void ebpf_domain_t::operator()(const Bin& bin) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::operator()(const Bin& bin) {
     using namespace crab::dsl_syntax;
 
     auto dst = reg_pack(bin.dst);
@@ -1673,41 +1898,44 @@ void ebpf_domain_t::operator()(const Bin& bin) {
     }
 }
 
-string_invariant ebpf_domain_t::to_set() {
+template <typename NumAbsDomain>
+string_invariant ebpf_domain_t<NumAbsDomain>::to_set() {
     return this->m_inv.to_set() + this->stack.to_set();
 }
 
-std::ostream& operator<<(std::ostream& o, const ebpf_domain_t& dom) {
-    if (dom.is_bottom()) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::write(std::ostream& o) const {
+    if (is_bottom()) {
         o << "_|_";
     } else {
-        o << dom.m_inv << "\nStack: " << dom.stack;
+        o << m_inv << "\nStack: " << stack;
     }
-    return o;
 }
 
-void ebpf_domain_t::initialize_packet(ebpf_domain_t& inv) {
+template <typename NumAbsDomain>
+void ebpf_domain_t<NumAbsDomain>::initialize_packet(ebpf_domain_t& inv) {
     using namespace crab::dsl_syntax;
 
     inv -= variable_t::packet_size();
     inv -= variable_t::meta_offset();
 
-    inv += 0 <= variable_t::packet_size();
-    inv += variable_t::packet_size() < MAX_PACKET_SIZE;
-    auto info = global_program_info;
+    inv.m_inv.add_constraints({0 <= variable_t::packet_size(), variable_t::packet_size() < MAX_PACKET_SIZE});
+    const program_info& info = verification_context_t::current().info;
     if (info.type.context_descriptor->meta >= 0) {
-        inv += variable_t::meta_offset() <= 0;
-        inv += variable_t::meta_offset() >= -4098;
+        inv.m_inv.add_constraints({variable_t::meta_offset() <= 0, variable_t::meta_offset() >= -4098});
     } else {
         inv.assign(variable_t::meta_offset(), 0);
     }
 }
 
-ebpf_domain_t ebpf_domain_t::from_constraints(const std::set<std::string>& constraints) {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::from_constraints(const std::set<std::string>& constraints) {
     ebpf_domain_t inv;
     auto numeric_ranges = std::vector<crab::interval_t>();
-    for (const auto& cst : parse_linear_constraints(constraints, numeric_ranges)) {
-        inv += cst;
+    auto cells = std::vector<stack_cell_t>();
+    inv.m_inv.add_constraints(parse_linear_constraints(constraints, numeric_ranges, cells));
+    for (const stack_cell_t& cell : cells) {
+        crab::domains::add_array_cell(cell.kind, cell.offset, cell.size);
     }
     for (const crab::interval_t& range : numeric_ranges) {
         int start = (int)range.lb().number().value();
@@ -1718,14 +1946,14 @@ ebpf_domain_t ebpf_domain_t::from_constraints(const std::set<std::string>& const
     return inv;
 }
 
-ebpf_domain_t ebpf_domain_t::setup_entry(bool check_termination) {
+template <typename NumAbsDomain>
+ebpf_domain_t<NumAbsDomain> ebpf_domain_t<NumAbsDomain>::setup_entry(bool check_termination) {
     using namespace crab::dsl_syntax;
 
     ebpf_domain_t inv;
     auto r10 = reg_pack(R10_STACK_POINTER);
     Reg r10_reg{(uint8_t)R10_STACK_POINTER};
-    inv += EBPF_STACK_SIZE <= r10.value;
-    inv += r10.value <= PTR_MAX;
+    inv.m_inv.add_constraints({EBPF_STACK_SIZE <= r10.value, r10.value <= PTR_MAX});
     inv.assign(r10.stack_offset, EBPF_STACK_SIZE);
     // stack_numeric_size would be 0, but TOP has the same result
     // so no need to assign it.
@@ -1733,8 +1961,7 @@ ebpf_domain_t ebpf_domain_t::setup_entry(bool check_termination) {
 
     auto r1 = reg_pack(R1_ARG);
     Reg r1_reg{(uint8_t)R1_ARG};
-    inv += 1 <= r1.value;
-    inv += r1.value <= PTR_MAX;
+    inv.m_inv.add_constraints({1 <= r1.value, r1.value <= PTR_MAX});
     inv.assign(r1.ctx_offset, 0);
     inv.type_inv.assign_type(inv.m_inv, r1_reg, T_CTX);
 
@@ -1745,3 +1972,6 @@ ebpf_domain_t ebpf_domain_t::setup_entry(bool check_termination) {
     }
     return inv;
 }
+
+template class ebpf_domain_t<crab::domains::PackedSplitDBM>;
+template class ebpf_domain_t<crab::domains::IntervalDomain>;
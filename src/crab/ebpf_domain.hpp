@@ -9,20 +9,38 @@
 #include <vector>
 
 #include "crab/array_domain.hpp"
+#include "crab/cfg.hpp"
+#include "crab/interval_domain.hpp"
+#include "crab/liveness.hpp"
+#include "crab/packed_split_dbm.hpp"
 #include "crab/split_dbm.hpp"
+#include "crab/type_set.hpp"
 #include "crab/variable.hpp"
 #include "string_constraints.hpp"
 
-using NumAbsDomain = crab::domains::NumAbsDomain;
-
 struct reg_pack_t;
 
+/**
+ * The abstract domain of eBPF programs, over a numeric domain that tracks the values of registers, stack cells,
+ * types and offsets.
+ *
+ * NumAbsDomain must be a lattice with top(), bottom(), <=, ==, |, &, widen, widening_thresholds and narrow,
+ * and support:
+ * - assign, set and -= to overwrite or forget a variable, forget to forget several, and set to bound several;
+ * - bound_differences to list the variables whose bounds differ between two operands;
+ * - apply for the binary operations of binop_t;
+ * - += and when to assume a linear constraint, add_constraints to assume several, entail and intersect to test one;
+ * - operator[] and eval_interval to read the bounds of a variable or expression;
+ * - to_set and << to print it.
+ * It is instantiated with crab::domains::PackedSplitDBM and crab::domains::IntervalDomain, in ebpf_domain.cpp.
+ */
+template <typename NumAbsDomain>
 class ebpf_domain_t final {
     struct TypeDomain;
 
   public:
     ebpf_domain_t();
-    ebpf_domain_t(crab::domains::NumAbsDomain inv, crab::domains::array_domain_t stack);
+    ebpf_domain_t(NumAbsDomain inv, crab::domains::array_domain_t stack);
 
     // Generic abstract domain operations
     static ebpf_domain_t top();
@@ -49,10 +67,13 @@ class ebpf_domain_t final {
     static ebpf_domain_t setup_entry(bool check_termination);
 
     static ebpf_domain_t from_constraints(const std::set<std::string>& constraints);
+
+    /// Forget everything about the registers and stack bytes that are not live.
+    void forget_dead(const crab::live_set_t& live);
     string_invariant to_set();
 
     // abstract transformers
-    void operator()(const basic_block_t& bb, bool check_termination);
+    void operator()(const flat_cfg_t::instruction_range& block, bool check_termination);
 
     void operator()(const Addable&);
     void operator()(const Assert&);
@@ -91,8 +112,8 @@ class ebpf_domain_t final {
     void apply(crab::binop_t op, variable_t x, variable_t y, const number_t& z);
     void apply(crab::binop_t op, variable_t x, variable_t y, variable_t z);
 
-    void apply(crab::domains::NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, const number_t& z, bool finite_width = false);
-    void apply(crab::domains::NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, variable_t z, bool finite_width = false);
+    void apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, const number_t& z, bool finite_width = false);
+    void apply(NumAbsDomain& inv, crab::binop_t op, variable_t x, variable_t y, variable_t z, bool finite_width = false);
 
     void add(const Reg& reg, int imm);
     void add(variable_t lhs, variable_t op2);
@@ -155,7 +176,10 @@ class ebpf_domain_t final {
 
     void assign_valid_ptr(const Reg& dst_reg, bool maybe_null);
 
-    void require(crab::domains::NumAbsDomain& inv, const linear_constraint_t& cst, const std::string& s);
+    void require(NumAbsDomain& inv, const linear_constraint_t& cst, const std::string& s);
+    // Applies the checks of an assertion for each type that reg may have. Only when assertions are assumed do they
+    // refine the invariant, so only then are the refinements for each type joined into it.
+    void require_over_types(const Reg& reg, const std::function<void(NumAbsDomain&, type_encoding_t)>& check);
 
     // memory check / load / store
     void check_access_stack(NumAbsDomain& inv, const linear_expression_t& lb, const linear_expression_t& ub);
@@ -173,13 +197,18 @@ class ebpf_domain_t final {
     void do_load(const Mem& b, const Reg& target_reg);
 
     template <typename A, typename X, typename Y>
-    void do_store_stack(crab::domains::NumAbsDomain& inv, int width, const A& addr, X val_type, Y val_value,
+    void do_store_stack(NumAbsDomain& inv, int width, const A& addr, X val_type, Y val_value,
                         const std::optional<reg_pack_t>& opt_val_reg);
 
     template <typename Type, typename Value>
     void do_mem_store(const Mem& b, Type val_type, Value val_value, const std::optional<reg_pack_t>& opt_val_reg);
 
-    friend std::ostream& operator<<(std::ostream& o, const ebpf_domain_t& dom);
+    void write(std::ostream& o) const;
+
+    friend std::ostream& operator<<(std::ostream& o, const ebpf_domain_t& dom) {
+        dom.write(o);
+        return o;
+    }
 
     static void initialize_packet(ebpf_domain_t& inv);
 
@@ -188,7 +217,7 @@ class ebpf_domain_t final {
     /// Mapping from variables (including registers, types, offsets,
     /// memory locations, etc.) to numeric intervals or relationships
     /// to other variables.
-    crab::domains::NumAbsDomain m_inv;
+    NumAbsDomain m_inv;
 
     /// Represents the stack as a memory region, i.e., an array of bytes,
     /// allowing mapping to variable in the m_inv numeric domains
@@ -211,6 +240,11 @@ class ebpf_domain_t final {
         [[nodiscard]] int get_type(const NumAbsDomain& inv, const Reg& r) const;
         [[nodiscard]] int get_type(const NumAbsDomain& inv, int t) const;
 
+        // The possible types, read with a single lookup in the numeric domain.
+        [[nodiscard]] crab::type_set_t get_types(const NumAbsDomain& inv, variable_t v) const;
+        [[nodiscard]] crab::type_set_t get_types(const NumAbsDomain& inv, const Reg& r) const;
+        [[nodiscard]] crab::type_set_t get_types(const NumAbsDomain& inv, int t) const;
+
         [[nodiscard]] bool has_type(const NumAbsDomain& inv, variable_t v, type_encoding_t type) const;
         [[nodiscard]] bool has_type(const NumAbsDomain& inv, const Reg& r, type_encoding_t type) const;
         [[nodiscard]] bool has_type(const NumAbsDomain& inv, int t, type_encoding_t type) const;
@@ -220,14 +254,14 @@ class ebpf_domain_t final {
 
         NumAbsDomain join_over_types(const NumAbsDomain& inv, const Reg& reg,
                                      const std::function<void(NumAbsDomain&, type_encoding_t)>& transition) const;
+        // Like join_over_types, for checks that leave the invariant unchanged: they all run on one copy of it,
+        // and nothing is joined.
+        void check_over_types(const NumAbsDomain& inv, const Reg& reg,
+                              const std::function<void(NumAbsDomain&, type_encoding_t)>& check) const;
         NumAbsDomain join_by_if_else(const NumAbsDomain& inv, const linear_constraint_t& condition,
                                      const std::function<void(NumAbsDomain&)>& if_true,
                                      const std::function<void(NumAbsDomain&)>& if_false) const;
         void selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain& src) const;
-        void add_extra_invariant(NumAbsDomain& dst,
-                                 std::map<crab::variable_t, crab::interval_t>& extra_invariants,
-                                 variable_t type_variable, type_encoding_t type, crab::data_kind_t kind,
-                                 const NumAbsDomain& other) const;
 
         [[nodiscard]] bool is_in_group(const NumAbsDomain& inv, const Reg& r, TypeGroup group) const;
     };
@@ -235,3 +269,6 @@ class ebpf_domain_t final {
     TypeDomain type_inv;
     std::string current_assertion;
 }; // end ebpf_domain_t
+
+using zone_domain_t = ebpf_domain_t<crab::domains::PackedSplitDBM>;
+using interval_domain_t = ebpf_domain_t<crab::domains::IntervalDomain>;
@@ -1,62 +1,44 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: Apache-2.0
+#include <map>
+#include <optional>
 #include <utility>
-#include <variant>
+#include <vector>
 
 #include "crab/cfg.hpp"
 #include "crab/wto.hpp"
 
 #include "crab/ebpf_domain.hpp"
 #include "crab/fwd_analyzer.hpp"
+#include "crab_utils/arena.hpp"
+#include "verification_context.hpp"
 
 namespace crab {
 
-// Simple visitor to check if node is a member of the wto component.
-class member_component_visitor final {
-    label_t _node;
-    bool _found;
+template <typename Domain>
+class interleaved_fwd_fixpoint_iterator_t final {
+    const flat_cfg_t& _cfg;
+    wto_t _wto;
+    liveness_t _liveness;
+    invariant_table_t<Domain> _pre, _post;
 
-  public:
-    explicit member_component_visitor(label_t node) : _node(node), _found(false) {}
+    /// Blocks whose pre-invariant is kept; see invariant_tables_t.
+    std::vector<bool> _stored_pre;
 
-    void operator()(const label_t& vertex) {
-        if (!_found) {
-            _found = (vertex == _node);
-        }
-    }
+    /// Number of successors of each block that may still read its post-invariant.
+    std::vector<size_t> _pending_successors;
 
-    void operator()(std::shared_ptr<wto_cycle_t>& c) {
-        if (!_found) {
-            _found = (c->head() == _node);
-            if (!_found) {
-                for (auto& component : *c) {
-                    if (_found)
-                        break;
-                    std::visit(*this, *component);
-                }
-            }
-        }
-    }
+    /// Blocks that were never visited, or whose predecessors' post-invariants changed since their last visit.
+    /// A component of a cycle none of whose blocks is dirty would compute the same invariants again,
+    /// so it is skipped on the following iterations of the cycle.
+    std::vector<bool> _dirty;
 
-    [[nodiscard]] bool is_member() const { return _found; }
-};
+    /// number of iterations until triggering widening, and number of narrowing iterations. If the narrowing
+    /// operator is indeed a narrowing operator the latter is not needed. However, there are abstract domains for
+    /// which an actual narrowing operation is not available so we must enforce termination.
+    const iteration_policy_t _policy;
 
-class interleaved_fwd_fixpoint_iterator_t final {
-    using iterator = typename invariant_table_t::iterator;
-
-    cfg_t& _cfg;
-    wto_t _wto;
-    invariant_table_t _pre, _post;
-
-    /// number of iterations until triggering widening
-    const unsigned int _widening_delay{1};
-
-    /// number of narrowing iterations. If the narrowing operator is
-    /// indeed a narrowing operator this parameter is not
-    /// needed. However, there are abstract domains for which an actual
-    /// narrowing operation is not available so we must enforce
-    /// termination.
-    const unsigned int _descending_iterations;
+    std::map<block_id_t, cycle_iterations_t> _cycle_iterations;
 
     /// Used to skip the analysis until _entry is found
     bool _skip{true};
@@ -65,27 +47,86 @@ class interleaved_fwd_fixpoint_iterator_t final {
     /// Generally corresponds to the check_termination flag in ebpf_verifier_options_t
     const bool check_termination;
 
+    const visit_hooks_t<Domain>& _hooks;
+
+    const settled_blocks_t<Domain>& _settled;
+
   private:
-    inline void set_pre(const label_t& label, const ebpf_domain_t& v) { _pre[label] = v; }
+    inline void set_pre(block_id_t block, const Domain& v) {
+        if (_stored_pre[block]) {
+            _pre[block] = v;
+        }
+    }
+
+    inline void transform_to_post(block_id_t block, Domain pre) {
+        // The temporaries of the previous block are all gone; reset() throws if one is not.
+        crab::scratch_arena().reset();
+        const flat_cfg_t::instruction_range instructions = _cfg.instructions(block);
+        if (_hooks.before) {
+            _hooks.before(block, pre);
+            pre(instructions, check_termination);
+            // Do not let the hook's require check leak into the invariants joined from this one.
+            pre.set_require_check({});
+        } else {
+            pre(instructions, check_termination);
+        }
+        if (const std::optional<live_set_t>& live = _liveness.live_at_join(block)) {
+            pre.forget_dead(*live);
+        }
+        if (_hooks.after) {
+            _hooks.after(block, pre);
+        }
+        std::optional<Domain>& post = _post[block];
+        if (!post || !(*post == pre)) {
+            for (block_id_t next : _cfg.next_nodes(block)) {
+                _dirty[next] = true;
+            }
+        }
+        post = std::move(pre);
+    }
+
+    [[nodiscard]] bool is_dirty(uint32_t index) const {
+        for (uint32_t i = index; i < _wto[index].end; i++) {
+            if (_dirty[_wto[i].vertex]) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-    inline void transform_to_post(const label_t& label, ebpf_domain_t pre) {
-        basic_block_t& bb = _cfg.get_node(label);
-        pre(bb, check_termination);
-        _post[label] = std::move(pre);
+    /// Once a top-level component is done, none of its blocks is visited again, so the post-invariants
+    /// that only they read can be dropped. Within a cycle, any block may be visited again on the next iteration of
+    /// the cycle or of an enclosing one, so nothing is dropped before the outermost cycle is done.
+    void release_consumed_posts(uint32_t index) {
+        auto release = [&](block_id_t block) {
+            if (_pending_successors[block] == 0 && block != _cfg.exit()) {
+                _post[block].reset();
+            }
+        };
+        const uint32_t end = _wto[index].end;
+        for (uint32_t i = index; i < end; i++) {
+            for (block_id_t prev : _cfg.prev_nodes(_wto[i].vertex)) {
+                _pending_successors[prev]--;
+                release(prev);
+            }
+        }
+        for (uint32_t i = index; i < end; i++) {
+            release(_wto[i].vertex);
+        }
     }
 
     [[nodiscard]]
-    ebpf_domain_t extrapolate(const label_t& node, unsigned int iteration, ebpf_domain_t before,
-                              const ebpf_domain_t& after) const {
-        if (iteration <= _widening_delay) {
+    Domain extrapolate(block_id_t node, unsigned int iteration, Domain before,
+                              const Domain& after) const {
+        if (iteration <= _policy.widening_delay) {
             return before | after;
         } else {
             return before.widen(after);
         }
     }
 
-    static ebpf_domain_t refine(const label_t& node, unsigned int iteration, ebpf_domain_t before,
-                                const ebpf_domain_t& after) {
+    static Domain refine(block_id_t node, unsigned int iteration, Domain before,
+                                const Domain& after) {
         if (iteration == 1) {
             return before & after;
         } else {
@@ -93,125 +134,297 @@ class interleaved_fwd_fixpoint_iterator_t final {
         }
     }
 
-    ebpf_domain_t join_all_prevs(const label_t& node) {
-        ebpf_domain_t res = ebpf_domain_t::bottom();
-        for (const label_t& prev : _cfg.prev_nodes(node)) {
+    Domain join_all_prevs(block_id_t node) {
+        Domain res = Domain::bottom();
+        for (block_id_t prev : _cfg.prev_nodes(node)) {
             res |= get_post(prev);
         }
         return res;
     }
 
   public:
-    explicit interleaved_fwd_fixpoint_iterator_t(cfg_t& cfg, unsigned int descending_iterations, bool check_termination)
-        : _cfg(cfg), _wto(cfg), _descending_iterations(descending_iterations), check_termination(check_termination) {
-        for (const auto& label : _cfg.labels()) {
-            _pre.emplace(label, ebpf_domain_t::bottom());
-            _post.emplace(label, ebpf_domain_t::bottom());
+    interleaved_fwd_fixpoint_iterator_t(const flat_cfg_t& cfg, const iteration_policy_t& policy,
+                                        bool check_termination, const visit_hooks_t<Domain>& hooks,
+                                        const settled_blocks_t<Domain>& settled)
+        : _cfg(cfg), _wto(cfg), _liveness(cfg), _pre(cfg.size()), _post(cfg.size()), _stored_pre(cfg.size()),
+          _pending_successors(cfg.size()), _dirty(cfg.size(), true), _policy(policy),
+          check_termination(check_termination), _hooks(hooks), _settled(settled) {
+        _stored_pre[_cfg.entry()] = true;
+        _stored_pre[_cfg.exit()] = true;
+        for (uint32_t index = 0; index < _wto.size(); index++) {
+            if (_wto[index].is_head) {
+                _stored_pre[_wto[index].vertex] = true;
+            }
+        }
+        for (block_id_t block = 0; block < _cfg.size(); block++) {
+            if (_cfg.in_degree(block) > 1) {
+                _stored_pre[block] = true;
+            }
+            _pending_successors[block] = _cfg.out_degree(block);
+            if (_stored_pre[block]) {
+                _pre[block] = Domain::bottom();
+            }
         }
+        _post[_cfg.exit()] = Domain::bottom();
     }
 
-    ebpf_domain_t get_pre(const label_t& node) { return _pre.at(node); }
+    Domain get_pre(block_id_t node) { return _pre.at(node).value(); }
+
+    Domain get_post(block_id_t node) {
+        const std::optional<Domain>& post = _post[node];
+        return post ? *post : Domain::bottom();
+    }
 
-    ebpf_domain_t get_post(const label_t& node) { return _post.at(node); }
+    void visit_vertex(block_id_t vertex);
 
-    void operator()(const label_t& vertex);
+    void visit_cycle(uint32_t index);
+
+    /// Visit the component whose entry is at the given index, unless it is not dirty,
+    /// and return the index of the next component.
+    uint32_t visit(uint32_t index) {
+        if (!is_dirty(index)) {
+            return _wto[index].end;
+        }
+        if (_wto[index].is_head) {
+            try {
+                visit_cycle(index);
+            } catch (verification_timeout_t& timeout) {
+                if (timeout.loop_head.empty()) {
+                    timeout.loop_head = to_string(_cfg.label(_wto[index].vertex));
+                }
+                throw;
+            }
+            // The posts that flow back into the head are those of the fixpoint, so the cycle only needs to be
+            // visited again if one of its predecessors outside of it changes.
+            _dirty[_wto[index].vertex] = false;
+        } else {
+            visit_vertex(_wto[index].vertex);
+        }
+        return _wto[index].end;
+    }
 
-    void operator()(std::shared_ptr<wto_cycle_t>& cycle);
+    /// Visit the components of the cycle whose head is at the given index, starting with the head.
+    void visit_cycle_components(uint32_t index) {
+        visit_vertex(_wto[index].vertex);
+        uint32_t i = index + 1;
+        while (i < _wto[index].end) {
+            i = visit(i);
+        }
+    }
 
-    friend std::pair<invariant_table_t, invariant_table_t> run_forward_analyzer(cfg_t& cfg, const ebpf_domain_t& entry_inv, bool check_termination);
+    template <typename D>
+    friend invariant_tables_t<D> run_forward_analyzer(const flat_cfg_t& cfg, const D& entry_inv, bool check_termination,
+                                                      const visit_hooks_t<D>& hooks, const settled_blocks_t<D>& settled,
+                                                      const iteration_policy_t& policy);
 };
 
-std::pair<invariant_table_t, invariant_table_t> run_forward_analyzer(cfg_t& cfg, const ebpf_domain_t& entry_inv, bool check_termination) {
+template <typename Domain>
+invariant_tables_t<Domain> run_forward_analyzer(const flat_cfg_t& cfg, const Domain& entry_inv, bool check_termination,
+                                                const visit_hooks_t<Domain>& hooks,
+                                                const settled_blocks_t<Domain>& settled,
+                                                const iteration_policy_t& policy) {
     // Go over the CFG in weak topological order (accounting for loops).
-    constexpr unsigned int descending_iterations = 2000000;
-    interleaved_fwd_fixpoint_iterator_t analyzer(cfg, descending_iterations, check_termination);
-    analyzer.set_pre(cfg.entry_label(), entry_inv);
-    for (auto& component : analyzer._wto) {
-        std::visit(analyzer, *component);
+    interleaved_fwd_fixpoint_iterator_t<Domain> analyzer(cfg, policy, check_termination, hooks, settled);
+    analyzer.set_pre(cfg.entry(), entry_inv);
+    try {
+        for (uint32_t index = 0; index < analyzer._wto.size();) {
+            const uint32_t next = analyzer.visit(index);
+            analyzer.release_consumed_posts(index);
+            index = next;
+        }
+    } catch (verification_timeout_t& timeout) {
+        timeout.loops = to_loop_stats(cfg, analyzer._cycle_iterations);
+        throw;
+    }
+    return invariant_tables_t<Domain>(cfg, check_termination, std::move(analyzer._liveness), std::move(analyzer._pre),
+                                      std::move(analyzer._post), std::move(analyzer._cycle_iterations));
+}
+
+std::vector<loop_stats_t> to_loop_stats(const flat_cfg_t& cfg,
+                                        const std::map<block_id_t, cycle_iterations_t>& cycle_iterations) {
+    std::vector<loop_stats_t> loops;
+    for (const auto& [head, iterations] : cycle_iterations) {
+        loops.push_back(loop_stats_t{
+            .head = to_string(cfg.label(head)),
+            .ascending_iterations = (int)iterations.ascending,
+            .descending_iterations = (int)iterations.descending,
+        });
+    }
+    return loops;
+}
+
+cycle_changes_t::cycle_changes_t(const flat_cfg_t& cfg) : _enclosing_head(cfg.size()), _changed(cfg.size()) {
+    const wto_t wto(cfg);
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        _enclosing_head[id] = wto.head(id);
+    }
+}
+
+void cycle_changes_t::mark(block_id_t block) {
+    for (std::optional<block_id_t> head = block; head; head = _enclosing_head[*head]) {
+        _changed[*head] = true;
+    }
+}
+
+bool cycle_changes_t::take(block_id_t head) {
+    const bool changed = _changed[head];
+    _changed[head] = false;
+    return changed;
+}
+
+template <typename Domain>
+Domain invariant_tables_t<Domain>::get_pre(block_id_t block) const {
+    if (const std::optional<Domain>& pre = _pre[block]) {
+        return *pre;
+    }
+    if (_cfg.in_degree(block) == 0) {
+        // Not reachable from the entry.
+        return Domain::bottom();
+    }
+    // Not a join point, so the pre-invariant is the post-invariant of the only predecessor.
+    return get_post(_cfg.prev_nodes(block).front());
+}
+
+template <typename Domain>
+Domain invariant_tables_t<Domain>::get_post(block_id_t block) const {
+    if (const std::optional<Domain>& post = _post[block]) {
+        return *post;
     }
-    return std::make_pair(analyzer._pre, analyzer._post);
+    if (_last_post && _last_post->first == block) {
+        return _last_post->second;
+    }
+
+    // Walk up the chain of single-predecessor blocks to one whose pre-invariant is known.
+    std::vector<block_id_t> chain{block};
+    std::optional<Domain> inv;
+    while (!inv) {
+        const block_id_t current = chain.back();
+        if (const std::optional<Domain>& pre = _pre[current]) {
+            inv = *pre;
+            break;
+        }
+        if (_cfg.in_degree(current) == 0) {
+            inv = Domain::bottom();
+            break;
+        }
+        const block_id_t prev = _cfg.prev_nodes(current).front();
+        if (_last_post && _last_post->first == prev) {
+            inv = _last_post->second;
+            break;
+        }
+        chain.push_back(prev);
+    }
+
+    // Then run the transfer functions back down the chain.
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        (*inv)(_cfg.instructions(*it), _check_termination);
+        if (const std::optional<live_set_t>& live = _liveness.live_at_join(*it)) {
+            inv->forget_dead(*live);
+        }
+    }
+    _last_post = std::make_pair(block, *inv);
+    return std::move(*inv);
 }
 
-void interleaved_fwd_fixpoint_iterator_t::operator()(const label_t& node) {
+template <typename Domain>
+void interleaved_fwd_fixpoint_iterator_t<Domain>::visit_vertex(block_id_t node) {
     /** decide whether skip vertex or not **/
-    if (_skip && (node == _cfg.entry_label())) {
+    if (_skip && (node == _cfg.entry())) {
         _skip = false;
     }
     if (_skip) {
         return;
     }
-
-    ebpf_domain_t pre = node == _cfg.entry_label() ? get_pre(node) : join_all_prevs(node);
+    verification_context_t::current().check_deadline();
+    _dirty[node] = false;
+
+    Domain pre = Domain::bottom();
+    if (node == _cfg.entry()) {
+        pre = get_pre(node);
+    } else if (_settled.is_settled(node) && _settled.pre[node]) {
+        pre = *_settled.pre[node];
+    } else {
+        pre = join_all_prevs(node);
+    }
 
     set_pre(node, pre);
     transform_to_post(node, pre);
 }
 
-void interleaved_fwd_fixpoint_iterator_t::operator()(std::shared_ptr<wto_cycle_t>& cycle) {
-    label_t head = cycle->head();
+template <typename Domain>
+void interleaved_fwd_fixpoint_iterator_t<Domain>::visit_cycle(uint32_t index) {
+    const block_id_t head = _wto[index].vertex;
 
     /** decide whether to skip cycle or not **/
     bool entry_in_this_cycle = false;
     if (_skip) {
         // We only skip the analysis of cycle if _entry is not a
         // component of it, included nested components.
-        member_component_visitor vis(_cfg.entry_label());
-        vis(cycle);
-        entry_in_this_cycle = vis.is_member();
+        const uint32_t entry_position = _wto.position(_cfg.entry());
+        entry_in_this_cycle = index <= entry_position && entry_position < _wto[index].end;
         _skip = !entry_in_this_cycle;
         if (_skip) {
             return;
         }
     }
 
-    ebpf_domain_t pre = ebpf_domain_t::bottom();
+    if (_settled.is_settled(head)) {
+        // So are all the blocks of the cycle, and none of their pre-invariants can change.
+        visit_cycle_components(index);
+        return;
+    }
+
+    Domain pre = Domain::bottom();
     if (entry_in_this_cycle) {
-        pre = get_pre(_cfg.entry_label());
+        pre = get_pre(_cfg.entry());
     } else {
-        wto_nesting_t cycle_nesting = _wto.nesting(head);
-        for (const label_t& prev : _cfg.prev_nodes(head)) {
-            if (!(_wto.nesting(prev) > cycle_nesting)) {
+        for (block_id_t prev : _cfg.prev_nodes(head)) {
+            if (!_wto.is_nested_deeper(prev, head)) {
                 pre |= get_post(prev);
             }
         }
     }
 
+    cycle_iterations_t& iterations = _cycle_iterations[head];
     for (unsigned int iteration = 1;; ++iteration) {
         // Increasing iteration sequence with widening
+        iterations.ascending++;
         set_pre(head, pre);
         transform_to_post(head, pre);
-        for (auto& component : *cycle) {
-            std::visit(*this, *component);
-        }
-        ebpf_domain_t new_pre = join_all_prevs(head);
+        visit_cycle_components(index);
+        Domain new_pre = join_all_prevs(head);
         if (new_pre <= pre) {
-            // Post-fixpoint reached
-            set_pre(head, new_pre);
-            pre = std::move(new_pre);
+            // Post-fixpoint reached. Without narrowing, the body is not visited again, so the pre-invariant
+            // it was last visited with is the one kept; otherwise the decreasing sequence starts from new_pre.
+            if (_policy.descending_iterations > 0) {
+                set_pre(head, new_pre);
+                pre = std::move(new_pre);
+            }
             break;
         } else {
             pre = extrapolate(head, iteration, pre, new_pre);
         }
     }
 
-    if (this->_descending_iterations == 0) {
+    if (_policy.descending_iterations == 0) {
         // no narrowing
         return;
     }
 
     for (unsigned int iteration = 1;; ++iteration) {
         // Decreasing iteration sequence with narrowing
+        iterations.descending++;
         transform_to_post(head, pre);
 
-        for (auto& component : *cycle) {
-            std::visit(*this, *component);
-        }
-        ebpf_domain_t new_pre = join_all_prevs(head);
+        visit_cycle_components(index);
+        Domain new_pre = join_all_prevs(head);
         if (pre <= new_pre) {
             // No more refinement possible(pre == new_pre)
             break;
         } else {
-            if (iteration > _descending_iterations)
+            if (iteration > _policy.descending_iterations)
+                break;
+            if (_hooks.keep_refining && !_hooks.keep_refining(head))
                 break;
             pre = refine(head, iteration, pre, new_pre);
             set_pre(head, pre);
@@ -219,4 +432,15 @@ void interleaved_fwd_fixpoint_iterator_t::operator()(std::shared_ptr<wto_cycle_t
     }
 }
 
+template class invariant_tables_t<zone_domain_t>;
+template class invariant_tables_t<interval_domain_t>;
+template invariant_tables_t<zone_domain_t> run_forward_analyzer(const flat_cfg_t&, const zone_domain_t&, bool,
+                                                                const visit_hooks_t<zone_domain_t>&,
+                                                                const settled_blocks_t<zone_domain_t>&,
+                                                                const iteration_policy_t&);
+template invariant_tables_t<interval_domain_t> run_forward_analyzer(const flat_cfg_t&, const interval_domain_t&, bool,
+                                                                    const visit_hooks_t<interval_domain_t>&,
+                                                                    const settled_blocks_t<interval_domain_t>&,
+                                                                    const iteration_policy_t&);
+
 } // namespace crab
@@ -2,18 +2,137 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <functional>
 #include <map>
+#include <optional>
 #include <tuple>
+#include <vector>
 
 #include "config.hpp"
 #include "crab/cfg.hpp"
 #include "crab/ebpf_domain.hpp"
+#include "crab/liveness.hpp"
 
 namespace crab {
 
-using invariant_table_t = std::map<label_t, ebpf_domain_t>;
+/// The fixpoint iterator and the tables below work with any abstract domain that has the lattice operations and
+/// transfer functions of ebpf_domain_t, and are instantiated for the instances of ebpf_domain_t in fwd_analyzer.cpp.
 
-std::pair<invariant_table_t, invariant_table_t> run_forward_analyzer(cfg_t& cfg, const ebpf_domain_t& entry_inv,
-                                                                     bool check_termination);
+/// Invariants indexed by block id. Blocks whose invariant is not stored hold nullopt.
+template <typename Domain>
+using invariant_table_t = std::vector<std::optional<Domain>>;
+
+/// Observers of the visits made by the fixpoint iterator.
+/// Blocks in a cycle are visited at most once per iteration: those whose predecessors' post-invariants did not change
+/// since their last visit are skipped. Either way, the last visit of each block is made with its final pre-invariant.
+template <typename Domain>
+struct visit_hooks_t {
+    /// Called just before a block's transfer function is applied to its pre-invariant, e.g., to install a require check.
+    /// It must not otherwise change the pre-invariant, since invariant_tables_t recomputes the invariants it does not
+    /// store without the hooks. A require check changes nothing: the assertions only refine the invariant with
+    /// assume_assertions, and then they do so whether or not a check is installed.
+    std::function<void(block_id_t block, Domain& pre)> before;
+    /// Called with the post-invariant that the transfer function produced.
+    std::function<void(block_id_t block, const Domain& post)> after;
+    /// Called after each iteration of the decreasing sequence of the cycle with the given head. Returning false
+    /// stops the sequence, which is sound since each of its iterations over-approximates the fixpoint.
+    std::function<bool(block_id_t head)> keep_refining;
+};
+
+/// How the fixpoint iterator extrapolates and refines the pre-invariants of cycle heads.
+struct iteration_policy_t {
+    /// Number of iterations of a cycle that join the pre-invariants of its head before widening them.
+    unsigned int widening_delay{1};
+    /// Maximal number of iterations of the decreasing sequence of a cycle; 0 disables narrowing.
+    unsigned int descending_iterations{2000000};
+};
+
+/// Number of iterations of a cycle, summed over all the times it was iterated, e.g., once per iteration of an
+/// enclosing cycle.
+struct cycle_iterations_t {
+    unsigned int ascending{};
+    unsigned int descending{};
+};
+
+/// Blocks whose pre-invariant is known before the analysis, e.g., from the analysis of a previous version of the
+/// program, together with the known pre-invariants of those that have several predecessors.
+/// All the predecessors of a settled block must be settled, so that nothing the analysis computes can change its
+/// pre-invariant: each settled block is visited exactly once, and cycles of settled blocks are not iterated.
+/// A settled block with a single predecessor gets the post-invariant of that predecessor as its pre-invariant.
+template <typename Domain>
+struct settled_blocks_t {
+    std::vector<bool> settled; // Indexed by block id; empty if no block is settled.
+    invariant_table_t<Domain> pre; // Indexed by block id.
+
+    [[nodiscard]] bool is_settled(block_id_t block) const { return !settled.empty() && settled[block]; }
+};
+
+/// The invariants computed by run_forward_analyzer.
+///
+/// Only the pre-invariants of the entry, the exit, cycle heads and join points (blocks with several predecessors)
+/// are stored, as well as the post-invariant of the exit. Any other block has a single predecessor, so its
+/// pre-invariant is the post-invariant of that predecessor; these are recomputed on demand by re-running the
+/// transfer functions from the closest stored pre-invariant up the chain.
+///
+/// The post-invariant of a block that flows into a join point does not keep the registers and stack bytes
+/// that are dead there, so that the joins and the widening work on smaller domains.
+template <typename Domain>
+class invariant_tables_t final {
+    const flat_cfg_t& _cfg;
+    bool _check_termination;
+    liveness_t _liveness;
+    invariant_table_t<Domain> _pre, _post;
+    std::map<block_id_t, cycle_iterations_t> _cycle_iterations;
+
+    // The last post-invariant that was recomputed, so that visiting the blocks of a chain in order is linear.
+    mutable std::optional<std::pair<block_id_t, Domain>> _last_post;
+
+  public:
+    invariant_tables_t(const flat_cfg_t& cfg, bool check_termination, liveness_t liveness,
+                       invariant_table_t<Domain> pre, invariant_table_t<Domain> post,
+                       std::map<block_id_t, cycle_iterations_t> cycle_iterations = {})
+        : _cfg(cfg), _check_termination(check_termination), _liveness(std::move(liveness)), _pre(std::move(pre)),
+          _post(std::move(post)), _cycle_iterations(std::move(cycle_iterations)) {}
+
+    [[nodiscard]] Domain get_pre(block_id_t block) const;
+    [[nodiscard]] Domain get_post(block_id_t block) const;
+
+    [[nodiscard]] Domain get_pre(const label_t& label) const { return get_pre(_cfg.id(label)); }
+    [[nodiscard]] Domain get_post(const label_t& label) const { return get_post(_cfg.id(label)); }
+
+    /// Indexed by the heads of the cycles that were iterated; settled cycles are not.
+    [[nodiscard]] const std::map<block_id_t, cycle_iterations_t>& cycle_iterations() const {
+        return _cycle_iterations;
+    }
+};
+
+/// The iterations of each cycle, labeled by its head, in the order of the heads.
+std::vector<loop_stats_t> to_loop_stats(const flat_cfg_t& cfg,
+                                        const std::map<block_id_t, cycle_iterations_t>& cycle_iterations);
+
+/// Whether some block of each cycle changed since the head of the cycle last asked, e.g., for keep_refining.
+/// A change in a block counts for every cycle that contains it, so that refining an inner cycle, which is done on
+/// each iteration of the outer one, does not hide what refining the outer one changed.
+class cycle_changes_t final {
+    std::vector<std::optional<block_id_t>> _enclosing_head; // Indexed by block id.
+    std::vector<bool> _changed; // Indexed by the block id of the heads.
+
+  public:
+    explicit cycle_changes_t(const flat_cfg_t& cfg);
+
+    /// Records a change of the given block, which may be a head, in each cycle that contains it.
+    void mark(block_id_t block);
+
+    /// Whether the cycle with the given head changed since the last call for it.
+    bool take(block_id_t head);
+};
+
+/// Throws verification_timeout_t, with the iterations of the cycles analyzed so far, if the deadline of the
+/// verification passes or it is cancelled.
+template <typename Domain>
+invariant_tables_t<Domain> run_forward_analyzer(const flat_cfg_t& cfg, const Domain& entry_inv, bool check_termination,
+                                                const visit_hooks_t<Domain>& hooks = {},
+                                                const settled_blocks_t<Domain>& settled = {},
+                                                const iteration_policy_t& policy = {});
 
 } // namespace crab
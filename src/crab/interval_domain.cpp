@@ -0,0 +1,278 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <set>
+#include <string>
+
+#include "crab/interval_domain.hpp"
+#include "crab_utils/debug.hpp"
+
+namespace crab::domains {
+
+bool IntervalDomain::operator<=(const IntervalDomain& o) const {
+    if (is_bottom()) {
+        return true;
+    }
+    if (o.is_bottom()) {
+        return false;
+    }
+    for (const auto& [v, intv] : o._intervals) {
+        if (!(operator[](v) <= intv)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+IntervalDomain IntervalDomain::operator|(const IntervalDomain& o) const {
+    if (is_bottom()) {
+        return o;
+    }
+    if (o.is_bottom()) {
+        return *this;
+    }
+    // A variable that is missing from either operand is top in the join.
+    IntervalDomain res;
+    for (const auto& [v, intv] : _intervals) {
+        const auto it = o._intervals.find(v);
+        if (it != o._intervals.end()) {
+            res.set(v, intv | it->second);
+        }
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::widen(const IntervalDomain& o) const {
+    if (is_bottom()) {
+        return o;
+    }
+    if (o.is_bottom()) {
+        return *this;
+    }
+    IntervalDomain res;
+    for (const auto& [v, intv] : _intervals) {
+        const auto it = o._intervals.find(v);
+        if (it != o._intervals.end()) {
+            res.set(v, intv.widen(it->second));
+        }
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::widening_thresholds(const IntervalDomain& o, const iterators::thresholds_t& ts) const {
+    if (is_bottom()) {
+        return o;
+    }
+    if (o.is_bottom()) {
+        return *this;
+    }
+    IntervalDomain res;
+    for (const auto& [v, intv] : _intervals) {
+        const auto it = o._intervals.find(v);
+        if (it != o._intervals.end()) {
+            res.set(v, interval_t(intv).widening_thresholds(it->second, ts));
+        }
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::operator&(const IntervalDomain& o) const {
+    if (is_bottom() || o.is_bottom()) {
+        return bottom();
+    }
+    IntervalDomain res(*this);
+    for (const auto& [v, intv] : o._intervals) {
+        res.set(v, res[v] & intv);
+        if (res.is_bottom()) {
+            break;
+        }
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::narrow(const IntervalDomain& o) const {
+    if (is_bottom() || o.is_bottom()) {
+        return bottom();
+    }
+    // Only the infinite bounds of this operand are refined, and a variable that is top here may only be refined
+    // by the other operand.
+    IntervalDomain res(*this);
+    for (const auto& [v, intv] : o._intervals) {
+        res.set(v, res[v].narrow(intv));
+        if (res.is_bottom()) {
+            break;
+        }
+    }
+    return res;
+}
+
+void IntervalDomain::apply(arith_binop_t op, variable_t x, variable_t y, const interval_t& z) {
+    if (is_bottom()) {
+        return;
+    }
+    const interval_t yi = operator[](y);
+    switch (op) {
+    case arith_binop_t::ADD: set(x, yi + z); break;
+    case arith_binop_t::SUB: set(x, yi - z); break;
+    case arith_binop_t::MUL: set(x, yi * z); break;
+    case arith_binop_t::SDIV: set(x, yi / z); break;
+    case arith_binop_t::UDIV: set(x, yi.UDiv(z)); break;
+    case arith_binop_t::SREM: set(x, yi.SRem(z)); break;
+    case arith_binop_t::UREM: set(x, yi.URem(z)); break;
+    default: CRAB_ERROR("Intervals: unreachable");
+    }
+}
+
+void IntervalDomain::apply(bitwise_binop_t op, variable_t x, variable_t y, const interval_t& z) {
+    if (is_bottom()) {
+        return;
+    }
+    const interval_t yi = operator[](y);
+    switch (op) {
+    case bitwise_binop_t::AND: set(x, yi.And(z)); break;
+    case bitwise_binop_t::OR: set(x, yi.Or(z)); break;
+    case bitwise_binop_t::XOR: set(x, yi.Xor(z)); break;
+    case bitwise_binop_t::SHL: set(x, yi.Shl(z)); break;
+    case bitwise_binop_t::LSHR: set(x, yi.LShr(z)); break;
+    case bitwise_binop_t::ASHR: set(x, yi.AShr(z)); break;
+    default: CRAB_ERROR("Intervals: unreachable");
+    }
+}
+
+void IntervalDomain::add_leq(const linear_expression_t& e) {
+    const interval_t value = eval_interval(e);
+    if (value.is_bottom() || value.lb() > bound_t{0}) {
+        set_to_bottom();
+        return;
+    }
+    // For each variable x with coefficient c in {1, -1}, c * x <= -rest, where rest is e without c * x.
+    // Variables with other coefficients are left alone, which is sound but may lose precision.
+    for (const auto& [variable, coefficient] : e.variable_terms()) {
+        if (coefficient != 1 && coefficient != -1) {
+            continue;
+        }
+        interval_t rest{e.constant_term()};
+        for (const auto& [other, other_coefficient] : e.variable_terms()) {
+            if (other != variable) {
+                rest += other_coefficient * operator[](other);
+            }
+        }
+        const bound_t bound = -rest.lb();
+        const interval_t limit = coefficient == 1 ? interval_t(bound_t::minus_infinity(), bound)
+                                                  : interval_t(-bound, bound_t::plus_infinity());
+        set(variable, operator[](variable) & limit);
+        if (is_bottom()) {
+            return;
+        }
+    }
+}
+
+void IntervalDomain::add_disequation(const linear_expression_t& e) {
+    const interval_t value = eval_interval(e);
+    if (value.singleton() == number_t{0}) {
+        set_to_bottom();
+        return;
+    }
+    // Only c * x + k != 0 with c in {1, -1} can remove an endpoint of the interval of x.
+    if (e.variable_terms().size() != 1) {
+        return;
+    }
+    const auto& [variable, coefficient] = *e.variable_terms().begin();
+    if (coefficient != 1 && coefficient != -1) {
+        return;
+    }
+    const number_t excluded = -e.constant_term() * coefficient;
+    const interval_t intv = operator[](variable);
+    if (intv.lb() == bound_t{excluded}) {
+        set(variable, interval_t(bound_t{excluded + 1}, intv.ub()));
+    } else if (intv.ub() == bound_t{excluded}) {
+        set(variable, interval_t(intv.lb(), bound_t{excluded - 1}));
+    }
+}
+
+void IntervalDomain::operator+=(const linear_constraint_t& cst) {
+    if (is_bottom() || cst.is_tautology()) {
+        return;
+    }
+    if (cst.is_contradiction()) {
+        set_to_bottom();
+        return;
+    }
+    const linear_expression_t& e = cst.expression();
+    switch (cst.kind()) {
+    case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: add_leq(e); break;
+    // Variables are integers, so e < 0 is e + 1 <= 0.
+    case constraint_kind_t::LESS_THAN_ZERO: add_leq(e + 1); break;
+    case constraint_kind_t::EQUALS_ZERO:
+        add_leq(e);
+        if (!is_bottom()) {
+            add_leq(-e);
+        }
+        break;
+    case constraint_kind_t::NOT_ZERO: add_disequation(e); break;
+    default: CRAB_ERROR("Intervals: unreachable");
+    }
+}
+
+interval_t IntervalDomain::operator[](variable_t x) const {
+    if (is_bottom()) {
+        return interval_t::bottom();
+    }
+    const auto it = _intervals.find(x);
+    return it == _intervals.end() ? interval_t::top() : it->second;
+}
+
+void IntervalDomain::set(variable_t x, const interval_t& intv) {
+    if (is_bottom()) {
+        return;
+    }
+    if (intv.is_bottom()) {
+        set_to_bottom();
+    } else if (intv.is_top()) {
+        _intervals.erase(x);
+    } else {
+        _intervals.insert_or_assign(x, intv);
+    }
+}
+
+bool IntervalDomain::intersect(const linear_constraint_t& cst) const {
+    if (is_bottom() || cst.is_contradiction()) {
+        return false;
+    }
+    return !when(cst).is_bottom();
+}
+
+bool IntervalDomain::entail(const linear_constraint_t& rhs) const {
+    if (is_bottom() || rhs.is_tautology()) {
+        return true;
+    }
+    if (rhs.is_contradiction()) {
+        return false;
+    }
+    const interval_t value = eval_interval(rhs.expression());
+    switch (rhs.kind()) {
+    case constraint_kind_t::EQUALS_ZERO: return value.singleton() == number_t{0};
+    case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: return value.ub() <= bound_t{0};
+    case constraint_kind_t::LESS_THAN_ZERO: return value.ub() < bound_t{0};
+    case constraint_kind_t::NOT_ZERO: return !value[number_t{0}];
+    default: CRAB_ERROR("Intervals: unreachable");
+    }
+}
+
+string_invariant IntervalDomain::to_set() const {
+    if (is_bottom()) {
+        return string_invariant::bottom();
+    }
+    std::set<std::string> result;
+    for (const auto& [v, intv] : _intervals) {
+        if (std::optional<std::string> elem = bounds_to_string(v, intv)) {
+            result.insert(*elem);
+        }
+    }
+    return string_invariant{result};
+}
+
+std::ostream& operator<<(std::ostream& o, const IntervalDomain& dom) {
+    return o << dom.to_set();
+}
+
+} // namespace crab::domains
@@ -0,0 +1,199 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/container/flat_map.hpp>
+
+#include "crab/interval.hpp"
+#include "crab/linear_constraint.hpp"
+#include "crab/split_dbm.hpp"
+#include "crab/thresholds.hpp"
+#include "crab/variable.hpp"
+#include "string_constraints.hpp"
+
+namespace crab::domains {
+
+/**
+ * Non-relational domain that keeps the interval of each variable, and nothing else.
+ *
+ * It has the interface of PackedSplitDBM, so that ebpf_domain_t can be instantiated with either.
+ * A constraint between several variables only tightens the bounds of each of them by the bounds of the others,
+ * so this domain proves less than the zone domains, but each operation is linear in the number of variables
+ * that it mentions, and the lattice operations are linear in the number of variables with finite bounds.
+ */
+class IntervalDomain final {
+    using variable_vector_t = std::vector<variable_t>;
+
+    // The variables that are not top, sorted.
+    boost::container::flat_map<variable_t, interval_t> _intervals;
+    bool _is_bottom;
+
+    // Tighten the bounds of the variables of an expression e by e <= 0.
+    void add_leq(const linear_expression_t& e);
+    void add_disequation(const linear_expression_t& e);
+
+  public:
+    explicit IntervalDomain(bool is_bottom = false) : _is_bottom(is_bottom) {}
+
+    void set_to_top() { *this = IntervalDomain(false); }
+
+    void set_to_bottom() { *this = IntervalDomain(true); }
+
+    [[nodiscard]] bool is_bottom() const { return _is_bottom; }
+
+    [[nodiscard]] bool is_top() const { return !_is_bottom && _intervals.empty(); }
+
+    static IntervalDomain top() { return IntervalDomain(false); }
+
+    static IntervalDomain bottom() { return IntervalDomain(true); }
+
+    bool operator<=(const IntervalDomain& o) const;
+
+    // Top bounds are not stored, so equal domains have equal maps.
+    bool operator==(const IntervalDomain& o) const {
+        if (is_bottom() || o.is_bottom()) {
+            return is_bottom() == o.is_bottom();
+        }
+        return _intervals == o._intervals;
+    }
+
+    void operator|=(const IntervalDomain& o) { *this = *this | o; }
+
+    IntervalDomain operator|(const IntervalDomain& o) const;
+
+    [[nodiscard]] IntervalDomain widen(const IntervalDomain& o) const;
+
+    // Like widen, but a bound that grows only goes as far as the next threshold.
+    [[nodiscard]] IntervalDomain widening_thresholds(const IntervalDomain& o, const iterators::thresholds_t& ts) const;
+
+    IntervalDomain operator&(const IntervalDomain& o) const;
+
+    [[nodiscard]] IntervalDomain narrow(const IntervalDomain& o) const;
+
+    void operator-=(variable_t v) { _intervals.erase(v); }
+
+    void assign(variable_t x, const linear_expression_t& e) { set(x, eval_interval(e)); }
+
+    void assign(std::optional<variable_t> x, const linear_expression_t& e) {
+        if (x) {
+            assign(*x, e);
+        }
+    }
+    void assign(variable_t x, signed long long int n) { assign(x, linear_expression_t(n)); }
+
+    void assign(variable_t x, variable_t v) { assign(x, linear_expression_t{v}); }
+
+    void assign(variable_t x, const std::optional<linear_expression_t>& e) {
+        if (e) {
+            assign(x, *e);
+        } else {
+            *this -= x;
+        }
+    }
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, variable_t z) { apply(op, x, y, operator[](z)); }
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, const number_t& k) { apply(op, x, y, interval_t(k)); }
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, const interval_t& z);
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, variable_t z) { apply(op, x, y, operator[](z)); }
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, const number_t& k) { apply(op, x, y, interval_t(k)); }
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, const interval_t& z);
+
+    void apply(binop_t op, variable_t x, variable_t y, const number_t& z) {
+        std::visit([&](auto top) { apply(top, x, y, z); }, op);
+    }
+
+    void apply(binop_t op, variable_t x, variable_t y, variable_t z) {
+        std::visit([&](auto top) { apply(top, x, y, z); }, op);
+    }
+
+    void operator+=(const linear_constraint_t& cst);
+
+    void add_constraints(const std::vector<linear_constraint_t>& csts) {
+        for (const linear_constraint_t& cst : csts) {
+            operator+=(cst);
+        }
+    }
+
+    [[nodiscard]] IntervalDomain when(const linear_constraint_t& cst) const {
+        IntervalDomain res(*this);
+        res += cst;
+        return res;
+    }
+
+    [[nodiscard]] interval_t eval_interval(const linear_expression_t& e) const {
+        interval_t r{e.constant_term()};
+        for (const auto& [variable, coefficient] : e.variable_terms())
+            r += coefficient * operator[](variable);
+        return r;
+    }
+
+    interval_t operator[](variable_t x) const;
+
+    void set(variable_t x, const interval_t& intv);
+
+    // Set the bounds of several distinct variables at once.
+    void set(const std::vector<std::pair<variable_t, interval_t>>& bounds) {
+        for (const auto& [x, intv] : bounds) {
+            set(x, intv);
+        }
+    }
+
+    // The variables that satisfy the filter and whose bounds differ between the operands, neither of which is bottom.
+    template <typename Filter>
+    [[nodiscard]] variable_vector_t bound_differences(const IntervalDomain& o, Filter filter) const {
+        variable_vector_t res;
+        auto l = _intervals.begin();
+        auto r = o._intervals.begin();
+        while (l != _intervals.end() || r != o._intervals.end()) {
+            if (r == o._intervals.end() || (l != _intervals.end() && l->first < r->first)) {
+                if (filter(l->first)) {
+                    res.push_back(l->first);
+                }
+                ++l;
+            } else if (l == _intervals.end() || r->first < l->first) {
+                if (filter(r->first)) {
+                    res.push_back(r->first);
+                }
+                ++r;
+            } else {
+                if (l->second != r->second && filter(l->first)) {
+                    res.push_back(l->first);
+                }
+                ++l;
+                ++r;
+            }
+        }
+        return res;
+    }
+
+    void forget(const variable_vector_t& variables) {
+        for (variable_t v : variables) {
+            operator-=(v);
+        }
+    }
+
+    // Return the number of packs, vertices and edges, as PackedSplitDBM does: each variable is a pack of its own.
+    [[nodiscard]] std::tuple<std::size_t, std::size_t, std::size_t> size() const {
+        return {_intervals.size(), _intervals.size(), 0};
+    }
+
+    // Return true if inv intersects with cst.
+    [[nodiscard]] bool intersect(const linear_constraint_t& cst) const;
+
+    // Return true if entails rhs.
+    [[nodiscard]] bool entail(const linear_constraint_t& rhs) const;
+
+    friend std::ostream& operator<<(std::ostream& o, const IntervalDomain& dom);
+    [[nodiscard]] string_invariant to_set() const;
+}; // class IntervalDomain
+
+} // namespace crab::domains
@@ -0,0 +1,215 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <algorithm>
+
+#include "crab/liveness.hpp"
+
+namespace crab {
+
+// Applies the effect of one instruction on the live set, backwards: what the instruction writes
+// is no longer live before it, and what it reads is.
+class liveness_visitor_t final {
+    live_set_t& live;
+
+    void read(const Reg& reg) { live.registers.set(reg.v); }
+
+    void read(const Value& value) {
+        if (const Reg* reg = std::get_if<Reg>(&value)) {
+            read(*reg);
+        }
+    }
+
+    void write(const Reg& reg) { live.registers.reset(reg.v); }
+
+    // Byte range of an access through r10 at a constant offset, if it is within the stack.
+    static std::optional<std::pair<int, int>> stack_range(const Reg& basereg, int offset, int width) {
+        if (basereg.v != R10_STACK_POINTER) {
+            return {};
+        }
+        const int start = EBPF_STACK_SIZE + offset;
+        if (start < 0 || width <= 0 || start + width > EBPF_STACK_SIZE) {
+            return {};
+        }
+        return std::make_pair(start, width);
+    }
+
+    void read_stack(const Reg& basereg, int offset, const Value& width) {
+        if (const Imm* imm = std::get_if<Imm>(&width)) {
+            if (auto range = stack_range(basereg, offset, (int)imm->v)) {
+                for (int i = range->first; i < range->first + range->second; i++) {
+                    live.stack.set(i);
+                }
+                return;
+            }
+        }
+        live.stack.set();
+    }
+
+    void read_stack(const Deref& access) { read_stack(access.basereg, access.offset, Imm{(uint64_t)access.width}); }
+
+    void write_stack(const Deref& access) {
+        if (auto range = stack_range(access.basereg, access.offset, access.width)) {
+            for (int i = range->first; i < range->first + range->second; i++) {
+                live.stack.reset(i);
+            }
+        }
+    }
+
+  public:
+    explicit liveness_visitor_t(live_set_t& live) : live(live) {}
+
+    void operator()(const Undefined&) {}
+
+    void operator()(const Bin& bin) {
+        write(bin.dst);
+        if (bin.op != Bin::Op::MOV) {
+            read(bin.dst);
+        }
+        read(bin.v);
+    }
+
+    void operator()(const Un& un) { read(un.dst); }
+
+    void operator()(const LoadMapFd& ins) { write(ins.dst); }
+
+    void operator()(const Call& call) {
+        // The return value and the caller-saved registers are written.
+        for (uint8_t i = R0_RETURN_VALUE; i <= R5_ARG; i++) {
+            write(Reg{i});
+        }
+        for (const ArgSingle& arg : call.singles) {
+            read(arg.reg);
+        }
+        for (const ArgPair& arg : call.pairs) {
+            read(arg.mem);
+            read(arg.size);
+        }
+        live.stack.set();
+    }
+
+    void operator()(const Exit&) { read(Reg{R0_RETURN_VALUE}); }
+
+    void operator()(const Jmp& jmp) {
+        if (jmp.cond) {
+            read(jmp.cond->left);
+            read(jmp.cond->right);
+        }
+    }
+
+    void operator()(const Mem& mem) {
+        if (mem.is_load) {
+            write(std::get<Reg>(mem.value));
+            read_stack(mem.access);
+        } else {
+            write_stack(mem.access);
+            read(mem.value);
+        }
+        read(mem.access.basereg);
+    }
+
+    void operator()(const Packet& packet) {
+        // Packet access is a call that implicitly reads the context from r6.
+        for (uint8_t i = R0_RETURN_VALUE; i <= R5_ARG; i++) {
+            write(Reg{i});
+        }
+        read(Reg{R6});
+        if (packet.regoffset) {
+            read(*packet.regoffset);
+        }
+    }
+
+    void operator()(const LockAdd& ins) {
+        read_stack(ins.access);
+        read(ins.access.basereg);
+        read(ins.valreg);
+    }
+
+    void operator()(const Assume& assume) {
+        read(assume.cond.left);
+        read(assume.cond.right);
+    }
+
+    void operator()(const Assert& assertion) { std::visit(*this, assertion.cst); }
+
+    void operator()(const Comparable& s) {
+        read(s.r1);
+        read(s.r2);
+    }
+
+    void operator()(const Addable& s) {
+        read(s.ptr);
+        read(s.num);
+    }
+
+    void operator()(const ValidAccess& s) {
+        read(s.reg);
+        read(s.width);
+        read_stack(s.reg, s.offset, s.width);
+    }
+
+    void operator()(const ValidStore& s) {
+        read(s.mem);
+        read(s.val);
+    }
+
+    void operator()(const ValidSize& s) { read(s.reg); }
+
+    void operator()(const ValidMapKeyValue& s) {
+        read(s.access_reg);
+        read(s.map_fd_reg);
+        live.stack.set();
+    }
+
+    void operator()(const TypeConstraint& s) { read(s.reg); }
+
+    void operator()(const ZeroCtxOffset& s) { read(s.reg); }
+};
+
+void update_liveness(live_set_t& live, const Instruction& ins) {
+    std::visit(liveness_visitor_t{live}, ins);
+    // The stack pointer is never written, and the domain relies on knowing it.
+    live.registers.set(R10_STACK_POINTER);
+}
+
+liveness_t::liveness_t(const flat_cfg_t& cfg) : _cfg(cfg), _live_in(cfg.size()), _live_at_join(cfg.size()) {
+    // Iterate to a fixpoint, visiting the blocks backwards so that most successors are done first.
+    _live_in[cfg.exit()] = live_set_t::all();
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (block_id_t block = cfg.size(); block-- > 0;) {
+            if (block == cfg.exit()) {
+                continue;
+            }
+            live_set_t live = live_out(block);
+            const flat_cfg_t::instruction_range instructions = cfg.instructions(block);
+            for (auto it = instructions.end(); it != instructions.begin();) {
+                update_liveness(live, *--it);
+            }
+            if (live != _live_in[block]) {
+                _live_in[block] = live;
+                changed = true;
+            }
+        }
+    }
+
+    const live_set_t all = live_set_t::all();
+    for (block_id_t block = 0; block < cfg.size(); block++) {
+        const auto next = cfg.next_nodes(block);
+        if (std::any_of(next.begin(), next.end(), [&](block_id_t n) { return cfg.in_degree(n) > 1; })) {
+            live_set_t live = live_out(block);
+            if (live != all) {
+                _live_at_join[block] = live;
+            }
+        }
+    }
+}
+
+live_set_t liveness_t::live_out(block_id_t block) const {
+    live_set_t res;
+    for (block_id_t next : _cfg.next_nodes(block)) {
+        res |= _live_in[next];
+    }
+    return res;
+}
+
+} // namespace crab
@@ -0,0 +1,70 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Backward liveness of registers and stack bytes over a flat control-flow graph.
+//
+// A register or stack byte is live at a point if some path from that point may read it
+// before writing it. The analysis is conservative about memory: only loads and stores
+// through r10 at a constant offset are tracked byte by byte, while any other access that
+// may reach the stack, such as through a pointer held in another register or by a helper
+// call, reads the whole stack and writes none of it. Everything is live at the exit, since
+// the invariant there is part of the result of the verification.
+
+#include <bitset>
+#include <optional>
+#include <vector>
+
+#include "crab/cfg.hpp"
+#include "ebpf_vm_isa.hpp"
+#include "spec_type_descriptors.hpp"
+
+namespace crab {
+
+struct live_set_t {
+    // Indexed by register number.
+    std::bitset<R10_STACK_POINTER + 1> registers;
+    // Indexed by offset from the bottom of the stack, so that r10-8 is byte EBPF_STACK_SIZE-8.
+    std::bitset<EBPF_STACK_SIZE> stack;
+
+    static live_set_t all() {
+        live_set_t res;
+        res.registers.set();
+        res.stack.set();
+        return res;
+    }
+
+    void operator|=(const live_set_t& other) {
+        registers |= other.registers;
+        stack |= other.stack;
+    }
+
+    bool operator==(const live_set_t& other) const { return registers == other.registers && stack == other.stack; }
+    bool operator!=(const live_set_t& other) const { return !(*this == other); }
+};
+
+// Update the set of live registers and stack bytes after an instruction to the set before it.
+void update_liveness(live_set_t& live, const Instruction& ins);
+
+class liveness_t final {
+    const flat_cfg_t& _cfg;
+    std::vector<live_set_t> _live_in;
+    std::vector<std::optional<live_set_t>> _live_at_join;
+
+  public:
+    explicit liveness_t(const flat_cfg_t& cfg);
+
+    // Registers and stack bytes live at the start of a block.
+    [[nodiscard]] const live_set_t& live_in(block_id_t block) const { return _live_in[block]; }
+
+    // Registers and stack bytes live at the end of a block, i.e., at the start of any of its successors.
+    [[nodiscard]] live_set_t live_out(block_id_t block) const;
+
+    // If a block flows into a join point and not everything is live at its end, the registers and stack bytes
+    // that are; the others can be forgotten from its post-invariant before it is joined.
+    [[nodiscard]] const std::optional<live_set_t>& live_at_join(block_id_t block) const {
+        return _live_at_join[block];
+    }
+};
+
+} // namespace crab
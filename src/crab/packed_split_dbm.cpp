@@ -0,0 +1,717 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "crab/packed_split_dbm.hpp"
+#include "crab_utils/debug.hpp"
+#include "crab_utils/stats.hpp"
+
+namespace crab::domains {
+
+static std::vector<variable_t> variables_of(const linear_expression_t& e) {
+    std::vector<variable_t> res;
+    for (const auto& [variable, coefficient] : e.variable_terms()) {
+        res.push_back(variable);
+    }
+    return res;
+}
+
+const std::shared_ptr<PackedSplitDBM::state_t>& PackedSplitDBM::initial_state() {
+    static const std::shared_ptr<state_t> state = std::make_shared<state_t>();
+    return state;
+}
+
+PackedSplitDBM::state_t& PackedSplitDBM::mutable_state() {
+    // Cloning the state only copies the list of packs; each pack is cloned when it is modified.
+    if (_state.use_count() > 1) {
+        _state = std::make_shared<state_t>(*_state);
+    }
+    return *_state;
+}
+
+void PackedSplitDBM::remove_pack(size_t index) {
+    state_t& state = mutable_state();
+    if (index + 1 != state.packs.size()) {
+        state.packs[index] = std::move(state.packs.back());
+        for (const auto& [v, n] : state.packs[index]._state->vert_map) {
+            state.pack_of[v] = index;
+        }
+    }
+    state.packs.pop_back();
+}
+
+size_t PackedSplitDBM::merge_packs(const variable_vector_t& variables) {
+    state_t& state = mutable_state();
+    std::vector<size_t> indices;
+    for (variable_t v : variables) {
+        auto it = state.pack_of.find(v);
+        if (it != state.pack_of.end()) {
+            indices.push_back(it->second);
+        }
+    }
+    if (indices.empty()) {
+        state.packs.emplace_back();
+        return state.packs.size() - 1;
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    // Merge from the highest index down, so that removing a pack never moves one that is still to be merged.
+    const size_t target = indices.front();
+    for (auto it = indices.rbegin(); *it != target; ++it) {
+        SplitDBM& pack = state.packs[*it];
+        for (const auto& [v, n] : pack._state->vert_map) {
+            state.pack_of[v] = target;
+        }
+        state.packs[target] = SplitDBM::disjoint_union(state.packs[target], pack);
+        remove_pack(*it);
+    }
+    return target;
+}
+
+void PackedSplitDBM::update_pack(size_t index, const variable_vector_t& variables) {
+    state_t& state = mutable_state();
+    const SplitDBM& pack = state.packs[index];
+    if (pack.is_bottom()) {
+        set_to_bottom();
+        return;
+    }
+    const auto& vert_map = pack._state->vert_map;
+    for (variable_t v : variables) {
+        if (vert_map.count(v)) {
+            state.pack_of[v] = index;
+        } else {
+            state.pack_of.erase(v);
+        }
+    }
+    if (vert_map.empty()) {
+        remove_pack(index);
+    }
+}
+
+SplitDBM PackedSplitDBM::view_of(const variable_vector_t& variables) const {
+    std::set<size_t> indices;
+    for (variable_t v : variables) {
+        auto it = _state->pack_of.find(v);
+        if (it != _state->pack_of.end()) {
+            indices.insert(it->second);
+        }
+    }
+    SplitDBM res;
+    for (size_t index : indices) {
+        res = SplitDBM::disjoint_union(res, _state->packs[index]);
+    }
+    return res;
+}
+
+void PackedSplitDBM::add_packs(std::vector<SplitDBM>&& packs) {
+    auto state = std::make_shared<state_t>();
+    std::vector<std::pair<variable_t, size_t>> pack_of;
+    for (SplitDBM& pack : packs) {
+        const auto& vert_map = pack._state->vert_map;
+        if (vert_map.empty()) {
+            continue;
+        }
+        for (const auto& [v, n] : vert_map) {
+            pack_of.emplace_back(v, state->packs.size());
+        }
+        state->packs.push_back(std::move(pack));
+    }
+    std::sort(pack_of.begin(), pack_of.end());
+    state->pack_of = pack_map_t(boost::container::ordered_unique_range, pack_of.begin(), pack_of.end());
+    _state = std::move(state);
+}
+
+std::vector<PackedSplitDBM::aligned_pack_t>
+PackedSplitDBM::align(const PackedSplitDBM& o, const std::vector<variable_vector_t>& related) const {
+    const state_t& left = *_state;
+    const state_t& right = *o._state;
+    const size_t n_left = left.packs.size();
+
+    // Union-find over the packs of both operands; the packs of the right operand come after those of the left.
+    std::vector<size_t> parent(n_left + right.packs.size());
+    for (size_t i = 0; i < parent.size(); i++) {
+        parent[i] = i;
+    }
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    auto unite = [&](size_t i, size_t j) { parent[find(i)] = find(j); };
+
+    auto l = left.pack_of.begin();
+    auto r = right.pack_of.begin();
+    while (l != left.pack_of.end() && r != right.pack_of.end()) {
+        if (l->first < r->first) {
+            ++l;
+        } else if (r->first < l->first) {
+            ++r;
+        } else {
+            unite(l->second, n_left + r->second);
+            ++l;
+            ++r;
+        }
+    }
+    for (const variable_vector_t& variables : related) {
+        std::optional<size_t> first;
+        for (variable_t v : variables) {
+            for (auto [pack_of, offset] : {std::make_pair(&left.pack_of, size_t{0}), std::make_pair(&right.pack_of, n_left)}) {
+                auto it = pack_of->find(v);
+                if (it == pack_of->end()) {
+                    continue;
+                }
+                if (first) {
+                    unite(offset + it->second, *first);
+                } else {
+                    first = offset + it->second;
+                }
+            }
+        }
+    }
+
+    std::vector<aligned_pack_t> res;
+    std::map<size_t, size_t> group_of_root;
+    for (size_t i = 0; i < parent.size(); i++) {
+        auto [it, inserted] = group_of_root.try_emplace(find(i), res.size());
+        if (inserted) {
+            res.emplace_back();
+        }
+        aligned_pack_t& group = res[it->second];
+        std::optional<SplitDBM>& side = i < n_left ? group.left : group.right;
+        const SplitDBM*& side_pack = i < n_left ? group.left_pack : group.right_pack;
+        const SplitDBM& pack = i < n_left ? left.packs[i] : right.packs[i - n_left];
+        if (side) {
+            side = SplitDBM::disjoint_union(*side, pack);
+            side_pack = nullptr;
+        } else {
+            side = pack;
+            side_pack = &pack;
+        }
+    }
+    return res;
+}
+
+std::vector<PackedSplitDBM::variable_vector_t> PackedSplitDBM::bound_changes(const PackedSplitDBM& o) const {
+    // Mirrors the last step of SplitDBM's join, which relates every variable whose lower bound goes up to every
+    // other variable whose upper bound goes up, and likewise for bounds that go down.
+    variable_vector_t lb_up, lb_down, ub_up, ub_down;
+    auto l = _state->pack_of.begin();
+    auto r = o._state->pack_of.begin();
+    while (l != _state->pack_of.end() && r != o._state->pack_of.end()) {
+        if (l->first < r->first) {
+            ++l;
+        } else if (r->first < l->first) {
+            ++r;
+        } else {
+            variable_t v = l->first;
+            interval_t x = _state->packs[l->second][v];
+            interval_t y = o._state->packs[r->second][v];
+            if (x.ub().is_finite() && y.ub().is_finite()) {
+                if (x.ub() < y.ub())
+                    ub_up.push_back(v);
+                if (y.ub() < x.ub())
+                    ub_down.push_back(v);
+            }
+            if (x.lb().is_finite() && y.lb().is_finite()) {
+                if (x.lb() > y.lb())
+                    lb_down.push_back(v);
+                if (y.lb() > x.lb())
+                    lb_up.push_back(v);
+            }
+            ++l;
+            ++r;
+        }
+    }
+
+    std::vector<variable_vector_t> res;
+    for (auto [lbs, ubs] : {std::make_pair(&lb_up, &ub_up), std::make_pair(&lb_down, &ub_down)}) {
+        if (lbs->empty() || ubs->empty()) {
+            continue;
+        }
+        if (lbs->size() == 1 && ubs->size() == 1 && lbs->front() == ubs->front()) {
+            // A variable is not related to itself.
+            continue;
+        }
+        variable_vector_t related = *lbs;
+        related.insert(related.end(), ubs->begin(), ubs->end());
+        res.push_back(std::move(related));
+    }
+    return res;
+}
+
+bool PackedSplitDBM::is_top() const {
+    if (_is_bottom)
+        return false;
+    return std::all_of(_state->packs.begin(), _state->packs.end(), [](const SplitDBM& pack) { return pack.is_top(); });
+}
+
+bool PackedSplitDBM::operator<=(const PackedSplitDBM& o) const {
+    CrabStats::count("PackedSplitDBM.count.leq");
+    ScopedCrabStats __st__("PackedSplitDBM.leq");
+
+    if (is_bottom())
+        return true;
+    else if (o.is_bottom())
+        return false;
+    else if (o.is_top())
+        return true;
+    else if (is_top())
+        return false;
+    if (_state == o._state)
+        return true;
+    // Same shortcut as SplitDBM, over all the packs.
+    if (_state->pack_of.size() < o._state->pack_of.size())
+        return false;
+
+    for (const aligned_pack_t& group : align(o, {})) {
+        const std::optional<SplitDBM>& left = group.left;
+        const std::optional<SplitDBM>& right = group.right;
+        if (!right) {
+            continue;
+        }
+        if (!left) {
+            if (!right->is_top())
+                return false;
+            continue;
+        }
+        if (group.same_edges()) {
+            continue;
+        }
+        if (!left->leq_aux(*right)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PackedSplitDBM::operator==(const PackedSplitDBM& o) const {
+    CrabStats::count("PackedSplitDBM.count.eq");
+    ScopedCrabStats __st__("PackedSplitDBM.eq");
+
+    if (is_bottom() || o.is_bottom())
+        return is_bottom() == o.is_bottom();
+    if (_state == o._state)
+        return true;
+    if (_state->packs.size() == o._state->packs.size()) {
+        const std::vector<aligned_pack_t> groups = align(o, {});
+        if (std::all_of(groups.begin(), groups.end(), [](const aligned_pack_t& group) { return group.same_edges(); }))
+            return true;
+    }
+    return *this <= o && o <= *this;
+}
+
+PackedSplitDBM PackedSplitDBM::operator|(const PackedSplitDBM& o) const {
+    CrabStats::count("PackedSplitDBM.count.join");
+    ScopedCrabStats __st__("PackedSplitDBM.join");
+
+    if (is_bottom() || o.is_top())
+        return o;
+    else if (is_top() || o.is_bottom())
+        return *this;
+
+    std::vector<SplitDBM> packs;
+    for (aligned_pack_t& group : align(o, bound_changes(o))) {
+        std::optional<SplitDBM>& left = group.left;
+        std::optional<SplitDBM>& right = group.right;
+        if (!left || !right) {
+            // The join only keeps the variables of both operands.
+            continue;
+        }
+        if (group.same_edges() && !left->has_edges_weaker_than_bounds()) {
+            left->drop_unconstrained_vertices();
+            packs.push_back(std::move(*left));
+            continue;
+        }
+        for (SplitDBM& component : left->join_aux(*right).connected_components()) {
+            packs.push_back(std::move(component));
+        }
+    }
+    PackedSplitDBM res;
+    res.add_packs(std::move(packs));
+    return res;
+}
+
+PackedSplitDBM PackedSplitDBM::widen(const PackedSplitDBM& o) const {
+    CrabStats::count("PackedSplitDBM.count.widening");
+    ScopedCrabStats __st__("PackedSplitDBM.widening");
+
+    if (is_bottom())
+        return o;
+    else if (o.is_bottom())
+        return *this;
+
+    // SplitDBM restores closure over the whole graph as soon as the widening destabilizes any vertex,
+    // so in that case the packs that were not destabilized must be closed as well.
+    std::vector<SplitDBM> widened;
+    std::vector<bool> closed;
+    bool any_destabilized = false;
+    for (aligned_pack_t& group : align(o, {})) {
+        std::optional<SplitDBM>& left = group.left;
+        std::optional<SplitDBM>& right = group.right;
+        if (!left || !right) {
+            continue;
+        }
+        bool destabilized = false;
+        if (group.same_edges()) {
+            widened.push_back(std::move(*left));
+        } else {
+            widened.push_back(left->widen_aux(*right, destabilized));
+        }
+        closed.push_back(destabilized);
+        any_destabilized |= destabilized;
+    }
+    std::vector<SplitDBM> packs;
+    for (size_t i = 0; i < widened.size(); i++) {
+        if (any_destabilized && !closed[i]) {
+            widened[i].close();
+        }
+        for (SplitDBM& component : widened[i].connected_components()) {
+            packs.push_back(std::move(component));
+        }
+    }
+    PackedSplitDBM res;
+    res.add_packs(std::move(packs));
+    return res;
+}
+
+PackedSplitDBM PackedSplitDBM::operator&(const PackedSplitDBM& o) const {
+    CrabStats::count("PackedSplitDBM.count.meet");
+    ScopedCrabStats __st__("PackedSplitDBM.meet");
+
+    if (is_bottom() || o.is_bottom())
+        return bottom();
+    else if (is_top())
+        return o;
+    else if (o.is_top())
+        return *this;
+
+    std::vector<SplitDBM> packs;
+    for (aligned_pack_t& group : align(o, {})) {
+        std::optional<SplitDBM>& left = group.left;
+        std::optional<SplitDBM>& right = group.right;
+        if (!right || group.same_edges()) {
+            packs.push_back(std::move(*left));
+        } else if (!left) {
+            packs.push_back(std::move(*right));
+        } else {
+            SplitDBM pack = left->meet_aux(*right);
+            if (pack.is_bottom()) {
+                return bottom();
+            }
+            packs.push_back(std::move(pack));
+        }
+    }
+    PackedSplitDBM res;
+    res.add_packs(std::move(packs));
+    return res;
+}
+
+PackedSplitDBM PackedSplitDBM::narrow(const PackedSplitDBM& o) const {
+    if (is_bottom() || o.is_bottom())
+        return bottom();
+    else if (is_top())
+        return o;
+    // Narrowing as a no-op should be sound, as in SplitDBM.
+    return *this;
+}
+
+void PackedSplitDBM::operator-=(variable_t v) {
+    if (is_bottom())
+        return;
+    if (_state->pack_of.count(v) == 0)
+        return;
+
+    state_t& state = mutable_state();
+    auto it = state.pack_of.find(v);
+    const size_t index = it->second;
+    state.pack_of.erase(it);
+    SplitDBM& pack = state.packs[index];
+    pack -= v;
+    if (pack._state->vert_map.empty()) {
+        remove_pack(index);
+    }
+}
+
+void PackedSplitDBM::assign(variable_t x, const linear_expression_t& e) {
+    if (is_bottom())
+        return;
+
+    variable_vector_t variables = variables_of(e);
+    if (std::find(variables.begin(), variables.end(), x) == variables.end()) {
+        // The old value of x is not needed, so there is no reason to merge its pack with those of e.
+        operator-=(x);
+    }
+    variables.push_back(x);
+    const size_t index = merge_packs(variables);
+    mutable_state().packs[index].assign(x, e);
+    update_pack(index, variables);
+}
+
+void PackedSplitDBM::apply(arith_binop_t op, variable_t x, variable_t y, variable_t z) {
+    if (is_bottom())
+        return;
+    switch (op) {
+    case arith_binop_t::ADD: assign(x, linear_expression_t(y) + z); break;
+    case arith_binop_t::SUB: assign(x, linear_expression_t(y) - z); break;
+    // For the rest of operations, we fall back on intervals.
+    case arith_binop_t::MUL: set(x, operator[](y) * operator[](z)); break;
+    case arith_binop_t::SDIV: set(x, operator[](y) / operator[](z)); break;
+    case arith_binop_t::UDIV: set(x, operator[](y).UDiv(operator[](z))); break;
+    case arith_binop_t::SREM: set(x, operator[](y).SRem(operator[](z))); break;
+    case arith_binop_t::UREM: set(x, operator[](y).URem(operator[](z))); break;
+    default: CRAB_ERROR("DBM: unreachable");
+    }
+}
+
+void PackedSplitDBM::apply(arith_binop_t op, variable_t x, variable_t y, const number_t& k) {
+    if (is_bottom())
+        return;
+    switch (op) {
+    case arith_binop_t::ADD: assign(x, linear_expression_t(y) + k); break;
+    case arith_binop_t::SUB: assign(x, linear_expression_t(y) - k); break;
+    case arith_binop_t::MUL: assign(x, linear_expression_t(k, y)); break;
+    // For the rest of operations, we fall back on intervals.
+    case arith_binop_t::SDIV: set(x, operator[](y) / interval_t(k)); break;
+    case arith_binop_t::UDIV: set(x, operator[](y).UDiv(interval_t(k))); break;
+    case arith_binop_t::SREM: set(x, operator[](y).SRem(interval_t(k))); break;
+    case arith_binop_t::UREM: set(x, operator[](y).URem(interval_t(k))); break;
+    default: CRAB_ERROR("DBM: unreachable");
+    }
+}
+
+void PackedSplitDBM::apply(bitwise_binop_t op, variable_t x, variable_t y, variable_t z) {
+    // Convert to intervals and perform the operation
+    operator-=(x);
+
+    interval_t yi = operator[](y);
+    interval_t zi = operator[](z);
+    interval_t xi = interval_t::bottom();
+    switch (op) {
+    case bitwise_binop_t::AND: xi = yi.And(zi); break;
+    case bitwise_binop_t::OR: xi = yi.Or(zi); break;
+    case bitwise_binop_t::XOR: xi = yi.Xor(zi); break;
+    case bitwise_binop_t::SHL: xi = yi.Shl(zi); break;
+    case bitwise_binop_t::LSHR: xi = yi.LShr(zi); break;
+    case bitwise_binop_t::ASHR: xi = yi.AShr(zi); break;
+    default: CRAB_ERROR("DBM: unreachable");
+    }
+    set(x, xi);
+}
+
+void PackedSplitDBM::apply(bitwise_binop_t op, variable_t x, variable_t y, const number_t& k) {
+    // Convert to intervals and perform the operation
+    interval_t yi = operator[](y);
+    interval_t zi(k);
+    interval_t xi = interval_t::bottom();
+
+    switch (op) {
+    case bitwise_binop_t::AND: xi = yi.And(zi); break;
+    case bitwise_binop_t::OR: xi = yi.Or(zi); break;
+    case bitwise_binop_t::XOR: xi = yi.Xor(zi); break;
+    case bitwise_binop_t::SHL: xi = yi.Shl(zi); break;
+    case bitwise_binop_t::LSHR: xi = yi.LShr(zi); break;
+    case bitwise_binop_t::ASHR: xi = yi.AShr(zi); break;
+    default: CRAB_ERROR("DBM: unreachable");
+    }
+    set(x, xi);
+}
+
+void PackedSplitDBM::operator+=(const linear_constraint_t& cst) {
+    if (is_bottom())
+        return;
+
+    if (cst.is_tautology())
+        return;
+
+    if (cst.is_contradiction()) {
+        set_to_bottom();
+        return;
+    }
+
+    const variable_vector_t variables = variables_of(cst.expression());
+    const size_t index = merge_packs(variables);
+    mutable_state().packs[index] += cst;
+    update_pack(index, variables);
+}
+
+void PackedSplitDBM::add_constraints(const std::vector<linear_constraint_t>& csts) {
+    size_t i = 0;
+    while (i < csts.size() && !is_bottom()) {
+        if (csts[i].is_tautology() || csts[i].is_contradiction()) {
+            operator+=(csts[i++]);
+            continue;
+        }
+        variable_vector_t variables = variables_of(csts[i].expression());
+        const size_t index = merge_packs(variables);
+        std::vector<linear_constraint_t> run{csts[i]};
+        // The following constraints join the run as long as they would be added to the same pack one by one:
+        // none of their variables is in another pack, and one of them is in this pack.
+        for (i++; i < csts.size(); i++) {
+            const variable_vector_t more = variables_of(csts[i].expression());
+            bool same_pack = false;
+            bool other_pack = false;
+            for (variable_t v : more) {
+                auto it = _state->pack_of.find(v);
+                if (it != _state->pack_of.end()) {
+                    (it->second == index ? same_pack : other_pack) = true;
+                } else if (std::find(variables.begin(), variables.end(), v) != variables.end()) {
+                    same_pack = true;
+                }
+            }
+            if (!same_pack || other_pack) {
+                break;
+            }
+            variables.insert(variables.end(), more.begin(), more.end());
+            run.push_back(csts[i]);
+        }
+        mutable_state().packs[index].add_constraints(run);
+        update_pack(index, variables);
+    }
+}
+
+interval_t PackedSplitDBM::operator[](variable_t x) const {
+    if (is_bottom()) {
+        return interval_t::bottom();
+    }
+    auto it = _state->pack_of.find(x);
+    if (it == _state->pack_of.end()) {
+        return interval_t::top();
+    }
+    return _state->packs[it->second][x];
+}
+
+void PackedSplitDBM::set(variable_t x, const interval_t& intv) {
+    if (is_bottom())
+        return;
+
+    if (intv.is_bottom()) {
+        set_to_bottom();
+        return;
+    }
+
+    operator-=(x);
+
+    if (intv.is_top()) {
+        return;
+    }
+
+    // x has no relations left, so it gets a pack of its own.
+    const size_t index = merge_packs({x});
+    mutable_state().packs[index].set(x, intv);
+    update_pack(index, {x});
+}
+
+void PackedSplitDBM::set(const std::vector<std::pair<variable_t, interval_t>>& bounds) {
+    if (is_bottom())
+        return;
+
+    for (const auto& [x, intv] : bounds) {
+        if (intv.is_bottom()) {
+            set_to_bottom();
+            return;
+        }
+        operator-=(x);
+    }
+
+    // Each variable has no relations left, so it gets a pack of its own.
+    state_t& state = mutable_state();
+    for (const auto& [x, intv] : bounds) {
+        if (intv.is_top()) {
+            continue;
+        }
+        SplitDBM pack;
+        pack.set(x, intv);
+        state.pack_of.insert_or_assign(x, state.packs.size());
+        state.packs.push_back(std::move(pack));
+    }
+}
+
+void PackedSplitDBM::forget(const variable_vector_t& variables) {
+    // Not skipped when there are no relations: the variables are still in packs, as after operator-=.
+    if (is_bottom()) {
+        return;
+    }
+
+    // Each pack forgets its own variables at once.
+    state_t& state = mutable_state();
+    std::map<size_t, variable_vector_t> by_pack;
+    for (variable_t v : variables) {
+        auto it = state.pack_of.find(v);
+        if (it != state.pack_of.end()) {
+            by_pack[it->second].push_back(v);
+            state.pack_of.erase(it);
+        }
+    }
+    // Remove the emptied packs from the last one, so that a removal moves no pack that is still to be removed.
+    for (auto it = by_pack.rbegin(); it != by_pack.rend(); ++it) {
+        SplitDBM& pack = state.packs[it->first];
+        pack.forget(it->second);
+        if (pack._state->vert_map.empty()) {
+            remove_pack(it->first);
+        }
+    }
+}
+
+std::tuple<std::size_t, std::size_t, std::size_t> PackedSplitDBM::size() const {
+    std::size_t vertices = 0;
+    std::size_t edges = 0;
+    for (const SplitDBM& pack : _state->packs) {
+        auto [pack_vertices, pack_edges] = pack.size();
+        vertices += pack_vertices;
+        edges += pack_edges;
+    }
+    return {_state->packs.size(), vertices, edges};
+}
+
+bool PackedSplitDBM::intersect(const linear_constraint_t& cst) const {
+    if (is_bottom() || cst.is_contradiction())
+        return false;
+    if (is_top() || cst.is_tautology())
+        return true;
+    return view_of(variables_of(cst.expression())).intersect(cst);
+}
+
+bool PackedSplitDBM::entail(const linear_constraint_t& rhs) const {
+    if (is_bottom())
+        return true;
+    if (rhs.is_tautology())
+        return true;
+    if (rhs.is_contradiction())
+        return false;
+    return view_of(variables_of(rhs.expression())).entail(rhs);
+}
+
+SplitDBM PackedSplitDBM::to_split_dbm() const {
+    if (is_bottom()) {
+        return SplitDBM::bottom();
+    }
+    SplitDBM res;
+    for (const SplitDBM& pack : _state->packs) {
+        res = SplitDBM::disjoint_union(res, pack);
+    }
+    return res;
+}
+
+string_invariant PackedSplitDBM::to_set() const {
+    if (is_bottom()) {
+        return string_invariant::bottom();
+    }
+    std::set<std::string> result;
+    for (const SplitDBM& pack : _state->packs) {
+        string_invariant constraints = pack.to_set();
+        result.insert(constraints.value().begin(), constraints.value().end());
+    }
+    return string_invariant{result};
+}
+
+std::ostream& operator<<(std::ostream& o, const PackedSplitDBM& dom) {
+    return o << dom.to_set();
+}
+
+} // namespace crab::domains
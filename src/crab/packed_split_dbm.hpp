@@ -0,0 +1,251 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <boost/container/flat_map.hpp>
+
+#include "crab/interval.hpp"
+#include "crab/linear_constraint.hpp"
+#include "crab/split_dbm.hpp"
+#include "crab/thresholds.hpp"
+#include "crab/variable.hpp"
+#include "string_constraints.hpp"
+
+namespace crab::domains {
+
+/**
+ * Zone domain that keeps variables which are not related to each other in separate SplitDBMs, called packs.
+ *
+ * A transfer function merges the packs of the variables it mentions and then only touches that pack.
+ * The lattice operations line up the packs of both operands, work pack by pack, and skip the packs that
+ * both operands share. Joins split their result back into connected components, so packs stay small.
+ *
+ * Every operation gives the same constraints as a single SplitDBM over all the variables would.
+ * In particular, the join keeps the relations that SplitDBM derives between variables whose bounds
+ * move in the same direction, by putting such variables in the same pack before joining.
+ * The one exception is the closure that SplitDBM's join runs with possibly stale potentials: it may
+ * tighten a relation to the difference of the bounds in one representation and not in the other.
+ * Such a relation is implied by the bounds either way, so both results are equivalent.
+ */
+class PackedSplitDBM final {
+    using variable_vector_t = std::vector<variable_t>;
+    using pack_map_t = boost::container::flat_map<variable_t, size_t>;
+
+    struct state_t {
+        std::vector<SplitDBM> packs;
+        // The pack of every variable that has a vertex in one of the packs.
+        pack_map_t pack_of;
+    };
+    // Shared between copies until one of them is modified, like the state of SplitDBM.
+    std::shared_ptr<state_t> _state;
+    bool _is_bottom;
+
+    // A pack of the common partition of two operands, as seen from each of them.
+    struct aligned_pack_t {
+        std::optional<SplitDBM> left;
+        std::optional<SplitDBM> right;
+        // The pack of each operand, when the group has exactly one of them. Its structural hash is kept by the
+        // state of the operand, where later comparisons find it again, rather than by a copy.
+        const SplitDBM* left_pack{};
+        const SplitDBM* right_pack{};
+
+        // Whether both sides have the same edges, as SplitDBM::same_edges.
+        [[nodiscard]] bool same_edges() const {
+            if (left_pack && right_pack) {
+                return left_pack->same_edges(*right_pack);
+            }
+            return left && right && left->same_edges(*right);
+        }
+    };
+
+    static const std::shared_ptr<state_t>& initial_state();
+    state_t& mutable_state();
+
+    // Merge the packs of the given variables into one, and return its index.
+    size_t merge_packs(const variable_vector_t& variables);
+
+    // Record which of the given variables the pack at the given index now has, after it was modified.
+    void update_pack(size_t index, const variable_vector_t& variables);
+
+    void remove_pack(size_t index);
+
+    // A SplitDBM over the packs of the given variables, for read-only use.
+    SplitDBM view_of(const variable_vector_t& variables) const;
+
+    // Group the packs of both operands so that no variable is in two groups.
+    // Variables listed together in `related` are also put in the same group.
+    std::vector<aligned_pack_t> align(const PackedSplitDBM& o, const std::vector<variable_vector_t>& related) const;
+
+    // Variables whose lower and upper bounds move in the same direction between the operands.
+    // SplitDBM's join adds relations between them, so they must be joined in the same pack.
+    std::vector<variable_vector_t> bound_changes(const PackedSplitDBM& o) const;
+
+    void add_packs(std::vector<SplitDBM>&& packs);
+
+  public:
+    explicit PackedSplitDBM(bool is_bottom = false) : _state(initial_state()), _is_bottom(is_bottom) {}
+
+    void set_to_top() { *this = PackedSplitDBM(false); }
+
+    void set_to_bottom() { *this = PackedSplitDBM(true); }
+
+    [[nodiscard]] bool is_bottom() const { return _is_bottom; }
+
+    [[nodiscard]] bool is_top() const;
+
+    static PackedSplitDBM top() { return PackedSplitDBM(false); }
+
+    static PackedSplitDBM bottom() { return PackedSplitDBM(true); }
+
+    bool operator<=(const PackedSplitDBM& o) const;
+
+    // Inclusion both ways, decided without it when the packs of both have the same edges.
+    bool operator==(const PackedSplitDBM& o) const;
+
+    void operator|=(const PackedSplitDBM& o) { *this = *this | o; }
+
+    void operator|=(PackedSplitDBM&& o) {
+        if (is_bottom()) {
+            std::swap(*this, o);
+        } else {
+            *this = *this | o;
+        }
+    }
+
+    PackedSplitDBM operator|(const PackedSplitDBM& o) const;
+
+    [[nodiscard]] PackedSplitDBM widen(const PackedSplitDBM& o) const;
+
+    [[nodiscard]] PackedSplitDBM widening_thresholds(const PackedSplitDBM& o, const iterators::thresholds_t& ts) const {
+        // TODO: use thresholds
+        return this->widen(o);
+    }
+
+    PackedSplitDBM operator&(const PackedSplitDBM& o) const;
+
+    [[nodiscard]] PackedSplitDBM narrow(const PackedSplitDBM& o) const;
+
+    void operator-=(variable_t v);
+
+    void assign(variable_t x, const linear_expression_t& e);
+
+    void assign(std::optional<variable_t> x, const linear_expression_t& e) {
+        if (x) {
+            assign(*x, e);
+        }
+    }
+    void assign(variable_t x, signed long long int n) { assign(x, linear_expression_t(n)); }
+
+    void assign(variable_t x, variable_t v) { assign(x, linear_expression_t{v}); }
+
+    void assign(variable_t x, const std::optional<linear_expression_t>& e) {
+        if (e) {
+            assign(x, *e);
+        } else {
+            *this -= x;
+        }
+    }
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, variable_t z);
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, const number_t& k);
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, variable_t z);
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, const number_t& k);
+
+    void apply(binop_t op, variable_t x, variable_t y, const number_t& z) {
+        std::visit([&](auto top) { apply(top, x, y, z); }, op);
+    }
+
+    void apply(binop_t op, variable_t x, variable_t y, variable_t z) {
+        std::visit([&](auto top) { apply(top, x, y, z); }, op);
+    }
+
+    void operator+=(const linear_constraint_t& cst);
+
+    // Add several constraints, each run of consecutive constraints over the same pack at once.
+    void add_constraints(const std::vector<linear_constraint_t>& csts);
+
+    [[nodiscard]] PackedSplitDBM when(const linear_constraint_t& cst) const {
+        PackedSplitDBM res(*this);
+        res += cst;
+        return res;
+    }
+
+    [[nodiscard]] interval_t eval_interval(const linear_expression_t& e) const {
+        interval_t r{e.constant_term()};
+        for (const auto& [variable, coefficient] : e.variable_terms())
+            r += coefficient * operator[](variable);
+        return r;
+    }
+
+    interval_t operator[](variable_t x) const;
+
+    void set(variable_t x, const interval_t& intv);
+
+    // Set the bounds of several distinct variables at once, each of them losing its relations.
+    void set(const std::vector<std::pair<variable_t, interval_t>>& bounds);
+
+    // The variables that satisfy the filter and whose bounds differ between the operands, neither of which is bottom.
+    // Only the variables that have a vertex in one of the operands can differ, and those of a pack that both
+    // operands share cannot.
+    template <typename Filter>
+    [[nodiscard]] variable_vector_t bound_differences(const PackedSplitDBM& o, Filter filter) const {
+        variable_vector_t res;
+        if (_state == o._state) {
+            return res;
+        }
+        const pack_map_t& left = _state->pack_of;
+        const pack_map_t& right = o._state->pack_of;
+        auto l = left.begin();
+        auto r = right.begin();
+        while (l != left.end() || r != right.end()) {
+            if (r == right.end() || (l != left.end() && l->first < r->first)) {
+                if (filter(l->first) && !_state->packs[l->second][l->first].is_top()) {
+                    res.push_back(l->first);
+                }
+                ++l;
+            } else if (l == left.end() || r->first < l->first) {
+                if (filter(r->first) && !o._state->packs[r->second][r->first].is_top()) {
+                    res.push_back(r->first);
+                }
+                ++r;
+            } else {
+                const SplitDBM& left_pack = _state->packs[l->second];
+                const SplitDBM& right_pack = o._state->packs[r->second];
+                if (left_pack._state != right_pack._state && filter(l->first) &&
+                    left_pack[l->first] != right_pack[r->first]) {
+                    res.push_back(l->first);
+                }
+                ++l;
+                ++r;
+            }
+        }
+        return res;
+    }
+
+    void forget(const variable_vector_t& variables);
+
+    // Return the number of packs, vertices and edges.
+    [[nodiscard]] std::tuple<std::size_t, std::size_t, std::size_t> size() const;
+
+    // Return true if inv intersects with cst.
+    [[nodiscard]] bool intersect(const linear_constraint_t& cst) const;
+
+    // Return true if entails rhs.
+    [[nodiscard]] bool entail(const linear_constraint_t& rhs) const;
+
+    // A single SplitDBM with the constraints of all the packs.
+    [[nodiscard]] SplitDBM to_split_dbm() const;
+
+    friend std::ostream& operator<<(std::ostream& o, const PackedSplitDBM& dom);
+    [[nodiscard]] string_invariant to_set() const;
+}; // class PackedSplitDBM
+
+} // namespace crab::domains
@@ -1,15 +1,40 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: Apache-2.0
+#include <map>
 #include <utility>
 
 #include "crab/split_dbm.hpp"
 #include "crab_utils/debug.hpp"
 #include "crab_utils/stats.hpp"
 #include "string_constraints.hpp"
+#include "verification_context.hpp"
 
 namespace crab::domains {
 
+const std::shared_ptr<SplitDBM::state_t>& SplitDBM::initial_state() {
+    static const std::shared_ptr<state_t> state = [] {
+        auto res = std::make_shared<state_t>();
+        res->g.growTo(1); // Allocate the zero vector
+        res->potential.emplace_back(0);
+        res->rev_map.push_back(std::nullopt);
+        return res;
+    }();
+    return state;
+}
+
+SplitDBM::state_t& SplitDBM::mutable_state() {
+    _hash.reset();
+    // The initial state is always shared, since initial_state() keeps a reference to it.
+    if (_state.use_count() > 1) {
+        CrabStats::count("SplitDBM.count.copy");
+        ScopedCrabStats __st__("SplitDBM.copy");
+        _state = std::make_shared<state_t>(*_state);
+    }
+    return *_state;
+}
+
 SplitDBM::vert_id SplitDBM::get_vert(variable_t v) {
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
     auto it = vert_map.find(v);
     if (it != vert_map.end())
         return (*it).second;
@@ -33,6 +58,7 @@ SplitDBM::vert_id SplitDBM::get_vert(variable_t v) {
 }
 
 void SplitDBM::close_over_edge(vert_id ii, vert_id jj) {
+    graph_t& g = mutable_state().g;
     assert(ii != 0 && jj != 0);
     SubGraph<graph_t> g_excl(g, 0);
 
@@ -40,7 +66,7 @@ void SplitDBM::close_over_edge(vert_id ii, vert_id jj) {
 
     typename graph_t::mut_val_ref_t w;
 
-    std::vector<std::pair<vert_id, Weight>> src_dec;
+    arena_vector<std::pair<vert_id, Weight>> src_dec;
     for (auto edge : g_excl.e_preds(ii)) {
         vert_id se = edge.vert;
         Weight wt_sij = edge.val + c;
@@ -59,7 +85,7 @@ void SplitDBM::close_over_edge(vert_id ii, vert_id jj) {
         }
     }
 
-    std::vector<std::pair<vert_id, Weight>> dest_dec;
+    arena_vector<std::pair<vert_id, Weight>> dest_dec;
     for (auto edge : g_excl.e_succs(jj)) {
         vert_id de = edge.vert;
         Weight wt_ijd = edge.val + c;
@@ -273,6 +299,7 @@ bool SplitDBM::add_linear_leq(const linear_expression_t& exp) {
     std::vector<diffcst_t> csts;
     diffcsts_of_lin_leq(exp, csts, lbs, ubs);
 
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
     typename graph_t::mut_val_ref_t w;
     for (auto [var, n] : lbs) {
         CRAB_LOG("zones-split", std::cout << var << ">=" << n << "\n");
@@ -313,14 +340,66 @@ bool SplitDBM::add_linear_leq(const linear_expression_t& exp) {
     // Collect bounds
     // GKG: Now done in close_over_edge
 
-    edge_vector delta;
-    GrOps::close_after_assign(g, potential, 0, delta);
-    GrOps::apply_delta(g, delta);
+    close_bounds();
     // CRAB_WARN("SplitDBM::add_linear_leq not yet implemented.");
     normalize();
     return true;
 }
 
+std::optional<bool> SplitDBM::add_difference_leq(const linear_expression_t& exp) {
+    const auto& terms = exp.variable_terms();
+    if (terms.empty() || terms.size() > 2) {
+        return {};
+    }
+    std::optional<variable_t> pos, neg;
+    for (const auto& [v, n] : terms) {
+        if (n == 1 && !pos) {
+            pos = v;
+        } else if (n == -1 && !neg) {
+            neg = v;
+        } else {
+            return {};
+        }
+    }
+
+    // Give up on the same constants as diffcsts_of_lin_leq.
+    bool overflow, underflow;
+    const Weight k = -convert_NtoW(exp.constant_term(), overflow);
+    convert_NtoW(exp.constant_term() - 1, underflow);
+    if (overflow || underflow) {
+        return true;
+    }
+
+    auto& g = mutable_state().g;
+    typename graph_t::mut_val_ref_t w;
+    // pos - neg <= k is the edge from neg to pos, where vertex 0 stands for a missing variable.
+    const vert_id src = neg ? get_vert(*neg) : 0;
+    const vert_id dest = pos ? get_vert(*pos) : 0;
+    if (src == 0 || dest == 0) {
+        if (g.lookup(src, dest, &w) && w.get() <= k) {
+            return true;
+        }
+        g.set_edge(src, k, dest);
+    } else {
+        g.update_edge(src, k, dest);
+    }
+    if (!repair_potential(src, dest)) {
+        set_to_bottom();
+        return false;
+    }
+    if (src != 0 && dest != 0) {
+        close_over_edge(src, dest);
+    }
+    return true;
+}
+
+void SplitDBM::close_bounds() {
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
+    edge_vector delta;
+    GrOps::close_after_assign(g, potential, 0, delta);
+    GrOps::apply_delta(g, delta);
+}
+
 void SplitDBM::add_univar_disequation(variable_t x, const number_t& n) {
     bool overflow;
     interval_t i = get_interval(x);
@@ -328,6 +407,7 @@ void SplitDBM::add_univar_disequation(variable_t x, const number_t& n) {
     if (new_i.is_bottom()) {
         set_to_bottom();
     } else if (!new_i.is_top() && (new_i <= i)) {
+        graph_t& g = mutable_state().g;
         vert_id v = get_vert(x);
         typename graph_t::mut_val_ref_t w;
         if (new_i.lb().is_finite()) {
@@ -400,60 +480,135 @@ bool SplitDBM::operator<=(const SplitDBM& o) const {
     else {
 
         // CRAB_LOG("zones-split", std::cout << "operator<=: "<< *this<< "<=?"<< o <<"\n");
+        if (same_edges(o))
+            return true;
 
-        if (vert_map.size() < o.vert_map.size())
+        if (_state->vert_map.size() < o._state->vert_map.size())
             return false;
 
-        typename graph_t::mut_val_ref_t wx;
-        typename graph_t::mut_val_ref_t wy;
+        return leq_aux(o);
+    }
+}
 
-        // Set up a mapping from o to this.
-        std::vector<unsigned int> vert_renaming(o.g.size(), -1);
-        vert_renaming[0] = 0;
-        for (auto [v, n] : o.vert_map) {
-            if (o.g.succs(n).size() == 0 && o.g.preds(n).size() == 0)
-                continue;
+std::size_t SplitDBM::structural_hash() const {
+    if (_hash) {
+        return *_hash;
+    }
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    auto vertex_key = [&](vert_id v) -> uint64_t { return v == 0 ? ~uint64_t{0} : rev_map[v]->hash(); };
+    // The edges are summed, so that the order in which they are visited does not matter.
+    uint64_t res = 0;
+    for (vert_id s : g.verts()) {
+        const uint64_t ks = vertex_key(s) * 0x9e3779b97f4a7c15;
+        for (auto edge : g.e_succs(s)) {
+            uint64_t h = ks ^ (vertex_key(edge.vert) * 0xc2b2ae3d27d4eb4f) ^ (uint64_t)(int64_t)edge.val;
+            // The finalizer of splitmix64.
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+            res += h ^ (h >> 31);
+        }
+    }
+    _hash = (std::size_t)res;
+    return *_hash;
+}
 
-            auto it = vert_map.find(v);
-            // We can't have this <= o if we're missing some
-            // vertex.
-            if (it == vert_map.end())
+bool SplitDBM::same_edges(const SplitDBM& o) const {
+    if (is_bottom() || o.is_bottom()) {
+        return is_bottom() == o.is_bottom();
+    }
+    if (_state == o._state) {
+        return true;
+    }
+    const state_t& left = *_state;
+    const state_t& right = *o._state;
+    if (left.g.num_edges() != right.g.num_edges() || structural_hash() != o.structural_hash()) {
+        return false;
+    }
+    // The hashes may collide, so check that each edge is also in the other operand, with the same weight.
+    auto vertex_in_right = [&](vert_id v) -> std::optional<vert_id> {
+        if (v == 0) {
+            return 0;
+        }
+        auto it = right.vert_map.find(*left.rev_map[v]);
+        if (it == right.vert_map.end()) {
+            return {};
+        }
+        return it->second;
+    };
+    for (vert_id s : left.g.verts()) {
+        if (left.g.succs(s).size() == 0) {
+            continue;
+        }
+        const std::optional<vert_id> rs = vertex_in_right(s);
+        if (!rs) {
+            return false;
+        }
+        for (auto edge : left.g.e_succs(s)) {
+            const std::optional<vert_id> rd = vertex_in_right(edge.vert);
+            if (!rd) {
                 return false;
-            vert_renaming[n] = it->second;
-            // vert_renaming[(*it).second] = p.second;
+            }
+            auto w = right.g.lookup(*rs, *rd);
+            if (!w || *w != edge.val) {
+                return false;
+            }
         }
+    }
+    return true;
+}
 
-        assert(g.size() > 0);
-        // GrPerm g_perm(vert_renaming, g);
+bool SplitDBM::leq_aux(const SplitDBM& o) const {
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    const state_t& os = *o._state;
+    typename graph_t::mut_val_ref_t wx;
+    typename graph_t::mut_val_ref_t wy;
+
+    // Set up a mapping from o to this.
+    arena_vector<unsigned int> vert_renaming(os.g.size(), -1);
+    vert_renaming[0] = 0;
+    for (auto [v, n] : os.vert_map) {
+        if (os.g.succs(n).size() == 0 && os.g.preds(n).size() == 0)
+            continue;
 
-        for (vert_id ox : o.g.verts()) {
-            if (o.g.succs(ox).size() == 0)
-                continue;
+        auto it = vert_map.find(v);
+        // We can't have this <= o if we're missing some
+        // vertex.
+        if (it == vert_map.end())
+            return false;
+        vert_renaming[n] = it->second;
+        // vert_renaming[(*it).second] = p.second;
+    }
 
-            assert(vert_renaming[ox] != (unsigned)-1);
-            vert_id x = vert_renaming[ox];
-            for (auto edge : o.g.e_succs(ox)) {
-                vert_id oy = edge.vert;
-                assert(vert_renaming[oy] != (unsigned)-1);
-                vert_id y = vert_renaming[oy];
-                Weight ow = edge.val;
+    assert(g.size() > 0);
+    // GrPerm g_perm(vert_renaming, g);
 
-                if (auto w = g.lookup(x, y)) {
-                    if (w <= ow)
-                        continue;
-                }
+    for (vert_id ox : os.g.verts()) {
+        if (os.g.succs(ox).size() == 0)
+            continue;
 
-                if (auto wx = g.lookup(x, 0)) {
-                    if (auto wy = g.lookup(0, y)) {
-                        if (*wx + *wy <= ow)
-                            continue;
-                    }
+        assert(vert_renaming[ox] != (unsigned)-1);
+        vert_id x = vert_renaming[ox];
+        for (auto edge : os.g.e_succs(ox)) {
+            vert_id oy = edge.vert;
+            assert(vert_renaming[oy] != (unsigned)-1);
+            vert_id y = vert_renaming[oy];
+            Weight ow = edge.val;
+
+            if (auto w = g.lookup(x, y)) {
+                if (w <= ow)
+                    continue;
+            }
+
+            if (auto wx = g.lookup(x, 0)) {
+                if (auto wy = g.lookup(0, y)) {
+                    if (*wx + *wy <= ow)
+                        continue;
                 }
-                return false;
             }
+            return false;
         }
-        return true;
     }
+    return true;
 }
 
 SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
@@ -464,16 +619,24 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
         return o;
     else if (is_top() || o.is_bottom())
         return *this;
+    return join_aux(o);
+}
+
+SplitDBM SplitDBM::join_aux(const SplitDBM& o) const {
+    verification_context_t::current().check_deadline();
     CRAB_LOG("zones-split", std::cout << "Before join:\n"
                                       << "DBM 1\n"
                                       << *this << "\n"
                                       << "DBM 2\n"
                                       << o << "\n");
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    const state_t& os = *o._state;
+
     // Figure out the common renaming, initializing the
     // resulting potentials as we go.
-    std::vector<vert_id> perm_x;
-    std::vector<vert_id> perm_y;
-    std::vector<variable_t> perm_inv;
+    arena_vector<vert_id> perm_x;
+    arena_vector<vert_id> perm_y;
+    arena_vector<variable_t> perm_inv;
 
     std::vector<Weight> pot_rx;
     std::vector<Weight> pot_ry;
@@ -488,16 +651,16 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     out_revmap.push_back(std::nullopt);
 
     for (auto [v, n] : vert_map) {
-        auto it = o.vert_map.find(v);
+        auto it = os.vert_map.find(v);
         // Variable exists in both
-        if (it != o.vert_map.end()) {
+        if (it != os.vert_map.end()) {
             out_vmap.emplace(v, static_cast<vert_id>(perm_x.size()));
             out_revmap.push_back(v);
 
             pot_rx.push_back(potential[n] - potential[0]);
             // XXX JNL: check this out
-            // pot_ry.push_back(o.potential[p.second] - o.potential[0]);
-            pot_ry.push_back(o.potential[it->second] - o.potential[0]);
+            // pot_ry.push_back(os.potential[p.second] - os.potential[0]);
+            pot_ry.push_back(os.potential[it->second] - os.potential[0]);
             perm_inv.push_back(v);
             perm_x.push_back(n);
             perm_y.push_back(it->second);
@@ -508,8 +671,8 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     // Build the permuted view of x and y.
     assert(g.size() > 0);
     GraphPerm<const graph_t> gx(perm_x, g);
-    assert(o.g.size() > 0);
-    GraphPerm<const graph_t> gy(perm_y, o.g);
+    assert(os.g.size() > 0);
+    GraphPerm<const graph_t> gy(perm_y, os.g);
 
     // Compute the deferred relations
     graph_t g_ix_ry;
@@ -563,10 +726,10 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
 
     // Now reapply the missing independent relations.
     // Need to derive vert_ids from lb_up/lb_down, and make sure the vertices exist
-    std::vector<vert_id> lb_up;
-    std::vector<vert_id> lb_down;
-    std::vector<vert_id> ub_up;
-    std::vector<vert_id> ub_down;
+    arena_vector<vert_id> lb_up;
+    arena_vector<vert_id> lb_down;
+    arena_vector<vert_id> ub_up;
+    arena_vector<vert_id> ub_down;
 
     for (vert_id v : gx_excl.verts()) {
         if (auto wx = gx.lookup(0, v)) {
@@ -641,56 +804,65 @@ SplitDBM SplitDBM::widen(const SplitDBM& o) const {
     else if (o.is_bottom())
         return *this;
     else {
-        CRAB_LOG("zones-split", std::cout << "Before widening:\n"
-                                          << "DBM 1\n"
-                                          << *this << "\n"
-                                          << "DBM 2\n"
-                                          << o << "\n");
+        bool destabilized;
+        return widen_aux(o, destabilized);
+    }
+}
 
-        // Figure out the common renaming
-        std::vector<vert_id> perm_x;
-        std::vector<vert_id> perm_y;
-        vert_map_t out_vmap;
-        rev_map_t out_revmap;
-        std::vector<Weight> widen_pot;
-        vert_set_t widen_unstable(unstable);
-
-        assert(!potential.empty());
-        widen_pot.emplace_back(0);
-        perm_x.push_back(0);
-        perm_y.push_back(0);
-        out_revmap.push_back(std::nullopt);
-        for (auto [v, n] : vert_map) {
-            auto it = o.vert_map.find(v);
-            // Variable exists in both
-            if (it != o.vert_map.end()) {
-                out_vmap.emplace(v, static_cast<vert_id>(perm_x.size()));
-                out_revmap.push_back(v);
-
-                widen_pot.push_back(potential[n] - potential[0]);
-                perm_x.push_back(n);
-                perm_y.push_back(it->second);
-            }
-        }
+SplitDBM SplitDBM::widen_aux(const SplitDBM& o, bool& destabilized) const {
+    CRAB_LOG("zones-split", std::cout << "Before widening:\n"
+                                      << "DBM 1\n"
+                                      << *this << "\n"
+                                      << "DBM 2\n"
+                                      << o << "\n");
 
-        // Build the permuted view of x and y.
-        assert(g.size() > 0);
-        GraphPerm<const graph_t> gx(perm_x, g);
-        assert(o.g.size() > 0);
-        GraphPerm<const graph_t> gy(perm_y, o.g);
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    const state_t& os = *o._state;
 
-        // Now perform the widening
-        std::vector<vert_id> destabilized;
-        graph_t widen_g(GrOps::widen(gx, gy, destabilized));
-        for (vert_id v : destabilized)
-            widen_unstable.insert(v);
+    // Figure out the common renaming
+    arena_vector<vert_id> perm_x;
+    arena_vector<vert_id> perm_y;
+    vert_map_t out_vmap;
+    rev_map_t out_revmap;
+    std::vector<Weight> widen_pot;
+    vert_set_t widen_unstable(unstable);
 
-        SplitDBM res(std::move(out_vmap), std::move(out_revmap), std::move(widen_g), std::move(widen_pot),
-                     std::move(widen_unstable));
+    assert(!potential.empty());
+    widen_pot.emplace_back(0);
+    perm_x.push_back(0);
+    perm_y.push_back(0);
+    out_revmap.push_back(std::nullopt);
+    for (auto [v, n] : vert_map) {
+        auto it = os.vert_map.find(v);
+        // Variable exists in both
+        if (it != os.vert_map.end()) {
+            out_vmap.emplace(v, static_cast<vert_id>(perm_x.size()));
+            out_revmap.push_back(v);
 
-        CRAB_LOG("zones-split", std::cout << "Result widening:\n" << res << "\n");
-        return res;
+            widen_pot.push_back(potential[n] - potential[0]);
+            perm_x.push_back(n);
+            perm_y.push_back(it->second);
+        }
     }
+
+    // Build the permuted view of x and y.
+    assert(g.size() > 0);
+    GraphPerm<const graph_t> gx(perm_x, g);
+    assert(os.g.size() > 0);
+    GraphPerm<const graph_t> gy(perm_y, os.g);
+
+    // Now perform the widening
+    arena_vector<vert_id> destabilized_verts;
+    graph_t widen_g(GrOps::widen(gx, gy, destabilized_verts));
+    for (vert_id v : destabilized_verts)
+        widen_unstable.insert(v);
+    destabilized = !widen_unstable.empty();
+
+    SplitDBM res(std::move(out_vmap), std::move(out_revmap), std::move(widen_g), std::move(widen_pot),
+                 std::move(widen_unstable));
+
+    CRAB_LOG("zones-split", std::cout << "Result widening:\n" << res << "\n");
+    return res;
 }
 SplitDBM SplitDBM::operator&(const SplitDBM& o) const {
     CrabStats::count("SplitDBM.count.meet");
@@ -702,102 +874,111 @@ SplitDBM SplitDBM::operator&(const SplitDBM& o) const {
         return o;
     else if (o.is_top())
         return *this;
-    else {
-        CRAB_LOG("zones-split", std::cout << "Before meet:\n"
-                                          << "DBM 1\n"
-                                          << *this << "\n"
-                                          << "DBM 2\n"
-                                          << o << "\n");
+    else
+        return meet_aux(o);
+}
 
-        // We map vertices in the left operand onto a contiguous range.
-        // This will often be the identity map, but there might be gaps.
-        vert_map_t meet_verts;
-        rev_map_t meet_rev;
-
-        std::vector<vert_id> perm_x;
-        std::vector<vert_id> perm_y;
-        std::vector<Weight> meet_pi;
-        perm_x.push_back(0);
-        perm_y.push_back(0);
-        meet_pi.emplace_back(0);
-        meet_rev.push_back(std::nullopt);
-        for (auto [v, n] : vert_map) {
-            vert_id vv = static_cast<vert_id>(perm_x.size());
-            meet_verts.emplace(v, vv);
-            meet_rev.push_back(v);
+SplitDBM SplitDBM::meet_aux(const SplitDBM& o) const {
+    verification_context_t::current().check_deadline();
+    CRAB_LOG("zones-split", std::cout << "Before meet:\n"
+                                      << "DBM 1\n"
+                                      << *this << "\n"
+                                      << "DBM 2\n"
+                                      << o << "\n");
 
-            perm_x.push_back(n);
-            perm_y.push_back(-1);
-            meet_pi.push_back(potential[n] - potential[0]);
-        }
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    const state_t& os = *o._state;
+
+    // We map vertices in the left operand onto a contiguous range.
+    // This will often be the identity map, but there might be gaps.
+    vert_map_t meet_verts;
+    rev_map_t meet_rev;
 
-        // Add missing mappings from the right operand.
-        for (auto [v, n] : o.vert_map) {
-            auto it = meet_verts.find(v);
+    arena_vector<vert_id> perm_x;
+    arena_vector<vert_id> perm_y;
+    std::vector<Weight> meet_pi;
+    perm_x.push_back(0);
+    perm_y.push_back(0);
+    meet_pi.emplace_back(0);
+    meet_rev.push_back(std::nullopt);
+    for (auto [v, n] : vert_map) {
+        vert_id vv = static_cast<vert_id>(perm_x.size());
+        meet_verts.emplace(v, vv);
+        meet_rev.push_back(v);
 
-            if (it == meet_verts.end()) {
-                vert_id vv = static_cast<vert_id>(perm_y.size());
-                meet_rev.push_back(v);
+        perm_x.push_back(n);
+        perm_y.push_back(-1);
+        meet_pi.push_back(potential[n] - potential[0]);
+    }
 
-                perm_y.push_back(n);
-                perm_x.push_back(-1);
-                meet_pi.push_back(o.potential[n] - o.potential[0]);
-                meet_verts.emplace(v, vv);
-            } else {
-                perm_y[it->second] = n;
-            }
-        }
+    // Add missing mappings from the right operand.
+    for (auto [v, n] : os.vert_map) {
+        auto it = meet_verts.find(v);
+
+        if (it == meet_verts.end()) {
+            vert_id vv = static_cast<vert_id>(perm_y.size());
+            meet_rev.push_back(v);
 
-        // Build the permuted view of x and y.
-        assert(g.size() > 0);
-        GraphPerm<const graph_t> gx(perm_x, g);
-        assert(o.g.size() > 0);
-        GraphPerm<const graph_t> gy(perm_y, o.g);
-
-        // Compute the syntactic meet of the permuted graphs.
-        bool is_closed;
-        graph_t meet_g(GrOps::meet(gx, gy, is_closed));
-
-        // Compute updated potentials on the zero-enriched graph
-        // vector<Weight> meet_pi(meet_g.size());
-        // We've warm-started pi with the operand potentials
-        if (!GrOps::select_potentials(meet_g, meet_pi)) {
-            // Potentials cannot be selected -- state is infeasible.
-            return SplitDBM::bottom();
+            perm_y.push_back(n);
+            perm_x.push_back(-1);
+            meet_pi.push_back(os.potential[n] - os.potential[0]);
+            meet_verts.emplace(v, vv);
+        } else {
+            perm_y[it->second] = n;
         }
+    }
 
-        if (!is_closed) {
-            edge_vector delta;
-            SubGraph<graph_t> meet_g_excl(meet_g, 0);
-            // GrOps::close_after_meet(meet_g_excl, meet_pi, gx, gy, delta);
+    // Build the permuted view of x and y.
+    assert(g.size() > 0);
+    GraphPerm<const graph_t> gx(perm_x, g);
+    assert(os.g.size() > 0);
+    GraphPerm<const graph_t> gy(perm_y, os.g);
 
-            GrOps::close_after_meet(meet_g_excl, meet_pi, gx, gy, delta);
+    // Compute the syntactic meet of the permuted graphs.
+    bool is_closed;
+    graph_t meet_g(GrOps::meet(gx, gy, is_closed));
 
-            GrOps::apply_delta(meet_g, delta);
+    // Compute updated potentials on the zero-enriched graph
+    // vector<Weight> meet_pi(meet_g.size());
+    // We've warm-started pi with the operand potentials
+    if (!GrOps::select_potentials(meet_g, meet_pi)) {
+        // Potentials cannot be selected -- state is infeasible.
+        return SplitDBM::bottom();
+    }
 
-            // Recover updated LBs and UBs.<
+    if (!is_closed) {
+        edge_vector delta;
+        SubGraph<graph_t> meet_g_excl(meet_g, 0);
+        // GrOps::close_after_meet(meet_g_excl, meet_pi, gx, gy, delta);
 
-            delta.clear();
-            GrOps::close_after_assign(meet_g, meet_pi, 0, delta);
-            GrOps::apply_delta(meet_g, delta);
-        }
-        SplitDBM res(std::move(meet_verts), std::move(meet_rev), std::move(meet_g), std::move(meet_pi), vert_set_t());
-        CRAB_LOG("zones-split", std::cout << "Result meet:\n" << res << "\n");
-        return res;
+        GrOps::close_after_meet(meet_g_excl, meet_pi, gx, gy, delta);
+
+        GrOps::apply_delta(meet_g, delta);
+
+        // Recover updated LBs and UBs.<
+
+        delta.clear();
+        GrOps::close_after_assign(meet_g, meet_pi, 0, delta);
+        GrOps::apply_delta(meet_g, delta);
     }
+    SplitDBM res(std::move(meet_verts), std::move(meet_rev), std::move(meet_g), std::move(meet_pi), vert_set_t());
+    CRAB_LOG("zones-split", std::cout << "Result meet:\n" << res << "\n");
+    return res;
 }
 
 void SplitDBM::operator-=(variable_t v) {
     if (is_bottom())
         return;
 
+    if (_state->vert_map.count(v) == 0)
+        return;
+
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
     auto it = vert_map.find(v);
-    if (it != vert_map.end()) {
-        g.forget(it->second);
-        rev_map[it->second] = std::nullopt;
-        vert_map.erase(v);
-        normalize();
-    }
+    g.forget(it->second);
+    rev_map[it->second] = std::nullopt;
+    vert_map.erase(it);
+    normalize();
 }
 
 void SplitDBM::operator+=(const linear_constraint_t& cst) {
@@ -857,6 +1038,61 @@ void SplitDBM::operator+=(const linear_constraint_t& cst) {
     normalize();
 }
 
+void SplitDBM::add_constraints(const std::vector<linear_constraint_t>& csts) {
+    CrabStats::count("SplitDBM.count.add_constraints");
+    ScopedCrabStats __st__("SplitDBM.add_constraints");
+
+    if (is_bottom())
+        return;
+
+    // Difference constraints only add edges, and the bounds are closed once after a run of them. Any other
+    // constraint is translated according to the bounds of its variables, so they are closed before it.
+    bool bounds_closed = true;
+    auto add_leq = [&](const linear_expression_t& exp) {
+        if (std::optional<bool> satisfiable = add_difference_leq(exp)) {
+            bounds_closed = false;
+            return *satisfiable;
+        }
+        if (!bounds_closed) {
+            close_bounds();
+            bounds_closed = true;
+        }
+        return add_linear_leq(exp);
+    };
+    for (const linear_constraint_t& cst : csts) {
+        if (cst.is_tautology())
+            continue;
+        if (cst.is_contradiction()) {
+            set_to_bottom();
+            return;
+        }
+        bool satisfiable = true;
+        switch (cst.kind()) {
+        case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: satisfiable = add_leq(cst.expression()); break;
+        case constraint_kind_t::LESS_THAN_ZERO: satisfiable = add_leq(cst.expression() + 1); break;
+        case constraint_kind_t::EQUALS_ZERO:
+            satisfiable = add_leq(cst.expression()) && add_leq(-cst.expression());
+            break;
+        case constraint_kind_t::NOT_ZERO:
+            if (!bounds_closed) {
+                close_bounds();
+                bounds_closed = true;
+            }
+            add_disequation(cst.expression());
+            break;
+        }
+        if (!satisfiable) {
+            set_to_bottom();
+        }
+        if (is_bottom())
+            return;
+    }
+    if (!bounds_closed) {
+        close_bounds();
+    }
+    normalize();
+}
+
 void SplitDBM::assign(variable_t x, const linear_expression_t& e) {
     CrabStats::count("SplitDBM.count.assign");
     ScopedCrabStats __st__("SplitDBM.assign");
@@ -914,6 +1150,7 @@ void SplitDBM::assign(variable_t x, const linear_expression_t& e) {
                 return;
             }
             // Allocate a new vertex for x
+            auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
             vert_id vert = g.new_vertex();
             assert(vert <= rev_map.size());
             if (vert == rev_map.size()) {
@@ -991,9 +1228,14 @@ void SplitDBM::normalize() {
 
     // dbm_canonical(_dbm);
     // Always maintained in normal form, except for widening
-    if (unstable.empty())
+    if (_state->unstable.empty())
         return;
+    close();
+}
 
+void SplitDBM::close() {
+    verification_context_t::current().check_deadline();
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
     edge_vector delta;
     // GrOps::close_after_widen(g, potential, vert_set_wrap_t(unstable), delta);
     // GKG: Check
@@ -1026,6 +1268,7 @@ void SplitDBM::set(variable_t x, const interval_t& intv) {
     }
 
     vert_id v = get_vert(x);
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
     bool overflow;
     if (intv.ub().is_finite()) {
         Weight ub = convert_NtoW(*(intv.ub().number()), overflow);
@@ -1137,19 +1380,177 @@ void SplitDBM::apply(bitwise_binop_t op, variable_t x, variable_t y, const numbe
 }
 
 void SplitDBM::forget(const variable_vector_t& variables) {
-    if (is_bottom() || is_top()) {
+    // Not skipped when there are no edges: the variables still have vertices to free, as after operator-=.
+    if (is_bottom()) {
         return;
     }
 
-    for (auto v : variables) {
-        auto it = vert_map.find(v);
-        if (it != vert_map.end()) {
-            operator-=(v);
+    std::vector<vert_id> verts;
+    for (variable_t v : variables) {
+        auto it = _state->vert_map.find(v);
+        if (it != _state->vert_map.end()) {
+            verts.push_back(it->second);
+        }
+    }
+    if (verts.empty()) {
+        return;
+    }
+
+    // Detach all the vertices in one sweep, then rebuild the variable map once instead of erasing from it one by one.
+    auto& [vert_map, rev_map, g, potential, unstable] = mutable_state();
+    g.forget(verts);
+    for (vert_id n : verts) {
+        rev_map[n] = std::nullopt;
+    }
+    vert_map_t kept;
+    kept.reserve(vert_map.size());
+    for (const auto& [v, n] : vert_map) {
+        if (rev_map[n]) {
+            kept.emplace_hint(kept.end(), v, n);
         }
     }
+    vert_map = std::move(kept);
     normalize();
 }
 
+SplitDBM SplitDBM::disjoint_union(const SplitDBM& a, const SplitDBM& b) {
+    assert(!a.is_bottom() && !b.is_bottom());
+    if (b._state->vert_map.empty())
+        return a;
+    if (a._state->vert_map.empty())
+        return b;
+
+    SplitDBM res(a);
+    auto& [vert_map, rev_map, g, potential, unstable] = res.mutable_state();
+    const state_t& bs = *b._state;
+    assert(unstable.empty() && bs.unstable.empty());
+    std::vector<vert_id> renaming(bs.g.size(), 0);
+    for (auto [v, n] : bs.vert_map) {
+        assert(vert_map.count(v) == 0);
+        vert_id vert = res.get_vert(v);
+        potential[vert] = potential[0] + (bs.potential[n] - bs.potential[0]);
+        renaming[n] = vert;
+    }
+    for (vert_id s : bs.g.verts()) {
+        for (auto e : bs.g.e_succs(s)) {
+            g.add_edge(renaming[s], e.val, renaming[e.vert]);
+        }
+    }
+    return res;
+}
+
+std::vector<SplitDBM> SplitDBM::connected_components() const {
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    assert(!is_bottom() && unstable.empty());
+
+    std::vector<vert_id> parent(g.size());
+    for (vert_id v = 0; v < parent.size(); v++) {
+        parent[v] = v;
+    }
+    auto find = [&parent](vert_id v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    for (auto [v, n] : vert_map) {
+        for (vert_id d : g.succs(n)) {
+            if (d != 0) {
+                parent[find(n)] = find(d);
+            }
+        }
+    }
+
+    std::vector<std::vector<std::pair<variable_t, vert_id>>> components;
+    std::map<vert_id, size_t> component_of_root;
+    std::optional<size_t> unconstrained;
+    for (auto [v, n] : vert_map) {
+        size_t c;
+        if (g.succs(n).size() == 0 && g.preds(n).size() == 0) {
+            if (!unconstrained) {
+                unconstrained = components.size();
+                components.emplace_back();
+            }
+            c = *unconstrained;
+        } else {
+            auto [it, inserted] = component_of_root.try_emplace(find(n), components.size());
+            if (inserted) {
+                components.emplace_back();
+            }
+            c = it->second;
+        }
+        components[c].emplace_back(v, n);
+    }
+    if (components.size() <= 1) {
+        return {*this};
+    }
+
+    std::vector<SplitDBM> res;
+    std::vector<vert_id> renaming(g.size(), 0);
+    for (const auto& component : components) {
+        vert_map_t c_vert_map;
+        rev_map_t c_rev_map{std::nullopt};
+        std::vector<Weight> c_potential{Weight(0)};
+        for (auto [v, n] : component) {
+            auto vert = static_cast<vert_id>(c_rev_map.size());
+            renaming[n] = vert;
+            c_vert_map.emplace(v, vert);
+            c_rev_map.push_back(v);
+            c_potential.push_back(potential[n] - potential[0]);
+        }
+        graph_t c_g;
+        c_g.growTo(c_rev_map.size());
+        for (auto [v, n] : component) {
+            // Edges of a component only lead to the component itself or to the zero vertex.
+            for (auto e : g.e_succs(n)) {
+                c_g.add_edge(renaming[n], e.val, renaming[e.vert]);
+            }
+            if (auto w = g.lookup(0, n)) {
+                c_g.add_edge(0, *w, renaming[n]);
+            }
+        }
+        res.emplace_back(std::move(c_vert_map), std::move(c_rev_map), std::move(c_g), std::move(c_potential),
+                         vert_set_t());
+    }
+    return res;
+}
+
+void SplitDBM::drop_unconstrained_vertices() {
+    if (is_bottom())
+        return;
+    const state_t& state = *_state;
+    std::vector<variable_t> unconstrained;
+    for (auto [v, n] : state.vert_map) {
+        if (state.g.succs(n).size() == 0 && state.g.preds(n).size() == 0) {
+            unconstrained.push_back(v);
+        }
+    }
+    forget(unconstrained);
+}
+
+bool SplitDBM::has_edges_weaker_than_bounds() const {
+    if (is_bottom())
+        return false;
+    const graph_t& g = _state->g;
+    for (vert_id s : g.verts()) {
+        if (s == 0)
+            continue;
+        auto ws = g.lookup(s, 0);
+        if (!ws)
+            continue;
+        for (auto e : g.e_succs(s)) {
+            if (e.vert == 0)
+                continue;
+            if (auto wd = g.lookup(0, e.vert)) {
+                if (*ws + *wd < e.val)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
 static std::string to_string(variable_t vd, variable_t vs, const SafeInt64DefaultParams::Weight& w, bool eq) {
     std::stringstream elem;
     if (eq) {
@@ -1169,6 +1570,42 @@ static const std::vector<std::string> type_string = {
     "shared", "stack", "packet", "ctx", "number", "map_fd", "map_fd_program", "uninitialized"
 };
 
+std::optional<std::string> bounds_to_string(variable_t variable, const interval_t& v_out) {
+    std::stringstream elem;
+    elem << variable;
+    if (variable.is_type()) {
+        int lb = (int)v_out.lb().number().value();
+        int ub = (int)v_out.ub().number().value();
+        if (lb == ub) {
+            if (variable.is_in_stack() && lb == T_NUM) {
+                // no need to show this
+                return {};
+            }
+            elem << "=" << type_string.at(-lb);
+        } else {
+            if (v_out.is_bottom()) {
+                elem << "=_|_";
+            } else {
+                elem << " in {";
+                for (int type = lb; type <= ub; type++) {
+                    if (type > lb)
+                        elem << ", ";
+                    elem << type_string.at(-type);
+                }
+                elem << "}";
+            }
+        }
+    } else {
+        elem << "=";
+        if (v_out.lb() == v_out.ub()) {
+            elem << v_out.lb();
+        } else {
+            elem << v_out;
+        }
+    }
+    return elem.str();
+}
+
 string_invariant SplitDBM::to_set() const {
     if (this->is_bottom()) {
         return string_invariant::bottom();
@@ -1181,61 +1618,29 @@ string_invariant SplitDBM::to_set() const {
     // Intervals
 
     // Extract all the edges
-    SubGraph<const SplitDBM::graph_t> g_excl(this->g, 0);
+    const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
+    SubGraph<const SplitDBM::graph_t> g_excl(g, 0);
     for (SplitDBM::vert_id v : g_excl.verts()) {
-        if (!this->rev_map[v])
+        if (!rev_map[v])
             continue;
-        if (!this->g.elem(0, v) && !this->g.elem(v, 0))
+        if (!g.elem(0, v) && !g.elem(v, 0))
             continue;
-        interval_t v_out = interval_t(this->g.elem(v, 0) ? -number_t(this->g.edge_val(v, 0)) : bound_t::minus_infinity(),
-                                      this->g.elem(0, v) ?  number_t(this->g.edge_val(0, v)) : bound_t::plus_infinity());
-
-        variable_t variable = *(this->rev_map[v]);
-
-        std::stringstream elem;
-        elem << variable;
-        if (variable.is_type()) {
-            int lb = (int)v_out.lb().number().value();
-            int ub = (int)v_out.ub().number().value();
-            if (lb == ub) {
-                if (variable.is_in_stack() && lb == T_NUM) {
-                    // no need to show this
-                    continue;
-                }
-                elem << "=" << type_string.at(-lb);
-            } else {
-                if (v_out.is_bottom()) {
-                    elem << "=_|_";
-                } else {
-                    elem << " in {";
-                    for (int type = lb; type <= ub; type++) {
-                        if (type > lb)
-                            elem << ", ";
-                        elem << type_string.at(-type);
-                    }
-                    elem << "}";
-                }
-            }
-        } else {
-            elem << "=";
-            if (v_out.lb() == v_out.ub()) {
-                elem << v_out.lb();
-            } else {
-                elem << v_out;
-            }
+        interval_t v_out = interval_t(g.elem(v, 0) ? -number_t(g.edge_val(v, 0)) : bound_t::minus_infinity(),
+                                      g.elem(0, v) ?  number_t(g.edge_val(0, v)) : bound_t::plus_infinity());
+        if (std::optional<std::string> elem = bounds_to_string(*rev_map[v], v_out)) {
+            result.insert(*elem);
         }
-        result.insert(elem.str());
     }
 
     std::set<std::tuple<variable_t, variable_t, Weight>> diff_csts;
     for (SplitDBM::vert_id s : g_excl.verts()) {
-        if (!this->rev_map[s])
+        if (!rev_map[s])
             continue;
-        variable_t vs = *this->rev_map[s];
+        variable_t vs = *rev_map[s];
         for (SplitDBM::vert_id d : g_excl.succs(s)) {
-            if (!this->rev_map[d])
+            if (!rev_map[d])
                 continue;
-            variable_t vd = *this->rev_map[d];
+            variable_t vd = *rev_map[d];
             diff_csts.emplace(vd, vs, g_excl.edge_val(s, d));
         }
     }
@@ -1244,7 +1649,7 @@ string_invariant SplitDBM::to_set() const {
         auto dual = to_string(vs, vd, -w, false);
         if (result.count(dual)) {
             result.erase(dual);
-            result.insert(to_string(vs, vd, w, true));
+            result.insert(to_string(vd, vs, w, true));
         } else {
             result.insert(to_string(vd, vs, w, false));
         }
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <memory>
 #include <optional>
 #include <type_traits>
 #include <unordered_set>
@@ -96,6 +97,9 @@ inline SafeInt64DefaultParams::Weight convert_NtoW(const z_number& n, bool& over
     return SafeInt64DefaultParams::Weight(n);
 }
 
+// How the bounds of a variable are printed in a string invariant, or nullopt if they go without saying.
+std::optional<std::string> bounds_to_string(variable_t variable, const interval_t& bounds);
+
 class SplitDBM final {
   private:
     using variable_vector_t = std::vector<variable_t>;
@@ -119,12 +123,25 @@ class SplitDBM final {
     // Domain data
     //================
     // GKG: ranges are now maintained in the graph
-    vert_map_t vert_map; // Mapping from variables to vertices
-    rev_map_t rev_map;
-    graph_t g;                 // The underlying relation graph
-    std::vector<Weight> potential; // Stored potential for the vertex
-    vert_set_t unstable;
+    struct state_t {
+        vert_map_t vert_map; // Mapping from variables to vertices
+        rev_map_t rev_map;
+        graph_t g;                 // The underlying relation graph
+        std::vector<Weight> potential; // Stored potential for the vertex
+        vert_set_t unstable;
+    };
+    // Copies share the state until one of them is modified, so copying a SplitDBM is O(1).
+    // Every non-const member function must go through mutable_state() before writing to it.
+    std::shared_ptr<state_t> _state;
     bool _is_bottom;
+    // The structural hash of the state, computed when first needed and dropped by mutable_state().
+    mutable std::optional<std::size_t> _hash;
+
+    // The state of top and bottom, shared by every fresh SplitDBM.
+    static const std::shared_ptr<state_t>& initial_state();
+
+    // Give this SplitDBM its own copy of the state, if it is shared, and return it.
+    state_t& mutable_state();
 
     vert_id get_vert(variable_t v);
 
@@ -138,6 +155,7 @@ class SplitDBM final {
 
     // Evaluate the potential value of a variable.
     Weight pot_value(variable_t v) const {
+        const auto& [vert_map, rev_map, g, potential, unstable] = *_state;
         auto it = vert_map.find(v);
         if (it != vert_map.end())
             return potential[(*it).second];
@@ -156,7 +174,7 @@ class SplitDBM final {
             if (overflow) {
                 return Weight(0);
             }
-            res += (pot_value(variable) - potential[0]) * coef;
+            res += (pot_value(variable) - _state->potential[0]) * coef;
         }
         return res;
     }
@@ -213,6 +231,13 @@ class SplitDBM final {
 
     bool add_linear_leq(const linear_expression_t& exp);
 
+    // If exp <= 0 is x - y <= k, x <= k or -x <= k, add its edge, whose weight does not depend on the bounds of the
+    // variables, and tell whether the DBM is still satisfiable. The bounds are left to be closed by close_bounds().
+    std::optional<bool> add_difference_leq(const linear_expression_t& exp);
+
+    // Restore the bounds of all variables after edges were added.
+    void close_bounds();
+
     // x != n
     void add_univar_disequation(variable_t x, const number_t& n);
 
@@ -227,7 +252,7 @@ class SplitDBM final {
         normalize();
     }
 
-    interval_t get_interval(variable_t x) const { return get_interval(vert_map, g, x); }
+    interval_t get_interval(variable_t x) const { return get_interval(_state->vert_map, _state->g, x); }
 
     static interval_t get_interval(const vert_map_t& m, const graph_t& r, variable_t x) {
         auto it = m.find(x);
@@ -241,31 +266,62 @@ class SplitDBM final {
     }
 
     // Restore potential after an edge addition
-    bool repair_potential(vert_id src, vert_id dest) { return GrOps::repair_potential(g, potential, src, dest); }
+    bool repair_potential(vert_id src, vert_id dest) {
+        state_t& s = mutable_state();
+        return GrOps::repair_potential(s.g, s.potential, src, dest);
+    }
 
     // Restore closure after a single edge addition
     void close_over_edge(vert_id ii, vert_id jj);
 
+    // The lattice operations, without the shortcuts for top and bottom.
+    // Both operands must be non-bottom.
+    bool leq_aux(const SplitDBM& o) const;
+    SplitDBM join_aux(const SplitDBM& o) const;
+    SplitDBM meet_aux(const SplitDBM& o) const;
+    // Also tell whether the widening left any vertex to be closed by normalize().
+    SplitDBM widen_aux(const SplitDBM& o, bool& destabilized) const;
+
+    // Restore closure as normalize() does after a widening, even if no vertex is unstable.
+    void close();
+
+    // Helpers for PackedSplitDBM, which keeps unrelated variables in separate SplitDBMs.
+    friend class PackedSplitDBM;
+
+    // Combine two SplitDBMs over disjoint sets of variables.
+    static SplitDBM disjoint_union(const SplitDBM& a, const SplitDBM& b);
+
+    // Split into the connected components of the relation graph, ignoring the zero vertex.
+    // Vertices without any edge are grouped into a component of their own.
+    std::vector<SplitDBM> connected_components() const;
+
+    // Forget the vertices that have no edge, as the join does.
+    void drop_unconstrained_vertices();
+
+    // A hash of the edges, in terms of the variables at their ends, so that it does not depend on the vertices.
+    std::size_t structural_hash() const;
+
+    // Whether both have the same edges between the same variables, which makes them equal.
+    // Sharing the state, or having different numbers of edges or different hashes, decides it without a walk.
+    bool same_edges(const SplitDBM& o) const;
+
+    // Whether some relation between two variables is weaker than what their bounds imply.
+    // The join tightens such relations even when both operands are the same.
+    bool has_edges_weaker_than_bounds() const;
+
   public:
-    explicit SplitDBM(bool is_bottom = false) : _is_bottom(is_bottom) {
-        g.growTo(1); // Allocate the zero vector
-        potential.emplace_back(0);
-        rev_map.push_back(std::nullopt);
-    }
+    explicit SplitDBM(bool is_bottom = false) : _state(initial_state()), _is_bottom(is_bottom) {}
 
-    // FIXME: Rewrite to avoid copying if o is _|_
     SplitDBM(vert_map_t&& _vert_map, rev_map_t&& _rev_map, graph_t&& _g, std::vector<Weight>&& _potential,
              vert_set_t&& _unstable)
-        : vert_map(std::move(_vert_map)), rev_map(std::move(_rev_map)), g(std::move(_g)),
-          potential(std::move(_potential)), unstable(std::move(_unstable)), _is_bottom(false) {
-
-        CrabStats::count("SplitDBM.count.copy");
-        ScopedCrabStats __st__("SplitDBM.copy");
+        : _state(std::make_shared<state_t>(state_t{std::move(_vert_map), std::move(_rev_map), std::move(_g),
+                                                   std::move(_potential), std::move(_unstable)})),
+          _is_bottom(false) {
 
         CRAB_LOG("zones-split-size", auto p = size();
                  std::cout << "#nodes = " << p.first << " #edges=" << p.second << "\n";);
 
-        assert(g.size() > 0);
+        assert(_state->g.size() > 0);
         normalize();
     }
 
@@ -294,7 +350,7 @@ class SplitDBM final {
     bool is_top() const {
         if (_is_bottom)
             return false;
-        return g.is_empty();
+        return _state->g.is_empty();
     }
 
     bool operator<=(const SplitDBM& o) const;
@@ -385,6 +441,9 @@ class SplitDBM final {
 
     void operator+=(const linear_constraint_t& cst);
 
+    // Add several constraints, closing the bounds once for each run of difference constraints.
+    void add_constraints(const std::vector<linear_constraint_t>& csts);
+
     SplitDBM when(const linear_constraint_t& cst) const {
         SplitDBM res(*this);
         res += cst;
@@ -402,7 +461,7 @@ class SplitDBM final {
         if (is_bottom()) {
             return interval_t::bottom();
         } else {
-            return get_interval(vert_map, g, x);
+            return get_interval(_state->vert_map, _state->g, x);
         }
     }
 
@@ -415,7 +474,7 @@ class SplitDBM final {
     // -- end array_sgraph_domain_helper_traits
 
     // return number of vertices and edges
-    std::pair<std::size_t, std::size_t> size() const { return {g.size(), g.num_edges()}; }
+    std::pair<std::size_t, std::size_t> size() const { return {_state->g.size(), _state->g.num_edges()}; }
 
   private:
     bool entail_aux(const linear_constraint_t& cst) const {
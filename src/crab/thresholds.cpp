@@ -1,5 +1,8 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <iterator>
+
 #include "crab/thresholds.hpp"
 #include "crab/cfg.hpp"
 
@@ -35,6 +38,16 @@ void thresholds_t::add(bound_t v1) {
     }
 }
 
+bound_t thresholds_t::get_next(const bound_t& v) const {
+    // The thresholds are sorted and end with +oo.
+    return *std::lower_bound(m_thresholds.begin(), m_thresholds.end(), v);
+}
+
+bound_t thresholds_t::get_prev(const bound_t& v) const {
+    // The thresholds are sorted and start with -oo.
+    return *std::prev(std::upper_bound(m_thresholds.begin(), m_thresholds.end(), v));
+}
+
 std::ostream& operator<<(std::ostream& o, const thresholds_t& t) {
     o << "{";
     for (typename std::vector<bound_t>::const_iterator it = t.m_thresholds.begin(), et = t.m_thresholds.end(); it != et;) {
@@ -48,50 +61,60 @@ std::ostream& operator<<(std::ostream& o, const thresholds_t& t) {
     return o;
 }
 
-void wto_thresholds_t::get_thresholds(const basic_block_t& bb, thresholds_t& thresholds) const {
+void wto_thresholds_t::get_thresholds(const flat_cfg_t::instruction_range& block, thresholds_t& thresholds) const {
 
 }
 
-void wto_thresholds_t::operator()(const label_t& vertex) {
+void wto_thresholds_t::operator()(block_id_t vertex) {
     if (m_stack.empty())
         return;
 
-    label_t head = m_stack.back();
+    block_id_t head = m_stack.back();
     auto it = m_head_to_thresholds.find(head);
     if (it != m_head_to_thresholds.end()) {
         thresholds_t& thresholds = it->second;
-        basic_block_t& bb = m_cfg.get_node(vertex);
-        get_thresholds(bb, thresholds);
+        get_thresholds(m_cfg.instructions(vertex), thresholds);
     } else {
         CRAB_ERROR("No head found while gathering thresholds");
     }
 }
 
-void wto_thresholds_t::operator()(std::shared_ptr<wto_cycle_t>& cycle) {
+void wto_thresholds_t::enter_cycle(block_id_t head) {
     thresholds_t thresholds(m_max_size);
-    auto& bb = m_cfg.get_node(cycle->head());
-    get_thresholds(bb, thresholds);
+    get_thresholds(m_cfg.instructions(head), thresholds);
 
     // XXX: if we want to consider constants from loop
     // initializations
-    for (auto pre : boost::make_iterator_range(bb.prev_blocks())) {
-        if (pre != cycle->head()) {
-            auto& pred_bb = m_cfg.get_node(pre);
-            get_thresholds(pred_bb, thresholds);
+    for (block_id_t pre : m_cfg.prev_nodes(head)) {
+        if (pre != head) {
+            get_thresholds(m_cfg.instructions(pre), thresholds);
         }
     }
 
-    m_head_to_thresholds.insert(std::make_pair(cycle->head(), thresholds));
-    m_stack.push_back(cycle->head());
-    for (auto& component : *cycle) {
-        std::visit(*this, *component);
+    m_head_to_thresholds.insert(std::make_pair(head, thresholds));
+    m_stack.push_back(head);
+}
+
+void wto_thresholds_t::operator()(const wto_t& wto) {
+    // The ends of the cycles that m_stack holds the heads of.
+    std::vector<uint32_t> ends;
+    for (uint32_t index = 0; index < wto.size(); index++) {
+        for (; !ends.empty() && ends.back() == index; ends.pop_back()) {
+            m_stack.pop_back();
+        }
+        const wto_entry_t& entry = wto[index];
+        if (entry.is_head) {
+            enter_cycle(entry.vertex);
+            ends.push_back(entry.end);
+        }
+        (*this)(entry.vertex);
     }
-    m_stack.pop_back();
+    m_stack.clear();
 }
 
 std::ostream& operator<<(std::ostream& o, const wto_thresholds_t& t) {
-    for (auto& [label, th] : t.m_head_to_thresholds) {
-        o << label << "=" << th << "\n";
+    for (auto& [head, th] : t.m_head_to_thresholds) {
+        o << t.m_cfg.label(head) << "=" << th << "\n";
     }
     return o;
 }
@@ -39,6 +39,10 @@ class thresholds_t final {
 
     void add(bound_t v1);
 
+    // The smallest threshold that is at least v, and the largest that is at most v.
+    [[nodiscard]] bound_t get_next(const bound_t& v) const;
+    [[nodiscard]] bound_t get_prev(const bound_t& v) const;
+
     friend std::ostream& operator<<(std::ostream& o, const thresholds_t& t);
 };
 
@@ -48,22 +52,25 @@ class thresholds_t final {
 class wto_thresholds_t final {
   private:
     // the cfg
-    cfg_t& m_cfg;
+    const flat_cfg_t& m_cfg;
     // maximum number of thresholds
     size_t m_max_size;
     // keep a set of thresholds per wto head
-    std::map<label_t, thresholds_t> m_head_to_thresholds;
+    std::map<block_id_t, thresholds_t> m_head_to_thresholds;
     // the top of the stack is the current wto head
-    std::vector<label_t> m_stack;
+    std::vector<block_id_t> m_stack;
+
+    void get_thresholds(const flat_cfg_t::instruction_range& block, thresholds_t& thresholds) const;
 
-    void get_thresholds(const basic_block_t& bb, thresholds_t& thresholds) const;
+    void enter_cycle(block_id_t head);
 
   public:
-    wto_thresholds_t(cfg_t& cfg, size_t max_size) : m_cfg(cfg), m_max_size(max_size) {}
+    wto_thresholds_t(const flat_cfg_t& cfg, size_t max_size) : m_cfg(cfg), m_max_size(max_size) {}
 
-    void operator()(const label_t& vertex);
+    // Collect the thresholds of every cycle of the wto.
+    void operator()(const wto_t& wto);
 
-    void operator()(std::shared_ptr<wto_cycle_t>& cycle);
+    void operator()(block_id_t vertex);
 
     friend std::ostream& operator<<(std::ostream& o, const wto_thresholds_t& t);
 
@@ -0,0 +1,93 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// This file is eBPF-specific, not derived from CRAB.
+
+#include <cstdint>
+#include <optional>
+
+#include "crab/interval.hpp"
+#include "crab/split_dbm.hpp"
+
+namespace crab {
+
+/// A set of the types of type_encoding_t, one bit per type.
+///
+/// The types of a register or a stack cell are tracked as the value of its type variable in the numeric domain,
+/// where the relations between the types of several of them can be kept, so this is only a view of the interval of
+/// that value. Reading it once makes the type queries, and the case splits over the types, bit operations rather than
+/// numeric domain operations.
+class type_set_t final {
+    uint8_t _bits{};
+
+    explicit constexpr type_set_t(uint8_t bits) : _bits(bits) {}
+
+    static constexpr uint8_t bit(int type) { return (uint8_t)(1u << (type - T_UNINIT)); }
+
+  public:
+    constexpr type_set_t() = default;
+
+    static constexpr type_set_t of(type_encoding_t type) { return type_set_t(bit(type)); }
+
+    /// The types from lb to ub, both included.
+    static constexpr type_set_t range(type_encoding_t lb, type_encoding_t ub) {
+        uint8_t bits = 0;
+        for (int type = lb; type <= ub; type++) {
+            bits |= bit(type);
+        }
+        return type_set_t(bits);
+    }
+
+    static constexpr type_set_t all() { return range(T_UNINIT, T_SHARED); }
+
+    /// The types in an interval of type values. Values that encode no type are not types of anything.
+    static type_set_t of(const interval_t& types) {
+        if (types.is_bottom()) {
+            return {};
+        }
+        const bound_t lb = std::max(types.lb(), bound_t{number_t{T_UNINIT}});
+        const bound_t ub = std::min(types.ub(), bound_t{number_t{T_SHARED}});
+        if (ub < lb) {
+            return {};
+        }
+        return range((type_encoding_t)(int)*lb.number(), (type_encoding_t)(int)*ub.number());
+    }
+
+    [[nodiscard]] constexpr bool contains(type_encoding_t type) const { return (_bits & bit(type)) != 0; }
+
+    [[nodiscard]] constexpr bool is_empty() const { return _bits == 0; }
+
+    /// The only type of the set, if it has exactly one.
+    [[nodiscard]] std::optional<type_encoding_t> singleton() const {
+        if (_bits == 0 || (_bits & (_bits - 1)) != 0) {
+            return {};
+        }
+        for (int type = T_UNINIT; type <= T_SHARED; type++) {
+            if (_bits == bit(type)) {
+                return (type_encoding_t)type;
+            }
+        }
+        return {};
+    }
+
+    constexpr bool operator<=(type_set_t o) const { return (_bits & ~o._bits) == 0; }
+    constexpr bool operator==(type_set_t o) const { return _bits == o._bits; }
+    constexpr bool operator!=(type_set_t o) const { return _bits != o._bits; }
+    constexpr type_set_t operator|(type_set_t o) const { return type_set_t((uint8_t)(_bits | o._bits)); }
+    constexpr type_set_t operator&(type_set_t o) const { return type_set_t((uint8_t)(_bits & o._bits)); }
+    /// The types of this set that are not in the other.
+    constexpr type_set_t operator-(type_set_t o) const { return type_set_t((uint8_t)(_bits & ~o._bits)); }
+
+    /// Call f with each type of the set, in increasing order.
+    template <typename F>
+    void for_each(F f) const {
+        for (int type = T_UNINIT; type <= T_SHARED; type++) {
+            if (contains((type_encoding_t)type)) {
+                f((type_encoding_t)type);
+            }
+        }
+    }
+};
+
+} // namespace crab
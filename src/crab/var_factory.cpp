@@ -4,39 +4,128 @@
  * Factories for variable names.
  */
 
+#include <sstream>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+
 #include "crab/variable.hpp"
+#include "verification_context.hpp"
 
 namespace crab {
 
-variable_t variable_t::make(const std::string& name) {
-    auto it = std::find(names.begin(), names.end(), name);
-    if (it == names.end()) {
-        names.emplace_back(name);
-        return variable_t(names.size() - 1);
-    } else {
-        return variable_t(std::distance(names.begin(), it));
+namespace {
+
+constexpr int NUM_REGISTERS = 11;
+constexpr int NUM_KINDS = 9;
+
+// Position of each data kind within a register's block of ids.
+// Follows the historical name order: value, ctx_offset, map_fd, packet_offset, shared_offset,
+// stack_offset, type, shared_region_size, stack_numeric_size.
+constexpr index_t reg_slot(data_kind_t kind) {
+    switch (kind) {
+    case data_kind_t::values: return 0;
+    case data_kind_t::ctx_offsets: return 1;
+    case data_kind_t::map_fds: return 2;
+    case data_kind_t::packet_offsets: return 3;
+    case data_kind_t::shared_offsets: return 4;
+    case data_kind_t::stack_offsets: return 5;
+    case data_kind_t::types: return 6;
+    case data_kind_t::shared_region_sizes: return 7;
+    case data_kind_t::stack_numeric_sizes: return 8;
     }
+    return 0;
 }
 
-thread_local std::vector<std::string> variable_t::names;
-
-void variable_t::clear_thread_local_state() {
-    names = std::vector<std::string>{
-        "r0.value", "r0.ctx_offset", "r0.map_fd", "r0.packet_offset", "r0.shared_offset", "r0.stack_offset", "r0.type", "r0.shared_region_size", "r0.stack_numeric_size",
-        "r1.value", "r1.ctx_offset", "r1.map_fd", "r1.packet_offset", "r1.shared_offset", "r1.stack_offset", "r1.type", "r1.shared_region_size", "r1.stack_numeric_size",
-        "r2.value", "r2.ctx_offset", "r2.map_fd", "r2.packet_offset", "r2.shared_offset", "r2.stack_offset", "r2.type", "r2.shared_region_size", "r2.stack_numeric_size",
-        "r3.value", "r3.ctx_offset", "r3.map_fd", "r3.packet_offset", "r3.shared_offset", "r3.stack_offset", "r3.type", "r3.shared_region_size", "r3.stack_numeric_size",
-        "r4.value", "r4.ctx_offset", "r4.map_fd", "r4.packet_offset", "r4.shared_offset", "r4.stack_offset", "r4.type", "r4.shared_region_size", "r4.stack_numeric_size",
-        "r5.value", "r5.ctx_offset", "r5.map_fd", "r5.packet_offset", "r5.shared_offset", "r5.stack_offset", "r5.type", "r5.shared_region_size", "r5.stack_numeric_size",
-        "r6.value", "r6.ctx_offset", "r6.map_fd", "r6.packet_offset", "r6.shared_offset", "r6.stack_offset", "r6.type", "r6.shared_region_size", "r6.stack_numeric_size",
-        "r7.value", "r7.ctx_offset", "r7.map_fd", "r7.packet_offset", "r7.shared_offset", "r7.stack_offset", "r7.type", "r7.shared_region_size", "r7.stack_numeric_size",
-        "r8.value", "r8.ctx_offset", "r8.map_fd", "r8.packet_offset", "r8.shared_offset", "r8.stack_offset", "r8.type", "r8.shared_region_size", "r8.stack_numeric_size",
-        "r9.value", "r9.ctx_offset", "r9.map_fd", "r9.packet_offset", "r9.shared_offset", "r9.stack_offset", "r9.type", "r9.shared_region_size", "r9.stack_numeric_size",
-        "r10.value", "r10.ctx_offset", "r10.map_fd", "r10.packet_offset", "r10.shared_offset", "r10.stack_offset", "r10.type", "r10.shared_region_size", "r10.stack_numeric_size",
-        "data_size", "meta_size",
-    };
+constexpr data_kind_t slot_kinds[NUM_KINDS] = {
+    data_kind_t::values,         data_kind_t::ctx_offsets,   data_kind_t::map_fds,
+    data_kind_t::packet_offsets, data_kind_t::shared_offsets, data_kind_t::stack_offsets,
+    data_kind_t::types,          data_kind_t::shared_region_sizes, data_kind_t::stack_numeric_sizes,
+};
+
+// Scalars that are neither registers nor stack cells. Their ids follow the register block.
+enum class scalar_t { meta_offset, packet_size, instruction_count };
+constexpr int NUM_SCALARS = 3;
+constexpr index_t first_scalar_id = NUM_REGISTERS * NUM_KINDS;
+
+const char* name_of(scalar_t s) {
+    switch (s) {
+    case scalar_t::meta_offset: return "meta_offset";
+    case scalar_t::packet_size: return "packet_size";
+    case scalar_t::instruction_count: return "instruction_count";
+    }
+    return "";
 }
 
+enum class origin_t { reg, cell, scalar };
+
+// Structured identity of a variable; replaces the string that used to be its key.
+// For registers `index` is the register number, for cells it is the stack offset and for scalars the scalar_t.
+struct var_key_t {
+    origin_t origin;
+    data_kind_t kind;
+    int index;
+    int size;
+
+    bool operator==(const var_key_t& o) const {
+        return origin == o.origin && kind == o.kind && index == o.index && size == o.size;
+    }
+};
+
+struct var_key_hasher_t {
+    std::size_t operator()(const var_key_t& k) const {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, static_cast<int>(k.kind));
+        boost::hash_combine(seed, k.index);
+        boost::hash_combine(seed, k.size);
+        return seed;
+    }
+};
+
+} // namespace
+
+// Register and scalar ids are fixed, so only stack cells go through the hash index.
+struct variable_table_t {
+    std::vector<var_key_t> keys;
+    std::unordered_map<var_key_t, index_t, var_key_hasher_t> cell_ids;
+    std::vector<index_t> type_ids;
+
+    variable_table_t() { reset(); }
+
+    void reset() {
+        keys.clear();
+        cell_ids.clear();
+        type_ids.clear();
+        for (int r = 0; r < NUM_REGISTERS; r++) {
+            for (data_kind_t kind : slot_kinds) {
+                keys.push_back({origin_t::reg, kind, r, 1});
+            }
+            type_ids.push_back(r * NUM_KINDS + reg_slot(data_kind_t::types));
+        }
+        for (int s = 0; s < NUM_SCALARS; s++) {
+            keys.push_back({origin_t::scalar, data_kind_t::values, s, 1});
+        }
+    }
+
+    index_t intern_cell(data_kind_t kind, int offset, int size) {
+        var_key_t key{origin_t::cell, kind, offset, size};
+        auto [it, inserted] = cell_ids.try_emplace(key, keys.size());
+        if (inserted) {
+            keys.push_back(key);
+            if (kind == data_kind_t::types) {
+                type_ids.push_back(it->second);
+            }
+        }
+        return it->second;
+    }
+};
+
+std::shared_ptr<variable_table_t> make_variable_table() { return std::make_shared<variable_table_t>(); }
+
+void clear_variable_table(variable_table_t& table) { table.reset(); }
+
+static variable_table_t& current_table() { return *verification_context_t::current().variables; }
+
 static std::string name_of(data_kind_t kind) {
     switch (kind) {
     case data_kind_t::ctx_offsets: return "ctx_offset";
@@ -53,7 +142,11 @@ static std::string name_of(data_kind_t kind) {
 }
 
 variable_t variable_t::reg(data_kind_t kind, int i) {
-    return make("r" + std::to_string(i) + "." + name_of(kind)); }
+    if (i < 0 || i >= NUM_REGISTERS) {
+        CRAB_ERROR("invalid register number ", i);
+    }
+    return variable_t(i * NUM_KINDS + reg_slot(kind));
+}
 
 std::ostream& operator<<(std::ostream& o, const data_kind_t& s) {
     return o << name_of(s);
@@ -70,33 +163,50 @@ static std::string mk_scalar_name(data_kind_t kind, int o, int size) {
 }
 
 variable_t variable_t::cell_var(data_kind_t array, index_t offset, unsigned size) {
-    return make(mk_scalar_name(array, (int)offset, (int)size));
+    return variable_t(current_table().intern_cell(array, (int)offset, (int)size));
 }
 
 // Given a type variable, get the associated variable of a given kind.
 variable_t variable_t::kind_var(data_kind_t kind, variable_t type_variable) {
-    std::string name = type_variable.name();
-    return make(name.substr(0, name.rfind('.') + 1) + name_of(kind));
+    variable_table_t& table = current_table();
+    const var_key_t key = table.keys.at(type_variable._id);
+    switch (key.origin) {
+    case origin_t::reg: return reg(kind, key.index);
+    case origin_t::cell: return variable_t(table.intern_cell(kind, key.index, key.size));
+    default: CRAB_ERROR("no variable of kind ", kind, " is associated with ", type_variable);
+    }
 }
 
-variable_t variable_t::meta_offset() { return make("meta_offset"); }
-variable_t variable_t::packet_size() { return make("packet_size"); }
-variable_t variable_t::instruction_count() { return make("instruction_count"); }
+variable_t variable_t::meta_offset() { return variable_t(first_scalar_id + (index_t)scalar_t::meta_offset); }
+variable_t variable_t::packet_size() { return variable_t(first_scalar_id + (index_t)scalar_t::packet_size); }
+variable_t variable_t::instruction_count() { return variable_t(first_scalar_id + (index_t)scalar_t::instruction_count); }
+
+std::string variable_t::name() const {
+    const var_key_t& key = current_table().keys.at(_id);
+    switch (key.origin) {
+    case origin_t::reg: return "r" + std::to_string(key.index) + "." + name_of(key.kind);
+    case origin_t::cell: return mk_scalar_name(key.kind, key.index, key.size);
+    case origin_t::scalar: return name_of(static_cast<scalar_t>(key.index));
+    }
+    return {};
+}
 
-static bool ends_with(const std::string& str, const std::string& suffix)
-{
-    return str.size() >= suffix.size() && 0 == str.compare(str.size()-suffix.size(), suffix.size(), suffix);
+bool variable_t::is_type() const {
+    const var_key_t& key = current_table().keys.at(_id);
+    return key.origin != origin_t::scalar && key.kind == data_kind_t::types;
 }
 
 std::vector<variable_t> variable_t::get_type_variables() {
+    const variable_table_t& table = current_table();
     std::vector<variable_t> res;
-    for (const std::string& name: names) {
-        if (ends_with(name, ".type"))
-            res.push_back(make(name));
+    res.reserve(table.type_ids.size());
+    for (index_t id : table.type_ids) {
+        res.push_back(variable_t(id));
     }
     return res;
 }
+
 bool variable_t::is_in_stack() const {
-    return this->name()[0] == 's';
+    return current_table().keys.at(_id).origin == origin_t::cell;
 }
 } // end namespace crab
@@ -38,22 +38,18 @@ class variable_t final {
     // for flat_map
     bool operator<(variable_t o) const { return _id < o._id; }
 
+    // The name is built from the variable's key on demand, so it should only be used for printing.
+    [[nodiscard]] std::string name() const;
 
-    [[nodiscard]] std::string name() const { return names.at(_id); }
+    [[nodiscard]] bool is_type() const;
 
-    [[nodiscard]] bool is_type() const { return names.at(_id).find(".type") != std::string::npos; }
-
-    friend std::ostream& operator<<(std::ostream& o, variable_t v)  { return o << names.at(v._id); }
+    friend std::ostream& operator<<(std::ostream& o, variable_t v) { return o << v.name(); }
 
     // var_factory portion.
-    // This singleton is eBPF-specific, to avoid lifetime issues and/or passing factory explicitly everywhere:
-  private:
-    static variable_t make(const std::string& name);
-    static thread_local std::vector<std::string> names;
-
+    // Variables are interned by a structured key (register number or stack cell, plus data kind),
+    // so creating a variable never needs to build or compare strings.
+    // The table lives in the current verification_context_t, to avoid passing it explicitly everywhere.
   public:
-    static void clear_thread_local_state();
-
     static std::vector<variable_t> get_type_variables();
     static variable_t reg(data_kind_t, int);
     static variable_t cell_var(data_kind_t array, index_t offset, unsigned size);
@@ -68,4 +64,10 @@ class variable_t final {
     };
 }; // class variable_t
 
+// Table of interned variables, owned by a verification context.
+struct variable_table_t;
+std::shared_ptr<variable_table_t> make_variable_table();
+// Forget all stack cells, keeping the fixed register and scalar ids and the allocated capacity.
+void clear_variable_table(variable_table_t& table);
+
 } // namespace crab
@@ -1,7 +1,56 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
+#include <algorithm>
+
 #include "wto.hpp"
 
+std::ostream& operator<<(std::ostream& o, const wto_t& wto) {
+    std::vector<uint32_t> ends;
+    for (uint32_t index = 0; index < wto.size(); index++) {
+        for (; !ends.empty() && ends.back() == index; ends.pop_back()) {
+            o << ") ";
+        }
+        const wto_entry_t& entry = wto[index];
+        if (entry.is_head) {
+            o << "( ";
+            ends.push_back(entry.end);
+        }
+        o << wto._cfg.label(entry.vertex) << " ";
+    }
+    for (; !ends.empty(); ends.pop_back()) {
+        o << ") ";
+    }
+    o << std::endl;
+    return o;
+}
+
+void wto_t::finish() {
+    // The components were written after their contents, so reversing puts every head first in its cycle.
+    std::reverse(_entries.begin(), _entries.end());
+    const auto size = static_cast<uint32_t>(_entries.size());
+    for (uint32_t index = 0; index < size; index++) {
+        wto_entry_t& entry = _entries[index];
+        entry.end = entry.is_head ? size - entry.end : index + 1;
+    }
+
+    _position.assign(_cfg.size(), npos);
+    _parent.assign(_cfg.size(), npos);
+    _depth.assign(_cfg.size(), 0);
+    std::vector<uint32_t> open_heads;
+    for (uint32_t index = 0; index < size; index++) {
+        while (!open_heads.empty() && _entries[open_heads.back()].end <= index) {
+            open_heads.pop_back();
+        }
+        const wto_entry_t& entry = _entries[index];
+        _position[entry.vertex] = index;
+        _parent[entry.vertex] = open_heads.empty() ? npos : open_heads.back();
+        _depth[entry.vertex] = static_cast<uint32_t>(open_heads.size());
+        if (entry.is_head) {
+            open_heads.push_back(index);
+        }
+    }
+}
+
 #ifndef RECURSIVE_WTO
 
 // This file contains an iterative implementation of the recursive algorithm in
@@ -11,8 +60,7 @@
 // algorithm.  However, this scales much higher since it does not run out of
 // stack memory.
 
-void wto_t::push_successors(const label_t& vertex, wto_partition_t& partition,
-                            std::weak_ptr<wto_cycle_t> containing_cycle) {
+void wto_t::push_successors(block_id_t vertex) {
     if (_vertex_data[vertex].dfn != 0) {
         // We found an alternate path to a node already visited, so nothing to do.
         return;
@@ -21,23 +69,21 @@ void wto_t::push_successors(const label_t& vertex, wto_partition_t& partition,
     _stack.push(vertex);
 
     // Schedule the next task for this vertex once we're done with anything else.
-    visit_args_t args(visit_task_type_t::StartVisit, vertex, partition, containing_cycle);
-    _visit_stack.push(args);
+    _visit_stack.emplace(visit_task_type_t::StartVisit, vertex);
 
-    for (const label_t& succ : _cfg.next_nodes_reversed(vertex)) {
+    for (block_id_t succ : _cfg.next_nodes_reversed(vertex)) {
         if (_vertex_data[succ].dfn == 0) {
-            visit_args_t args(visit_task_type_t::PushSuccessors, succ, partition, containing_cycle);
-            _visit_stack.push(args);
+            _visit_stack.emplace(visit_task_type_t::PushSuccessors, succ);
         }
     }
 }
 
-void wto_t::start_visit(const label_t& vertex, wto_partition_t& partition, std::weak_ptr<wto_cycle_t> containing_cycle) {
+void wto_t::start_visit(block_id_t vertex) {
     wto_vertex_data_t& vertex_data = _vertex_data[vertex];
     int head_dfn = vertex_data.dfn;
     bool loop = false;
     int min_dfn = INT_MAX;
-    for (const label_t& succ : _cfg.next_nodes(vertex)) {
+    for (block_id_t succ : _cfg.next_nodes(vertex)) {
         wto_vertex_data_t& data = _vertex_data[succ];
         if (data.head_dfn != 0 && data.dfn != INT_MAX) {
             min_dfn = data.head_dfn;
@@ -50,12 +96,9 @@ void wto_t::start_visit(const label_t& vertex, wto_partition_t& partition, std::
         }
     }
 
-    // Create a new cycle component inside the containing cycle.
-    auto cycle = std::make_shared<wto_cycle_t>(containing_cycle);
-
-    if (head_dfn == vertex_data.dfn) {  
+    if (head_dfn == vertex_data.dfn) {
         vertex_data.dfn = INT_MAX;
-        label_t element = _stack.top();
+        block_id_t element = _stack.top();
         _stack.pop();
         if (loop) {
             while (element != vertex) {
@@ -66,75 +109,51 @@ void wto_t::start_visit(const label_t& vertex, wto_partition_t& partition, std::
             }
             vertex_data.head_dfn = head_dfn;
 
-            // Stash a reference to the cycle.
-            _vertex_data[vertex].containing_cycle = cycle;
-
             // Schedule the next task for this vertex once we're done with anything else.
-            visit_args_t args2(visit_task_type_t::ContinueVisit, vertex, partition, cycle);
-            _visit_stack.push(args2);
+            // The components of the new cycle are the entries written until then.
+            _visit_stack.emplace(visit_task_type_t::ContinueVisit, vertex, static_cast<uint32_t>(_entries.size()));
 
             // Walk the control flow graph, adding nodes to this cycle.
             // This is the Component() function described in figure 4 of the paper.
-            for (const label_t& succ : _cfg.next_nodes_reversed(vertex)) {
+            for (block_id_t succ : _cfg.next_nodes_reversed(vertex)) {
                 if (dfn(succ) == 0) {
-                    visit_args_t args(visit_task_type_t::PushSuccessors, succ, cycle->components(), cycle);
-                    _visit_stack.push(args);
+                    _visit_stack.emplace(visit_task_type_t::PushSuccessors, succ);
                 }
             }
             return;
         } else {
             // Create a new vertex component.
-            auto component = std::make_shared<wto_component_t>(wto_component_t(vertex));
-
-            // Insert the vertex into the current partition.
-            partition.push_back(component);
-
-            // Remember that we put the vertex into the caller's cycle.
-            _containing_cycle.emplace(vertex, containing_cycle);
+            _entries.push_back({vertex, 0, false});
         }
     }
     vertex_data.head_dfn = head_dfn;
 }
 
-void wto_t::continue_visit(const label_t& vertex, wto_partition_t& partition,
-                        std::weak_ptr<wto_cycle_t> containing_cycle) {
-    // Add the vertex at the start of the cycle
-    // (end of the vector which stores the cycle in reverse order).
-    auto cycle = containing_cycle.lock();
-
-    cycle->components().push_back(std::make_shared<wto_component_t>(vertex));
-
-    // Insert the component into the current partition.
-    auto component = std::make_shared<wto_component_t>(cycle);
-    partition.emplace_back(component);
-
-    // Remember that we put the vertex into the new cycle.
-    _containing_cycle.emplace(vertex, cycle);
+void wto_t::continue_visit(block_id_t vertex, uint32_t start) {
+    // Add the head of the cycle after its components.
+    _entries.push_back({vertex, start, true});
 }
 
-wto_t::wto_t(const cfg_t& cfg) : _cfg(cfg) {
-    // Create a map for holding a "depth-first number (DFN)" for each vertex.
-    for (const label_t& label : cfg.labels()) {
-        _vertex_data.emplace(label, 0);
-    }
+wto_t::wto_t(const flat_cfg_t& cfg) : _cfg(cfg), _vertex_data(cfg.size(), 0) {
+    _entries.reserve(cfg.size());
 
     // Initialize the DFN counter.
     _num = 0;
 
     // Push the entry vertex on the stack to process.
-    visit_args_t args(visit_task_type_t::PushSuccessors, cfg.entry_label(), _components, {});
-    _visit_stack.push(args);
+    _visit_stack.emplace(visit_task_type_t::PushSuccessors, cfg.entry());
 
     // Keep processing tasks until we're done.
     while (!_visit_stack.empty()) {
-        visit_args_t& args2 = _visit_stack.top();
+        const visit_args_t args = _visit_stack.top();
         _visit_stack.pop();
-        switch (args2.type) {
-        case visit_task_type_t::PushSuccessors: push_successors(args2.vertex, args2.partition, args2.containing_cycle); break;
-        case visit_task_type_t::StartVisit: start_visit(args2.vertex, args2.partition, args2.containing_cycle); break;
-        case visit_task_type_t::ContinueVisit: continue_visit(args2.vertex, args2.partition, args2.containing_cycle); break;
+        switch (args.type) {
+        case visit_task_type_t::PushSuccessors: push_successors(args.vertex); break;
+        case visit_task_type_t::StartVisit: start_visit(args.vertex); break;
+        case visit_task_type_t::ContinueVisit: continue_visit(args.vertex, args.start); break;
         default: break;
         }
     }
+    finish();
 }
 #endif
@@ -17,10 +17,16 @@
 //   1 --> 2 --------> 8
 //
 // results in the WTO: 1 2 (3 4 (5 6) 7) 8
-// where a single vertex is represented via label_t, and a
-// cycle such as (5 6) is represented via a wto_cycle_t.
-// Each arrow points to a wto_component_t, which can be either a
-// single vertex such as 8, or a cycle such as (5 6).
+// which is stored flat, as one entry per vertex in the order written above:
+//
+//   index:   0  1  2  3  4  5  6  7
+//   vertex:  1  2  3  4  5  6  7  8
+//   head:          *     *
+//   end:     1  2  7  4  6  6  7  8
+//
+// A cycle such as (5 6) is represented by the entry of its head, which is marked as such
+// and whose end is the index one past the last entry of the cycle.
+// Any other entry is a single vertex such as 8, and its end is the next index.
 
 // Define this to use the old recursive algorithm instead of the new
 // iterative algorithm.  The recursive algorithm can result in a stack
@@ -28,16 +34,20 @@
 // comparison.
 #undef RECURSIVE_WTO
 
+#include <climits>
+#include <cstdint>
+#include <optional>
 #include <stack>
 #include <vector>
 #include "crab/cfg.hpp"
-#include "crab/wto_nesting.hpp"
 
-// Define types used by both this header file and wto_cycle.hpp
-using wto_component_t = std::variant<std::shared_ptr<class wto_cycle_t>, label_t>;
-using wto_partition_t = std::vector<std::shared_ptr<wto_component_t>>;
-
-#include "crab/wto_cycle.hpp"
+// A component of the WTO: either a single vertex, or the head of a cycle
+// whose components are the entries from this one up to end.
+struct wto_entry_t {
+    block_id_t vertex;
+    uint32_t end;
+    bool is_head;
+};
 
 #ifndef RECURSIVE_WTO
 enum class visit_task_type_t {
@@ -48,12 +58,11 @@ enum class visit_task_type_t {
 
 struct visit_args_t {
     visit_task_type_t type;
-    label_t vertex;
-    wto_partition_t& partition;
-    std::weak_ptr<wto_cycle_t> containing_cycle;
+    block_id_t vertex;
+    // For ContinueVisit, the number of entries written before the components of the cycle.
+    uint32_t start;
 
-    visit_args_t(visit_task_type_t t, label_t v, wto_partition_t& p, std::weak_ptr<wto_cycle_t> cc)
-        : type(t), vertex(v), partition(p), containing_cycle(cc) {};
+    visit_args_t(visit_task_type_t t, block_id_t v, uint32_t s = 0) : type(t), vertex(v), start(s) {};
 };
 
 struct wto_vertex_data_t {
@@ -61,7 +70,6 @@ struct wto_vertex_data_t {
     // DFN as "depth first number".
     int dfn;
     int head_dfn; // Head value returned from Visit() in the paper.
-    std::shared_ptr<wto_cycle_t> containing_cycle;
 
     wto_vertex_data_t() : dfn(0), head_dfn(0){};
     wto_vertex_data_t(int d) : dfn(d), head_dfn(0) {};
@@ -69,51 +77,60 @@ struct wto_vertex_data_t {
 #endif
 
 class wto_t final {
+  public:
+    // Position of a vertex that is not reachable from the entry, and so is not part of the WTO.
+    static constexpr uint32_t npos = UINT32_MAX;
+
+  private:
     // Original control-flow graph.
-    const crab::cfg_t& _cfg;
+    const crab::flat_cfg_t& _cfg;
+
+    // The components, in order. While the WTO is being built they are written in reverse order,
+    // with the end of each head holding the number of entries written before the components of its cycle.
+    std::vector<wto_entry_t> _entries;
+
+    // Tables about vertices, indexed by block id.
+    // Index of the entry of each vertex.
+    std::vector<uint32_t> _position;
+    // Index of the entry of the head of the innermost cycle containing each vertex, not counting the cycle
+    // that the vertex is itself the head of; npos if there is none.
+    std::vector<uint32_t> _parent;
+    // Number of cycles containing each vertex, counted the same way; this is the size of w(c) in the paper.
+    std::vector<uint32_t> _depth;
 
     // The following members are named to match the names in the paper.
 #ifdef RECURSIVE_WTO
     // Bourdoncle's thesis (reference [4]) is all in French but
     // expands DFN as "depth first number".
-    std::map<label_t, int> _dfn;
+    std::vector<int> _dfn;
 #else
-    std::map<label_t, wto_vertex_data_t> _vertex_data;
+    std::vector<wto_vertex_data_t> _vertex_data;
 #endif
     int _num; // Highest DFN used so far.
-    std::stack<label_t> _stack;
+    std::stack<block_id_t, std::vector<block_id_t>> _stack;
 
 #ifndef RECURSIVE_WTO
-    std::stack<visit_args_t> _visit_stack;
+    std::stack<visit_args_t, std::vector<visit_args_t>> _visit_stack;
 #endif
 
-    // Top level components, in reverse order.
-    wto_partition_t _components;
-
-    // Table mapping label to the cycle containing the label.
-    std::map<label_t, std::weak_ptr<wto_cycle_t>> _containing_cycle;
-
-    // Table mapping label to the list of heads of cycles containing the label.
-    // This is an on-demand cache, since for most vertices the nesting is never
-    // looked at so we only create a wto_nesting_t for cases we actually need it.
-    std::map<label_t, wto_nesting_t> _nesting;
+    // Put the entries in order and fill the tables about vertices.
+    void finish();
 
 #ifndef RECURSIVE_WTO
-    void push_successors(const label_t& vertex, wto_partition_t& partition, std::weak_ptr<wto_cycle_t> containing_cycle);
-    void start_visit(const label_t& vertex, wto_partition_t& partition,
-                            std::weak_ptr<wto_cycle_t> containing_cycle);
-    void continue_visit(const label_t& vertex, wto_partition_t& partition, std::weak_ptr<wto_cycle_t> containing_cycle);
+    void push_successors(block_id_t vertex);
+    void start_visit(block_id_t vertex);
+    void continue_visit(block_id_t vertex, uint32_t start);
 #else
     // Implementation of the Visit() function defined in Figure 4 of the paper.
-    int visit(const label_t& vertex, wto_partition_t& partition, std::weak_ptr<wto_cycle_t> containing_cycle) {
+    int visit(block_id_t vertex) {
         _stack.push(vertex);
         _num++;
         int head = _dfn[vertex] = _num;
         bool loop = false;
         int min = INT_MAX;
-        for (const label_t& succ : _cfg.next_nodes(vertex)) {
+        for (block_id_t succ : _cfg.next_nodes(vertex)) {
             if (_dfn[succ] == 0) {
-                min = visit(succ, partition, containing_cycle);
+                min = visit(succ);
             } else {
                 min = _dfn[succ];
             }
@@ -124,7 +141,7 @@ class wto_t final {
         }
         if (head == _dfn[vertex]) {
             _dfn[vertex] = INT_MAX;
-            label_t& element = _stack.top();
+            block_id_t element = _stack.top();
             _stack.pop();
             if (loop) {
                 while (element != vertex) {
@@ -136,116 +153,77 @@ class wto_t final {
                 // Create a new cycle component.
                 // Walk the control flow graph, adding nodes to this cycle.
                 // This is the Component() function described in figure 4 of the paper.
-                auto cycle = std::make_shared<wto_cycle_t>(containing_cycle);
-                auto component = std::make_shared<wto_component_t>(cycle);
-                for (const label_t& succ : _cfg.next_nodes(vertex)) {
+                const auto start = static_cast<uint32_t>(_entries.size());
+                for (block_id_t succ : _cfg.next_nodes(vertex)) {
                     if (dfn(succ) == 0) {
-                        visit(succ, cycle->components(), cycle);
+                        visit(succ);
                     }
                 }
 
-                // Finally, add the vertex at the start of the cycle
-                // (end of the vector which stores the cycle in reverse order).
-                cycle->components().push_back(std::make_shared<wto_component_t>(vertex));
-
-                // Insert the component into the current partition.
-                partition.emplace_back(component);
-
-                // Remember that we put the vertex into the new cycle.
-                _containing_cycle.emplace(vertex, cycle);
+                // Finally, add the head of the cycle after its components.
+                _entries.push_back({vertex, start, true});
             } else {
                 // Create a new vertex component.
-                auto component = std::make_shared<wto_component_t>(wto_component_t(vertex));
-
-                // Insert the vertex into the current partition.
-                partition.push_back(component);
-
-                // Remember that we put the vertex into the caller's cycle.
-                _containing_cycle.emplace(vertex, containing_cycle);
+                _entries.push_back({vertex, 0, false});
             }
         }
         return head;
     }
 #endif
 
-    public:
-    [[nodiscard]] const crab::cfg_t& cfg() const { return _cfg; }
+  public:
+    [[nodiscard]] const crab::flat_cfg_t& cfg() const { return _cfg; }
 #ifdef RECURSIVE_WTO
-    [[nodiscard]] int dfn(const label_t& vertex) const { return _dfn.at(vertex); }
+    [[nodiscard]] int dfn(block_id_t vertex) const { return _dfn.at(vertex); }
 #else
-    [[nodiscard]] int dfn(const label_t& vertex) const { return _vertex_data.at(vertex).dfn; }
+    [[nodiscard]] int dfn(block_id_t vertex) const { return _vertex_data.at(vertex).dfn; }
 #endif
 
     // Construct a Weak Topological Ordering from a control-flow graph using
     // the algorithm of figure 4 in the paper, where this constructor matches
     // what is shown there as the Partition function.
 #ifdef RECURSIVE_WTO
-    wto_t(const cfg_t& cfg) : _cfg(cfg) {
-        for (const label_t& label : cfg.labels()) {
-            _dfn.emplace(label, 0);
-        }
+    wto_t(const flat_cfg_t& cfg) : _cfg(cfg), _dfn(cfg.size(), 0) {
         _num = 0;
-        visit(cfg.entry_label(), _components, {});
+        visit(cfg.entry());
+        finish();
     }
 #else
-    wto_t(const cfg_t& cfg);
+    wto_t(const flat_cfg_t& cfg);
 #endif
 
-    [[nodiscard]] wto_partition_t::reverse_iterator begin() { return _components.rbegin(); }
-    [[nodiscard]] wto_partition_t::reverse_iterator end() { return _components.rend(); }
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(_entries.size()); }
+    [[nodiscard]] const wto_entry_t& operator[](uint32_t index) const { return _entries[index]; }
 
-    friend std::ostream& operator<<(std::ostream& o, wto_t& wto) {
-        o << wto._components << std::endl;
-        return o;
-    }
+    // Index of the entry of a vertex, or npos if the vertex is not reachable from the entry.
+    [[nodiscard]] uint32_t position(block_id_t vertex) const { return _position[vertex]; }
+
+    friend std::ostream& operator<<(std::ostream& o, const wto_t& wto);
 
     // Get the vertex at the head of the component containing a given
-    // label, as discussed in section 4.2 of the paper.  If the label
+    // vertex, as discussed in section 4.2 of the paper.  If the vertex
     // is itself a head of a component, we want the head of whatever
-    // contains that entire component.  Returns nullopt if the label is
+    // contains that entire component.  Returns nullopt if the vertex is
     // not nested, i.e., the head is logically the entry point of the CFG.
-    std::optional<label_t> head(const label_t& label) {
-        auto it = _containing_cycle.find(label);
-        if (it == _containing_cycle.end()) {
-            // Label is not in any cycle.
-            return {};
-        }
-        std::shared_ptr<wto_cycle_t> cycle = it->second.lock();
-        if (cycle == nullptr) {
-            return {};
-        }
-        const label_t& first = cycle->head();
-        if (first != label) {
-            // Return the head of the cycle the label is inside.
-            return first;
-        }
-
-        // This label is already the head of a cycle, so get the cycle's parent.
-        std::shared_ptr<wto_cycle_t> parent = cycle->containing_cycle().lock();
-        if (parent == nullptr) {
+    [[nodiscard]] std::optional<block_id_t> head(block_id_t vertex) const {
+        const uint32_t parent = _parent[vertex];
+        if (parent == npos) {
             return {};
         }
-        return parent->head();
+        return _entries[parent].vertex;
     }
 
-    // Compute the set of heads of the nested components containing a given label.
+    // Number of heads of the nested components containing a given vertex.
     // See section 3.1 of the paper for discussion, which uses the notation w(c).
-    const wto_nesting_t& nesting(const label_t& label) {
-        auto it = _nesting.find(label);
-        if (it != _nesting.end()) {
-            return it->second;
-        }
+    [[nodiscard]] uint32_t nesting_depth(block_id_t vertex) const { return _depth[vertex]; }
 
-        // Not found in the cache yet, so construct the list of heads of the
-        // nested components containing the label, stored in reverse order.
-        std::vector<label_t> heads;
-        for (std::optional<label_t> h = head(label); h.has_value(); h = head(h.value())) {
-            heads.push_back(h.value());
+    // Test whether w(vertex) is a longer list of heads than w(other) that starts with w(other),
+    // i.e., whether the vertex is nested more deeply than the other one, inside the component that contains it.
+    [[nodiscard]] bool is_nested_deeper(block_id_t vertex, block_id_t other) const {
+        if (_depth[vertex] <= _depth[other]) {
+            return false;
         }
-
-        wto_nesting_t n = wto_nesting_t(std::move(heads));
-        _nesting.emplace(label, std::move(n));
-        return _nesting.at(label);
+        const uint32_t parent = _parent[other];
+        return parent == npos || (parent < _position[vertex] && _position[vertex] < _entries[parent].end);
     }
-
 };
@@ -2,12 +2,17 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 
 #include <boost/container/flat_map.hpp>
 
 #include "crab_utils/safeint.hpp"
 #include "crab_utils/debug.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 // Adaptive sparse-set based weighted graph implementation
 
 namespace crab {
@@ -111,6 +116,24 @@ class TreeSMap final {
     void clear() { map.clear(); }
 };
 
+// Index of the lowest set bit, and number of set bits, of a non-zero word.
+#if defined(_MSC_VER)
+inline unsigned int lowest_bit(uint64_t bits) {
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned int>(index);
+}
+inline size_t count_bits(uint64_t bits) { return static_cast<size_t>(__popcnt64(bits)); }
+#else
+inline unsigned int lowest_bit(uint64_t bits) { return static_cast<unsigned int>(__builtin_ctzll(bits)); }
+inline size_t count_bits(uint64_t bits) { return static_cast<size_t>(__builtin_popcountll(bits)); }
+#endif
+
+// Graphs of up to dense_limit vertices keep their weights in a square matrix, and the successors and the
+// predecessors of each vertex in a bitmask, so that looking up an edge is a bit test and a load.
+// A graph switches to the sparse maps once it grows past dense_limit vertices.
+// Both representations enumerate neighbours in increasing order, so the graph operations give the same
+// results with either.
 class AdaptGraph final {
     using smap_t = TreeSMap;
 
@@ -118,6 +141,8 @@ class AdaptGraph final {
     using Weight = safe_i64;  // same as SafeInt64DefaultParams::Weight; previously template
     using vert_id = unsigned int;
 
+    static constexpr size_t dense_limit = 64;
+
     AdaptGraph() : edge_count(0) {}
 
     AdaptGraph(AdaptGraph&& o) noexcept = default;
@@ -170,84 +195,137 @@ class AdaptGraph final {
     };
     [[nodiscard]] vert_const_range verts() const { return vert_const_range{is_free}; }
 
+    // Neighbours of a vertex: the remaining bits of its mask, or a position in its sparse map.
+    struct neighbour_iter {
+        uint64_t bits{};
+        smap_t::elt_iter_t it{};
+        bool dense{true};
+
+        static neighbour_iter empty_iterator() { return {}; }
+
+        vert_id operator*() const { return dense ? lowest_bit(bits) : it->first; }
+        neighbour_iter& operator++() {
+            if (dense)
+                bits &= bits - 1;
+            else
+                ++it;
+            return *this;
+        }
+        bool operator!=(const neighbour_iter& o) const { return dense ? bits != o.bits : it != o.it; }
+    };
+
+    struct neighbour_const_range_t {
+        using iterator = neighbour_iter;
+
+        neighbour_iter first;
+        neighbour_iter last;
+        size_t count;
+
+        [[nodiscard]] neighbour_iter begin() const { return first; }
+        [[nodiscard]] neighbour_iter end() const { return last; }
+        [[nodiscard]] size_t size() const { return count; }
+    };
+
     struct edge_const_iter {
         struct edge_ref {
             vert_id vert{};
             Weight val;
         };
 
-        smap_t::elt_iter_t it{};
-        const std::vector<Weight>* ws{};
+        neighbour_iter n;
+        // Dense: the weight of neighbour v is ws[v * step]. Sparse: the map gives the index into ws.
+        const Weight* ws{};
+        size_t step{};
 
-        edge_const_iter(const smap_t::elt_iter_t& _it, const std::vector<Weight>& _ws) : it(_it), ws(&_ws) {}
-        edge_const_iter(const edge_const_iter& o) = default;
-        edge_const_iter& operator=(const edge_const_iter& o) = default;
-        edge_const_iter() = default;
+        static edge_const_iter empty_iterator() { return {}; }
 
-        // XXX: to make sure that we always return the same address
-        // for the "empty" iterator, otherwise we can trigger
-        // undefined behavior.
-        inline static std::unique_ptr<edge_const_iter> _empty_iter = std::make_unique<edge_const_iter>();
-        static edge_const_iter empty_iterator() {
-            return *_empty_iter;
+        edge_ref operator*() const {
+            if (n.dense) {
+                vert_id v = *n;
+                return edge_ref{v, ws[v * step]};
+            }
+            return edge_ref{n.it->first, ws[n.it->second]};
         }
-
-        edge_ref operator*() const { return edge_ref{it->first, (*ws)[it->second]}; }
         edge_const_iter operator++() {
-            ++it;
+            ++n;
             return *this;
         }
-        bool operator!=(const edge_const_iter& o) const { return it != o.it; }
+        bool operator!=(const edge_const_iter& o) const { return n != o.n; }
     };
 
-
     struct edge_const_range_t {
-        using elt_range_t = typename smap_t::elt_range_t;
         using iterator = edge_const_iter;
 
-        elt_range_t r;
-        const std::vector<Weight>& ws;
+        edge_const_iter first;
+        edge_const_iter last;
+        size_t count;
 
-        [[nodiscard]] edge_const_iter begin() const { return edge_const_iter(r.begin(), ws); }
-        [[nodiscard]] edge_const_iter end() const { return edge_const_iter(r.end(), ws); }
-        [[nodiscard]] size_t size() const { return r.size(); }
+        [[nodiscard]] edge_const_iter begin() const { return first; }
+        [[nodiscard]] edge_const_iter end() const { return last; }
+        [[nodiscard]] size_t size() const { return count; }
     };
 
     using fwd_edge_const_iter = edge_const_iter;
     using rev_edge_const_iter = edge_const_iter;
 
-    using adj_range_t = typename smap_t::key_const_range_t;
-    using adj_const_range_t = typename smap_t::key_const_range_t;
+    using adj_range_t = neighbour_const_range_t;
+    using adj_const_range_t = neighbour_const_range_t;
     using neighbour_range = adj_range_t;
     using neighbour_const_range = adj_const_range_t;
 
-    [[nodiscard]] adj_const_range_t succs(vert_id v) const { return _succs[v].keys(); }
-    [[nodiscard]] adj_const_range_t preds(vert_id v) const { return _preds[v].keys(); }
+    [[nodiscard]] adj_const_range_t succs(vert_id v) const {
+        return _dense ? dense_neighbours(_succ_bits[v]) : sparse_neighbours(_succs[v]);
+    }
+    [[nodiscard]] adj_const_range_t preds(vert_id v) const {
+        return _dense ? dense_neighbours(_pred_bits[v]) : sparse_neighbours(_preds[v]);
+    }
 
     using fwd_edge_range = edge_const_range_t;
     using rev_edge_range = edge_const_range_t;
 
-    [[nodiscard]] edge_const_range_t e_succs(vert_id v) const { return {_succs[v].elts(), _ws}; }
-    [[nodiscard]] edge_const_range_t e_preds(vert_id v) const { return {_preds[v].elts(), _ws}; }
+    [[nodiscard]] edge_const_range_t e_succs(vert_id v) const {
+        if (_dense) {
+            return dense_edges(_succ_bits[v], &_matrix[v * _stride], 1);
+        }
+        return sparse_edges(_succs[v]);
+    }
+    [[nodiscard]] edge_const_range_t e_preds(vert_id v) const {
+        if (_dense) {
+            return dense_edges(_pred_bits[v], &_matrix[v], _stride);
+        }
+        return sparse_edges(_preds[v]);
+    }
 
     using e_neighbour_const_range = edge_const_range_t;
 
     // Management
     [[nodiscard]] bool is_empty() const { return edge_count == 0; }
-    [[nodiscard]] size_t size() const { return _succs.size(); }
+    [[nodiscard]] size_t size() const { return is_free.size(); }
     [[nodiscard]] size_t num_edges() const { return edge_count; }
+    [[nodiscard]] bool is_dense() const { return _dense; }
     vert_id new_vertex() {
         vert_id v;
         if (!free_id.empty()) {
             v = free_id.back();
-            assert(v < _succs.size());
+            assert(v < size());
             free_id.pop_back();
             is_free[v] = false;
         } else {
-            v = static_cast<vert_id>(_succs.size());
+            v = static_cast<vert_id>(size());
+            if (_dense && v >= dense_limit) {
+                to_sparse();
+            }
             is_free.push_back(false);
-            _succs.emplace_back();
-            _preds.emplace_back();
+            if (_dense) {
+                if (v >= _stride) {
+                    grow_matrix();
+                }
+                _succ_bits.push_back(0);
+                _pred_bits.push_back(0);
+            } else {
+                _succs.emplace_back();
+                _preds.emplace_back();
+            }
         }
 
         return v;
@@ -262,31 +340,114 @@ class AdaptGraph final {
         if (is_free[v])
             return;
 
-        for (const auto& [key, val] : _succs[v].elts()) {
-            free_widx.push_back(val);
-            _preds[key].remove(v);
-        }
-        edge_count -= _succs[v].size();
-        _succs[v].clear();
+        if (_dense) {
+            const uint64_t bit = uint64_t{1} << v;
+            for (uint64_t bits = _succ_bits[v]; bits; bits &= bits - 1)
+                _pred_bits[lowest_bit(bits)] &= ~bit;
+            edge_count -= count_bits(_succ_bits[v]);
+            _succ_bits[v] = 0;
+
+            for (uint64_t bits = _pred_bits[v]; bits; bits &= bits - 1)
+                _succ_bits[lowest_bit(bits)] &= ~bit;
+            edge_count -= count_bits(_pred_bits[v]);
+            _pred_bits[v] = 0;
+        } else {
+            for (const auto& [key, val] : _succs[v].elts()) {
+                free_widx.push_back(val);
+                _preds[key].remove(v);
+            }
+            edge_count -= _succs[v].size();
+            _succs[v].clear();
 
-        for (smap_t::key_t k : _preds[v].keys())
-            _succs[k].remove(v);
-        edge_count -= _preds[v].size();
-        _preds[v].clear();
+            for (smap_t::key_t k : _preds[v].keys())
+                _succs[k].remove(v);
+            edge_count -= _preds[v].size();
+            _preds[v].clear();
+        }
 
         is_free[v] = true;
         free_id.push_back(v);
     }
 
-    void clear_edges() {
-        _ws.clear();
-        for (vert_id v : verts()) {
+    // Forget several vertices at once: the edges between two of them are dropped once, and the other vertices
+    // have their edges to all of them dropped in a single pass.
+    void forget(const std::vector<vert_id>& vs) {
+        if (_dense) {
+            uint64_t removed = 0;
+            for (vert_id v : vs) {
+                if (!is_free[v])
+                    removed |= uint64_t{1} << v;
+            }
+            if (removed == 0)
+                return;
+            for (uint64_t bits = removed; bits; bits &= bits - 1) {
+                const vert_id v = lowest_bit(bits);
+                edge_count -= count_bits(_succ_bits[v]) + count_bits(_pred_bits[v] & ~removed);
+                _succ_bits[v] = 0;
+                _pred_bits[v] = 0;
+            }
+            for (vert_id u : verts()) {
+                _succ_bits[u] &= ~removed;
+                _pred_bits[u] &= ~removed;
+            }
+            for (uint64_t bits = removed; bits; bits &= bits - 1) {
+                const vert_id v = lowest_bit(bits);
+                is_free[v] = true;
+                free_id.push_back(v);
+            }
+            return;
+        }
+
+        // Mark the vertices first, so that edges within the set are not looked up in maps that are cleared anyway.
+        std::vector<vert_id> removed;
+        for (vert_id v : vs) {
+            if (!is_free[v]) {
+                is_free[v] = true;
+                removed.push_back(v);
+            }
+        }
+        for (vert_id v : removed) {
+            for (const auto& [key, val] : _succs[v].elts()) {
+                free_widx.push_back(val);
+                if (!is_free[key])
+                    _preds[key].remove(v);
+            }
+            edge_count -= _succs[v].size();
             _succs[v].clear();
+
+            for (const auto& [key, val] : _preds[v].elts()) {
+                if (!is_free[key]) {
+                    free_widx.push_back(val);
+                    _succs[key].remove(v);
+                    edge_count--;
+                }
+            }
             _preds[v].clear();
         }
+        free_id.insert(free_id.end(), removed.begin(), removed.end());
+    }
+
+    void clear_edges() {
+        if (_dense) {
+            std::fill(_succ_bits.begin(), _succ_bits.end(), 0);
+            std::fill(_pred_bits.begin(), _pred_bits.end(), 0);
+        } else {
+            _ws.clear();
+            free_widx.clear();
+            for (vert_id v : verts()) {
+                _succs[v].clear();
+                _preds[v].clear();
+            }
+        }
         edge_count = 0;
     }
     void clear() {
+        _dense = true;
+        _stride = 0;
+        _matrix.clear();
+        _succ_bits.clear();
+        _pred_bits.clear();
+
         _ws.clear();
         _succs.clear();
         _preds.clear();
@@ -298,10 +459,14 @@ class AdaptGraph final {
     }
 
     [[nodiscard]] bool elem(vert_id s, vert_id d) const {
+        if (_dense)
+            return (_succ_bits[s] >> d) & 1;
         return _succs[s].contains(d);
     }
 
     const Weight& edge_val(vert_id s, vert_id d) const {
+        if (_dense)
+            return _matrix[s * _stride + d];
         return _ws[*_succs[s].lookup(d)];
     }
 
@@ -327,21 +492,29 @@ class AdaptGraph final {
     };
 
     bool lookup(vert_id s, vert_id d, mut_val_ref_t* w) {
-        if (auto idx = _succs[s].lookup(d)) {
-            *w = &_ws[*idx];
+        if (Weight* p = find(s, d)) {
+            *w = p;
             return true;
         }
         return false;
     }
 
     [[nodiscard]] std::optional<Weight> lookup(vert_id s, vert_id d) const {
-        if (auto idx = _succs[s].lookup(d)) {
-            return _ws[*idx];
+        if (const Weight* p = find(s, d)) {
+            return *p;
         }
         return {};
     }
 
     void add_edge(vert_id s, Weight w, vert_id d) {
+        if (_dense) {
+            _matrix[s * _stride + d] = w;
+            _succ_bits[s] |= uint64_t{1} << d;
+            _pred_bits[d] |= uint64_t{1} << s;
+            edge_count++;
+            return;
+        }
+
         size_t idx;
         if (!free_widx.empty()) {
             idx = free_widx.back();
@@ -358,16 +531,16 @@ class AdaptGraph final {
     }
 
     void update_edge(vert_id s, Weight w, vert_id d) {
-        if (auto idx = _succs[s].lookup(d)) {
-            _ws[*idx] = std::min(_ws[*idx], w);
+        if (Weight* p = find(s, d)) {
+            *p = std::min(*p, w);
         } else {
             add_edge(s, w, d);
         }
     }
 
     void set_edge(vert_id s, Weight w, vert_id d) {
-        if (auto idx = _succs[s].lookup(d)) {
-            _ws[*idx] = w;
+        if (Weight* p = find(s, d)) {
+            *p = w;
         } else {
             add_edge(s, w, d);
         }
@@ -399,6 +572,90 @@ class AdaptGraph final {
         return o;
     }
 
+  private:
+    static neighbour_const_range_t dense_neighbours(uint64_t bits) {
+        return {neighbour_iter{bits}, neighbour_iter{}, count_bits(bits)};
+    }
+
+    static neighbour_const_range_t sparse_neighbours(const smap_t& m) {
+        auto elts = m.elts();
+        return {neighbour_iter{0, elts.begin(), false}, neighbour_iter{0, elts.end(), false}, m.size()};
+    }
+
+    static edge_const_range_t dense_edges(uint64_t bits, const Weight* ws, size_t step) {
+        return {edge_const_iter{neighbour_iter{bits}, ws, step}, edge_const_iter{}, count_bits(bits)};
+    }
+
+    [[nodiscard]] edge_const_range_t sparse_edges(const smap_t& m) const {
+        auto elts = m.elts();
+        return {edge_const_iter{neighbour_iter{0, elts.begin(), false}, _ws.data(), 0},
+                edge_const_iter{neighbour_iter{0, elts.end(), false}, _ws.data(), 0}, m.size()};
+    }
+
+    [[nodiscard]] const Weight* find(vert_id s, vert_id d) const {
+        if (_dense) {
+            if ((_succ_bits[s] >> d) & 1)
+                return &_matrix[s * _stride + d];
+            return nullptr;
+        }
+        if (auto idx = _succs[s].lookup(d))
+            return &_ws[*idx];
+        return nullptr;
+    }
+
+    Weight* find(vert_id s, vert_id d) {
+        if (_dense) {
+            if ((_succ_bits[s] >> d) & 1)
+                return &_matrix[s * _stride + d];
+            return nullptr;
+        }
+        if (auto idx = _succs[s].lookup(d))
+            return &_ws[*idx];
+        return nullptr;
+    }
+
+    // Double the row length of the matrix, up to dense_limit.
+    void grow_matrix() {
+        size_t stride = std::min(dense_limit, std::max<size_t>(8, 2 * _stride));
+        std::vector<Weight> matrix(stride * stride);
+        for (size_t s = 0; s < _succ_bits.size(); s++) {
+            for (uint64_t bits = _succ_bits[s]; bits; bits &= bits - 1) {
+                size_t d = lowest_bit(bits);
+                matrix[s * stride + d] = _matrix[s * _stride + d];
+            }
+        }
+        _matrix = std::move(matrix);
+        _stride = stride;
+    }
+
+    void to_sparse() {
+        _succs.resize(size());
+        _preds.resize(size());
+        for (vert_id s = 0; s < _succ_bits.size(); s++) {
+            for (uint64_t bits = _succ_bits[s]; bits; bits &= bits - 1) {
+                vert_id d = lowest_bit(bits);
+                size_t idx = _ws.size();
+                _ws.push_back(_matrix[s * _stride + d]);
+                _succs[s].add(d, idx);
+                _preds[d].add(s, idx);
+            }
+        }
+        _dense = false;
+        _stride = 0;
+        _matrix = {};
+        _succ_bits = {};
+        _pred_bits = {};
+    }
+
+    bool _dense{true};
+
+    // Dense representation: the weight of s -> d is _matrix[s * _stride + d] if bit d of _succ_bits[s] is set.
+    size_t _stride{0};
+    std::vector<Weight> _matrix;
+    std::vector<uint64_t> _succ_bits;
+    std::vector<uint64_t> _pred_bits;
+
+    // Sparse representation.
     // Ick. This'll have another indirection on every operation.
     // We'll see what the performance costs are like.
     std::vector<smap_t> _preds;
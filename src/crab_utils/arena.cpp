@@ -0,0 +1,56 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <algorithm>
+#include <atomic>
+
+#include "arena.hpp"
+#include "debug.hpp"
+
+namespace crab {
+
+static std::atomic<size_t> next_arena_id{1};
+
+arena_t::arena_t(size_t chunk_size) : _id(next_arena_id++), _chunk_size(chunk_size) {}
+
+void arena_t::add_chunk(size_t min_size) {
+    size_t size = std::max(_chunk_size, min_size);
+    _chunks.push_back(chunk_t{std::make_unique<std::byte[]>(size), size});
+    _stats.system_allocations++;
+}
+
+void* arena_t::allocate_in_new_chunk(size_t bytes, size_t alignment) {
+    if (_current + 1 < _chunks.size() && bytes + alignment <= _chunks[_current + 1].size) {
+        _current++;
+    } else {
+        // Later chunks are too small for this request, so drop them in favour of a big enough one.
+        _chunks.resize(_chunks.empty() ? 0 : _current + 1);
+        add_chunk(bytes + alignment);
+        _current = _chunks.size() - 1;
+    }
+    _offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void arena_t::reset() {
+    if (_live > 0) {
+        // The memory of those allocations would be handed out again while still in use.
+        CRAB_ERROR("scratch arena reset with ", _live, " allocations in use");
+    }
+    if (_chunks.size() > 1) {
+        // Replace the chunks by a single one that fits them all, so that the next round needs no new chunk.
+        size_t total = 0;
+        for (const chunk_t& chunk : _chunks) {
+            total += chunk.size;
+        }
+        _chunks.clear();
+        add_chunk(total);
+    }
+    _current = 0;
+    _offset = 0;
+    _in_use = 0;
+    _live = 0;
+    _last = nullptr;
+    _stats.resets++;
+}
+
+} // namespace crab
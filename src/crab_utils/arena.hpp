@@ -0,0 +1,149 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace crab {
+
+/**
+ * Bump allocator for the temporaries of the graph algorithms and of the zone domain operations.
+ *
+ * Memory is carved out of large chunks, and freeing only takes effect for the most recent allocation.
+ * Everything is reclaimed at once by reset(), which the fixpoint iterator calls before each basic block,
+ * or as soon as no allocation is in use any more. Chunks are kept for the next round, so that once the
+ * arena has grown to fit the largest operation, temporaries no longer go through the system allocator.
+ *
+ * The arena also holds buffers that are worth keeping across resets, see retained().
+ */
+class arena_t final {
+  public:
+    struct stats_t {
+        size_t allocations{};        // Requests served from the chunks.
+        size_t bytes{};              // Bytes handed out by those requests.
+        size_t peak_bytes{};         // Most bytes in use at once.
+        size_t system_allocations{}; // Chunks and retained buffers obtained from the system allocator.
+        size_t resets{};
+    };
+
+    explicit arena_t(size_t chunk_size = 64 * 1024);
+    arena_t(const arena_t&) = delete;
+    arena_t& operator=(const arena_t&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment) {
+        size_t start = (_offset + alignment - 1) & ~(alignment - 1);
+        if (_current < _chunks.size() && start + bytes <= _chunks[_current].size) {
+            _offset = start + bytes;
+            _last = _chunks[_current].data.get() + start;
+            count_allocation(bytes);
+            return _last;
+        }
+        return allocate_in_new_chunk(bytes, alignment);
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        assert(_live > 0 && _in_use >= bytes);
+        _in_use -= bytes;
+        if (--_live == 0) {
+            // Nothing is in use: start over from the first chunk.
+            _current = 0;
+            _offset = 0;
+            _last = nullptr;
+        } else if (p == _last) {
+            _offset = static_cast<size_t>(_last - _chunks[_current].data.get());
+            _last = nullptr;
+        }
+    }
+
+    // Reclaim all the memory handed out so far. Throws if an allocation is still in use.
+    void reset();
+
+    [[nodiscard]] const stats_t& stats() const { return _stats; }
+    void clear_stats() { _stats = {}; }
+
+    // Identifies this arena among all those created by the process.
+    [[nodiscard]] size_t id() const { return _id; }
+
+    // An object of type T that lives as long as the arena.
+    template <class T>
+    T& retained() {
+        std::shared_ptr<void>& slot = _retained[std::type_index(typeid(T))];
+        if (!slot) {
+            slot = std::make_shared<T>();
+            _stats.system_allocations++;
+        }
+        return *static_cast<T*>(slot.get());
+    }
+
+    // Record that a retained buffer had to grow.
+    void count_system_allocation() { _stats.system_allocations++; }
+
+  private:
+    struct chunk_t {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void add_chunk(size_t min_size);
+    void* allocate_in_new_chunk(size_t bytes, size_t alignment);
+
+    void count_allocation(size_t bytes) {
+        _in_use += bytes;
+        _live++;
+        _stats.allocations++;
+        _stats.bytes += bytes;
+        if (_in_use > _stats.peak_bytes) {
+            _stats.peak_bytes = _in_use;
+        }
+    }
+
+    size_t _id;
+    size_t _chunk_size;
+    std::vector<chunk_t> _chunks;
+    size_t _current{};   // Chunk that allocations are carved from.
+    size_t _offset{};    // First free byte of the current chunk.
+    size_t _in_use{};    // Bytes handed out and not freed.
+    size_t _live{};      // Allocations handed out and not freed.
+    std::byte* _last{};  // Most recent allocation, which can be given back.
+    std::unordered_map<std::type_index, std::shared_ptr<void>> _retained;
+    stats_t _stats;
+};
+
+// The arena of the verification running on the calling thread; see verification_context_t.
+arena_t& scratch_arena();
+
+// Standard allocator that draws from the arena of the current verification.
+// Containers using it must not outlive the operation that creates them.
+template <class T>
+class arena_allocator {
+  public:
+    using value_type = T;
+
+    arena_allocator() : arena(&scratch_arena()) {}
+    template <class U>
+    arena_allocator(const arena_allocator<U>& o) : arena(o.arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t n) { arena->deallocate(p, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const arena_allocator<U>& o) const {
+        return arena == o.arena;
+    }
+    template <class U>
+    bool operator!=(const arena_allocator<U>& o) const {
+        return arena != o.arena;
+    }
+
+    arena_t* arena;
+};
+
+template <class T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+} // namespace crab
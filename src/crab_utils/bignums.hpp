@@ -3,7 +3,9 @@
 #pragma once
 
 #include <climits>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -16,163 +18,281 @@ using boost::multiprecision::cpp_int;
 
 namespace crab {
 
+// Arbitrary-precision integer.
+// Values that fit in 64 bits are held inline and operated on with overflow checks;
+// only results outside that range are promoted to a heap-allocated cpp_int.
+// The representation is canonical: _big is set if and only if the value does not fit in an int64_t.
 class z_number final {
   private:
-    cpp_int _n{nullptr};
+    int64_t _small{0};
+    std::unique_ptr<cpp_int> _big;
+
+#ifdef __GNUC__
+    using wideint_t = __int128;
+#else
+    using wideint_t = boost::multiprecision::int128_t;
+#endif
+
+    static bool fits(const wideint_t& n) { return n >= LLONG_MIN && n <= LLONG_MAX; }
+
+    [[nodiscard]] bool is_small() const { return !_big; }
+
+    [[nodiscard]] cpp_int big() const { return _big ? *_big : cpp_int(_small); }
+
+    void set(cpp_int n) {
+        if (n >= LLONG_MIN && n <= LLONG_MAX) {
+            _small = static_cast<int64_t>(n);
+            _big.reset();
+        } else if (_big) {
+            *_big = std::move(n);
+        } else {
+            _big = std::make_unique<cpp_int>(std::move(n));
+        }
+    }
+
+    void set(wideint_t n) {
+        if (fits(n)) {
+            _small = static_cast<int64_t>(n);
+            _big.reset();
+        } else {
+            set(cpp_int(n));
+        }
+    }
+
+    // Compare with x; only valid when at least one side is a bignum.
+    [[nodiscard]] int compare_slow(const z_number& x) const {
+        // A canonical bignum lies outside the int64 range, so its sign decides against a small value.
+        if (is_small()) {
+            return x._big->sign() > 0 ? -1 : 1;
+        }
+        if (x.is_small()) {
+            return _big->sign() > 0 ? 1 : -1;
+        }
+        return _big->compare(*x._big);
+    }
+
+    [[nodiscard]] int compare(const z_number& x) const {
+        if (is_small() && x.is_small()) {
+            return (_small < x._small) ? -1 : (_small > x._small) ? 1 : 0;
+        }
+        return compare_slow(x);
+    }
 
   public:
     z_number() = default;
-    z_number(cpp_int n) : _n(std::move(n)) {}
-    explicit z_number(const std::string& s) { _n = cpp_int(s); }
+    z_number(cpp_int n) { set(std::move(n)); }
+    explicit z_number(const std::string& s) { set(cpp_int(s)); }
 
-    z_number(signed long long int n) { _n = n; }
-    z_number(unsigned long long int n) { _n = n; }
-    z_number(int n) { _n = n; }
-    z_number(unsigned int n) { _n = n; }
-    z_number(long n) { _n = n; }
+    z_number(signed long long int n) : _small(n) {}
+    z_number(unsigned long long int n) {
+        if (n <= LLONG_MAX) {
+            _small = static_cast<int64_t>(n);
+        } else {
+            _big = std::make_unique<cpp_int>(n);
+        }
+    }
+    z_number(int n) : _small(n) {}
+    z_number(unsigned int n) : _small(n) {}
+    z_number(long n) : _small(n) {}
+
+    z_number(const z_number& x) : _small(x._small), _big(x._big ? std::make_unique<cpp_int>(*x._big) : nullptr) {}
+    z_number(z_number&& x) noexcept = default;
+
+    z_number& operator=(const z_number& x) {
+        if (this != &x) {
+            _small = x._small;
+            if (x._big) {
+                _big = std::make_unique<cpp_int>(*x._big);
+            } else {
+                _big.reset();
+            }
+        }
+        return *this;
+    }
+    z_number& operator=(z_number&& x) noexcept = default;
 
     // overloaded typecast operators
     explicit operator int64_t() const {
         if (!fits_sint64()) {
-            CRAB_ERROR("z_number ", _n.str(), " does not fit into a signed 64-bit integer");
+            CRAB_ERROR("z_number ", *this, " does not fit into a signed 64-bit integer");
         } else {
-            return (int64_t)_n;
+            return _small;
         }
     }
 
     explicit operator uint64_t() const {
         if (!fits_uint64()) {
-            CRAB_ERROR("z_number ", _n.str(), " does not fit into an unsigned 64-bit integer");
+            CRAB_ERROR("z_number ", *this, " does not fit into an unsigned 64-bit integer");
         } else {
-            return (uint64_t)_n;
+            return is_small() ? static_cast<uint64_t>(_small) : static_cast<uint64_t>(*_big);
         }
     }
 
     explicit operator int() const {
         if (!fits_sint()) {
-            CRAB_ERROR("z_number ", _n.str(), " does not fit into a signed integer");
+            CRAB_ERROR("z_number ", *this, " does not fit into a signed integer");
         } else {
-            return (int)_n;
+            return static_cast<int>(_small);
         }
     }
 
     explicit operator unsigned int() const {
         if (!fits_uint()) {
-            CRAB_ERROR("z_number ", _n.str(), " does not fit into an unsigned integer");
+            CRAB_ERROR("z_number ", *this, " does not fit into an unsigned integer");
         } else {
-            return (unsigned int)_n;
+            return static_cast<unsigned int>(_small);
         }
     }
 
-    explicit operator cpp_int() const { return _n; }
+    explicit operator cpp_int() const { return big(); }
 
     [[nodiscard]] std::size_t hash() const {
-        boost::hash<std::string> hasher;
-        return hasher(_n.str());
+        if (is_small()) {
+            return boost::hash<int64_t>{}(_small);
+        }
+        std::size_t seed = boost::hash_range(_big->backend().limbs(), _big->backend().limbs() + _big->backend().size());
+        boost::hash_combine(seed, _big->sign());
+        return seed;
     }
 
-    [[nodiscard]] bool fits_sint() const {
-        return ((_n >= INT_MIN) && (_n <= INT_MAX));
-    }
+    [[nodiscard]] bool fits_sint() const { return is_small() && _small >= INT_MIN && _small <= INT_MAX; }
 
-    [[nodiscard]] bool fits_uint() const { return ((_n >= 0) && (_n <= UINT_MAX)); }
+    [[nodiscard]] bool fits_uint() const { return is_small() && _small >= 0 && _small <= UINT_MAX; }
 
-    [[nodiscard]] bool fits_sint64() const {
-        // "long long" is always 64-bits, whereas "long" varies
-        // (see https://en.cppreference.com/w/cpp/language/types)
-        // so make sure we use 64-bit numbers.
-        return ((_n >= LLONG_MIN) && (_n <= LLONG_MAX));
-    }
+    [[nodiscard]] bool fits_sint64() const { return is_small(); }
 
-    [[nodiscard]] bool fits_uint64() const { return ((_n >= 0) && (_n <= ULLONG_MAX)); }
+    [[nodiscard]] bool fits_uint64() const {
+        if (is_small()) {
+            return _small >= 0;
+        }
+        return _big->sign() > 0 && *_big <= ULLONG_MAX;
+    }
 
     z_number operator+(const z_number& x) const {
-        return z_number(_n + x._n);
+        z_number r;
+        if (is_small() && x.is_small()) {
+            r.set((wideint_t)_small + (wideint_t)x._small);
+        } else {
+            r.set(big() + x.big());
+        }
+        return r;
     }
 
     z_number operator+(int x) const { return operator+(z_number(x)); }
 
-    z_number operator*(const z_number& x) const { return z_number(_n * x._n); }
+    z_number operator*(const z_number& x) const {
+        z_number r;
+        if (is_small() && x.is_small()) {
+            r.set((wideint_t)_small * (wideint_t)x._small);
+        } else {
+            r.set(big() * x.big());
+        }
+        return r;
+    }
 
     z_number operator*(int x) const { return operator*(z_number(x)); }
 
-    z_number operator-(const z_number& x) const { return z_number(_n - x._n); }
+    z_number operator-(const z_number& x) const {
+        z_number r;
+        if (is_small() && x.is_small()) {
+            r.set((wideint_t)_small - (wideint_t)x._small);
+        } else {
+            r.set(big() - x.big());
+        }
+        return r;
+    }
 
     z_number operator-(int x) const { return operator-(z_number(x)); }
 
-    z_number operator-() const { return z_number(-_n); }
+    z_number operator-() const {
+        z_number r;
+        if (is_small()) {
+            r.set(-(wideint_t)_small);
+        } else {
+            r.set(-*_big);
+        }
+        return r;
+    }
 
     z_number operator/(const z_number& x) const {
-        if (x._n.is_zero()) {
+        if (x.is_zero()) {
             CRAB_ERROR("z_number: division by zero [1]");
         } else {
-            return z_number(_n / x._n);
+            z_number r;
+            if (is_small() && x.is_small()) {
+                // Both operands are truncated towards zero, as cpp_int does.
+                r.set((wideint_t)_small / (wideint_t)x._small);
+            } else {
+                r.set(big() / x.big());
+            }
+            return r;
         }
     }
 
     z_number operator/(int x) const { return operator/(z_number(x)); }
 
     z_number operator%(const z_number& x) const {
-        if (x._n.is_zero()) {
+        if (x.is_zero()) {
             CRAB_ERROR("z_number: division by zero [2]");
         } else {
-            return z_number(_n % x._n);
+            z_number r;
+            if (is_small() && x.is_small()) {
+                r.set((wideint_t)_small % (wideint_t)x._small);
+            } else {
+                r.set(big() % x.big());
+            }
+            return r;
         }
     }
 
     z_number operator%(int x) const { return operator%(z_number(x)); }
 
-    z_number& operator+=(const z_number& x) {
-        _n += x._n;
-        return *this;
-    }
+    z_number& operator+=(const z_number& x) { return *this = *this + x; }
 
     z_number& operator+=(int x) { return operator+=(z_number(x)); }
 
-    z_number& operator*=(const z_number& x) {
-        _n *= x._n;
-        return *this;
-    }
+    z_number& operator*=(const z_number& x) { return *this = *this * x; }
 
     z_number& operator*=(int x) { return operator*=(z_number(x)); }
 
-    z_number& operator-=(const z_number& x) {
-        _n -= x._n;
-        return *this;
-    }
+    z_number& operator-=(const z_number& x) { return *this = *this - x; }
 
     z_number& operator-=(int x) { return operator-=(z_number(x)); }
 
     z_number& operator/=(const z_number& x) {
-        if (x._n.is_zero()) {
+        if (x.is_zero()) {
             CRAB_ERROR("z_number: division by zero [3]");
         } else {
-            _n /= x._n;
-            return *this;
+            return *this = *this / x;
         }
     }
 
     z_number& operator/=(int x) { return operator/=(z_number(x)); }
 
     z_number& operator%=(const z_number& x) {
-        if (x._n.is_zero()) {
+        if (x.is_zero()) {
             CRAB_ERROR("z_number: division by zero [4]");
         } else {
-            _n %= x._n;
-            return *this;
+            return *this = *this % x;
         }
     }
 
     z_number& operator%=(int x) { return operator%=(z_number(x)); }
 
     z_number& operator--() & {
-        _n--;
-        return *this;
+        if (is_small() && _small != LLONG_MIN) {
+            _small--;
+            return *this;
+        }
+        return *this = *this - 1;
     }
 
     z_number& operator++() & {
-        _n++;
-        return *this;
+        if (is_small() && _small != LLONG_MAX) {
+            _small++;
+            return *this;
+        }
+        return *this = *this + 1;
     }
 
     z_number operator++(int) & {
@@ -187,64 +307,95 @@ class z_number final {
         return r;
     }
 
+    [[nodiscard]] bool is_zero() const { return is_small() && _small == 0; }
+
     bool operator==(const z_number& x) const {
-        return (_n == x._n);
+        if (is_small() || x.is_small()) {
+            return is_small() && x.is_small() && _small == x._small;
+        }
+        return *_big == *x._big;
     }
 
-    bool operator==(int x) const { return operator==(z_number(x)); }
+    bool operator==(int x) const { return is_small() && _small == x; }
 
-    bool operator!=(const z_number& x) const { return (_n != x._n); }
+    bool operator!=(const z_number& x) const { return !operator==(x); }
 
-    bool operator!=(int x) const { return operator!=(z_number(x)); }
+    bool operator!=(int x) const { return !operator==(x); }
 
-    bool operator<(const z_number& x) const { return (_n < x._n); }
+    bool operator<(const z_number& x) const { return compare(x) < 0; }
 
     bool operator<(int x) const { return operator<(z_number(x)); }
 
-    bool operator<=(const z_number& x) const { return (_n <= x._n); }
+    bool operator<=(const z_number& x) const { return compare(x) <= 0; }
 
     bool operator<=(int x) const { return operator<=(z_number(x)); }
 
-    bool operator>(const z_number& x) const { return (_n > x._n); }
+    bool operator>(const z_number& x) const { return compare(x) > 0; }
 
     bool operator>(int x) const { return operator>(z_number(x)); }
 
-    bool operator>=(const z_number& x) const { return (_n >= x._n); }
+    bool operator>=(const z_number& x) const { return compare(x) >= 0; }
 
     bool operator>=(int x) const { return operator>=(z_number(x)); }
 
-    z_number operator&(const z_number& x) const { return z_number(_n & x._n); }
+    // Bitwise operations on negative values keep going through cpp_int so that their semantics are unchanged.
+    z_number operator&(const z_number& x) const {
+        if (is_small() && x.is_small() && _small >= 0 && x._small >= 0) {
+            return z_number(_small & x._small);
+        }
+        return z_number(big() & x.big());
+    }
 
-    z_number operator&(int x) const { return z_number(_n & x); }
+    z_number operator&(int x) const { return operator&(z_number(x)); }
 
-    z_number operator|(const z_number& x) const { return z_number(_n | x._n); }
+    z_number operator|(const z_number& x) const {
+        if (is_small() && x.is_small() && _small >= 0 && x._small >= 0) {
+            return z_number(_small | x._small);
+        }
+        return z_number(big() | x.big());
+    }
 
-    z_number operator|(int x) const { return z_number(_n | x); }
+    z_number operator|(int x) const { return operator|(z_number(x)); }
 
-    z_number operator^(const z_number& x) const { return z_number(_n ^ x._n); }
+    z_number operator^(const z_number& x) const {
+        if (is_small() && x.is_small() && _small >= 0 && x._small >= 0) {
+            return z_number(_small ^ x._small);
+        }
+        return z_number(big() ^ x.big());
+    }
 
-    z_number operator^(int x) const { return z_number(_n ^ x); }
+    z_number operator^(int x) const { return operator^(z_number(x)); }
 
     z_number operator<<(z_number x) const {
         if (!x.fits_sint()) {
-            CRAB_ERROR("z_number ", x._n.str(), " does not fit into an int");
+            CRAB_ERROR("z_number ", x, " does not fit into an int");
         }
-        return z_number(_n << (int)x);
+        return operator<<((int)x);
     }
 
-    z_number operator<<(int x) const { return z_number(_n << x); }
+    z_number operator<<(int x) const {
+        if (is_small() && _small >= 0 && x >= 0 && x < 63 && _small <= (LLONG_MAX >> x)) {
+            return z_number(_small << x);
+        }
+        return z_number(big() << x);
+    }
 
     z_number operator>>(z_number x) const {
         if (!x.fits_sint()) {
-            CRAB_ERROR("z_number ", x._n.str(), " does not fit into an int");
+            CRAB_ERROR("z_number ", x, " does not fit into an int");
         }
-        return z_number(_n >> (int)x);
+        return operator>>((int)x);
     }
 
-    z_number operator>>(int x) const { return z_number(_n >> x); }
+    z_number operator>>(int x) const {
+        if (is_small() && _small >= 0 && x >= 0) {
+            return z_number(x < 63 ? _small >> x : 0);
+        }
+        return z_number(big() >> x);
+    }
 
     [[nodiscard]] z_number fill_ones() const {
-        if (_n.is_zero()) {
+        if (is_zero()) {
             return z_number((signed long long)0);
         }
 
@@ -255,7 +406,10 @@ class z_number final {
     }
 
     friend std::ostream& operator<<(std::ostream& o, const z_number& z) {
-        return o << z._n.str();
+        if (z.is_small()) {
+            return o << z._small;
+        }
+        return o << z._big->str();
     }
 
 }; // class z_number
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <optional>
 
+#include "crab_utils/arena.hpp"
 #include "crab_utils/heap.hpp"
 
 //============================
@@ -32,8 +33,9 @@ class GraphPerm {
     using Weight = typename G::Weight;
     using g_neighbour_const_range = typename G::neighbour_const_range;
     using mut_val_ref_t = typename G::mut_val_ref_t;
+    using vert_vector = arena_vector<vert_id>;
 
-    GraphPerm(const std::vector<vert_id>& _perm, G& _g) : g(_g), perm(_perm), inv(_g.size(), -1) {
+    GraphPerm(const vert_vector& _perm, G& _g) : g(_g), perm(_perm), inv(_g.size(), -1) {
         for (unsigned int vi = 0; vi < perm.size(); vi++) {
             if (perm[vi] == -1)
                 continue;
@@ -112,7 +114,7 @@ class GraphPerm {
     template <class ItG>
     class adj_const_iterator final {
       public:
-        adj_const_iterator(const std::vector<vert_id>& _inv, const ItG& _v) : inv(_inv), v(_v) {}
+        adj_const_iterator(const vert_vector& _inv, const ItG& _v) : inv(_inv), v(_v) {}
 
         vert_id operator*() const { return inv[*v]; }
 
@@ -128,7 +130,7 @@ class GraphPerm {
         }
 
       private:
-        const std::vector<vert_id>& inv;
+        const vert_vector& inv;
         ItG v;
     };
 
@@ -137,7 +139,7 @@ class GraphPerm {
       public:
         using edge_ref = typename ItG::edge_ref;
 
-        e_adj_const_iterator(const std::vector<vert_id>& _inv, const ItG& _v) : inv(_inv), v(_v) {}
+        e_adj_const_iterator(const vert_vector& _inv, const ItG& _v) : inv(_inv), v(_v) {}
 
         edge_ref operator*() const { return edge_ref{inv[(*v).vert], (*v).val}; }
 
@@ -153,7 +155,7 @@ class GraphPerm {
         }
 
       private:
-        const std::vector<vert_id>& inv;
+        const vert_vector& inv;
         ItG v;
     };
 
@@ -164,10 +166,10 @@ class GraphPerm {
 
         using iterator = It;
 
-        adj_list(const std::vector<vert_id>& _perm, const std::vector<vert_id>& _inv, const RG& _adj)
+        adj_list(const vert_vector& _perm, const vert_vector& _inv, const RG& _adj)
             : perm(_perm), inv(_inv), adj(_adj) {}
 
-        adj_list(const std::vector<vert_id>& _perm, const std::vector<vert_id>& _inv) : perm(_perm), inv(_inv), adj() {}
+        adj_list(const vert_vector& _perm, const vert_vector& _inv) : perm(_perm), inv(_inv), adj() {}
 
         iterator begin() const {
             if (adj)
@@ -189,8 +191,8 @@ class GraphPerm {
         }
 
       private:
-        const std::vector<vert_id>& perm;
-        const std::vector<vert_id>& inv;
+        const vert_vector& perm;
+        const vert_vector& inv;
         std::optional<RG> adj;
     };
 
@@ -201,10 +203,10 @@ class GraphPerm {
 
         using iterator = It;
 
-        const_adj_list(const std::vector<vert_id>& _perm, const std::vector<vert_id>& _inv, const RG& _adj)
+        const_adj_list(const vert_vector& _perm, const vert_vector& _inv, const RG& _adj)
             : perm(_perm), inv(_inv), adj(_adj) {}
 
-        const_adj_list(const std::vector<vert_id>& _perm, const std::vector<vert_id>& _inv) : perm(_perm), inv(_inv), adj() {}
+        const_adj_list(const vert_vector& _perm, const vert_vector& _inv) : perm(_perm), inv(_inv), adj() {}
 
         iterator begin() const {
             if (adj)
@@ -226,8 +228,8 @@ class GraphPerm {
         }
 
       private:
-        const std::vector<vert_id>& perm;
-        const std::vector<vert_id>& inv;
+        const vert_vector& perm;
+        const vert_vector& inv;
         std::optional<RG> adj;
     };
 
@@ -264,8 +266,8 @@ class GraphPerm {
     }
 
     const G& g;
-    std::vector<vert_id> perm;
-    std::vector<vert_id> inv;
+    vert_vector perm;
+    vert_vector inv;
 };
 
 // View of a graph, omitting a given vertex
@@ -489,10 +491,13 @@ class GraphOps {
     using vert_id = typename graph_t::vert_id;
     using mut_val_ref_t = typename graph_t::mut_val_ref_t;
 
-    using edge_vector = std::vector<std::tuple<vert_id, vert_id, Weight>>;
+    // Temporaries of the graph operations are drawn from the arena of the verification.
+    using edge_vector = arena_vector<std::tuple<vert_id, vert_id, Weight>>;
+    using vert_vector = arena_vector<vert_id>;
+    using dist_vector = arena_vector<std::tuple<vert_id, Weight>>;
 
     using WtComp = DistComp<std::vector<Weight>>;
-    using WtHeap = Heap<WtComp>;
+    using WtHeap = Heap<WtComp, arena_allocator<int>>;
 
     using edge_ref = std::tuple<vert_id, vert_id, Weight>;
 
@@ -507,55 +512,60 @@ class GraphOps {
     enum QMarkT { BF_NONE = 0, BF_SCC = 1, BF_QUEUED = 2 };
     // ===========================================
     // Scratch space needed by the graph algorithms.
-    // Should really switch to some kind of arena allocator, rather
-    // than having all these static structures.
+    // It is kept by the arena of the verification, so it is allocated
+    // once per verification rather than once per operation.
     // ===========================================
-    static thread_local char* edge_marks;
-
-    // Used for Bellman-Ford queueing
-    static thread_local vert_id* dual_queue;
-    static thread_local int* vert_marks;
-    static thread_local size_t scratch_sz;
-
-    // For locality, should combine dists & dist_ts.
-    // Weight must have an empty constructor, but does _not_
-    // need a top or infty element.
-    // dist_ts tells us which distances are current,
-    // and ts_idx prevents wraparound problems, in the unlikely
-    // circumstance that we have more than 2^sizeof(uint) iterations.
-    static thread_local std::vector<Weight> dists;
-    static thread_local std::vector<Weight> dists_alt;
-    static thread_local std::vector<unsigned int> dist_ts;
-    static thread_local unsigned int ts;
-    static thread_local unsigned int ts_idx;
-
-    static void check_realloc(void** ptr, size_t size) {
-        void* newptr = realloc(*ptr, size);
-        if (newptr == nullptr)
-            throw std::bad_alloc();
-        *ptr = newptr;
-    }
+    struct scratch_t {
+        std::vector<char> edge_marks;
+
+        // Used for Bellman-Ford queueing
+        std::vector<vert_id> dual_queue;
+        std::vector<int> vert_marks;
+        size_t size{};
+
+        // For locality, should combine dists & dist_ts.
+        // Weight must have an empty constructor, but does _not_
+        // need a top or infty element.
+        // dist_ts tells us which distances are current,
+        // and ts_idx prevents wraparound problems, in the unlikely
+        // circumstance that we have more than 2^sizeof(uint) iterations.
+        std::vector<Weight> dists;
+        std::vector<Weight> dists_alt;
+        std::vector<unsigned int> dist_ts;
+        unsigned int ts{};
+        unsigned int ts_idx{};
+    };
+    // The scratch space of the arena that grow_scratch last saw.
+    static thread_local scratch_t* scratch;
+    static thread_local size_t scratch_owner;
 
     static void grow_scratch(size_t sz) {
-        if (sz <= scratch_sz)
+        arena_t& arena = scratch_arena();
+        if (arena.id() != scratch_owner) {
+            scratch = &arena.retained<scratch_t>();
+            scratch_owner = arena.id();
+        }
+        scratch_t& s = *scratch;
+        if (sz <= s.size)
             return;
 
-        size_t new_sz = scratch_sz;
+        size_t new_sz = s.size;
         if (new_sz == 0)
             new_sz = 10; // TODO: Introduce enums for init_sz and growth_factor
         while (new_sz < sz)
             new_sz = static_cast<size_t>(new_sz * 1.5);
 
-        check_realloc((void**)&edge_marks, sizeof(char) * new_sz * new_sz);
-        check_realloc((void**)&dual_queue, sizeof(vert_id) * 2 * new_sz);
-        check_realloc((void**)&vert_marks, sizeof(int) * new_sz);
-        scratch_sz = new_sz;
+        s.edge_marks.resize(new_sz * new_sz);
+        s.dual_queue.resize(2 * new_sz);
+        s.vert_marks.resize(new_sz);
+        s.size = new_sz;
+        arena.count_system_allocation();
 
         // Initialize new elements as necessary.
-        while (dists.size() < scratch_sz) {
-            dists.emplace_back();
-            dists_alt.emplace_back();
-            dist_ts.push_back(ts - 1);
+        while (s.dists.size() < s.size) {
+            s.dists.emplace_back();
+            s.dists_alt.emplace_back();
+            s.dist_ts.push_back(s.ts - 1);
         }
     }
 
@@ -615,7 +625,7 @@ class GraphOps {
     }
 
     template <class G1, class G2>
-    static graph_t widen(const G1& l, const G2& r, std::vector<vert_id>& unstable) {
+    static graph_t widen(const G1& l, const G2& r, vert_vector& unstable) {
         assert(l.size() == r.size());
         size_t sz = l.size();
         graph_t g;
@@ -644,51 +654,50 @@ class GraphOps {
     // Duped pretty much verbatim from Wikipedia
     // Abuses 'dual_queue' to store indices.
     template <class G>
-    static void strong_connect(const G& x, std::vector<vert_id>& stack, int& index, vert_id v,
-                               std::vector<std::vector<vert_id>>& sccs) {
-        vert_marks[v] = (index << 1) | 1;
+    static void strong_connect(const G& x, vert_vector& stack, int& index, vert_id v, arena_vector<vert_vector>& sccs) {
+        scratch->vert_marks[v] = (index << 1) | 1;
         // assert(vert_marks[v]&1);
-        dual_queue[v] = index;
+        scratch->dual_queue[v] = index;
         index++;
 
         stack.push_back(v);
 
         // Consider successors of v
         for (vert_id w : x.succs(v)) {
-            if (!vert_marks[w]) {
+            if (!scratch->vert_marks[w]) {
                 strong_connect(x, stack, index, w, sccs);
-                dual_queue[v] = std::min(dual_queue[v], dual_queue[w]);
-            } else if (vert_marks[w] & 1) {
+                scratch->dual_queue[v] = std::min(scratch->dual_queue[v], scratch->dual_queue[w]);
+            } else if (scratch->vert_marks[w] & 1) {
                 // W is on the stack
-                dual_queue[v] = std::min(dual_queue[v], (vert_id)(vert_marks[w] >> 1));
+                scratch->dual_queue[v] = std::min(scratch->dual_queue[v], (vert_id)(scratch->vert_marks[w] >> 1));
             }
         }
 
         // If v is a root node, pop the stack and generate an SCC
-        if (dual_queue[v] == (vert_marks[v] >> 1)) {
+        if (scratch->dual_queue[v] == (scratch->vert_marks[v] >> 1)) {
             sccs.emplace_back();
-            std::vector<vert_id>& scc(sccs.back());
+            vert_vector& scc(sccs.back());
             int w;
             do {
                 w = stack.back();
                 stack.pop_back();
-                vert_marks[w] &= (~1);
+                scratch->vert_marks[w] &= (~1);
                 scc.push_back(w);
             } while (v != w);
         }
     }
 
     template <class G>
-    static void compute_sccs(const G& x, std::vector<std::vector<vert_id>>& out_scc) {
+    static void compute_sccs(const G& x, arena_vector<vert_vector>& out_scc) {
         size_t sz = x.size();
         grow_scratch(sz);
 
         for (vert_id v : x.verts())
-            vert_marks[v] = 0;
+            scratch->vert_marks[v] = 0;
         int index = 1;
-        std::vector<vert_id> stack;
+        vert_vector stack;
         for (vert_id v : x.verts()) {
-            if (!vert_marks[v])
+            if (!scratch->vert_marks[v])
                 strong_connect(x, stack, index, v, out_scc);
         }
         /*
@@ -704,7 +713,7 @@ class GraphOps {
         */
 
         for (vert_id v : x.verts())
-            vert_marks[v] = 0;
+            scratch->vert_marks[v] = 0;
     }
 
     // Run Bellman-Ford to compute a valid model of a set of difference constraints.
@@ -715,7 +724,7 @@ class GraphOps {
         assert(potentials.size() >= sz);
         grow_scratch(sz);
 
-        std::vector<std::vector<vert_id>> sccs;
+        arena_vector<vert_vector> sccs;
         compute_sccs(g, sccs);
 
         // Currently trusting the call-site to select reasonable
@@ -734,17 +743,17 @@ class GraphOps {
         // for(std::vector<vert_id>& scc : sccs)
         // Current implementation returns sccs in reverse topological order.
         for (auto it = sccs.rbegin(); it != sccs.rend(); ++it) {
-            std::vector<vert_id>& scc(*it);
+            vert_vector& scc(*it);
 
-            vert_id* qhead = dual_queue;
+            vert_id* qhead = scratch->dual_queue.data();
             vert_id* qtail = qhead;
 
-            vert_id* next_head = dual_queue + sz;
+            vert_id* next_head = scratch->dual_queue.data() + sz;
             vert_id* next_tail = next_head;
 
             for (vert_id v : scc) {
                 *qtail = v;
-                vert_marks[v] = BF_SCC | BF_QUEUED;
+                scratch->vert_marks[v] = BF_SCC | BF_QUEUED;
                 qtail++;
             }
 
@@ -752,7 +761,7 @@ class GraphOps {
                 for (; qtail != qhead;) {
                     vert_id s = *(--qtail);
                     // If it _was_ on the queue, it must be in the SCC
-                    vert_marks[s] = BF_SCC;
+                    scratch->vert_marks[s] = BF_SCC;
 
                     Weight s_pot = potentials[s];
 
@@ -761,9 +770,9 @@ class GraphOps {
                         Weight sd_pot = s_pot + e.val;
                         if (sd_pot < potentials[d]) {
                             potentials[d] = sd_pot;
-                            if (vert_marks[d] == BF_SCC) {
+                            if (scratch->vert_marks[d] == BF_SCC) {
                                 *next_tail = d;
-                                vert_marks[d] = (BF_SCC | BF_QUEUED);
+                                scratch->vert_marks[d] = (BF_SCC | BF_QUEUED);
                                 next_tail++;
                             }
                         }
@@ -785,7 +794,7 @@ class GraphOps {
                     if (s_pot + e.val < potentials[d]) {
                         // Cleanup vertex marks
                         for (vert_id v : g.verts())
-                            vert_marks[v] = BF_NONE;
+                            scratch->vert_marks[v] = BF_NONE;
                         return false;
                     }
                 }
@@ -804,7 +813,7 @@ class GraphOps {
         grow_scratch(sz);
         delta.clear();
 
-        std::vector<std::vector<vert_id>> colour_succs(2 * sz);
+        arena_vector<vert_vector> colour_succs(2 * sz);
 
         // Partition edges into r-only/rb/b-only.
         for (vert_id s : g.verts()) {
@@ -827,13 +836,13 @@ class GraphOps {
                 case E_RIGHT: colour_succs[2 * s + 1].push_back(d); break;
                 default: break;
                 }
-                edge_marks[sz * s + d] = mark;
+                scratch->edge_marks[sz * s + d] = mark;
             }
         }
 
         // We can run the chromatic Dijkstra variant
         // on each source.
-        std::vector<std::tuple<vert_id, Weight>> adjs;
+        dist_vector adjs;
         //      for(vert_id v = 0; v < sz; v++)
         for (vert_id v : g.verts()) {
             adjs.clear();
@@ -856,35 +865,35 @@ class GraphOps {
     // P is some vector-alike holding a valid system of potentials.
     // Don't need to clear/initialize
     template <class G, class P>
-    static void chrome_dijkstra(const G& g, const P& p, std::vector<std::vector<vert_id>>& colour_succs, vert_id src,
-                                std::vector<std::tuple<vert_id, Weight>>& out) {
+    static void chrome_dijkstra(const G& g, const P& p, arena_vector<vert_vector>& colour_succs, vert_id src,
+                                dist_vector& out) {
         size_t sz = g.size();
         if (sz == 0)
             return;
         grow_scratch(sz);
 
         // Reset all vertices to infty.
-        dist_ts[ts_idx] = ts++;
-        ts_idx = (ts_idx + 1) % dists.size();
+        scratch->dist_ts[scratch->ts_idx] = scratch->ts++;
+        scratch->ts_idx = (scratch->ts_idx + 1) % scratch->dists.size();
 
-        dists[src] = Weight(0);
-        dist_ts[src] = ts;
+        scratch->dists[src] = Weight(0);
+        scratch->dist_ts[src] = scratch->ts;
 
-        WtComp comp(dists);
+        WtComp comp(scratch->dists);
         WtHeap heap(comp);
 
         for (auto e : g.e_succs(src)) {
             vert_id dest = e.vert;
-            dists[dest] = p[src] + e.val - p[dest];
-            dist_ts[dest] = ts;
+            scratch->dists[dest] = p[src] + e.val - p[dest];
+            scratch->dist_ts[dest] = scratch->ts;
 
-            vert_marks[dest] = edge_marks[sz * src + dest];
+            scratch->vert_marks[dest] = scratch->edge_marks[sz * src + dest];
             heap.insert(dest);
         }
 
         while (!heap.empty()) {
             int es = heap.removeMin();
-            Weight es_cost = dists[es] + p[es]; // If it's on the queue, distance is not infinite.
+            Weight es_cost = scratch->dists[es] + p[es]; // If it's on the queue, distance is not infinite.
             Weight es_val = es_cost - p[src];
             {
                 auto w = g.lookup(src, es);
@@ -892,26 +901,26 @@ class GraphOps {
                     out.emplace_back(es, es_val);
             }
 
-            if (vert_marks[es] == (E_LEFT | E_RIGHT))
+            if (scratch->vert_marks[es] == (E_LEFT | E_RIGHT))
                 continue;
 
             // Pick the appropriate set of successors
-            std::vector<vert_id>& es_succs =
-                (vert_marks[es] == E_LEFT) ? colour_succs[2 * es + 1] : colour_succs[2 * es];
+            vert_vector& es_succs =
+                (scratch->vert_marks[es] == E_LEFT) ? colour_succs[2 * es + 1] : colour_succs[2 * es];
             for (vert_id ed : es_succs) {
                 Weight v = es_cost + g.edge_val(es, ed) - p[ed];
-                if (dist_ts[ed] != ts || v < dists[ed]) {
-                    dists[ed] = v;
-                    dist_ts[ed] = ts;
-                    vert_marks[ed] = edge_marks[sz * es + ed];
+                if (scratch->dist_ts[ed] != scratch->ts || v < scratch->dists[ed]) {
+                    scratch->dists[ed] = v;
+                    scratch->dist_ts[ed] = scratch->ts;
+                    scratch->vert_marks[ed] = scratch->edge_marks[sz * es + ed];
 
                     if (heap.inHeap(ed)) {
                         heap.decrease(ed);
                     } else {
                         heap.insert(ed);
                     }
-                } else if (v == dists[ed]) {
-                    vert_marks[ed] |= edge_marks[sz * es + ed];
+                } else if (v == scratch->dists[ed]) {
+                    scratch->vert_marks[ed] |= scratch->edge_marks[sz * es + ed];
                 }
             }
         }
@@ -922,7 +931,7 @@ class GraphOps {
     // GKG: Factor out common elements of this & the previous algorithm.
     template <class G, class P, class S>
     static void dijkstra_recover(const G& g, const P& p, const S& is_stable, vert_id src,
-                                 std::vector<std::tuple<vert_id, Weight>>& out) {
+                                 dist_vector& out) {
         size_t sz = g.size();
         if (sz == 0)
             return;
@@ -932,34 +941,34 @@ class GraphOps {
         grow_scratch(sz);
 
         // Reset all vertices to infty.
-        dist_ts[ts_idx] = ts++;
-        ts_idx = (ts_idx + 1) % dists.size();
+        scratch->dist_ts[scratch->ts_idx] = scratch->ts++;
+        scratch->ts_idx = (scratch->ts_idx + 1) % scratch->dists.size();
 
-        dists[src] = Weight(0);
-        dist_ts[src] = ts;
+        scratch->dists[src] = Weight(0);
+        scratch->dist_ts[src] = scratch->ts;
 
-        WtComp comp(dists);
+        WtComp comp(scratch->dists);
         WtHeap heap(comp);
 
         for (auto e : g.e_succs(src)) {
             vert_id dest = e.vert;
-            dists[dest] = p[src] + e.val - p[dest];
-            dist_ts[dest] = ts;
+            scratch->dists[dest] = p[src] + e.val - p[dest];
+            scratch->dist_ts[dest] = scratch->ts;
 
-            vert_marks[dest] = V_UNSTABLE;
+            scratch->vert_marks[dest] = V_UNSTABLE;
             heap.insert(dest);
         }
 
         while (!heap.empty()) {
             int es = heap.removeMin();
-            Weight es_cost = dists[es] + p[es]; // If it's on the queue, distance is not infinite.
+            Weight es_cost = scratch->dists[es] + p[es]; // If it's on the queue, distance is not infinite.
             Weight es_val = es_cost - p[src];
             {
                 auto w = g.lookup(src, es);
                 if (!w || *w > es_val)
                     out.emplace_back(es, es_val);
             }
-            if (vert_marks[es] == V_STABLE)
+            if (scratch->vert_marks[es] == V_STABLE)
                 continue;
 
             char es_mark = is_stable[es] ? V_STABLE : V_UNSTABLE;
@@ -968,18 +977,18 @@ class GraphOps {
             for (auto e : g.e_succs(es)) {
                 vert_id ed = e.vert;
                 Weight v = es_cost + e.val - p[ed];
-                if (dist_ts[ed] != ts || v < dists[ed]) {
-                    dists[ed] = v;
-                    dist_ts[ed] = ts;
-                    vert_marks[ed] = es_mark;
+                if (scratch->dist_ts[ed] != scratch->ts || v < scratch->dists[ed]) {
+                    scratch->dists[ed] = v;
+                    scratch->dist_ts[ed] = scratch->ts;
+                    scratch->vert_marks[ed] = es_mark;
 
                     if (heap.inHeap(ed)) {
                         heap.decrease(ed);
                     } else {
                         heap.insert(ed);
                     }
-                } else if (v == dists[ed]) {
-                    vert_marks[ed] |= es_mark;
+                } else if (v == scratch->dists[ed]) {
+                    scratch->vert_marks[ed] |= es_mark;
                 }
             }
         }
@@ -993,15 +1002,15 @@ class GraphOps {
         grow_scratch(sz);
 
         for (vert_id vi : g.verts()) {
-            dists[vi] = Weight(0);
-            dists_alt[vi] = p[vi];
+            scratch->dists[vi] = Weight(0);
+            scratch->dists_alt[vi] = p[vi];
         }
-        dists[jj] = p[ii] + g.edge_val(ii, jj) - p[jj];
+        scratch->dists[jj] = p[ii] + g.edge_val(ii, jj) - p[jj];
 
-        if (dists[jj] >= Weight(0))
+        if (scratch->dists[jj] >= Weight(0))
             return true;
 
-        WtComp comp(dists);
+        WtComp comp(scratch->dists);
         WtHeap heap(comp);
 
         heap.insert(jj);
@@ -1009,14 +1018,14 @@ class GraphOps {
         while (!heap.empty()) {
             int es = heap.removeMin();
 
-            dists_alt[es] = p[es] + dists[es];
+            scratch->dists_alt[es] = p[es] + scratch->dists[es];
 
             for (auto e : g.e_succs(es)) {
                 vert_id ed = e.vert;
-                if (dists_alt[ed] == p[ed]) {
-                    Weight gnext_ed = dists_alt[es] + e.val - dists_alt[ed];
-                    if (gnext_ed < dists[ed]) {
-                        dists[ed] = gnext_ed;
+                if (scratch->dists_alt[ed] == p[ed]) {
+                    Weight gnext_ed = scratch->dists_alt[es] + e.val - scratch->dists_alt[ed];
+                    if (gnext_ed < scratch->dists[ed]) {
+                        scratch->dists[ed] = gnext_ed;
                         if (heap.inHeap(ed)) {
                             heap.decrease(ed);
                         } else {
@@ -1026,11 +1035,11 @@ class GraphOps {
                 }
             }
         }
-        if (dists[ii] < Weight(0))
+        if (scratch->dists[ii] < Weight(0))
             return false;
 
         for (vert_id v : g.verts())
-            p[v] = dists_alt[v];
+            p[v] = scratch->dists_alt[v];
 
         return true;
     }
@@ -1044,14 +1053,14 @@ class GraphOps {
         for (vert_id v : g.verts()) {
             // We're abusing edge_marks to store _vertex_ flags.
             // Should really just switch this to allocating types of a fixed-size buffer.
-            edge_marks[v] = is_stable[v] ? V_STABLE : V_UNSTABLE;
+            scratch->edge_marks[v] = is_stable[v] ? V_STABLE : V_UNSTABLE;
         }
 
-        std::vector<std::tuple<vert_id, Weight>> aux;
+        dist_vector aux;
         for (vert_id v : g.verts()) {
-            if (!edge_marks[v]) {
+            if (!scratch->edge_marks[v]) {
                 aux.clear();
-                dijkstra_recover(g, p, edge_marks, v, aux);
+                dijkstra_recover(g, p, scratch->edge_marks, v, aux);
                 for (auto [vid, wt] : aux)
                     delta.emplace_back(v, vid, wt);
             }
@@ -1066,7 +1075,7 @@ class GraphOps {
       public:
         explicit AdjCmp(const P& _p) : p(_p) {}
 
-        bool operator()(vert_id d1, vert_id d2) const { return (dists[d1] - p[d1]) < (dists[d2] - p[d2]); }
+        bool operator()(vert_id d1, vert_id d2) const { return (scratch->dists[d1] - p[d1]) < (scratch->dists[d2] - p[d2]); }
 
       protected:
         const P& p;
@@ -1093,19 +1102,19 @@ class GraphOps {
     // Compute the transitive closure of edges reachable from v, assuming
     // (1) the subgraph G \ {v} is closed, and (2) P is a valid model of G.
     template <class G, class P>
-    static void close_after_assign_fwd(const G& g, const P& p, vert_id v, std::vector<std::tuple<vert_id, Weight>>& aux) {
+    static void close_after_assign_fwd(const G& g, const P& p, vert_id v, dist_vector& aux) {
         // Initialize the queue and distances.
         for (vert_id u : g.verts())
-            vert_marks[u] = 0;
+            scratch->vert_marks[u] = 0;
 
-        vert_marks[v] = BF_QUEUED;
-        dists[v] = Weight(0);
-        vert_id* adj_head = dual_queue;
+        scratch->vert_marks[v] = BF_QUEUED;
+        scratch->dists[v] = Weight(0);
+        vert_id* adj_head = scratch->dual_queue.data();
         vert_id* adj_tail = adj_head;
         for (auto e : g.e_succs(v)) {
             vert_id d = e.vert;
-            vert_marks[d] = BF_QUEUED;
-            dists[d] = e.val;
+            scratch->vert_marks[d] = BF_QUEUED;
+            scratch->dists[d] = e.val;
             //        assert(p[v] + dists[d] - p[d] >= Weight(0));
             *adj_tail = d;
             adj_tail++;
@@ -1118,26 +1127,26 @@ class GraphOps {
         for (; adj_head < adj_tail; adj_head++) {
             vert_id d = *adj_head;
 
-            Weight d_wt = dists[d];
+            Weight d_wt = scratch->dists[d];
             for (auto edge : g.e_succs(d)) {
                 vert_id e = edge.vert;
                 Weight e_wt = d_wt + edge.val;
-                if (!vert_marks[e]) {
-                    dists[e] = e_wt;
-                    vert_marks[e] = BF_QUEUED;
+                if (!scratch->vert_marks[e]) {
+                    scratch->dists[e] = e_wt;
+                    scratch->vert_marks[e] = BF_QUEUED;
                     *reach_tail = e;
                     reach_tail++;
                 } else {
-                    dists[e] = std::min(e_wt, dists[e]);
+                    scratch->dists[e] = std::min(e_wt, scratch->dists[e]);
                 }
             }
         }
 
         // Now collect the adjacencies, and clear vertex flags
         // FIXME: This collects _all_ edges from x, not just new ones.
-        for (adj_head = dual_queue; adj_head < reach_tail; adj_head++) {
-            aux.emplace_back(*adj_head, dists[*adj_head]);
-            vert_marks[*adj_head] = 0;
+        for (adj_head = scratch->dual_queue.data(); adj_head < reach_tail; adj_head++) {
+            aux.emplace_back(*adj_head, scratch->dists[*adj_head]);
+            scratch->vert_marks[*adj_head] = 0;
         }
     }
 
@@ -1146,13 +1155,13 @@ class GraphOps {
         size_t sz = g.size();
         grow_scratch(sz);
         {
-            std::vector<std::tuple<vert_id, Weight>> aux;
+            dist_vector aux;
             close_after_assign_fwd(g, p, v, aux);
             for (auto [vid, wt] : aux)
                 delta.emplace_back(v, vid, wt);
         }
         {
-            std::vector<std::tuple<vert_id, Weight>> aux;
+            dist_vector aux;
             GraphRev<const G> g_rev(g);
             close_after_assign_fwd(g_rev, make_negp(p), v, aux);
             for (auto [vid, wt] : aux)
@@ -1161,30 +1170,10 @@ class GraphOps {
     }
 };
 
-// Static data allocation
-template <class Weight>
-thread_local char* GraphOps<Weight>::edge_marks = nullptr;
-
-// Used for Bellman-Ford queueing
-template <class Weight>
-thread_local typename GraphOps<Weight>::vert_id* GraphOps<Weight>::dual_queue = NULL;
-
-template <class Weight>
-thread_local int* GraphOps<Weight>::vert_marks = nullptr;
-
-template <class Weight>
-thread_local size_t GraphOps<Weight>::scratch_sz = 0;
-
-template <class G>
-thread_local std::vector<typename G::Weight> GraphOps<G>::dists;
-template <class G>
-thread_local std::vector<typename G::Weight> GraphOps<G>::dists_alt;
-template <class G>
-thread_local std::vector<unsigned int> GraphOps<G>::dist_ts;
 template <class G>
-thread_local unsigned int GraphOps<G>::ts = 0;
+thread_local typename GraphOps<G>::scratch_t* GraphOps<G>::scratch = nullptr;
 template <class G>
-thread_local unsigned int GraphOps<G>::ts_idx = 0;
+thread_local size_t GraphOps<G>::scratch_owner = 0;
 
 } // namespace crab
 #ifdef __GNUC__
@@ -21,6 +21,7 @@ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
 OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************************************/
+#include <memory>
 #include <vector>
 
 //=========================================================================================
@@ -29,11 +30,11 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace crab {
 
-template <class Comp>
+template <class Comp, class Alloc = std::allocator<int>>
 class Heap {
     Comp lt;
-    std::vector<int> heap;    // heap of ints
-    std::vector<int> indices; // int -> index in heap
+    std::vector<int, Alloc> heap;    // heap of ints
+    std::vector<int, Alloc> indices; // int -> index in heap
 
     // Index "traversal" functions
     static inline int left(int i) { return i * 2 + 1; }
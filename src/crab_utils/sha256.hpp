@@ -0,0 +1,41 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace crab {
+
+// SHA-256 as specified in FIPS 180-4, for keys that must not collide even when chosen by an adversary.
+class sha256_t final {
+    std::array<uint32_t, 8> h{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array<uint8_t, 64> block{};
+    size_t block_size{};
+    uint64_t total_bytes{};
+
+    void compress();
+
+  public:
+    void update(const void* data, size_t size);
+
+    template <typename T>
+    void update_value(const T& value) {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+        update(&value, sizeof(value));
+    }
+
+    void update_string(const std::string& s) {
+        update_value(s.size());
+        update(s.data(), s.size());
+    }
+
+    // The digest of everything added so far, as 64 hexadecimal digits. No more can be added afterwards.
+    std::string hex_digest();
+};
+
+} // namespace crab
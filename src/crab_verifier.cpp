@@ -10,29 +10,38 @@
 #include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
 
 #include "crab/ebpf_domain.hpp"
 #include "crab/fwd_analyzer.hpp"
+#include "crab_utils/arena.hpp"
 
 #include "asm_syntax.hpp"
 #include "crab_verifier.hpp"
+#include "invariant_snapshot.hpp"
 #include "string_constraints.hpp"
+#include "verification_cache.hpp"
+#include "verification_context.hpp"
 
 using std::string;
 
-thread_local program_info global_program_info;
-thread_local ebpf_verifier_options_t thread_local_options;
-
 // Toy database to store invariants.
 struct checks_db final {
     std::map<label_t, std::vector<std::string>> m_db;
     int total_warnings{};
     int total_unreachable{};
     int max_instruction_count{};
+    int reused_blocks{};
+    numeric_domain_t tier{numeric_domain_t::zones};
+    std::vector<loop_stats_t> loops;
+    bool timed_out{};
+    std::string timeout_loop_head;
     std::set<label_t> maybe_nonterminating;
 
     void add(const label_t& label, const std::string& msg) {
@@ -57,18 +66,39 @@ struct checks_db final {
     checks_db() = default;
 };
 
-static checks_db generate_report(cfg_t& cfg,
-                                 crab::invariant_table_t& pre_invariants,
-                                 crab::invariant_table_t& post_invariants) {
-    checks_db m_db;
-    for (const label_t& label : cfg.sorted_labels()) {
-        basic_block_t& bb = cfg.get_node(label);
-        ebpf_domain_t from_inv(pre_invariants.at(label));
-        from_inv.set_require_check([&m_db, label](auto& inv, const linear_constraint_t& cst, const std::string& s) {
+// What the report needs to know about each basic block, as found on its latest visit by the fixpoint iterator.
+// Blocks that are never visited keep the default, bottom, facts.
+struct block_facts_t {
+    bool pre_is_bottom{true};
+    bool post_is_bottom{true};
+    int instruction_count_upper_bound{zone_domain_t::bottom().get_instruction_count_upper_bound()};
+    std::vector<std::string> warnings;
+};
+using block_facts_table_t = std::vector<block_facts_t>; // Indexed by block id.
+
+// Check the assertions of each block while the fixpoint is being computed, instead of re-running the transfer
+// functions once it is reached. Facts from earlier visits of a block are overwritten, so that only the ones found
+// on the final invariant remain. If facts_changed is given, it is called with each block whose warnings or
+// reachability a visit changes.
+template <typename Domain>
+static crab::visit_hooks_t<Domain> collect_block_facts(block_facts_table_t& facts, bool check_termination,
+                                                       std::function<void(block_id_t)> facts_changed = {}) {
+    // The facts of the block being visited, as of its previous visit.
+    auto previous = std::make_shared<block_facts_t>();
+    auto before = [&facts, check_termination, previous](block_id_t id, Domain& pre) {
+        block_facts_t& block = facts[id];
+        *previous = block;
+        block.pre_is_bottom = pre.is_bottom();
+        if (check_termination) {
+            block.instruction_count_upper_bound = pre.get_instruction_count_upper_bound();
+        }
+        std::vector<std::string>& block_warnings = block.warnings;
+        block_warnings.clear();
+        pre.set_require_check([&block_warnings](auto& inv, const linear_constraint_t& cst, const std::string& s) {
             if (inv.is_bottom())
                 return true;
             if (cst.is_contradiction()) {
-                m_db.add_warning(label, s);
+                block_warnings.emplace_back(s);
                 return false;
             }
 
@@ -77,24 +107,42 @@ static checks_db generate_report(cfg_t& cfg,
                 return true;
             } else if (inv.intersect(cst)) {
                 // TODO: add_error() if imply negation
-                m_db.add_warning(label, s);
+                block_warnings.emplace_back(s);
                 return false;
             } else {
-                m_db.add_warning(label, s);
+                block_warnings.emplace_back(s);
                 return false;
             }
         });
+    };
+    auto after = [&facts, facts_changed, previous](block_id_t id, const Domain& post) {
+        block_facts_t& block = facts[id];
+        block.post_is_bottom = post.is_bottom();
+        if (facts_changed && (block.warnings != previous->warnings || block.pre_is_bottom != previous->pre_is_bottom ||
+                              block.post_is_bottom != previous->post_is_bottom)) {
+            facts_changed(id);
+        }
+    };
+    return {before, after};
+}
 
-        if (thread_local_options.check_termination) {
+static checks_db generate_report(const flat_cfg_t& cfg, const block_facts_table_t& facts, bool check_termination) {
+    checks_db m_db;
+    // Block ids follow the order of the labels.
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        const label_t& label = cfg.label(id);
+        const block_facts_t& block = facts[id];
+
+        if (check_termination) {
             // Pinpoint the places where divergence might occur.
             int min_instruction_count_upper_bound = INT_MAX;
-            for (const label_t& prev_label : bb.prev_blocks_set()) {
-                int instruction_count = pre_invariants.at(prev_label).get_instruction_count_upper_bound();
+            for (block_id_t prev : cfg.prev_nodes(id)) {
+                int instruction_count = facts[prev].instruction_count_upper_bound;
                 min_instruction_count_upper_bound = std::min(min_instruction_count_upper_bound, instruction_count);
             }
 
             constexpr int max_instructions = 100000;
-            int instruction_count_upper_bound = from_inv.get_instruction_count_upper_bound();
+            int instruction_count_upper_bound = block.instruction_count_upper_bound;
             if ((min_instruction_count_upper_bound < max_instructions) &&
                 (instruction_count_upper_bound >= max_instructions))
                 m_db.add_nontermination(label);
@@ -102,12 +150,12 @@ static checks_db generate_report(cfg_t& cfg,
             m_db.max_instruction_count = std::max(m_db.max_instruction_count, instruction_count_upper_bound);
         }
 
-        bool pre_bot = from_inv.is_bottom();
-
-        from_inv(bb, thread_local_options.check_termination);
+        for (const std::string& msg : block.warnings) {
+            m_db.add_warning(label, msg);
+        }
 
-        if (!pre_bot && from_inv.is_bottom()) {
-            m_db.add_unreachable(label, std::string("Code is unreachable after ") + to_string(bb.label()));
+        if (!block.pre_is_bottom && block.post_is_bottom) {
+            m_db.add_unreachable(label, std::string("Code is unreachable after ") + to_string(label));
         }
     }
     return m_db;
@@ -145,96 +193,211 @@ static void print_report(std::ostream& os, const checks_db& db, const Instructio
     }
 }
 
-checks_db get_ebpf_report(std::ostream& s, cfg_t& cfg, program_info info, const ebpf_verifier_options_t* options) {
-    global_program_info = std::move(info);
-    crab::domains::clear_global_state();
-    variable_t::clear_thread_local_state();
-    thread_local_options = *options;
+// The deadline and the cancellation flag given to an analysis only hold until it returns: the flag belongs to the
+// caller and may be gone by then, and what runs later in the same context, e.g. ebpf_analyze_program_for_test,
+// must not be stopped by them.
+class stop_conditions_scope_t final {
+  public:
+    stop_conditions_scope_t() = default;
+    ~stop_conditions_scope_t() {
+        ebpf_verifier_options_t& options = verification_context_t::current().options;
+        options.deadline.reset();
+        options.cancelled = nullptr;
+    }
+    stop_conditions_scope_t(const stop_conditions_scope_t&) = delete;
+    stop_conditions_scope_t& operator=(const stop_conditions_scope_t&) = delete;
+};
+
+// If a snapshot of the invariants of a previous version of the program is given, the blocks that are unchanged
+// since then are not analyzed again, and the snapshot is replaced by one of this version.
+template <typename Domain>
+static checks_db analyze(std::ostream& s, const flat_cfg_t& cfg, program_info info,
+                         const ebpf_verifier_options_t* options, invariant_snapshot_t* snapshot) {
+    const std::string setup = snapshot ? verification_cache_t::setup_key(info, *options) : std::string();
+    verification_context_t::current().reset(std::move(info), *options);
+    const stop_conditions_scope_t stop_conditions;
 
     try {
-        // Get dictionaries of pre-invariants and post-invariants for each basic block.
-        ebpf_domain_t entry_dom = ebpf_domain_t::setup_entry(options->check_termination);
-        auto [pre_invariants, post_invariants] =
-            crab::run_forward_analyzer(cfg, std::move(entry_dom), options->check_termination);
+        std::vector<std::string> digests;
+        crab::settled_blocks_t<Domain> settled;
+        if (snapshot) {
+            digests = block_digests(cfg);
+            try {
+                settled = settle_blocks<Domain>(cfg, digests, setup, *snapshot);
+            } catch (std::runtime_error&) {
+                // An invariant that cannot be parsed is not a failure of the program, so analyze it all again.
+                settled = {};
+            }
+        }
+
+        // Get the pre-invariants and post-invariants for each basic block.
+        Domain entry_dom = Domain::setup_entry(options->check_termination);
+        block_facts_table_t facts(cfg.size());
+        crab::visit_hooks_t<Domain> hooks;
+        if (options->adaptive_narrowing) {
+            auto changes = std::make_shared<crab::cycle_changes_t>(cfg);
+            hooks = collect_block_facts<Domain>(facts, options->check_termination,
+                                                [changes](block_id_t id) { changes->mark(id); });
+            // Only refine a loop while that changes what the assertions checked in it find. The first call also
+            // sees the changes made by the increasing sequence, so that there is at least one refinement.
+            hooks.keep_refining = [changes](block_id_t head) { return changes->take(head); };
+        } else {
+            hooks = collect_block_facts<Domain>(facts, options->check_termination);
+        }
+        const crab::iteration_policy_t policy{
+            .widening_delay = options->widening_delay,
+            .descending_iterations = options->descending_iterations,
+        };
+        crab::invariant_tables_t<Domain> invariants =
+            crab::run_forward_analyzer(cfg, entry_dom, options->check_termination, hooks, settled, policy);
 
         // Analyze the control-flow graph.
-        checks_db db = generate_report(cfg, pre_invariants, post_invariants);
-        if (thread_local_options.print_invariants) {
-            for (const label_t& label : cfg.sorted_labels()) {
-                s << "\nPre-invariant : " << pre_invariants.at(label) << "\n";
-                s << cfg.get_node(label);
-                s << "\nPost-invariant: " << post_invariants.at(label) << "\n";
+        checks_db db = generate_report(cfg, facts, options->check_termination);
+        db.loops = crab::to_loop_stats(cfg, invariants.cycle_iterations());
+        if (snapshot) {
+            db.reused_blocks = (int)std::count(settled.settled.begin(), settled.settled.end(), true);
+            *snapshot = take_snapshot(cfg, digests, setup, invariants);
+        }
+        if (options->print_invariants) {
+            for (block_id_t id = 0; id < cfg.size(); id++) {
+                s << "\nPre-invariant : " << invariants.get_pre(id) << "\n";
+                print_block(s, cfg, id);
+                s << "\nPost-invariant: " << invariants.get_post(id) << "\n";
             }
         }
         return db;
+    } catch (verification_timeout_t& timeout) {
+        if (snapshot) {
+            *snapshot = {};
+        }
+        checks_db db;
+        db.timed_out = true;
+        db.timeout_loop_head = timeout.loop_head;
+        db.loops = std::move(timeout.loops);
+        db.add_warning(label_t::exit, timeout.loop_head.empty()
+                                          ? std::string("Verification timed out")
+                                          : "Verification timed out in the loop at " + timeout.loop_head);
+        return db;
     } catch (std::runtime_error& e) {
         // Convert verifier runtime_error exceptions to failure.
+        if (snapshot) {
+            *snapshot = {};
+        }
         checks_db db;
         db.add_warning(label_t::exit, e.what());
         return db;
     }
 }
 
+// A tiered verification first analyzes the program with intervals, which is enough for most programs,
+// and only analyzes it again with zones if some assertion remains unproven. Snapshots are only taken of
+// the analysis with zones, so a verification that uses one is not tiered.
+checks_db get_ebpf_report(std::ostream& s, const flat_cfg_t& cfg, program_info info, const ebpf_verifier_options_t* options,
+                          invariant_snapshot_t* snapshot = nullptr) {
+    if (options->tiered && !snapshot) {
+        std::ostringstream intervals_log;
+        checks_db db = analyze<interval_domain_t>(intervals_log, cfg, info, options, nullptr);
+        if (db.total_warnings == 0 || db.timed_out) {
+            // A timeout is not a reason to analyze the program again, with a domain that is more expensive.
+            db.tier = numeric_domain_t::intervals;
+            s << intervals_log.str();
+            return db;
+        }
+    } else if (options->numeric_domain == numeric_domain_t::intervals) {
+        checks_db db = analyze<interval_domain_t>(s, cfg, std::move(info), options, snapshot);
+        db.tier = numeric_domain_t::intervals;
+        return db;
+    }
+    return analyze<zone_domain_t>(s, cfg, std::move(info), options, snapshot);
+}
+
+static void fill_stats(ebpf_verifier_stats_t& stats, const checks_db& report) {
+    stats.total_unreachable = report.total_unreachable;
+    stats.total_warnings = report.total_warnings;
+    stats.max_instruction_count = report.max_instruction_count;
+    stats.reused_blocks = report.reused_blocks;
+    stats.tier = report.tier;
+    stats.loops = report.loops;
+    stats.timed_out = report.timed_out;
+    stats.timeout_loop_head = report.timeout_loop_head;
+    const crab::arena_t::stats_t& arena = verification_context_t::current().arena->stats();
+    stats.scratch_allocations = arena.allocations;
+    stats.scratch_bytes = arena.bytes;
+    stats.scratch_peak_bytes = arena.peak_bytes;
+    stats.system_allocations = arena.system_allocations;
+}
+
 /// Returned value is true if the program passes verification.
-bool run_ebpf_analysis(std::ostream& s, cfg_t& cfg, const program_info& info, const ebpf_verifier_options_t* options,
+bool run_ebpf_analysis(std::ostream& s, const flat_cfg_t& cfg, const program_info& info, const ebpf_verifier_options_t* options,
                        ebpf_verifier_stats_t* stats) {
     if (options == nullptr)
         options = &ebpf_verifier_default_options;
     checks_db report = get_ebpf_report(s, cfg, info, options);
     if (stats) {
-        stats->total_unreachable = report.total_unreachable;
-        stats->total_warnings = report.total_warnings;
-        stats->max_instruction_count = report.max_instruction_count;
+        fill_stats(*stats, report);
     }
     return (report.total_warnings == 0);
 }
 
-static string_invariant_map to_string_invariant_map(crab::invariant_table_t& inv_table) {
-    string_invariant_map res;
-    for (auto& [label, inv]: inv_table) {
-        res.insert_or_assign(label, inv.to_set());
+static std::pair<string_invariant_map, string_invariant_map>
+to_string_invariant_maps(const flat_cfg_t& cfg, const crab::invariant_tables_t<zone_domain_t>& invariants) {
+    string_invariant_map pre, post;
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        pre.insert_or_assign(cfg.label(id), invariants.get_pre(id).to_set());
+        post.insert_or_assign(cfg.label(id), invariants.get_post(id).to_set());
     }
-    return res;
+    return {pre, post};
 }
 
 std::tuple<string_invariant_map, string_invariant_map>
 ebpf_analyze_program_for_test(std::ostream& os, const InstructionSeq& prog, const string_invariant& entry_invariant,
                               const program_info& info,
                               bool no_simplify, bool check_termination) {
-    ebpf_domain_t entry_inv = entry_invariant.is_bottom()
-        ? ebpf_domain_t::bottom()
-        : ebpf_domain_t::from_constraints(entry_invariant.value());
+    zone_domain_t entry_inv = entry_invariant.is_bottom()
+        ? zone_domain_t::bottom()
+        : zone_domain_t::from_constraints(entry_invariant.value());
     assert(!entry_inv.is_bottom());
-    global_program_info = info;
-    cfg_t cfg = prepare_cfg(prog, info, !no_simplify, false);
-    auto [pre_invariants, post_invariants] = crab::run_forward_analyzer(cfg, entry_inv, check_termination);
-    checks_db report = generate_report(cfg, pre_invariants, post_invariants);
+    verification_context_t::current().info = info;
+    flat_cfg_t cfg = prepare_cfg(prog, info, !no_simplify, false);
+    block_facts_table_t facts(cfg.size());
+    crab::invariant_tables_t<zone_domain_t> invariants = crab::run_forward_analyzer(
+        cfg, entry_inv, check_termination,
+        collect_block_facts<zone_domain_t>(facts, check_termination));
+    checks_db report = generate_report(cfg, facts, check_termination);
     print_report(os, report, prog, false);
 
-    return {
-        to_string_invariant_map(pre_invariants),
-        to_string_invariant_map(post_invariants)
-    };
+    auto [pre, post] = to_string_invariant_maps(cfg, invariants);
+    return {pre, post};
 }
 
-/// Returned value is true if the program passes verification.
-bool ebpf_verify_program(std::ostream& os, const InstructionSeq& prog, const program_info& info,
-                         const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats) {
+static bool verify_program(std::ostream& os, const InstructionSeq& prog, const program_info& info,
+                           const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats,
+                           invariant_snapshot_t* snapshot) {
     if (options == nullptr)
         options = &ebpf_verifier_default_options;
 
     // Convert the instruction sequence to a control-flow graph
     // in a "passive", non-deterministic form.
-    cfg_t cfg = prepare_cfg(prog, info, !options->no_simplify);
+    flat_cfg_t cfg = prepare_cfg(prog, info, !options->no_simplify);
 
-    checks_db report = get_ebpf_report(os, cfg, info, options);
+    checks_db report = get_ebpf_report(os, cfg, info, options, snapshot);
     if (options->print_failures) {
         print_report(os, report, prog, options->print_line_info);
     }
     if (stats) {
-        stats->total_unreachable = report.total_unreachable;
-        stats->total_warnings = report.total_warnings;
-        stats->max_instruction_count = report.max_instruction_count;
+        fill_stats(*stats, report);
     }
     return (report.total_warnings == 0);
 }
+
+/// Returned value is true if the program passes verification.
+bool ebpf_verify_program(std::ostream& os, const InstructionSeq& prog, const program_info& info,
+                         const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats) {
+    return verify_program(os, prog, info, options, stats, nullptr);
+}
+
+bool ebpf_verify_program(std::ostream& os, const InstructionSeq& prog, const program_info& info,
+                         const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats,
+                         invariant_snapshot_t& snapshot) {
+    return verify_program(os, prog, info, options, stats, &snapshot);
+}
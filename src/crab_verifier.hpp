@@ -7,7 +7,9 @@
 #include "spec_type_descriptors.hpp"
 #include "string_constraints.hpp"
 
-bool run_ebpf_analysis(std::ostream& s, cfg_t& cfg, const program_info& info, const ebpf_verifier_options_t* options,
+struct invariant_snapshot_t;
+
+bool run_ebpf_analysis(std::ostream& s, const flat_cfg_t& cfg, const program_info& info, const ebpf_verifier_options_t* options,
     ebpf_verifier_stats_t* stats);
 
 bool ebpf_verify_program(
@@ -17,6 +19,17 @@ bool ebpf_verify_program(
     const ebpf_verifier_options_t* options,
     ebpf_verifier_stats_t* stats);
 
+// Same as ebpf_verify_program, but reuse the invariants of the blocks that are unchanged since the snapshot
+// was taken, which is typically of a previous version of the same program, and replace the snapshot by one
+// of this program. The snapshot is cleared if the analysis fails.
+bool ebpf_verify_program(
+    std::ostream& s,
+    const InstructionSeq& prog,
+    const program_info& info,
+    const ebpf_verifier_options_t* options,
+    ebpf_verifier_stats_t* stats,
+    invariant_snapshot_t& snapshot);
+
 using string_invariant_map = std::map<crab::label_t, string_invariant>;
 
 std::tuple<string_invariant_map, string_invariant_map>
@@ -7,4 +7,8 @@
 #include "config.hpp"
 #include "crab/cfg.hpp"
 #include "crab_verifier.hpp"
+#include "invariant_snapshot.hpp"
 #include "platform.hpp"
+#include "section_verifier.hpp"
+#include "verification_cache.hpp"
+#include "verification_context.hpp"
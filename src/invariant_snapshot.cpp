@@ -0,0 +1,307 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include "asm_ostream.hpp"
+#include "crab/liveness.hpp"
+#include "crab_utils/sha256.hpp"
+#include "invariant_snapshot.hpp"
+
+// Bump this whenever a change to the verifier may change the invariants computed for some program,
+// so that snapshots written by older versions are no longer used.
+constexpr int snapshot_format_version = 1;
+
+static const char* const snapshot_magic = "prevail-invariants";
+
+// Digest of instructions, field by field: their printed form is not enough, e.g., it truncates wide immediates.
+struct instruction_digest_t {
+    crab::sha256_t& sha;
+
+    void operator()(const Imm& imm) { sha.update_value(imm.v); }
+    void operator()(const Reg& reg) { sha.update_value(reg.v); }
+
+    void value(const Value& v) {
+        sha.update_value(v.index());
+        std::visit(*this, v);
+    }
+
+    void deref(const Deref& access) {
+        sha.update_value(access.width);
+        (*this)(access.basereg);
+        sha.update_value(access.offset);
+    }
+
+    void condition(const Condition& cond) {
+        sha.update_value(cond.op);
+        (*this)(cond.left);
+        value(cond.right);
+    }
+
+    void operator()(const Undefined& a) { sha.update_value(a.opcode); }
+    void operator()(const Bin& a) {
+        sha.update_value(a.op);
+        (*this)(a.dst);
+        value(a.v);
+        sha.update_value(a.is64);
+        sha.update_value(a.lddw);
+    }
+    void operator()(const Un& a) {
+        sha.update_value(a.op);
+        (*this)(a.dst);
+    }
+    void operator()(const LoadMapFd& a) {
+        (*this)(a.dst);
+        sha.update_value(a.mapfd);
+    }
+    void operator()(const Call& a) {
+        sha.update_value(a.func);
+        sha.update_string(a.name);
+        sha.update_value(a.is_map_lookup);
+        sha.update_value(a.reallocate_packet);
+        sha.update_value(a.singles.size());
+        for (const ArgSingle& arg : a.singles) {
+            sha.update_value(arg.kind);
+            (*this)(arg.reg);
+        }
+        sha.update_value(a.pairs.size());
+        for (const ArgPair& arg : a.pairs) {
+            sha.update_value(arg.kind);
+            (*this)(arg.mem);
+            (*this)(arg.size);
+            sha.update_value(arg.can_be_zero);
+        }
+    }
+    void operator()(const Exit&) {}
+    void operator()(const Jmp& a) {
+        sha.update_value(a.cond.has_value());
+        if (a.cond) {
+            condition(*a.cond);
+        }
+        sha.update_string(to_string(a.target));
+    }
+    void operator()(const Mem& a) {
+        deref(a.access);
+        value(a.value);
+        sha.update_value(a.is_load);
+    }
+    void operator()(const Packet& a) {
+        sha.update_value(a.width);
+        sha.update_value(a.offset);
+        sha.update_value(a.regoffset.has_value());
+        if (a.regoffset) {
+            (*this)(*a.regoffset);
+        }
+    }
+    void operator()(const LockAdd& a) {
+        deref(a.access);
+        (*this)(a.valreg);
+    }
+    void operator()(const Assume& a) { condition(a.cond); }
+    void operator()(const Assert& a) {
+        sha.update_value(a.cst.index());
+        std::visit(*this, a.cst);
+    }
+
+    void operator()(const Comparable& a) {
+        (*this)(a.r1);
+        (*this)(a.r2);
+        sha.update_value(a.or_r2_is_number);
+    }
+    void operator()(const Addable& a) {
+        (*this)(a.ptr);
+        (*this)(a.num);
+    }
+    void operator()(const ValidAccess& a) {
+        (*this)(a.reg);
+        sha.update_value(a.offset);
+        value(a.width);
+        sha.update_value(a.or_null);
+        sha.update_value(a.access_type);
+    }
+    void operator()(const ValidStore& a) {
+        (*this)(a.mem);
+        (*this)(a.val);
+    }
+    void operator()(const ValidSize& a) {
+        (*this)(a.reg);
+        sha.update_value(a.can_be_zero);
+    }
+    void operator()(const ValidMapKeyValue& a) {
+        (*this)(a.access_reg);
+        (*this)(a.map_fd_reg);
+        sha.update_value(a.key);
+    }
+    void operator()(const TypeConstraint& a) {
+        (*this)(a.reg);
+        sha.update_value(a.types);
+    }
+    void operator()(const ZeroCtxOffset& a) { (*this)(a.reg); }
+};
+
+std::vector<std::string> block_digests(const flat_cfg_t& cfg) {
+    const crab::liveness_t liveness(cfg);
+    std::vector<std::string> digests;
+    digests.reserve(cfg.size());
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        crab::sha256_t sha;
+        sha.update_string(to_string(cfg.label(id)));
+
+        instruction_digest_t digest{sha};
+        sha.update_value(cfg.instructions(id).size());
+        for (const Instruction& ins : cfg.instructions(id)) {
+            sha.update_value(ins.index());
+            std::visit(digest, ins);
+        }
+
+        sha.update_value(cfg.in_degree(id));
+        for (const block_id_t prev : cfg.prev_nodes(id)) {
+            sha.update_string(to_string(cfg.label(prev)));
+        }
+        sha.update_value(cfg.out_degree(id));
+        for (const block_id_t next : cfg.next_nodes(id)) {
+            sha.update_string(to_string(cfg.label(next)));
+        }
+
+        // What is forgotten from the post-invariant before it is joined.
+        const std::optional<crab::live_set_t>& live = liveness.live_at_join(id);
+        sha.update_value(live.has_value());
+        if (live) {
+            sha.update_string(live->registers.to_string());
+            sha.update_string(live->stack.to_string());
+        }
+        digests.push_back(sha.hex_digest());
+    }
+    return digests;
+}
+
+template <typename Domain>
+crab::settled_blocks_t<Domain> settle_blocks(const flat_cfg_t& cfg, const std::vector<std::string>& digests,
+                                             const std::string& setup, const invariant_snapshot_t& previous) {
+    if (previous.setup != setup) {
+        return {};
+    }
+
+    // A block is unchanged if it has the same digest as before. Its pre-invariant is also unchanged if its own
+    // is known, or if it is the post-invariant of an unchanged block; so the blocks that are reachable from
+    // a changed block, or from a join point whose pre-invariant is not known, must be analyzed again.
+    std::vector<bool> settled(cfg.size(), true);
+    std::vector<block_id_t> worklist;
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        const auto it = previous.blocks.find(to_string(cfg.label(id)));
+        const bool eligible = it != previous.blocks.end() && it->second.digest == digests[id] &&
+                              (id == cfg.entry() || cfg.in_degree(id) <= 1 || it->second.pre);
+        if (!eligible) {
+            settled[id] = false;
+            worklist.push_back(id);
+        }
+    }
+    while (!worklist.empty()) {
+        const block_id_t id = worklist.back();
+        worklist.pop_back();
+        for (const block_id_t next : cfg.next_nodes(id)) {
+            if (settled[next]) {
+                settled[next] = false;
+                worklist.push_back(next);
+            }
+        }
+    }
+    if (std::find(settled.begin(), settled.end(), true) == settled.end()) {
+        return {};
+    }
+
+    crab::settled_blocks_t<Domain> res{.settled = std::move(settled),
+                                       .pre = crab::invariant_table_t<Domain>(cfg.size())};
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        if (!res.settled[id] || id == cfg.entry() || cfg.in_degree(id) <= 1) {
+            continue;
+        }
+        const string_invariant& pre = *previous.blocks.at(to_string(cfg.label(id))).pre;
+        res.pre[id] = pre.is_bottom() ? Domain::bottom() : Domain::from_constraints(pre.value());
+    }
+    return res;
+}
+
+template <typename Domain>
+invariant_snapshot_t take_snapshot(const flat_cfg_t& cfg, const std::vector<std::string>& digests, std::string setup,
+                                   const crab::invariant_tables_t<Domain>& invariants) {
+    invariant_snapshot_t res{.setup = std::move(setup)};
+    for (block_id_t id = 0; id < cfg.size(); id++) {
+        invariant_snapshot_t::block_t block{.digest = digests[id]};
+        if (id != cfg.entry() && cfg.in_degree(id) > 1) {
+            Domain pre = invariants.get_pre(id);
+            block.pre = pre.is_bottom() ? string_invariant::bottom() : pre.to_set();
+        }
+        res.blocks.emplace(to_string(cfg.label(id)), std::move(block));
+    }
+    return res;
+}
+
+template crab::settled_blocks_t<zone_domain_t> settle_blocks(const flat_cfg_t&, const std::vector<std::string>&,
+                                                             const std::string&, const invariant_snapshot_t&);
+template crab::settled_blocks_t<interval_domain_t> settle_blocks(const flat_cfg_t&, const std::vector<std::string>&,
+                                                                 const std::string&, const invariant_snapshot_t&);
+template invariant_snapshot_t take_snapshot(const flat_cfg_t&, const std::vector<std::string>&, std::string,
+                                            const crab::invariant_tables_t<zone_domain_t>&);
+template invariant_snapshot_t take_snapshot(const flat_cfg_t&, const std::vector<std::string>&, std::string,
+                                            const crab::invariant_tables_t<interval_domain_t>&);
+
+void invariant_snapshot_t::write(std::ostream& o) const {
+    o << snapshot_magic << " " << snapshot_format_version << " " << setup << "\n";
+    for (const auto& [label, block] : blocks) {
+        o << "block " << label << " " << block.digest << " ";
+        if (!block.pre) {
+            o << "-\n";
+        } else if (block.pre->is_bottom()) {
+            o << "bottom\n";
+        } else {
+            o << block.pre->value().size() << "\n";
+            for (const std::string& constraint : block.pre->value()) {
+                o << constraint << "\n";
+            }
+        }
+    }
+}
+
+std::optional<invariant_snapshot_t> invariant_snapshot_t::read(std::istream& i) {
+    std::string magic;
+    int version{};
+    invariant_snapshot_t res;
+    i >> magic >> version >> res.setup;
+    if (!i || magic != snapshot_magic || version != snapshot_format_version) {
+        return {};
+    }
+    std::string keyword;
+    while (i >> keyword) {
+        std::string label, pre;
+        block_t block;
+        i >> label >> block.digest >> pre;
+        if (!i || keyword != "block") {
+            return {};
+        }
+        if (pre == "bottom") {
+            block.pre = string_invariant::bottom();
+        } else if (pre != "-") {
+            size_t size{};
+            try {
+                size = std::stoul(pre);
+            } catch (const std::exception&) {
+                return {};
+            }
+            i.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::set<std::string> constraints;
+            for (size_t n = 0; n < size; n++) {
+                std::string constraint;
+                if (!std::getline(i, constraint)) {
+                    return {};
+                }
+                constraints.insert(std::move(constraint));
+            }
+            block.pre = string_invariant{std::move(constraints)};
+        }
+        res.blocks.emplace(std::move(label), std::move(block));
+    }
+    return res;
+}
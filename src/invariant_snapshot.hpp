@@ -0,0 +1,54 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <iosfwd>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "crab/fwd_analyzer.hpp"
+#include "string_constraints.hpp"
+
+// Invariants of a verified program, kept so that the next version of the program can be verified incrementally.
+//
+// Each block of the control-flow graph is identified by its label, and has a digest of everything that its
+// invariants depend on locally: its instructions, the labels of its predecessors and successors, and the
+// registers and stack bytes that are live where its post-invariant is joined. When a new version of the program
+// is verified with the same program type, maps and options, a block that has the same label and digest as before,
+// and can only be reached from blocks that do too, has the same pre-invariant as before, so it is reused.
+// Only the blocks that can be reached from a changed block are analyzed again, and the cycles that none of them
+// belongs to are not iterated.
+//
+// A snapshot is trusted: the invariants it holds are assumed to be the ones that the same version
+// of the verifier computed.
+struct invariant_snapshot_t {
+    struct block_t {
+        std::string digest;
+        // The pre-invariant of a block with several predecessors. That of any other block is not kept,
+        // since it is the post-invariant of its predecessor.
+        std::optional<string_invariant> pre;
+    };
+
+    // Digest of the program type, maps and options, see verification_cache_t::setup_key.
+    std::string setup;
+    std::map<std::string, block_t> blocks; // By label.
+
+    void write(std::ostream& o) const;
+    // Returns nullopt if the input is not a snapshot written by this version of the verifier.
+    static std::optional<invariant_snapshot_t> read(std::istream& i);
+};
+
+// Digests of the blocks of a control-flow graph, indexed by block id.
+std::vector<std::string> block_digests(const flat_cfg_t& cfg);
+
+// The blocks whose pre-invariant is the same as in the snapshot of the previous version of the program,
+// with their invariants parsed in the current verification context. No block is settled if the setup differs.
+template <typename Domain>
+crab::settled_blocks_t<Domain> settle_blocks(const flat_cfg_t& cfg, const std::vector<std::string>& digests,
+                                             const std::string& setup, const invariant_snapshot_t& previous);
+
+template <typename Domain>
+invariant_snapshot_t take_snapshot(const flat_cfg_t& cfg, const std::vector<std::string>& digests, std::string setup,
+                                   const crab::invariant_tables_t<Domain>& invariants);
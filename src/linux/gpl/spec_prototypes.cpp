@@ -1,5 +1,6 @@
 #include "platform.hpp"
 #include "spec_type_descriptors.hpp"
+#include "verification_context.hpp"
 
 #define EBPF_RETURN_TYPE_PTR_TO_SOCK_COMMON_OR_NULL   EBPF_RETURN_TYPE_UNSUPPORTED
 #define EBPF_RETURN_TYPE_PTR_TO_SOCKET_OR_NULL        EBPF_RETURN_TYPE_UNSUPPORTED
@@ -2108,7 +2109,7 @@ bool is_helper_usable_linux(int32_t n) {
 
     // If the helper has a context_descriptor, it must match the hook's context_descriptor.
     if ((prototypes[n].context_descriptor != nullptr) &&
-        (prototypes[n].context_descriptor != global_program_info.type.context_descriptor))
+        (prototypes[n].context_descriptor != verification_context_t::current().info.type.context_descriptor))
         return false;
 
     return true;
@@ -1,6 +1,10 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -25,6 +29,75 @@ static size_t hash(const raw_program& raw_prog) {
     return boost::hash_range(start, end);
 }
 
+static const char* to_string(numeric_domain_t tier) {
+    return tier == numeric_domain_t::intervals ? "intervals" : "zones";
+}
+
+static string json_escape(const string& s) {
+    std::ostringstream os;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            os << "\\u00" << std::hex << ((c >> 4) & 0xf) << (c & 0xf) << std::dec;
+        } else {
+            os << c;
+        }
+    }
+    return os.str();
+}
+
+static bool verify_program(std::ostream& os, const raw_program& raw_prog, const InstructionSeq& prog,
+                           const ebpf_verifier_options_t& options, ebpf_verifier_stats_t* stats,
+                           const verification_cache_t* cache) {
+    if (cache) {
+        return ebpf_verify_program(os, raw_prog, prog, &options, stats, *cache);
+    }
+    return ebpf_verify_program(os, prog, raw_prog.info, &options, stats);
+}
+
+// Verify every program section, and print one row per section in section order.
+static int verify_all_sections(const vector<raw_program>& raw_progs, const ebpf_verifier_options_t& options,
+                               const verification_cache_t* cache, unsigned jobs, bool json, double timeout) {
+    const vector<section_result_t> results = ebpf_verify_sections(raw_progs, options, cache, jobs, timeout);
+
+    bool all_pass = true;
+    if (json) {
+        std::cout << "[\n";
+    }
+    for (size_t n = 0; n < results.size(); n++) {
+        const section_result_t& r = results[n];
+        all_pass = all_pass && r.pass;
+        if (options.print_failures || options.print_invariants) {
+            std::cerr << "--- " << r.section << " ---\n" << r.log;
+        }
+        if (json) {
+            std::cout << "  {\"section\": \"" << json_escape(r.section) << "\", \"pass\": " << (r.pass ? "true" : "false")
+                      << ", \"seconds\": " << r.seconds << ", \"scratch_peak_kb\": " << r.scratch_peak_kb;
+            if (options.tiered && r.error.empty()) {
+                std::cout << ", \"tier\": \"" << to_string(r.tier) << "\"";
+            }
+            if (!r.error.empty()) {
+                std::cout << ", \"error\": \"" << json_escape(r.error) << "\"";
+            }
+            std::cout << "}" << (n + 1 < results.size() ? "," : "") << "\n";
+        } else if (!r.error.empty()) {
+            std::cerr << r.section << ": " << r.error << "\n";
+            std::cout << r.section << ",0,-1,-1" << (options.tiered ? ",-" : "") << "\n";
+        } else {
+            std::cout << r.section << "," << r.pass << "," << r.seconds << "," << r.scratch_peak_kb;
+            if (options.tiered) {
+                std::cout << "," << to_string(r.tier);
+            }
+            std::cout << "\n";
+        }
+    }
+    if (json) {
+        std::cout << "]\n";
+    }
+    return !all_pass;
+}
+
 int main(int argc, char** argv) {
     ebpf_verifier_options_t ebpf_verifier_options = ebpf_verifier_default_options;
 
@@ -42,15 +115,51 @@ int main(int argc, char** argv) {
     app.add_option("section", desired_section, "Section to analyze")->type_name("SECTION");
     bool list = false;
     app.add_flag("-l", list, "List sections");
+    bool all_sections = false;
+    app.add_flag("--all-sections", all_sections, "Verify all sections, printing one row per section");
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    app.add_option("-j,--jobs", jobs, "Number of sections to verify in parallel with --all-sections")->type_name("N");
+    std::string format = "csv";
+    app.add_option("--format", format, "Output format for --all-sections")
+        ->check(CLI::IsMember({"csv", "json"}))
+        ->type_name("FORMAT");
 
     std::string domain = "zoneCrab";
-    std::set<string> doms{"stats", "linux", "zoneCrab", "cfg"};
+    std::set<string> doms{"stats", "linux", "zoneCrab", "intervalCrab", "cfg"};
     app.add_set("-d,--dom,--domain", domain, doms, "Abstract domain")->type_name("DOMAIN");
 
+    std::string cache_dir;
+    auto cache_option =
+        app.add_option("--cache", cache_dir, "Reuse verification results stored in DIR, and store new ones there")
+            ->type_name("DIR");
+
+    std::string snapshot_file;
+    app.add_option("--incremental", snapshot_file,
+                   "Reuse the invariants of the blocks unchanged since the program was verified with the same FILE, "
+                   "and store those of this version there")
+        ->type_name("FILE")
+        ->excludes(cache_option);
+
     app.add_flag("--termination", ebpf_verifier_options.check_termination, "Verify termination");
 
+    double timeout = 0;
+    app.add_option("--timeout", timeout, "Give up verifying a program after SECONDS, and report a timeout")
+        ->type_name("SECONDS");
+
+    app.add_flag("--tiered", ebpf_verifier_options.tiered,
+                 "Analyze with intervals first, and with zones only if needed; print which one decided");
+
     app.add_flag("--assume-assert", ebpf_verifier_options.assume_assertions, "Assume assertions");
 
+    app.add_option("--widening-delay", ebpf_verifier_options.widening_delay,
+                   "Number of iterations of a loop before widening its invariant")
+        ->type_name("N");
+    app.add_option("--narrowing-iterations", ebpf_verifier_options.descending_iterations,
+                   "Maximal number of narrowing iterations of a loop, 0 for none")
+        ->type_name("N");
+    app.add_flag("--adaptive-narrowing", ebpf_verifier_options.adaptive_narrowing,
+                 "Stop narrowing a loop once that changes the outcome of no assertion in it");
+
     bool verbose = false;
     app.add_flag("-i", ebpf_verifier_options.print_invariants, "Print invariants");
     app.add_flag("-f", ebpf_verifier_options.print_failures, "Print verifier's failure logs");
@@ -58,6 +167,10 @@ int main(int argc, char** argv) {
     app.add_flag("-v", verbose, "Print both invariants and failures");
     app.add_flag("--no-simplify", ebpf_verifier_options.no_simplify, "Do not simplify");
     app.add_flag("--line-info", ebpf_verifier_options.print_line_info, "Print line information");
+    bool alloc_stats = false;
+    app.add_flag("--alloc-stats", alloc_stats, "Print the use of the scratch arena");
+    bool loop_stats = false;
+    app.add_flag("--loop-stats", loop_stats, "Print the number of iterations of each loop");
 
     std::string asmfile;
     app.add_option("--asm", asmfile, "Print disassembly to FILE")->type_name("FILE");
@@ -79,6 +192,12 @@ int main(int argc, char** argv) {
             for (const string& h : stats_headers()) {
                 std::cout << "," << h;
             }
+        } else if (all_sections) {
+            // The columns of the rows printed by verify_all_sections.
+            std::cout << "section,pass,seconds,scratch_peak_kb";
+            if (ebpf_verifier_options.tiered) {
+                std::cout << ",tier";
+            }
         } else {
             std::cout << domain << "?,";
             std::cout << domain << "_sec,";
@@ -95,6 +214,16 @@ int main(int argc, char** argv) {
     }
 #endif
 
+    // Both crab domains run the same verifier, over a different numeric domain.
+    const bool crab_domain = domain == "zoneCrab" || domain == "intervalCrab";
+    if (domain == "intervalCrab")
+        ebpf_verifier_options.numeric_domain = numeric_domain_t::intervals;
+
+    if (all_sections && !crab_domain) {
+        std::cerr << "error: --all-sections is only supported with the zoneCrab and intervalCrab domains\n";
+        return 64;
+    }
+
     if (domain == "linux")
         ebpf_verifier_options.mock_map_fds = false;
     const ebpf_platform_t* platform = &g_ebpf_platform_linux;
@@ -108,6 +237,16 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    std::optional<verification_cache_t> cache;
+    if (!cache_dir.empty()) {
+        cache.emplace(cache_dir);
+    }
+
+    if (all_sections) {
+        return verify_all_sections(raw_progs, ebpf_verifier_options, cache ? &*cache : nullptr, jobs,
+                                   format == "json", timeout);
+    }
+
     if (list || raw_progs.size() != 1) {
         if (!list) {
             std::cout << "please specify a section\n";
@@ -139,17 +278,58 @@ int main(int argc, char** argv) {
     if (!asmfile.empty()) {
         std::ofstream out{asmfile};
         print(prog, out, {});
-        print_map_descriptors(global_program_info.map_descriptors, out);
+        print_map_descriptors(verification_context_t::current().info.map_descriptors, out);
     }
 
-    if (domain == "zoneCrab") {
+    if (crab_domain) {
         ebpf_verifier_stats_t verifier_stats;
+        std::optional<invariant_snapshot_t> snapshot;
+        if (!snapshot_file.empty()) {
+            std::ifstream in(snapshot_file);
+            snapshot = invariant_snapshot_t::read(in);
+            if (!snapshot) {
+                snapshot.emplace();
+            }
+        }
         const auto [res, seconds] = timed_execution([&] {
-            return ebpf_verify_program(std::cout, prog, raw_prog.info, &ebpf_verifier_options, &verifier_stats);
+            const ebpf_verifier_options_t options = with_timeout(ebpf_verifier_options, timeout);
+            if (snapshot) {
+                return ebpf_verify_program(std::cout, prog, raw_prog.info, &options, &verifier_stats, *snapshot);
+            }
+            return verify_program(std::cout, raw_prog, prog, options, &verifier_stats, cache ? &*cache : nullptr);
         });
+        if (snapshot) {
+            std::ofstream out(snapshot_file);
+            snapshot->write(out);
+            if (ebpf_verifier_options.print_failures || ebpf_verifier_options.print_invariants) {
+                std::cout << "Reused the invariants of " << verifier_stats.reused_blocks << " blocks\n";
+            }
+        }
         if (ebpf_verifier_options.check_termination && (ebpf_verifier_options.print_failures || ebpf_verifier_options.print_invariants)) {
             std::cout << "Program terminates within " << verifier_stats.max_instruction_count << " instructions\n";
         }
+        if (alloc_stats) {
+            std::cout << "Scratch arena: " << verifier_stats.scratch_allocations << " allocations, "
+                      << verifier_stats.scratch_bytes << " bytes, peak " << verifier_stats.scratch_peak_bytes
+                      << " bytes, " << verifier_stats.system_allocations << " system allocations\n";
+        }
+        if (verifier_stats.timed_out) {
+            // On stderr, so that the row below stays the only line of output.
+            std::cerr << "Timed out";
+            if (!verifier_stats.timeout_loop_head.empty()) {
+                std::cerr << " in the loop at " << verifier_stats.timeout_loop_head;
+            }
+            std::cerr << "\n";
+        }
+        if (loop_stats) {
+            for (const loop_stats_t& loop : verifier_stats.loops) {
+                std::cout << "Loop at " << loop.head << ": " << loop.ascending_iterations << " ascending, "
+                          << loop.descending_iterations << " descending iterations\n";
+            }
+        }
+        if (ebpf_verifier_options.tiered) {
+            std::cout << "Decided by " << to_string(verifier_stats.tier) << "\n";
+        }
         std::cout << res << "," << seconds << "," << resident_set_size_kb() << "\n";
         return !res;
     } else if (domain == "linux") {
@@ -159,7 +339,7 @@ int main(int argc, char** argv) {
         return !res;
     } else if (domain == "stats") {
         // Convert the instruction sequence to a control-flow graph.
-        cfg_t cfg = prepare_cfg(prog, raw_prog.info, !ebpf_verifier_options.no_simplify);
+        flat_cfg_t cfg = prepare_cfg(prog, raw_prog.info, !ebpf_verifier_options.no_simplify);
 
         // Just print eBPF program stats.
         auto stats = collect_stats(cfg);
@@ -173,7 +353,7 @@ int main(int argc, char** argv) {
         std::cout << "\n";
     } else if (domain == "cfg") {
         // Convert the instruction sequence to a control-flow graph.
-        cfg_t cfg = prepare_cfg(prog, raw_prog.info, !ebpf_verifier_options.no_simplify);
+        flat_cfg_t cfg = prepare_cfg(prog, raw_prog.info, !ebpf_verifier_options.no_simplify);
         std::cout << cfg;
         std::cout << "\n";
     } else {
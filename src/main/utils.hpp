@@ -1,6 +1,10 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
 
+#include <chrono>
+#include <ctime>
+#include <tuple>
+
 template<typename F>
 auto timed_execution(F f) {
     clock_t begin = clock();
@@ -12,3 +16,17 @@ auto timed_execution(F f) {
     double elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
     return std::make_tuple(res, elapsed_secs);
 }
+
+// Like timed_execution, but measures wall-clock time, which is what a single task
+// running on one worker thread of a multi-threaded process can be charged with.
+template<typename F>
+auto wall_timed_execution(F f) {
+    const auto begin = std::chrono::steady_clock::now();
+
+    const auto& res = f();
+
+    const auto end = std::chrono::steady_clock::now();
+
+    double elapsed_secs = std::chrono::duration<double>(end - begin).count();
+    return std::make_tuple(res, elapsed_secs);
+}
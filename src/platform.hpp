@@ -40,6 +40,10 @@ struct ebpf_platform_t {
     ebpf_parse_maps_section_fn parse_maps_section;
     ebpf_get_map_descriptor_fn get_map_descriptor;
     ebpf_get_map_type_fn get_map_type;
+
+    // Tells platforms apart where the verdicts of several may be kept together, as in the verification cache.
+    // Helper prototypes and map types differ between platforms, so each platform should have its own name.
+    const char* name;
 };
 
 extern const ebpf_platform_t g_ebpf_platform_linux;
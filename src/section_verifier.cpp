@@ -0,0 +1,80 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "asm_unmarshal.hpp"
+#include "crab_verifier.hpp"
+#include "section_verifier.hpp"
+#include "verification_context.hpp"
+
+ebpf_verifier_options_t with_timeout(ebpf_verifier_options_t options, double seconds) {
+    if (seconds > 0) {
+        options.deadline = std::chrono::steady_clock::now() +
+                           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(seconds));
+    }
+    return options;
+}
+
+static section_result_t verify_section(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                                       const verification_cache_t* cache, double timeout) {
+    section_result_t result{.section = raw_prog.section};
+    // Runs on a worker thread, where an escaping exception would terminate the process:
+    // whatever is thrown is recorded in the row of the section instead.
+    try {
+        verification_context_t context;
+        verification_context_t::scope_t scope{context};
+        std::variant<InstructionSeq, std::string> prog_or_error = unmarshal(raw_prog);
+        if (std::holds_alternative<std::string>(prog_or_error)) {
+            result.error = "unmarshaling error at " + std::get<std::string>(prog_or_error);
+            return result;
+        }
+        const InstructionSeq& prog = std::get<InstructionSeq>(prog_or_error);
+        const ebpf_verifier_options_t section_options = with_timeout(options, timeout);
+        std::ostringstream log;
+        ebpf_verifier_stats_t stats{};
+        const auto begin = std::chrono::steady_clock::now();
+        result.pass = cache ? ebpf_verify_program(log, raw_prog, prog, &section_options, &stats, *cache)
+                            : ebpf_verify_program(log, prog, raw_prog.info, &section_options, &stats);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        result.tier = stats.tier;
+        result.scratch_peak_kb = (stats.scratch_peak_bytes + 1023) / 1024;
+        result.log = log.str();
+        if (stats.timed_out) {
+            result.error = "timed out";
+            if (!stats.timeout_loop_head.empty()) {
+                result.error += " in the loop at " + stats.timeout_loop_head;
+            }
+        }
+    } catch (const std::exception& e) {
+        result.pass = false;
+        result.error = e.what();
+    } catch (...) {
+        result.pass = false;
+        result.error = "unknown exception";
+    }
+    return result;
+}
+
+std::vector<section_result_t> ebpf_verify_sections(const std::vector<raw_program>& raw_progs,
+                                                   const ebpf_verifier_options_t& options,
+                                                   const verification_cache_t* cache, unsigned jobs, double timeout) {
+    std::vector<section_result_t> results(raw_progs.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::max(1u, std::min<unsigned>(jobs, raw_progs.size())); i++) {
+        workers.emplace_back([&] {
+            for (size_t n = next++; n < raw_progs.size(); n = next++) {
+                results[n] = verify_section(raw_progs[n], options, cache, timeout);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "config.hpp"
+#include "spec_type_descriptors.hpp"
+#include "verification_cache.hpp"
+
+// Result of the verification of one program section.
+struct section_result_t {
+    std::string section;
+    bool pass{};
+    double seconds{}; // Wall-clock time.
+    size_t scratch_peak_kb{}; // Of this verification alone, unlike the RSS of the whole process; 0 for cache hits.
+    numeric_domain_t tier{};
+    std::string log; // What the verification printed, as requested by the options.
+    // Why the section has no result: it could not be unmarshaled, it timed out, or its verification threw.
+    std::string error;
+};
+
+// Gives a verification the given time, counted from now; 0 means no limit.
+ebpf_verifier_options_t with_timeout(ebpf_verifier_options_t options, double seconds);
+
+// Verifies each section in its own verification context, on up to `jobs` threads, each section getting
+// `timeout` seconds from when it starts. The results are in the order of the sections.
+std::vector<section_result_t> ebpf_verify_sections(const std::vector<raw_program>& raw_progs,
+                                                   const ebpf_verifier_options_t& options,
+                                                   const verification_cache_t* cache, unsigned jobs, double timeout);
@@ -66,5 +66,3 @@ struct raw_program {
     program_info info;
     std::vector<btf_line_info_t> line_info;
 };
-
-extern thread_local program_info global_program_info;
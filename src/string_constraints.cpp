@@ -1,5 +1,7 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
+#include <algorithm>
+#include <optional>
 #include <set>
 #include <regex>
 
@@ -56,7 +58,9 @@ static long number(const string& s) {
 static type_encoding_t string_to_type_encoding(const string& s) {
     static map<string, type_encoding_t> string_to_type{
         {string("uninit"), T_UNINIT},
+        {string("uninitialized"), T_UNINIT},
         {string("map_fd_programs"), T_MAP_PROGRAMS},
+        {string("map_fd_program"), T_MAP_PROGRAMS},
         {string("map_fd"), T_MAP},
         {string("number"), T_NUM},
         {string("ctx"), T_CTX},
@@ -70,7 +74,104 @@ static type_encoding_t string_to_type_encoding(const string& s) {
     throw std::runtime_error(string("Unsupported type name: ") + s);
 }
 
-std::vector<linear_constraint_t> parse_linear_constraints(const std::set<string>& constraints, std::vector<crab::interval_t>& numeric_ranges) {
+static crab::bound_t bound(const string& s) {
+    if (s == "-oo") return crab::bound_t::minus_infinity();
+    if (s == "+oo") return crab::bound_t::plus_infinity();
+    return crab::bound_t(number(s));
+}
+
+// Any variable, as printed by variable_t::name().
+static std::optional<variable_t> parse_variable(const string& s, std::vector<stack_cell_t>& cells) {
+    std::smatch m;
+    if (regex_match(s, m, regex(REG DOT KIND))) {
+        return variable_t::reg(regkind(m[2]), regnum(m[1]));
+    }
+    if (regex_match(s, m, regex(R"_(\s*s\[(\d+)(?:\.\.\.(\d+))?\])_" DOT KIND))) {
+        const int lb = (int)number(m[1]);
+        const int ub = m[2].matched ? (int)number(m[2]) : lb;
+        const data_kind_t kind = regkind(m[3]);
+        cells.push_back({kind, lb, ub - lb + 1});
+        return variable_t::cell_var(kind, lb, ub - lb + 1);
+    }
+    if (regex_match(s, m, regex(R"_(\s*(meta_offset|packet_size|instruction_count)\s*)_"))) {
+        if (m[1] == "meta_offset") return variable_t::meta_offset();
+        if (m[1] == "packet_size") return variable_t::packet_size();
+        return variable_t::instruction_count();
+    }
+    return {};
+}
+
+// Constraints in the general forms printed by to_set(), between any variables.
+static bool parse_general_constraint(const string& cst_text, std::vector<linear_constraint_t>& res,
+                                     std::vector<crab::interval_t>& numeric_ranges,
+                                     std::vector<stack_cell_t>& cells) {
+    using namespace crab::dsl_syntax;
+
+    std::smatch m;
+    if (regex_match(cst_text, m, regex(R"_(\s*s\[(\d+)(?:\.\.\.(\d+))?\]\.type=number\s*)_"))) {
+        const long lb = number(m[1]);
+        numeric_ranges.emplace_back(crab::interval_t(lb, m[2].matched ? number(m[2]) : lb));
+        return true;
+    }
+    if (regex_match(cst_text, m, regex(R"_((.+) in \{(.+)\})_"))) {
+        const std::optional<variable_t> d = parse_variable(m[1], cells);
+        if (!d) return false;
+        std::vector<int> types;
+        const string names = m[2];
+        const regex type_name(R"_([a-z_]+)_");
+        for (std::sregex_iterator it(names.begin(), names.end(), type_name), end; it != end; ++it) {
+            types.push_back(string_to_type_encoding(it->str()));
+        }
+        res.push_back(*std::min_element(types.begin(), types.end()) <= *d);
+        res.push_back(*d <= *std::max_element(types.begin(), types.end()));
+        return true;
+    }
+    if (regex_match(cst_text, m, regex(R"_(([^=<]+)-([^=<]+)<=([-+]?\d+))_"))) {
+        const std::optional<variable_t> d = parse_variable(m[1], cells);
+        const std::optional<variable_t> s = parse_variable(m[2], cells);
+        if (!d || !s) return false;
+        res.push_back(*d - *s <= number_t(number(m[3])));
+        return true;
+    }
+    if (!regex_match(cst_text, m, regex(R"_(([^=]+)=(.+))_"))) {
+        return false;
+    }
+    const std::optional<variable_t> d = parse_variable(m[1], cells);
+    if (!d) return false;
+    const string rhs = m[2];
+    if (regex_match(rhs, m, regex(R"_(\[([-+]?\d+|-oo), ([-+]?\d+|\+oo)\])_"))) {
+        const crab::bound_t lb = bound(m[1]);
+        const crab::bound_t ub = bound(m[2]);
+        if (std::optional<crab::number_t> n = lb.number()) res.push_back(*n <= *d);
+        if (std::optional<crab::number_t> n = ub.number()) res.push_back(*d <= *n);
+        return true;
+    }
+    if (regex_match(rhs, m, regex(R"_([-+]?\d+)_"))) {
+        res.push_back(*d == number(rhs));
+        return true;
+    }
+    if (regex_match(rhs, m, regex(R"_(([^+]+)\+(\d+))_"))) {
+        const std::optional<variable_t> s = parse_variable(m[1], cells);
+        if (!s) return false;
+        const number_t k = number(m[2]);
+        res.push_back(*d - *s <= k);
+        res.push_back(*s - *d <= -k);
+        return true;
+    }
+    if (const std::optional<variable_t> s = parse_variable(rhs, cells)) {
+        res.push_back(equals(*d, *s));
+        return true;
+    }
+    if (regex_match(rhs, m, regex(R"_([a-z_]+)_"))) {
+        res.push_back(*d == string_to_type_encoding(rhs));
+        return true;
+    }
+    return false;
+}
+
+std::vector<linear_constraint_t> parse_linear_constraints(const std::set<string>& constraints,
+                                                          std::vector<crab::interval_t>& numeric_ranges,
+                                                          std::vector<stack_cell_t>& cells) {
     using namespace crab::dsl_syntax;
 
     std::vector<linear_constraint_t> res;
@@ -116,9 +217,10 @@ std::vector<linear_constraint_t> parse_linear_constraints(const std::set<string>
                 long lb = number(m[1]);
                 long ub = number(m[2]);
                 variable_t d = variable_t::cell_var(data_kind_t::types, lb, ub - lb + 1);
+                cells.push_back({data_kind_t::types, (int)lb, (int)(ub - lb + 1)});
                 res.push_back(d == type);
             }
-        } else {
+        } else if (!parse_general_constraint(cst_text, res, numeric_ranges, cells)) {
             throw std::runtime_error(string("Unknown constraint: ") + cst_text);
         }
     }
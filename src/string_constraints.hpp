@@ -44,4 +44,15 @@ struct string_invariant {
     friend std::ostream& operator<<(std::ostream&, const string_invariant& inv);
 };
 
-std::vector<linear_constraint_t> parse_linear_constraints(const std::set<std::string>& constraints, std::vector<crab::interval_t>& numeric_ranges);
+// A stack cell that a parsed constraint refers to, which the array domain must know about.
+struct stack_cell_t {
+    crab::data_kind_t kind;
+    int offset;
+    int size;
+};
+
+// Parse the constraints of a string invariant, as printed by to_set(). Byte ranges of the stack known to hold numbers
+// go to numeric_ranges, and the stack cells that the constraints refer to go to cells.
+std::vector<linear_constraint_t> parse_linear_constraints(const std::set<std::string>& constraints,
+                                                          std::vector<crab::interval_t>& numeric_ranges,
+                                                          std::vector<stack_cell_t>& cells);
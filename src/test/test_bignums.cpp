@@ -0,0 +1,137 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "crab/interval.hpp"
+#include "crab_verifier.hpp"
+#include "config.hpp"
+#include "platform.hpp"
+#include "test_programs.hpp"
+
+using namespace crab;
+
+TEST_CASE("z_number promotes on overflow and demotes back", "[bignums]") {
+    const z_number max{(signed long long)LLONG_MAX};
+    const z_number min{(signed long long)LLONG_MIN};
+
+    REQUIRE(max.fits_sint64());
+    REQUIRE_FALSE((max + 1).fits_sint64());
+    REQUIRE((max + 1) - 1 == max);
+    REQUIRE((max + 1).fits_uint64());
+    REQUIRE((uint64_t)(max + 1) == (uint64_t)LLONG_MAX + 1);
+    REQUIRE_FALSE((min - 1).fits_sint64());
+    REQUIRE_FALSE((-min).fits_sint64());
+    REQUIRE(-(-min) == min);
+    REQUIRE((min / -1) == -min);
+    REQUIRE((min % -1) == 0);
+    REQUIRE(max * max == z_number(cpp_int(LLONG_MAX) * cpp_int(LLONG_MAX)));
+    REQUIRE((max * max) / max == max);
+
+    const z_number umax{(unsigned long long)ULLONG_MAX};
+    REQUIRE(umax.fits_uint64());
+    REQUIRE_FALSE(umax.fits_sint64());
+    REQUIRE_FALSE((umax + 1).fits_uint64());
+    REQUIRE(umax == z_number(std::string("18446744073709551615")));
+    REQUIRE((z_number(1) << 64) - 1 == umax);
+    REQUIRE((umax >> 1) == max);
+    REQUIRE((umax & 0xff) == 0xff);
+
+    z_number n = max;
+    ++n;
+    REQUIRE(n > max);
+    --n;
+    REQUIRE(n == max);
+}
+
+TEST_CASE("z_number ordering across representations", "[bignums]") {
+    const z_number big = z_number((unsigned long long)ULLONG_MAX) * 4;
+    const z_number neg_big = -big;
+    const z_number small = 7;
+
+    REQUIRE(neg_big < small);
+    REQUIRE(small < big);
+    REQUIRE(neg_big < big);
+    REQUIRE(big > small);
+    REQUIRE(small != big);
+    REQUIRE(big - big == 0);
+    REQUIRE(big.hash() == (big + 0).hash());
+    REQUIRE(small.hash() == z_number(cpp_int(7)).hash());
+
+    std::ostringstream os;
+    os << big << " " << neg_big << " " << small;
+    REQUIRE(os.str() == "73786976294838206460 -73786976294838206460 7");
+}
+
+TEST_CASE("z_number arithmetic matches cpp_int", "[bignums]") {
+    const std::vector<long long> values{0, 1, -1, 7, -13, 255, 1LL << 31, -(1LL << 40), LLONG_MAX, LLONG_MIN};
+    for (long long a : values) {
+        for (long long b : values) {
+            const cpp_int x = a, y = b;
+            REQUIRE((cpp_int)(z_number(a) + z_number(b)) == x + y);
+            REQUIRE((cpp_int)(z_number(a) - z_number(b)) == x - y);
+            REQUIRE((cpp_int)(z_number(a) * z_number(b)) == x * y);
+            if (b != 0) {
+                REQUIRE((cpp_int)(z_number(a) / z_number(b)) == x / y);
+                REQUIRE((cpp_int)(z_number(a) % z_number(b)) == x % y);
+            }
+            REQUIRE((cpp_int)(z_number(a) & z_number(b)) == (x & y));
+            REQUIRE((cpp_int)(z_number(a) | z_number(b)) == (x | y));
+            REQUIRE((z_number(a) < z_number(b)) == (x < y));
+        }
+    }
+}
+
+// Hidden by default; run with `tests "[benchmark]"`.
+TEST_CASE("interval arithmetic benchmark", "[.][benchmark]") {
+    BENCHMARK("cpp_int add/mul/compare") {
+        cpp_int acc = 0;
+        for (int i = 0; i < 1000; i++) {
+            cpp_int x = i;
+            acc = (acc + x * 3) % 1000003;
+            if (acc < x) {
+                acc += 1;
+            }
+        }
+        return acc;
+    };
+
+    BENCHMARK("z_number add/mul/compare") {
+        z_number acc = 0;
+        for (int i = 0; i < 1000; i++) {
+            z_number x = i;
+            acc = (acc + x * 3) % 1000003;
+            if (acc < x) {
+                acc += 1;
+            }
+        }
+        return acc;
+    };
+
+    BENCHMARK("interval_t join/meet/add/mul") {
+        interval_t acc = interval_t(number_t(0));
+        for (int i = 0; i < 1000; i++) {
+            interval_t x(bound_t(number_t(-i)), bound_t(number_t(i)));
+            acc = ((acc | x) + interval_t(number_t(1))) & interval_t(bound_t(number_t(-4096)), bound_t(number_t(4096)));
+            acc = acc * interval_t(number_t(1));
+        }
+        return acc;
+    };
+}
+
+TEST_CASE("ebpf_verify_program benchmark", "[.][benchmark]") {
+    // A bounded loop that keeps a counter both in a register and on the stack.
+    const Reg r0{0}, r1{1}, r10{10};
+    const InstructionSeq prog =
+        counting_loop(100,
+                      {Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r1, .is_load = false},
+                       Bin{.op = Bin::Op::ADD, .dst = r0, .v = r1, .is64 = true}},
+                      Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true});
+    const program_info info = program_info_of();
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.print_failures = false;
+    std::ostringstream os;
+    REQUIRE(ebpf_verify_program(os, prog, info, &options, nullptr));
+
+    BENCHMARK("counting loop") { return ebpf_verify_program(os, prog, info, &options, nullptr); };
+}
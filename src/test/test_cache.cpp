@@ -0,0 +1,107 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <filesystem>
+#include <sstream>
+
+#include "catch.hpp"
+
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+// Exits without setting r0.
+static raw_program uninitialized_return() { return raw_program_of({Exit{}}); }
+
+static raw_program return_zero() {
+    return raw_program_of({Bin{.op = Bin::Op::MOV, .dst = Reg{0}, .v = Imm{0}, .is64 = true}, Exit{}});
+}
+
+static std::filesystem::path fresh_cache_directory() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "prevail-test-cache";
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+
+static bool verify(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                   const verification_cache_t& cache, std::string* report = nullptr) {
+    const InstructionSeq prog = std::get<InstructionSeq>(unmarshal(raw_prog));
+    std::ostringstream os;
+    const bool res = ebpf_verify_program(os, raw_prog, prog, &options, nullptr, cache);
+    if (report) {
+        *report = os.str();
+    }
+    return res;
+}
+
+TEST_CASE("the cache key covers what the verdict depends on", "[cache]") {
+    const ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    const raw_program raw_prog = return_zero();
+    const std::string key = verification_cache_t::key(raw_prog, options);
+    REQUIRE(key.size() == 64);
+    REQUIRE(key == verification_cache_t::key(return_zero(), options));
+
+    REQUIRE(key != verification_cache_t::key(uninitialized_return(), options));
+
+    raw_program with_map = raw_prog;
+    with_map.info.map_descriptors.push_back(
+        {.original_fd = 1, .type = 1, .key_size = 4, .value_size = 8, .max_entries = 16});
+    REQUIRE(key != verification_cache_t::key(with_map, options));
+
+    raw_program other_type = raw_prog;
+    other_type.info.type = g_ebpf_platform_linux.get_program_type("xdp", "");
+    REQUIRE(key != verification_cache_t::key(other_type, options));
+
+    // The same bytes and program type name mean other helpers and map types on another platform.
+    ebpf_platform_t other_platform = g_ebpf_platform_linux;
+    other_platform.name = "other";
+    raw_program on_other_platform = raw_prog;
+    on_other_platform.info.platform = &other_platform;
+    REQUIRE(key != verification_cache_t::key(on_other_platform, options));
+
+    ebpf_verifier_options_t termination = options;
+    termination.check_termination = true;
+    REQUIRE(key != verification_cache_t::key(raw_prog, termination));
+
+    // Printing options do not change the result.
+    ebpf_verifier_options_t print = options;
+    print.print_failures = true;
+    REQUIRE(key == verification_cache_t::key(raw_prog, print));
+}
+
+TEST_CASE("verification results are reused from the cache", "[cache]") {
+    const verification_cache_t cache(fresh_cache_directory());
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.print_failures = true;
+
+    std::string report;
+    REQUIRE_FALSE(verify(uninitialized_return(), options, cache, &report));
+    REQUIRE(report.find("r0.type") != std::string::npos);
+    const std::string key = verification_cache_t::key(uninitialized_return(), options);
+    const std::optional<verification_cache_entry_t> entry = cache.lookup(key);
+    REQUIRE(entry.has_value());
+    REQUIRE_FALSE(entry->pass);
+    REQUIRE(entry->total_warnings > 0);
+    REQUIRE(entry->report == report);
+
+    std::string cached_report;
+    REQUIRE_FALSE(verify(uninitialized_return(), options, cache, &cached_report));
+    REQUIRE(cached_report == report);
+
+    // A stored result is returned without verifying the program again.
+    cache.store(key, {.pass = true});
+    REQUIRE(verify(uninitialized_return(), options, cache));
+
+    REQUIRE(verify(return_zero(), options, cache));
+    REQUIRE(cache.lookup(verification_cache_t::key(return_zero(), options))->pass);
+}
+
+TEST_CASE("unreadable cache entries are ignored", "[cache]") {
+    const std::filesystem::path directory = fresh_cache_directory();
+    const verification_cache_t cache(directory);
+    const ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    const std::string key = verification_cache_t::key(return_zero(), options);
+
+    std::ofstream(directory / key) << "not a cache entry\n";
+    REQUIRE_FALSE(cache.lookup(key).has_value());
+    REQUIRE(verify(return_zero(), options, cache));
+    REQUIRE(cache.lookup(key).has_value());
+}
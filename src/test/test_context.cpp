@@ -0,0 +1,101 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <thread>
+
+#include "catch.hpp"
+
+#include "crab_utils/arena.hpp"
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+using namespace crab;
+
+static const Reg r0{0}, r1{1}, r10{10};
+
+// Stores a counter on the stack and reads it back after a bounded loop.
+static raw_program stack_loop() {
+    return raw_program_of({
+        Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{0}, .is64 = true},
+        Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r1, .is_load = false},
+        Bin{.op = Bin::Op::ADD, .dst = r1, .v = Imm{1}, .is64 = true},
+        Jmp{.cond = Condition{.op = Condition::Op::LT, .left = r1, .right = Imm{10}}, .target = label_t(1)},
+        Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r0, .is_load = true},
+        Exit{},
+    });
+}
+
+// Reads a stack slot that was never written.
+static raw_program uninitialized_read() {
+    return raw_program_of({
+        Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -16}, .value = r0, .is_load = true},
+        Exit{},
+    });
+}
+
+static bool verify(const raw_program& raw_prog, ebpf_verifier_stats_t* stats = nullptr) {
+    return verify_raw_program(raw_prog, ebpf_verifier_default_options, stats);
+}
+
+TEST_CASE("verification contexts are independent and reusable", "[context]") {
+    verification_context_t first;
+    verification_context_t second;
+    for (int i = 0; i < 2; i++) {
+        {
+            verification_context_t::scope_t scope{first};
+            REQUIRE(verify(stack_loop()));
+        }
+        {
+            verification_context_t::scope_t scope{second};
+            REQUIRE_FALSE(verify(uninitialized_read()));
+        }
+    }
+    REQUIRE(first.info.platform == &g_ebpf_platform_linux);
+    REQUIRE(second.info.platform == &g_ebpf_platform_linux);
+    REQUIRE(&verification_context_t::current() != &first);
+    REQUIRE(&verification_context_t::current() != &second);
+}
+
+TEST_CASE("verification contexts can move between threads", "[context]") {
+    std::vector<verification_context_t> contexts(4);
+    std::vector<int> results(contexts.size());
+    for (int round = 0; round < 2; round++) {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < contexts.size(); i++) {
+            workers.emplace_back([&, i] {
+                verification_context_t::scope_t scope{contexts[i]};
+                results[i] = verify((i % 2 == 0) ? stack_loop() : uninitialized_read());
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(results == std::vector<int>{1, 0, 1, 0});
+    }
+}
+
+TEST_CASE("a reused context takes its temporaries from memory it already holds", "[context]") {
+    verification_context_t context;
+    verification_context_t::scope_t scope{context};
+    ebpf_verifier_stats_t first{};
+    REQUIRE(verify(stack_loop(), &first));
+    REQUIRE(first.scratch_allocations > 0);
+    REQUIRE(first.scratch_peak_bytes > 0);
+    REQUIRE(first.scratch_peak_bytes <= first.scratch_bytes);
+    REQUIRE(first.system_allocations > 0);
+
+    ebpf_verifier_stats_t second{};
+    REQUIRE(verify(stack_loop(), &second));
+    REQUIRE(second.scratch_allocations == first.scratch_allocations);
+    REQUIRE(second.system_allocations == 0);
+}
+
+TEST_CASE("the scratch arena is not reset while a temporary is in use", "[context]") {
+    verification_context_t context;
+    verification_context_t::scope_t scope{context};
+    {
+        crab::arena_vector<int> temporary(16);
+        REQUIRE_THROWS_AS(crab::scratch_arena().reset(), std::runtime_error);
+    }
+    crab::scratch_arena().reset();
+    REQUIRE(crab::scratch_arena().stats().resets == 1);
+}
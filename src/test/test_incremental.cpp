@@ -0,0 +1,89 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <sstream>
+
+#include "catch.hpp"
+
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+static const Reg r0{0}, r1{1};
+
+static InstructionSeq return_counter() {
+    return counting_loop(10, {}, Bin{.op = Bin::Op::MOV, .dst = r0, .v = r1, .is64 = true});
+}
+
+static InstructionSeq return_ten() {
+    return counting_loop(10, {}, Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{10}, .is64 = true});
+}
+
+static bool verify(const InstructionSeq& prog, invariant_snapshot_t& snapshot, ebpf_verifier_stats_t& stats,
+                   const ebpf_verifier_options_t& options = ebpf_verifier_default_options) {
+    std::ostringstream os;
+    return ebpf_verify_program(os, prog, program_info_of(), &options, &stats, snapshot);
+}
+
+static std::string to_string(const invariant_snapshot_t& snapshot) {
+    std::ostringstream os;
+    snapshot.write(os);
+    return os.str();
+}
+
+TEST_CASE("an unchanged program reuses the invariants of all its blocks", "[incremental]") {
+    invariant_snapshot_t snapshot;
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(return_counter(), snapshot, stats));
+    REQUIRE(stats.reused_blocks == 0);
+    REQUIRE_FALSE(snapshot.blocks.empty());
+    const std::string first = to_string(snapshot);
+
+    REQUIRE(verify(return_counter(), snapshot, stats));
+    REQUIRE(stats.reused_blocks == (int)snapshot.blocks.size());
+    REQUIRE(stats.total_warnings == 0);
+    REQUIRE(to_string(snapshot) == first);
+}
+
+TEST_CASE("only the blocks reachable from a change are analyzed again", "[incremental]") {
+    invariant_snapshot_t fresh;
+    ebpf_verifier_stats_t fresh_stats{};
+    REQUIRE(verify(return_ten(), fresh, fresh_stats));
+
+    invariant_snapshot_t snapshot;
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(return_counter(), snapshot, stats));
+    REQUIRE(verify(return_ten(), snapshot, stats));
+    // The loop is unchanged, and so is the block before it.
+    REQUIRE(stats.reused_blocks > 0);
+    REQUIRE(stats.reused_blocks < (int)snapshot.blocks.size());
+    REQUIRE(to_string(snapshot) == to_string(fresh));
+}
+
+TEST_CASE("invariants are not reused with other options", "[incremental]") {
+    invariant_snapshot_t snapshot;
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(return_counter(), snapshot, stats));
+
+    ebpf_verifier_options_t termination = ebpf_verifier_default_options;
+    termination.check_termination = true;
+    REQUIRE(verify(return_counter(), snapshot, stats, termination));
+    REQUIRE(stats.reused_blocks == 0);
+    REQUIRE(verify(return_counter(), snapshot, stats, termination));
+    REQUIRE(stats.reused_blocks == (int)snapshot.blocks.size());
+}
+
+TEST_CASE("snapshots can be written and read back", "[incremental]") {
+    invariant_snapshot_t snapshot;
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(return_counter(), snapshot, stats));
+
+    std::stringstream ss;
+    snapshot.write(ss);
+    std::optional<invariant_snapshot_t> read = invariant_snapshot_t::read(ss);
+    REQUIRE(read.has_value());
+    REQUIRE(to_string(*read) == to_string(snapshot));
+    REQUIRE(verify(return_counter(), *read, stats));
+    REQUIRE(stats.reused_blocks == (int)snapshot.blocks.size());
+
+    std::istringstream not_a_snapshot("prevail-verification-cache 1\n");
+    REQUIRE_FALSE(invariant_snapshot_t::read(not_a_snapshot).has_value());
+}
@@ -0,0 +1,138 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "catch.hpp"
+
+#include "crab/interval_domain.hpp"
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+using namespace crab;
+using crab::domains::IntervalDomain;
+
+static const variable_t x = variable_t::reg(data_kind_t::values, 1);
+static const variable_t y = variable_t::reg(data_kind_t::values, 2);
+
+static linear_constraint_t leq(const linear_expression_t& e) {
+    return linear_constraint_t(e, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+}
+
+TEST_CASE("IntervalDomain tightens bounds by constraints between variables", "[interval_domain]") {
+    IntervalDomain dom;
+    dom.set(x, interval_t{number_t{0}, number_t{10}});
+    dom.set(y, interval_t{number_t{3}, number_t{20}});
+
+    // y <= x
+    dom += leq(linear_expression_t(y) - x);
+    REQUIRE(dom[x] == interval_t(number_t{3}, number_t{10}));
+    REQUIRE(dom[y] == interval_t(number_t{3}, number_t{10}));
+
+    // But it does not keep the relation.
+    dom.set(x, interval_t{number_t{4}});
+    REQUIRE(dom[y] == interval_t(number_t{3}, number_t{10}));
+
+    dom += linear_constraint_t(linear_expression_t(y) - 3, constraint_kind_t::NOT_ZERO);
+    REQUIRE(dom[y] == interval_t(number_t{4}, number_t{10}));
+    REQUIRE(dom.entail(leq(linear_expression_t(x) - y)));
+    REQUIRE_FALSE(dom.entail(linear_constraint_t(linear_expression_t(x) - y, constraint_kind_t::EQUALS_ZERO)));
+
+    dom += leq(linear_expression_t(y) - x + 1);
+    REQUIRE(dom.is_bottom());
+}
+
+TEST_CASE("IntervalDomain joins and widens variable by variable", "[interval_domain]") {
+    IntervalDomain a;
+    a.set(x, interval_t{number_t{0}});
+    a.set(y, interval_t{number_t{1}});
+    IntervalDomain b;
+    b.set(x, interval_t{number_t{1}});
+
+    const IntervalDomain join = a | b;
+    REQUIRE(join[x] == interval_t(number_t{0}, number_t{1}));
+    REQUIRE(join[y] == interval_t::top());
+    REQUIRE(a <= join);
+    REQUIRE(b <= join);
+    REQUIRE_FALSE(join <= a);
+
+    const IntervalDomain widened = a.widen(join);
+    REQUIRE(widened[x] == interval_t(bound_t{number_t{0}}, bound_t::plus_infinity()));
+    REQUIRE(join <= widened);
+    REQUIRE(widened.narrow(join)[x] == interval_t(number_t{0}, number_t{1}));
+
+    REQUIRE((a & b).is_bottom());
+    REQUIRE((IntervalDomain::bottom() | a)[y] == interval_t(number_t{1}));
+}
+
+TEST_CASE("IntervalDomain widens growing bounds up to the next threshold", "[interval_domain]") {
+    crab::iterators::thresholds_t thresholds;
+    thresholds.add(bound_t{number_t{10}});
+    thresholds.add(bound_t{number_t{-5}});
+
+    IntervalDomain before;
+    before.set(x, interval_t{number_t{0}, number_t{1}});
+    before.set(y, interval_t{number_t{0}});
+    IntervalDomain after;
+    after.set(x, interval_t{number_t{-1}, number_t{2}});
+    after.set(y, interval_t{number_t{0}, number_t{20}});
+
+    const IntervalDomain widened = before.widening_thresholds(after, thresholds);
+    REQUIRE(widened[x] == interval_t(number_t{-5}, number_t{10}));
+    REQUIRE(widened[y] == interval_t(bound_t{number_t{0}}, bound_t::plus_infinity()));
+    REQUIRE(after <= widened);
+    REQUIRE(widened <= before.widen(after));
+    REQUIRE(IntervalDomain::bottom().widening_thresholds(after, thresholds) == after);
+}
+
+TEST_CASE("IntervalDomain lists the variables whose bounds differ", "[interval_domain]") {
+    IntervalDomain a;
+    a.set(x, interval_t{number_t{0}});
+    IntervalDomain b(a);
+    auto any = [](variable_t) { return true; };
+    REQUIRE(a.bound_differences(b, any).empty());
+
+    b.set({{x, interval_t{number_t{1}}}, {y, interval_t{number_t{2}}}});
+    REQUIRE(a.bound_differences(b, any) == std::vector<variable_t>{x, y});
+    REQUIRE(b.bound_differences(a, [](variable_t v) { return v == y; }) == std::vector<variable_t>{y});
+}
+
+TEST_CASE("IntervalDomain compares the bounds of its variables for equality", "[interval_domain]") {
+    IntervalDomain a;
+    a.set(x, interval_t{number_t{0}, number_t{1}});
+    IntervalDomain b;
+    b.set(y, interval_t::top());
+    b.set(x, interval_t{number_t{0}, number_t{1}});
+    REQUIRE(a == b);
+
+    b.set(y, interval_t{number_t{2}});
+    REQUIRE_FALSE(a == b);
+    REQUIRE_FALSE(a == IntervalDomain::bottom());
+    REQUIRE(IntervalDomain::bottom() == IntervalDomain::bottom());
+}
+
+static bool verify_with(numeric_domain_t numeric_domain, ebpf_verifier_stats_t& stats) {
+    // Stores a number on the stack, reads it back, masks it and adds 1 to it.
+    const Reg r0{0}, r1{1}, r10{10};
+    const raw_program raw_prog = raw_program_of({
+        Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{200}, .is64 = true},
+        Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r1, .is_load = false},
+        Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r0, .is_load = true},
+        Bin{.op = Bin::Op::AND, .dst = r0, .v = Imm{0xff}, .is64 = true},
+        Bin{.op = Bin::Op::ADD, .dst = r0, .v = Imm{1}, .is64 = true},
+        Exit{},
+    });
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.numeric_domain = numeric_domain;
+    options.print_invariants = true;
+    std::string report;
+    const bool res = verify_raw_program(raw_prog, options, &stats, &report);
+    REQUIRE(report.find("r0.value=201") != std::string::npos);
+    return res;
+}
+
+TEST_CASE("the verifier can analyze with intervals instead of zones", "[interval_domain]") {
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify_with(numeric_domain_t::intervals, stats));
+    REQUIRE(stats.tier == numeric_domain_t::intervals);
+
+    REQUIRE(verify_with(numeric_domain_t::zones, stats));
+    REQUIRE(stats.tier == numeric_domain_t::zones);
+}
@@ -0,0 +1,90 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "catch.hpp"
+
+#include "crab/fwd_analyzer.hpp"
+#include "crab/liveness.hpp"
+#include "ebpf_verifier.hpp"
+
+using namespace crab;
+
+static const Reg r0{0}, r1{1}, r2{2}, r3{3}, r10{10};
+
+// Two branches that compute r3 from different registers, joined before r1 is overwritten
+// and r3 is stored on the stack.
+static cfg_t diamond() {
+    cfg_t cfg;
+    basic_block_t& start = cfg.insert(label_t(0));
+    basic_block_t& left = cfg.insert(label_t(1));
+    basic_block_t& right = cfg.insert(label_t(2));
+    basic_block_t& join = cfg.insert(label_t(3));
+    basic_block_t& exit = cfg.get_node(cfg.exit_label());
+
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{1}, .is64 = true});
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r2, .v = Imm{2}, .is64 = true});
+    left.insert(Bin{.op = Bin::Op::MOV, .dst = r3, .v = r1, .is64 = true});
+    right.insert(Bin{.op = Bin::Op::MOV, .dst = r3, .v = r2, .is64 = true});
+    join.insert(Mem{.access = Deref{.width = 8, .basereg = r10, .offset = -8}, .value = r3, .is_load = false});
+    join.insert(Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{0}, .is64 = true});
+    join.insert(Bin{.op = Bin::Op::MOV, .dst = r0, .v = r3, .is64 = true});
+
+    cfg.get_node(cfg.entry_label()) >> start;
+    start >> left;
+    start >> right;
+    left >> join;
+    right >> join;
+    join >> exit;
+    return cfg;
+}
+
+TEST_CASE("registers and stack bytes written before they are read are dead", "[liveness]") {
+    const cfg_t cfg = diamond();
+    const flat_cfg_t flat_cfg(cfg);
+    const liveness_t liveness(flat_cfg);
+
+    const live_set_t& at_join = liveness.live_in(flat_cfg.id(label_t(3)));
+    REQUIRE_FALSE(at_join.registers.test(0));
+    REQUIRE_FALSE(at_join.registers.test(1));
+    REQUIRE(at_join.registers.test(2));
+    REQUIRE(at_join.registers.test(3));
+    REQUIRE(at_join.registers.test(10));
+    for (int i = 0; i < EBPF_STACK_SIZE; i++) {
+        REQUIRE(at_join.stack.test(i) == (i < EBPF_STACK_SIZE - 8));
+    }
+
+    // The left branch reads r1, so it is live before the branches but dead after them.
+    const live_set_t& at_start = liveness.live_in(flat_cfg.id(label_t(0)));
+    REQUIRE_FALSE(at_start.registers.test(1));
+    REQUIRE(liveness.live_in(flat_cfg.id(label_t(1))).registers.test(1));
+    REQUIRE(liveness.live_at_join(flat_cfg.id(label_t(1))).has_value());
+    REQUIRE_FALSE(liveness.live_at_join(flat_cfg.id(label_t(0))).has_value());
+
+    // Everything is live at the exit.
+    REQUIRE(liveness.live_in(flat_cfg.exit()) == live_set_t::all());
+}
+
+TEST_CASE("dead registers are forgotten before a join", "[liveness]") {
+    const cfg_t cfg = diamond();
+    const flat_cfg_t flat_cfg(cfg);
+    verification_context_t::current().reset(
+        program_info{
+            .platform = &g_ebpf_platform_linux,
+            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec"),
+        },
+        ebpf_verifier_default_options);
+
+    const invariant_tables_t invariants = run_forward_analyzer(flat_cfg, zone_domain_t::setup_entry(false), false);
+
+    const string_invariant at_join = invariants.get_pre(label_t(3)).to_set();
+    REQUIRE(at_join.contains("r2.value=2"));
+    REQUIRE(at_join.contains("r3.type=number"));
+    for (const std::string& item : at_join.value()) {
+        REQUIRE(item.rfind("r1.", 0) != 0);
+    }
+
+    // The join does not lose what the exit needs.
+    const string_invariant at_exit = invariants.get_post(flat_cfg.exit()).to_set();
+    REQUIRE(at_exit.contains("r1.value=0"));
+    REQUIRE(at_exit.contains("r2.value=2"));
+    REQUIRE(at_exit.contains("r0.type=number"));
+}
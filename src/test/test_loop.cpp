@@ -1,8 +1,12 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
 
+#include "crab/fwd_analyzer.hpp"
+#include "crab/wto.hpp"
 #include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
 
 using namespace crab;
 
@@ -28,6 +32,356 @@ TEST_CASE("Trivial loop: middle", "[sanity][loop]") {
         .platform = &g_ebpf_platform_linux,
         .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")
     };
-    bool pass = run_ebpf_analysis(std::cout, cfg, info, &options, nullptr);
+    bool pass = run_ebpf_analysis(std::cout, flat_cfg_t(cfg), info, &options, nullptr);
     REQUIRE(pass);
 }
+
+TEST_CASE("Invariants that are not stored are recomputed", "[loop]") {
+    cfg_t cfg;
+
+    Reg r0{0}, r1{1};
+    basic_block_t& start = cfg.insert(label_t(0));
+    basic_block_t& head = cfg.insert(label_t(1));
+    basic_block_t& body = cfg.insert(label_t(2));
+    basic_block_t& body_tail = cfg.insert(label_t(3));
+    basic_block_t& done = cfg.insert(label_t(4));
+    basic_block_t& exit = cfg.get_node(cfg.exit_label());
+
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true});
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{0}, .is64 = true});
+    body.insert(Assume{{.op = Condition::Op::LT, .left = r0, .right = Imm{10}}});
+    body.insert(Bin{.op = Bin::Op::ADD, .dst = r0, .v = Imm{1}, .is64 = true});
+    body_tail.insert(Bin{.op = Bin::Op::ADD, .dst = r1, .v = Imm{2}, .is64 = true});
+    done.insert(Assume{{.op = Condition::Op::GE, .left = r0, .right = Imm{10}}});
+    done.insert(Bin{.op = Bin::Op::MOV, .dst = r1, .v = r0, .is64 = true});
+
+    cfg.get_node(cfg.entry_label()) >> start;
+    start >> head;
+    head >> body;
+    body >> body_tail;
+    body_tail >> head;
+    head >> done;
+    done >> exit;
+
+    verification_context_t::current().reset(program_info_of(), ebpf_verifier_default_options);
+
+    // The invariants seen on the last visit of each block are the final ones.
+    flat_cfg_t flat_cfg(cfg);
+    std::map<label_t, string_invariant> last_pre, last_post;
+    crab::visit_hooks_t<zone_domain_t> hooks{
+        .before = [&](block_id_t id, zone_domain_t& pre) { last_pre.insert_or_assign(flat_cfg.label(id), pre.to_set()); },
+        .after = [&](block_id_t id, const zone_domain_t& post) {
+            last_post.insert_or_assign(flat_cfg.label(id), zone_domain_t(post).to_set());
+        },
+    };
+    crab::invariant_tables_t invariants =
+        crab::run_forward_analyzer(flat_cfg, zone_domain_t::setup_entry(false), false, hooks);
+
+    for (const label_t& label : cfg.sorted_labels()) {
+        REQUIRE(invariants.get_pre(label).to_set() == last_pre.at(label));
+        REQUIRE(invariants.get_post(label).to_set() == last_post.at(label));
+    }
+}
+
+TEST_CASE("Blocks whose inputs did not change are not visited again", "[loop]") {
+    cfg_t cfg;
+
+    Reg r0{0}, r6{6};
+    basic_block_t& start = cfg.insert(label_t(0));
+    basic_block_t& head = cfg.insert(label_t(1));
+    basic_block_t& body = cfg.insert(label_t(2));
+    basic_block_t& rare = cfg.insert(label_t(3));
+    basic_block_t& rare_tail = cfg.insert(label_t(4));
+    basic_block_t& done = cfg.insert(label_t(5));
+    basic_block_t& exit = cfg.get_node(cfg.exit_label());
+
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true});
+    start.insert(Bin{.op = Bin::Op::MOV, .dst = r6, .v = Imm{0}, .is64 = true});
+    body.insert(Assume{{.op = Condition::Op::LT, .left = r0, .right = Imm{10}}});
+    body.insert(Bin{.op = Bin::Op::ADD, .dst = r0, .v = Imm{1}, .is64 = true});
+    // Never taken, so its post-invariant is bottom on every iteration.
+    rare.insert(Assume{{.op = Condition::Op::NE, .left = r6, .right = Imm{0}}});
+    rare_tail.insert(Bin{.op = Bin::Op::ADD, .dst = r0, .v = Imm{2}, .is64 = true});
+    done.insert(Assume{{.op = Condition::Op::GE, .left = r0, .right = Imm{10}}});
+
+    cfg.get_node(cfg.entry_label()) >> start;
+    start >> head;
+    head >> body;
+    body >> head;
+    head >> rare;
+    rare >> rare_tail;
+    rare_tail >> head;
+    head >> done;
+    done >> exit;
+
+    verification_context_t::current().reset(program_info_of(), ebpf_verifier_default_options);
+
+    flat_cfg_t flat_cfg(cfg);
+    std::map<label_t, int> visits;
+    crab::visit_hooks_t<zone_domain_t> hooks{
+        .before = [&](block_id_t id, zone_domain_t&) { visits[flat_cfg.label(id)]++; },
+    };
+    crab::invariant_tables_t invariants =
+        crab::run_forward_analyzer(flat_cfg, zone_domain_t::setup_entry(false), false, hooks);
+
+    REQUIRE(visits.at(label_t(1)) > 2);
+    REQUIRE(visits.at(label_t(2)) > 1);
+    REQUIRE(visits.at(label_t(4)) == 1);
+    REQUIRE(invariants.get_pre(label_t(4)).is_bottom());
+}
+
+// Nests loops the way the counter/templates programs do when they are not unrolled:
+// each level counts from 0 to 4 in its own register, and the innermost body
+// counts in r0 or r6 depending on whether the two innermost counters are equal.
+static InstructionSeq nested_loops(int depth) {
+    const Reg r0{0}, r6{6};
+    InstructionSeq prog;
+    auto add = [&](Instruction ins) { prog.emplace_back(label_t((int)prog.size()), ins, std::nullopt); };
+    auto next = [&](int offset) { return label_t((int)prog.size() + offset); };
+
+    add(Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true});
+    add(Bin{.op = Bin::Op::MOV, .dst = r6, .v = Imm{0}, .is64 = true});
+    std::vector<label_t> heads;
+    for (int level = 1; level <= depth; level++) {
+        add(Bin{.op = Bin::Op::MOV, .dst = Reg{(uint8_t)level}, .v = Imm{0}, .is64 = true});
+        heads.push_back(next(0));
+    }
+    const Reg inner{(uint8_t)depth}, outer{(uint8_t)std::max(depth - 1, 1)};
+    add(Jmp{.cond = Condition{.op = Condition::Op::EQ, .left = inner, .right = outer}, .target = next(3)});
+    add(Bin{.op = Bin::Op::ADD, .dst = r6, .v = Imm{1}, .is64 = true});
+    add(Jmp{.cond = {}, .target = next(2)});
+    add(Bin{.op = Bin::Op::ADD, .dst = r0, .v = Imm{1}, .is64 = true});
+    for (int level = depth; level >= 1; level--) {
+        add(Bin{.op = Bin::Op::ADD, .dst = Reg{(uint8_t)level}, .v = Imm{1}, .is64 = true});
+        add(Jmp{.cond = Condition{.op = Condition::Op::LT, .left = Reg{(uint8_t)level}, .right = Imm{4}},
+                .target = heads[level - 1]});
+    }
+    add(Exit{});
+    return prog;
+}
+
+TEST_CASE("Nested loops are nested in the wto", "[loop]") {
+    constexpr int depth = 4;
+    const InstructionSeq prog = nested_loops(depth);
+    const program_info info = program_info_of();
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.print_failures = false;
+    const flat_cfg_t cfg = prepare_cfg(prog, info, !options.no_simplify);
+    const wto_t wto(cfg);
+
+    uint32_t heads = 0;
+    uint32_t deepest = 0;
+    for (uint32_t index = 0; index < wto.size(); index++) {
+        heads += wto[index].is_head ? 1 : 0;
+        deepest = std::max(deepest, wto.nesting_depth(wto[index].vertex));
+    }
+    REQUIRE(heads == depth);
+    REQUIRE(deepest == depth);
+    REQUIRE(wto.nesting_depth(cfg.id(label_t(2 + depth))) == depth - 1);
+    REQUIRE(wto.nesting_depth(cfg.exit()) == 0);
+
+    std::ostringstream os;
+    REQUIRE(ebpf_verify_program(os, prog, info, &options, nullptr));
+}
+
+TEST_CASE("The iterations of each loop are counted as the policy allows", "[loop]") {
+    constexpr int depth = 3;
+    const InstructionSeq prog = nested_loops(depth);
+    const program_info info = program_info_of();
+    auto verify = [&](const ebpf_verifier_options_t& options) {
+        ebpf_verifier_stats_t stats{};
+        std::ostringstream os;
+        REQUIRE(ebpf_verify_program(os, prog, info, &options, &stats));
+        REQUIRE(stats.loops.size() == depth);
+        return stats.loops;
+    };
+    auto total = [](const std::vector<loop_stats_t>& loops, int loop_stats_t::*iterations) {
+        int sum = 0;
+        for (const loop_stats_t& loop : loops) {
+            sum += loop.*iterations;
+        }
+        return sum;
+    };
+
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    const std::vector<loop_stats_t> loops = verify(options);
+    for (const loop_stats_t& loop : loops) {
+        REQUIRE(loop.ascending_iterations > 1);
+        REQUIRE(loop.descending_iterations > 0);
+    }
+    // The inner loops are analyzed again on each iteration of the outer ones.
+    REQUIRE(loops.back().ascending_iterations > loops.front().ascending_iterations);
+
+    options.descending_iterations = 0;
+    REQUIRE(total(verify(options), &loop_stats_t::descending_iterations) == 0);
+
+    options = ebpf_verifier_default_options;
+    options.widening_delay = 3;
+    REQUIRE(total(verify(options), &loop_stats_t::ascending_iterations) >
+            total(loops, &loop_stats_t::ascending_iterations));
+
+    options = ebpf_verifier_default_options;
+    options.adaptive_narrowing = true;
+    REQUIRE(total(verify(options), &loop_stats_t::descending_iterations) <=
+            total(loops, &loop_stats_t::descending_iterations));
+}
+
+TEST_CASE("The kept pre-invariants are those the blocks were last visited with", "[loop]") {
+    const program_info info = program_info_of();
+    const flat_cfg_t cfg = prepare_cfg(nested_loops(2), info, true);
+    verification_context_t::current().reset(info, ebpf_verifier_default_options);
+    for (unsigned int descending_iterations : {0u, 1u, 2000000u}) {
+        std::map<block_id_t, zone_domain_t> last_pre;
+        crab::visit_hooks_t<zone_domain_t> hooks{
+            .before = [&](block_id_t id, zone_domain_t& pre) { last_pre.insert_or_assign(id, pre); },
+        };
+        const crab::invariant_tables_t<zone_domain_t> invariants = crab::run_forward_analyzer(
+            cfg, zone_domain_t::setup_entry(false), false, hooks, {},
+            crab::iteration_policy_t{.descending_iterations = descending_iterations});
+        const wto_t wto(cfg);
+        for (uint32_t index = 0; index < wto.size(); index++) {
+            if (wto[index].is_head) {
+                const block_id_t head = wto[index].vertex;
+                REQUIRE(invariants.get_pre(head) == last_pre.at(head));
+            }
+        }
+    }
+}
+
+TEST_CASE("The post-invariants recomputed from the tables are those of the analysis", "[loop]") {
+    const program_info info = program_info_of();
+    const flat_cfg_t cfg = prepare_cfg(nested_loops(2), info, true);
+    for (bool assume_assertions : {false, true}) {
+        ebpf_verifier_options_t options = ebpf_verifier_default_options;
+        options.assume_assertions = assume_assertions;
+        verification_context_t::current().reset(info, options);
+        // The tables recompute the posts without the hooks, and so without the require check installed here.
+        std::map<block_id_t, zone_domain_t> last_post;
+        crab::visit_hooks_t<zone_domain_t> hooks{
+            .before =
+                [](block_id_t, zone_domain_t& pre) {
+                    pre.set_require_check(
+                        [](auto& inv, const linear_constraint_t& cst, const std::string&) { return inv.entail(cst); });
+                },
+            .after = [&](block_id_t id, const zone_domain_t& post) { last_post.insert_or_assign(id, post); },
+        };
+        const crab::invariant_tables_t<zone_domain_t> invariants =
+            crab::run_forward_analyzer(cfg, zone_domain_t::setup_entry(false), false, hooks);
+        for (const auto& [id, post] : last_post) {
+            REQUIRE(invariants.get_post(id) == post);
+        }
+    }
+    verification_context_t::current().reset(info, ebpf_verifier_default_options);
+}
+
+TEST_CASE("A verification past its deadline or cancelled times out", "[loop]") {
+    const InstructionSeq prog = nested_loops(2);
+    const program_info info = program_info_of();
+    std::atomic<bool> cancelled{true};
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.cancelled = &cancelled;
+    ebpf_verifier_stats_t stats{};
+    std::ostringstream os;
+    REQUIRE_FALSE(ebpf_verify_program(os, prog, info, &options, &stats));
+    REQUIRE(stats.timed_out);
+    REQUIRE(stats.total_warnings == 1);
+    // The flag is forgotten once the verification returns, so nothing run later in this context is stopped by it.
+    REQUIRE(verification_context_t::current().options.cancelled == nullptr);
+
+    options = ebpf_verifier_default_options;
+    options.deadline = std::chrono::steady_clock::now();
+    options.tiered = true;
+    REQUIRE_FALSE(ebpf_verify_program(os, prog, info, &options, &stats));
+    REQUIRE(stats.timed_out);
+    REQUIRE_FALSE(verification_context_t::current().options.deadline);
+
+    options.deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+    REQUIRE(ebpf_verify_program(os, prog, info, &options, &stats));
+    REQUIRE_FALSE(stats.timed_out);
+}
+
+TEST_CASE("A timeout reports the innermost loop being analyzed", "[loop]") {
+    const program_info info = program_info_of();
+    const flat_cfg_t cfg = prepare_cfg(nested_loops(2), info, true);
+    const wto_t wto(cfg);
+    std::atomic<bool> cancelled{false};
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.cancelled = &cancelled;
+    verification_context_t::current().reset(info, options);
+
+    // Cancel from within the inner loop, which the next visit notices.
+    crab::visit_hooks_t<zone_domain_t> hooks{
+        .before = [&](block_id_t id, zone_domain_t&) {
+            if (wto.nesting_depth(id) == 2) {
+                cancelled = true;
+            }
+        },
+    };
+    try {
+        crab::run_forward_analyzer(cfg, zone_domain_t::setup_entry(false), false, hooks);
+        FAIL("the analysis was not cancelled");
+    } catch (const verification_timeout_t& timeout) {
+        REQUIRE(timeout.loops.size() == 2);
+        REQUIRE(timeout.loop_head == timeout.loops.back().head);
+    }
+    // The flag is about to go out of scope.
+    verification_context_t::current().reset(info, ebpf_verifier_default_options);
+}
+
+// Hidden by default; run with `tests "[benchmark]"`.
+TEST_CASE("nested loops benchmark", "[.][benchmark]") {
+    const program_info info = program_info_of();
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.print_failures = false;
+    std::ostringstream os;
+    for (int depth : {3, 5}) {
+        const InstructionSeq prog = nested_loops(depth);
+        const flat_cfg_t cfg = prepare_cfg(prog, info, !options.no_simplify);
+        REQUIRE(ebpf_verify_program(os, prog, info, &options, nullptr));
+
+        BENCHMARK("wto of " + std::to_string(depth) + " nested loops") { return wto_t(cfg).size(); };
+        BENCHMARK("verify " + std::to_string(depth) + " nested loops") {
+            return ebpf_verify_program(os, prog, info, &options, nullptr);
+        };
+    }
+}
+
+TEST_CASE("Refining an inner loop does not hide the changes in the outer one", "[loop]") {
+    const flat_cfg_t cfg = prepare_cfg(nested_loops(2), program_info_of(), true);
+    const wto_t wto(cfg);
+    std::optional<block_id_t> outer, inner;
+    for (uint32_t index = 0; index < wto.size(); index++) {
+        if (wto[index].is_head) {
+            (wto.nesting_depth(wto[index].vertex) == 0 ? outer : inner) = wto[index].vertex;
+        }
+    }
+    REQUIRE(outer);
+    REQUIRE(inner);
+    const block_id_t inner_body = cfg.next_nodes(*inner).front();
+    REQUIRE(wto.nesting_depth(inner_body) == 2);
+
+    crab::cycle_changes_t changes(cfg);
+    REQUIRE_FALSE(changes.take(*outer));
+
+    // A change on an iteration of the outer loop, then the inner loop refined on that same iteration.
+    changes.mark(*outer);
+    changes.mark(inner_body);
+    REQUIRE(changes.take(*inner));
+    REQUIRE_FALSE(changes.take(*inner));
+    // The outer loop still sees both changes, once.
+    REQUIRE(changes.take(*outer));
+    REQUIRE_FALSE(changes.take(*outer));
+
+    // A change that is only in the outer loop is not one of the inner loop.
+    changes.mark(*outer);
+    REQUIRE_FALSE(changes.take(*inner));
+    REQUIRE(changes.take(*outer));
+
+    // A head is in its own cycle.
+    changes.mark(*inner);
+    REQUIRE(changes.take(*inner));
+    REQUIRE(changes.take(*outer));
+    changes.mark(cfg.exit());
+    REQUIRE_FALSE(changes.take(*inner));
+    REQUIRE_FALSE(changes.take(*outer));
+}
@@ -0,0 +1,60 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Programs built from instructions, as the ELF loader would give them to the verifier.
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "asm_marshal.hpp"
+#include "ebpf_verifier.hpp"
+
+inline program_info program_info_of(const std::string& type = "unspec") {
+    return {.platform = &g_ebpf_platform_linux, .type = g_ebpf_platform_linux.get_program_type(type, "")};
+}
+
+// A program of the given type for the Linux platform. Jump targets are offsets in the marshaled program.
+inline raw_program raw_program_of(const std::vector<Instruction>& instructions, const std::string& type = "unspec") {
+    raw_program raw_prog{.info = program_info_of(type)};
+    for (const Instruction& ins : instructions) {
+        for (const ebpf_inst& inst : marshal(ins, (pc_t)raw_prog.prog.size())) {
+            raw_prog.prog.push_back(inst);
+        }
+    }
+    return raw_prog;
+}
+
+// The instructions as the verifier sees them once raw_program_of them is unmarshaled.
+inline InstructionSeq program_of(const std::vector<Instruction>& instructions) {
+    return std::get<InstructionSeq>(unmarshal(raw_program_of(instructions)));
+}
+
+// Unmarshals and verifies the program. What the verification prints is kept in *report if given.
+inline bool verify_raw_program(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                               ebpf_verifier_stats_t* stats = nullptr, std::string* report = nullptr) {
+    const InstructionSeq prog = std::get<InstructionSeq>(unmarshal(raw_prog));
+    std::ostringstream os;
+    const bool res = ebpf_verify_program(os, prog, raw_prog.info, &options, stats);
+    if (report) {
+        *report = os.str();
+    }
+    return res;
+}
+
+// Counts r1 from 0 up to `bound`, running `body` after each increment, then runs `last` and exits.
+inline InstructionSeq counting_loop(int bound, const std::vector<Instruction>& body, const Instruction& last) {
+    const Reg r0{0}, r1{1};
+    std::vector<Instruction> instructions{
+        Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true},
+        Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{0}, .is64 = true},
+        Bin{.op = Bin::Op::ADD, .dst = r1, .v = Imm{1}, .is64 = true},
+    };
+    instructions.insert(instructions.end(), body.begin(), body.end());
+    instructions.push_back(Jmp{.cond = Condition{.op = Condition::Op::LT, .left = r1, .right = Imm{(uint64_t)bound}},
+                               .target = label_t(2)});
+    instructions.push_back(last);
+    instructions.push_back(Exit{});
+    return program_of(instructions);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "catch.hpp"
+
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+static raw_program section_of(const std::string& section, const std::vector<Instruction>& instructions) {
+    raw_program raw_prog = raw_program_of(instructions);
+    raw_prog.section = section;
+    return raw_prog;
+}
+
+static const Reg r0{0}, r1{1};
+
+static std::vector<raw_program> sections() {
+    raw_program bad_opcode = section_of("bad_opcode", {});
+    bad_opcode.prog.push_back(ebpf_inst{.opcode = 0xff});
+    return {
+        section_of("return_zero", {Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true}, Exit{}}),
+        section_of("uninitialized_return", {Exit{}}),
+        bad_opcode,
+        section_of("loop", {Bin{.op = Bin::Op::MOV, .dst = r1, .v = Imm{0}, .is64 = true},
+                            Bin{.op = Bin::Op::ADD, .dst = r1, .v = Imm{1}, .is64 = true},
+                            Jmp{.cond = Condition{.op = Condition::Op::LT, .left = r1, .right = Imm{100}},
+                                .target = label_t(1)},
+                            Bin{.op = Bin::Op::MOV, .dst = r0, .v = r1, .is64 = true}, Exit{}}),
+    };
+}
+
+TEST_CASE("sections verified concurrently get their results in section order", "[sections]") {
+    const std::vector<raw_program> raw_progs = sections();
+    for (unsigned jobs : {1u, 2u, 4u, 16u}) {
+        const std::vector<section_result_t> results =
+            ebpf_verify_sections(raw_progs, ebpf_verifier_default_options, nullptr, jobs, 0);
+        REQUIRE(results.size() == raw_progs.size());
+        for (size_t n = 0; n < results.size(); n++) {
+            REQUIRE(results[n].section == raw_progs[n].section);
+        }
+        REQUIRE(results[0].pass);
+        REQUIRE(results[0].error.empty());
+        REQUIRE_FALSE(results[1].pass);
+        REQUIRE(results[1].error.empty());
+        REQUIRE_FALSE(results[2].pass);
+        REQUIRE(results[2].error.rfind("unmarshaling error", 0) == 0);
+        REQUIRE(results[3].pass);
+        REQUIRE(results[3].error.empty());
+    }
+}
+
+static ebpf_platform_t throwing_platform(ebpf_is_helper_usable_fn is_helper_usable) {
+    ebpf_platform_t platform = g_ebpf_platform_linux;
+    platform.is_helper_usable = is_helper_usable;
+    return platform;
+}
+
+TEST_CASE("a section whose verification throws gets an error row", "[sections]") {
+    // Worker threads must not let anything escape, whether or not it is a std::runtime_error.
+    static const ebpf_platform_t logic_error_platform =
+        throwing_platform([](int32_t) -> bool { throw std::logic_error("no helpers here"); });
+    static const ebpf_platform_t int_platform = throwing_platform([](int32_t) -> bool { throw 0; });
+    raw_program logic_error = section_of("logic_error", {Call{.func = 1}, Exit{}});
+    logic_error.info.platform = &logic_error_platform;
+    raw_program not_an_exception = section_of("not_an_exception", {Call{.func = 1}, Exit{}});
+    not_an_exception.info.platform = &int_platform;
+    const std::vector<raw_program> raw_progs{logic_error, sections()[0], not_an_exception};
+
+    const std::vector<section_result_t> results =
+        ebpf_verify_sections(raw_progs, ebpf_verifier_default_options, nullptr, 3, 0);
+    REQUIRE_FALSE(results[0].pass);
+    REQUIRE(results[0].error == "no helpers here");
+    REQUIRE(results[1].pass);
+    REQUIRE(results[1].error.empty());
+    REQUIRE_FALSE(results[2].pass);
+    REQUIRE(results[2].error == "unknown exception");
+}
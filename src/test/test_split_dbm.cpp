@@ -0,0 +1,301 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <random>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "crab/packed_split_dbm.hpp"
+#include "crab/split_dbm.hpp"
+
+using namespace crab;
+using crab::domains::PackedSplitDBM;
+using crab::domains::SplitDBM;
+
+static const variable_t x = variable_t::reg(data_kind_t::values, 1);
+static const variable_t y = variable_t::reg(data_kind_t::values, 2);
+
+TEST_CASE("SplitDBM copies are independent", "[split_dbm]") {
+    SplitDBM original;
+    original.set(x, interval_t{number_t{1}, number_t{5}});
+    original += linear_constraint_t(linear_expression_t(y) - x, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+
+    SplitDBM copy(original);
+    REQUIRE(copy <= original);
+    REQUIRE(original <= copy);
+
+    copy.set(x, interval_t{number_t{3}});
+    REQUIRE(original[x] == interval_t(number_t{1}, number_t{5}));
+    REQUIRE(copy[x] == interval_t(number_t{3}));
+    REQUIRE(!(original <= copy));
+
+    SplitDBM other(original);
+    original -= y;
+    REQUIRE(original[y] == interval_t::top());
+    REQUIRE(other[y].ub() == bound_t(number_t{5}));
+    REQUIRE(copy[y].ub() == bound_t(number_t{5}));
+}
+
+TEST_CASE("SplitDBM top and bottom do not share modifications", "[split_dbm]") {
+    SplitDBM a = SplitDBM::top();
+    SplitDBM b = SplitDBM::top();
+    a.set(x, interval_t{number_t{7}});
+    REQUIRE(b.is_top());
+    REQUIRE(SplitDBM::top().is_top());
+
+    SplitDBM c = SplitDBM::bottom();
+    c |= a;
+    c.set(y, interval_t{number_t{0}});
+    REQUIRE(a[y] == interval_t::top());
+    REQUIRE(c[x] == interval_t(number_t{7}));
+}
+
+TEST_CASE("SplitDBM keeps its relations when it outgrows the dense graph", "[split_dbm]") {
+    const int n = static_cast<int>(AdaptGraph::dense_limit) + 10;
+    auto cell = [](int i) { return variable_t::cell_var(data_kind_t::values, 8 * i, 8); };
+    SplitDBM dbm;
+    dbm.set(cell(0), interval_t{number_t{0}, number_t{1}});
+    for (int i = 1; i < n; i++) {
+        dbm += linear_constraint_t(linear_expression_t(cell(i)) - cell(i - 1) - 1, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+        dbm += linear_constraint_t(linear_expression_t(cell(i - 1)) - cell(i) + 1, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+    }
+    REQUIRE(dbm[cell(n - 1)] == interval_t(number_t{n - 1}, number_t{n}));
+    REQUIRE(dbm.entail(linear_constraint_t(linear_expression_t(cell(n - 1)) - cell(0) - (n - 1),
+                                           constraint_kind_t::EQUALS_ZERO)));
+
+    SplitDBM copy(dbm);
+    copy -= cell(n / 2);
+    REQUIRE(copy[cell(n - 1)] == interval_t(number_t{n - 1}, number_t{n}));
+    REQUIRE(copy <= dbm.widen(copy));
+}
+
+TEST_CASE("SplitDBM forgets several variables as it forgets them one by one", "[split_dbm]") {
+    // Both below and above the size where the graph stops being dense.
+    for (const int n : {8, static_cast<int>(AdaptGraph::dense_limit) + 10}) {
+        CAPTURE(n);
+        auto cell = [](int i) { return variable_t::cell_var(data_kind_t::values, 8 * i, 8); };
+        SplitDBM dbm;
+        dbm.set(cell(0), interval_t{number_t{0}, number_t{1}});
+        for (int i = 1; i < n; i++) {
+            dbm += linear_constraint_t(linear_expression_t(cell(i)) - cell(i - 1) - 1, constraint_kind_t::EQUALS_ZERO);
+        }
+        // An unconstrained variable, and a variable that is not in the DBM at all.
+        dbm.set(x, interval_t::top());
+
+        SplitDBM batched(dbm), one_by_one(dbm);
+        std::vector<variable_t> forgotten{x, y};
+        for (int i = 1; i < n; i += 2) {
+            forgotten.push_back(cell(i));
+        }
+        batched.forget(forgotten);
+        for (variable_t v : forgotten) {
+            one_by_one -= v;
+        }
+        REQUIRE(batched <= one_by_one);
+        REQUIRE(one_by_one <= batched);
+        REQUIRE(batched[cell(1)] == interval_t::top());
+        REQUIRE(batched.entail(linear_constraint_t(linear_expression_t(cell(n - 2)) - cell(0) - (n - 2),
+                                                   constraint_kind_t::EQUALS_ZERO)));
+
+        // The freed vertices are reused.
+        batched.assign(cell(1), linear_expression_t(cell(0)) + 1);
+        REQUIRE(batched[cell(1)] == interval_t(number_t{1}, number_t{2}));
+    }
+}
+
+TEST_CASE("SplitDBM adds several constraints as it adds them one by one", "[split_dbm]") {
+    const variable_t z = variable_t::reg(data_kind_t::values, 3);
+    const variable_t w = variable_t::reg(data_kind_t::values, 4);
+    auto leq = [](const linear_expression_t& e) {
+        return linear_constraint_t(e, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+    };
+    SplitDBM base;
+    base.set(w, interval_t{number_t{0}, number_t{100}});
+    // Difference constraints, then one that is translated according to the bounds the first ones set,
+    // then an equality and a disequation.
+    const std::vector<linear_constraint_t> csts{
+        leq(linear_expression_t(x) - 10),
+        leq(linear_expression_t(y) - x - 2),
+        leq(-linear_expression_t(y)),
+        leq(linear_expression_t(x) + y + w - 30),
+        linear_constraint_t(linear_expression_t(z) - y - 1, constraint_kind_t::EQUALS_ZERO),
+        linear_constraint_t(linear_expression_t(y), constraint_kind_t::NOT_ZERO),
+        leq(linear_expression_t(x) - z),
+    };
+
+    SplitDBM batched(base), one_by_one(base);
+    batched.add_constraints(csts);
+    for (const linear_constraint_t& cst : csts) {
+        one_by_one += cst;
+    }
+    REQUIRE(batched <= one_by_one);
+    REQUIRE(one_by_one <= batched);
+    REQUIRE(batched[y] == interval_t(number_t{1}, number_t{12}));
+    REQUIRE(batched[w] == interval_t(number_t{0}, number_t{32}));
+
+    batched.add_constraints({leq(linear_expression_t(z) - y), leq(linear_expression_t(y) - z)});
+    REQUIRE(batched.is_bottom());
+}
+
+// The constraints of each entail those of the other.
+static bool equivalent(const SplitDBM& dbm, const PackedSplitDBM& packed) {
+    SplitDBM flat = packed.to_split_dbm();
+    return dbm <= flat && flat <= dbm;
+}
+
+// Applies the same random operations to a SplitDBM and to a PackedSplitDBM, and checks that they agree.
+class differential_t {
+    std::mt19937 rng;
+    std::vector<variable_t> vars;
+
+    int pick(int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); }
+    variable_t pick_var() { return vars[pick((int)vars.size())]; }
+    number_t pick_number() { return number_t{pick(21) - 10}; }
+
+  public:
+    explicit differential_t(unsigned seed) : rng(seed) {
+        for (int i = 0; i < 6; i++) {
+            vars.push_back(variable_t::reg(data_kind_t::values, i));
+        }
+    }
+
+    void mutate(SplitDBM& dbm, PackedSplitDBM& packed) {
+        variable_t x = pick_var();
+        variable_t y = pick_var();
+        variable_t z = pick_var();
+        number_t k = pick_number();
+        number_t width{pick(5)};
+        int op = pick(9);
+        auto apply = [&](auto& dom) {
+            switch (op) {
+            case 0: dom.set(x, interval_t{k, k + width}); break;
+            case 1: dom.assign(x, linear_expression_t(y) + k); break;
+            case 2: dom.assign(x, linear_expression_t(k)); break;
+            case 3: dom += linear_constraint_t(linear_expression_t(x) - y - k, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO); break;
+            case 4: dom += linear_constraint_t(linear_expression_t(x) - k, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO); break;
+            case 5: dom -= x; break;
+            case 6: dom.apply(arith_binop_t::ADD, x, y, z); break;
+            case 7: dom.forget({x, y}); break;
+            case 8:
+                dom.add_constraints({linear_constraint_t(linear_expression_t(x) - y - k, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO),
+                                     linear_constraint_t(linear_expression_t(y) - z + width, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO),
+                                     linear_constraint_t(linear_expression_t(z) - k - width, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO)});
+                break;
+            }
+        };
+        apply(dbm);
+        apply(packed);
+    }
+
+    void mutate_n(int n, SplitDBM& dbm, PackedSplitDBM& packed) {
+        for (int i = 0; i < n; i++) {
+            mutate(dbm, packed);
+            REQUIRE(equivalent(dbm, packed));
+        }
+    }
+};
+
+TEST_CASE("PackedSplitDBM agrees with SplitDBM", "[split_dbm]") {
+    for (unsigned seed = 0; seed < 300; seed++) {
+        CAPTURE(seed);
+        differential_t gen(seed);
+        SplitDBM base;
+        PackedSplitDBM packed_base;
+        gen.mutate_n(6, base, packed_base);
+
+        SplitDBM a = base, b = base;
+        PackedSplitDBM packed_a = packed_base, packed_b = packed_base;
+        gen.mutate_n(4, a, packed_a);
+        gen.mutate_n(4, b, packed_b);
+
+        REQUIRE((a <= b) == (packed_a <= packed_b));
+        REQUIRE((b <= a) == (packed_b <= packed_a));
+        REQUIRE((packed_a == packed_b) == (a <= b && b <= a));
+        REQUIRE(equivalent(a | b, packed_a | packed_b));
+        REQUIRE(equivalent(a & b, packed_a & packed_b));
+        REQUIRE(equivalent(a.widen(b), packed_a.widen(packed_b)));
+
+        // Keep going from the join, to exercise the packs it produces.
+        SplitDBM joined = a | b;
+        PackedSplitDBM packed_joined = packed_a | packed_b;
+        gen.mutate_n(4, joined, packed_joined);
+        REQUIRE((joined <= a) == (packed_joined <= packed_a));
+        REQUIRE((a <= joined) == (packed_a <= packed_joined));
+        REQUIRE(equivalent(joined | a, packed_joined | packed_a));
+    }
+}
+
+TEST_CASE("PackedSplitDBM lists the variables whose bounds differ", "[split_dbm]") {
+    const variable_t z = variable_t::reg(data_kind_t::values, 3);
+    const variable_t w = variable_t::reg(data_kind_t::values, 4);
+    PackedSplitDBM left;
+    left.set(x, interval_t{number_t{0}, number_t{10}});
+    left.set(y, interval_t{number_t{1}});
+    PackedSplitDBM right(left);
+    auto any = [](variable_t) { return true; };
+    REQUIRE(left.bound_differences(right, any).empty());
+
+    // Set several bounds at once, one of which is a variable that has relations.
+    right.assign(z, linear_expression_t(y) + 1);
+    right.set({{y, interval_t{number_t{2}}}, {w, interval_t{number_t{4}}}, {x, interval_t::top()}});
+    REQUIRE(right[y] == interval_t(number_t{2}));
+    REQUIRE(right[z] == interval_t(number_t{2}));
+    REQUIRE(right[x] == interval_t::top());
+    REQUIRE(right[w] == interval_t(number_t{4}));
+
+    REQUIRE(left.bound_differences(right, any) == std::vector<variable_t>{x, y, z, w});
+    REQUIRE(left.bound_differences(right, [&](variable_t v) { return v == z; }) == std::vector<variable_t>{z});
+}
+
+TEST_CASE("PackedSplitDBM tells equal domains apart from their edges", "[split_dbm]") {
+    const variable_t z = variable_t::reg(data_kind_t::values, 3);
+    // Built in different orders, so that no pack is shared and the variables get different vertices.
+    PackedSplitDBM left;
+    left.set(x, interval_t{number_t{0}, number_t{10}});
+    left.assign(y, linear_expression_t(x) + 1);
+    left.set(z, interval_t{number_t{5}});
+    PackedSplitDBM right;
+    right.set(z, interval_t{number_t{5}});
+    right.set(y, interval_t{number_t{1}, number_t{11}});
+    right += linear_constraint_t(linear_expression_t(y) - x - 1, constraint_kind_t::EQUALS_ZERO);
+    REQUIRE(left == right);
+    REQUIRE(right == left);
+
+    // A constraint that is already implied leaves it equal.
+    PackedSplitDBM implied(right);
+    implied += linear_constraint_t(linear_expression_t(x) - y, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+    REQUIRE(implied == left);
+
+    PackedSplitDBM other(right);
+    other.set(z, interval_t{number_t{6}});
+    REQUIRE_FALSE(left == other);
+    REQUIRE_FALSE(other == left);
+    REQUIRE_FALSE(left == PackedSplitDBM::bottom());
+    REQUIRE(PackedSplitDBM::bottom() == PackedSplitDBM::bottom());
+}
+
+// Hidden by default; run with `tests "[benchmark]"`.
+TEST_CASE("SplitDBM benchmark", "[.][benchmark]") {
+    // A chain of related stack cells, x_i - x_{i-1} <= 1.
+    auto cell = [](int i) { return variable_t::cell_var(data_kind_t::values, 8 * i, 8); };
+    auto chain = [&](int n, int bound) {
+        SplitDBM dbm;
+        for (int i = 0; i < n; i++) {
+            variable_t v = cell(i);
+            dbm.set(v, interval_t{number_t{0}, number_t{bound + i}});
+            if (i > 0) {
+                variable_t prev = cell(i - 1);
+                dbm += linear_constraint_t(linear_expression_t(v) - prev - 1, constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO);
+            }
+        }
+        return dbm;
+    };
+    const SplitDBM a = chain(40, 10);
+    const SplitDBM b = chain(40, 20);
+
+    BENCHMARK("SplitDBM join/leq/widen, 40 related variables") {
+        SplitDBM joined = a | b;
+        bool stable = joined <= b;
+        return std::make_pair(stable, a.widen(joined).size());
+    };
+}
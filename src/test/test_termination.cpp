@@ -6,6 +6,8 @@
 #include "crab_verifier.hpp"
 #include "config.hpp"
 #include "platform.hpp"
+#include "test_programs.hpp"
+#include "verification_context.hpp"
 
 using namespace crab;
 
@@ -28,7 +30,7 @@ TEST_CASE("Trivial infinite loop", "[loop][termination]") {
         .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")
     };
     ebpf_verifier_stats_t stats;
-    bool pass = run_ebpf_analysis(std::cout, cfg, info, &options, &stats);
+    bool pass = run_ebpf_analysis(std::cout, flat_cfg_t(cfg), info, &options, &stats);
     REQUIRE_FALSE(pass);
     REQUIRE(stats.max_instruction_count == INT_MAX);
     REQUIRE(stats.total_unreachable == 0);
@@ -61,9 +63,22 @@ TEST_CASE("Trivial finite loop", "[loop][termination]") {
         .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")
     };
     ebpf_verifier_stats_t stats;
-    bool pass = run_ebpf_analysis(std::cout, cfg, info, &options, &stats);
+    bool pass = run_ebpf_analysis(std::cout, flat_cfg_t(cfg), info, &options, &stats);
     REQUIRE(pass);
     REQUIRE(stats.max_instruction_count == 3);
     REQUIRE(stats.total_unreachable == 1);
     REQUIRE(stats.total_warnings == 0);
 }
+
+TEST_CASE("Termination is checked as the caller of the test analysis asks", "[termination]") {
+    const program_info info = program_info_of();
+    // The options of the context do not check termination; the argument does.
+    verification_context_t::current().reset(info, ebpf_verifier_default_options);
+    const InstructionSeq prog{
+        {label_t(0), Bin{.op = Bin::Op::MOV, .dst = Reg{0}, .v = Imm{0}, .is64 = true}, {}},
+        {label_t(1), Jmp{.cond = {}, .target = label_t(0)}, {}},
+    };
+    std::ostringstream os;
+    ebpf_analyze_program_for_test(os, prog, string_invariant{{"instruction_count=0"}}, info, false, true);
+    REQUIRE(os.str().find("Could not prove termination") != std::string::npos);
+}
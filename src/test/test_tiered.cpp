@@ -0,0 +1,62 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "catch.hpp"
+
+#include "ebpf_verifier.hpp"
+#include "test_programs.hpp"
+
+static const Reg r0{0}, r1{1}, r2{2}, r3{3}, r4{4}, r5{5}, r6{6};
+
+static raw_program return_zero() {
+    return raw_program_of({Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true}, Exit{}});
+}
+
+// Reads a packet byte at a variable offset, after checking that the byte after it is within the packet.
+// The check bounds the offset relative to the packet size, which intervals cannot express.
+static raw_program read_packet_at_variable_offset() {
+    return raw_program_of(
+        {
+            Mem{.access = Deref{.width = 4, .basereg = r1, .offset = 0}, .value = r2, .is_load = true},
+            Mem{.access = Deref{.width = 4, .basereg = r1, .offset = 4}, .value = r3, .is_load = true},
+            Mem{.access = Deref{.width = 4, .basereg = r1, .offset = 12}, .value = r5, .is_load = true},
+            Bin{.op = Bin::Op::AND, .dst = r5, .v = Imm{0xff}, .is64 = true},
+            Bin{.op = Bin::Op::MOV, .dst = r4, .v = r2, .is64 = true},
+            Bin{.op = Bin::Op::ADD, .dst = r4, .v = r5, .is64 = true},
+            Bin{.op = Bin::Op::MOV, .dst = r6, .v = r4, .is64 = true},
+            Bin{.op = Bin::Op::ADD, .dst = r6, .v = Imm{1}, .is64 = true},
+            Jmp{.cond = Condition{.op = Condition::Op::GT, .left = r6, .right = r3}, .target = label_t(10)},
+            Mem{.access = Deref{.width = 1, .basereg = r4, .offset = 0}, .value = r0, .is_load = true},
+            Bin{.op = Bin::Op::MOV, .dst = r0, .v = Imm{0}, .is64 = true},
+            Exit{},
+        },
+        "xdp");
+}
+
+static bool verify(const raw_program& raw_prog, bool tiered, ebpf_verifier_stats_t& stats) {
+    ebpf_verifier_options_t options = ebpf_verifier_default_options;
+    options.tiered = tiered;
+    return verify_raw_program(raw_prog, options, &stats);
+}
+
+TEST_CASE("intervals decide programs that need no relations", "[tiered]") {
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(return_zero(), true, stats));
+    REQUIRE(stats.tier == numeric_domain_t::intervals);
+
+    REQUIRE(verify(return_zero(), false, stats));
+    REQUIRE(stats.tier == numeric_domain_t::zones);
+}
+
+TEST_CASE("zones decide programs that intervals cannot prove safe", "[tiered]") {
+    ebpf_verifier_stats_t stats{};
+    REQUIRE(verify(read_packet_at_variable_offset(), true, stats));
+    REQUIRE(stats.tier == numeric_domain_t::zones);
+    REQUIRE(stats.total_warnings == 0);
+}
+
+TEST_CASE("programs that zones reject are rejected by a tiered verification", "[tiered]") {
+    ebpf_verifier_stats_t stats{};
+    REQUIRE_FALSE(verify(raw_program_of({Exit{}}), true, stats));
+    REQUIRE(stats.tier == numeric_domain_t::zones);
+    REQUIRE(stats.total_warnings > 0);
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "catch.hpp"
+
+#include "crab/type_set.hpp"
+
+using crab::bound_t;
+using crab::interval_t;
+using crab::type_set_t;
+
+TEST_CASE("type sets are read from intervals of type values", "[type_set]") {
+    REQUIRE(type_set_t::of(interval_t::top()) == type_set_t::all());
+    REQUIRE(type_set_t::of(interval_t::bottom()).is_empty());
+    REQUIRE(type_set_t::of(interval_t{number_t{T_NUM}}) == type_set_t::of(T_NUM));
+    REQUIRE(type_set_t::of(interval_t{number_t{T_PACKET}, number_t{T_SHARED}}) == type_set_t::range(T_PACKET, T_SHARED));
+
+    // Values that encode no type are not types.
+    REQUIRE(type_set_t::of(interval_t{bound_t{number_t{T_NUM}}, bound_t::plus_infinity()}) ==
+            type_set_t::range(T_NUM, T_SHARED));
+    REQUIRE(type_set_t::of(interval_t{number_t{1}, number_t{5}}).is_empty());
+}
+
+TEST_CASE("type sets are a lattice of bits", "[type_set]") {
+    const type_set_t pointers = type_set_t::range(T_CTX, T_SHARED);
+    const type_set_t packet_or_num = type_set_t::of(T_PACKET) | type_set_t::of(T_NUM);
+
+    REQUIRE(type_set_t::of(T_STACK) <= pointers);
+    REQUIRE_FALSE(packet_or_num <= pointers);
+    REQUIRE(type_set_t{} <= type_set_t::of(T_NUM));
+    REQUIRE((packet_or_num & pointers) == type_set_t::of(T_PACKET));
+    REQUIRE(packet_or_num - pointers == type_set_t::of(T_NUM));
+    REQUIRE(packet_or_num.contains(T_NUM));
+    REQUIRE_FALSE(packet_or_num.contains(T_CTX));
+
+    REQUIRE(type_set_t::of(T_MAP).singleton() == T_MAP);
+    REQUIRE_FALSE(packet_or_num.singleton());
+    REQUIRE_FALSE(type_set_t{}.singleton());
+
+    std::vector<type_encoding_t> types;
+    packet_or_num.for_each([&](type_encoding_t type) { types.push_back(type); });
+    REQUIRE(types == std::vector<type_encoding_t>{T_NUM, T_PACKET});
+}
@@ -511,7 +511,7 @@ TEST_SECTION_FAIL("cilium", "bpf_xdp_snat_linux.o", "2/24")
 // False positive, unknown cause
 TEST_SECTION_FAIL("linux", "test_map_in_map_kern.o", "kprobe/sys_connect")
 
-void test_analyze_thread(cfg_t* cfg, program_info* info, bool* res) {
+void test_analyze_thread(const flat_cfg_t* cfg, program_info* info, bool* res) {
     *res = run_ebpf_analysis(std::cout, *cfg, *info, nullptr, nullptr);
 }
 
@@ -523,7 +523,7 @@ TEST_CASE("multithreading", "[verify][multithreading]") {
     std::variant<InstructionSeq, std::string> prog_or_error1 = unmarshal(raw_prog1);
     REQUIRE(std::holds_alternative<InstructionSeq>(prog_or_error1));
     auto& prog1 = std::get<InstructionSeq>(prog_or_error1);
-    cfg_t cfg1 = prepare_cfg(prog1, raw_prog1.info, true);
+    flat_cfg_t cfg1 = prepare_cfg(prog1, raw_prog1.info, true);
 
     auto raw_progs2 = read_elf("ebpf-samples/bpf_cilium_test/bpf_netdev.o", "2/2", nullptr, &g_ebpf_platform_linux);
     REQUIRE(raw_progs2.size() == 1);
@@ -531,7 +531,7 @@ TEST_CASE("multithreading", "[verify][multithreading]") {
     std::variant<InstructionSeq, std::string> prog_or_error2 = unmarshal(raw_prog2);
     REQUIRE(std::holds_alternative<InstructionSeq>(prog_or_error2));
     auto& prog2 = std::get<InstructionSeq>(prog_or_error2);
-    cfg_t cfg2 = prepare_cfg(prog2, raw_prog2.info, true);
+    flat_cfg_t cfg2 = prepare_cfg(prog2, raw_prog2.info, true);
 
     bool res1, res2;
     std::thread a(test_analyze_thread, &cfg1, &raw_prog1.info, &res1);
@@ -29,11 +29,27 @@ TEST_CASE("wto figure 1", "[wto]") {
     cfg.get_node(label_t(7)) >> cfg.get_node(label_t(8));
     cfg.get_node(label_t(8)) >> cfg.get_node(label_t::exit);
 
-    wto_t wto(cfg);
+    flat_cfg_t flat_cfg(cfg);
+    wto_t wto(flat_cfg);
 
     std::ostringstream os;
     os << wto;
     REQUIRE(os.str() == "entry 1 2 ( 3 4 ( 5 6 ) 7 ) 8 exit \n");
+
+    auto id = [&](int label) { return flat_cfg.id(label_t(label)); };
+    REQUIRE(wto.nesting_depth(id(2)) == 0);
+    REQUIRE(wto.nesting_depth(id(3)) == 0);
+    REQUIRE(wto.nesting_depth(id(5)) == 1);
+    REQUIRE(wto.nesting_depth(id(6)) == 2);
+    REQUIRE(wto.head(id(6)) == id(5));
+    REQUIRE(wto.head(id(5)) == id(3));
+    REQUIRE_FALSE(wto.head(id(3)).has_value());
+
+    // The predecessors of a head that are inside its cycle are exactly those nested deeper.
+    REQUIRE(wto.is_nested_deeper(id(7), id(3)));
+    REQUIRE_FALSE(wto.is_nested_deeper(id(2), id(3)));
+    REQUIRE(wto.is_nested_deeper(id(6), id(5)));
+    REQUIRE_FALSE(wto.is_nested_deeper(id(4), id(5)));
 }
 
 TEST_CASE("wto figure 2a", "[wto]") {
@@ -57,7 +73,8 @@ TEST_CASE("wto figure 2a", "[wto]") {
     cfg.get_node(label_t(4)) >> cfg.get_node(label_t(5));
     cfg.get_node(label_t(5)) >> cfg.get_node(label_t(4));
 
-    wto_t wto(cfg);
+    flat_cfg_t flat_cfg(cfg);
+    wto_t wto(flat_cfg);
 
     std::ostringstream os;
     os << wto;
@@ -84,9 +101,63 @@ TEST_CASE("wto figure 2b", "[wto]") {
     cfg.get_node(label_t(3)) >> cfg.get_node(label_t::exit);
     cfg.get_node(label_t(4)) >> cfg.get_node(label_t(3));
 
-    wto_t wto(cfg);
+    flat_cfg_t flat_cfg(cfg);
+    wto_t wto(flat_cfg);
 
     std::ostringstream os;
     os << wto;
     REQUIRE(os.str() == "entry ( 1 4 2 3 ) exit \n");
 }
+
+TEST_CASE("flat cfg numbers blocks in label order", "[cfg]") {
+    cfg_t cfg;
+    for (int i = 1; i <= 3; i++) {
+        cfg.insert(label_t(i));
+    }
+    cfg.get_node(label_t::entry) >> cfg.get_node(label_t(1));
+    cfg.get_node(label_t(1)) >> cfg.get_node(label_t(3));
+    cfg.get_node(label_t(1)) >> cfg.get_node(label_t(2));
+    cfg.get_node(label_t(2)) >> cfg.get_node(label_t(3));
+    cfg.get_node(label_t(3)) >> cfg.get_node(label_t(1));
+    cfg.get_node(label_t(3)) >> cfg.get_node(label_t::exit);
+
+    flat_cfg_t flat_cfg(cfg);
+    REQUIRE(flat_cfg.size() == 5);
+    REQUIRE(flat_cfg.label(flat_cfg.entry()) == label_t::entry);
+    REQUIRE(flat_cfg.label(flat_cfg.exit()) == label_t::exit);
+    for (block_id_t id = 0; id < flat_cfg.size(); id++) {
+        REQUIRE(flat_cfg.id(flat_cfg.label(id)) == id);
+    }
+
+    const block_id_t one = flat_cfg.id(label_t(1));
+    const block_id_t two = flat_cfg.id(label_t(2));
+    const block_id_t three = flat_cfg.id(label_t(3));
+    REQUIRE(std::vector<block_id_t>(flat_cfg.next_nodes(one).begin(), flat_cfg.next_nodes(one).end()) ==
+            std::vector<block_id_t>{two, three});
+    REQUIRE(std::vector<block_id_t>(flat_cfg.prev_nodes(three).begin(), flat_cfg.prev_nodes(three).end()) ==
+            std::vector<block_id_t>{one, two});
+    REQUIRE(flat_cfg.in_degree(one) == 2);
+    REQUIRE(flat_cfg.out_degree(three) == 2);
+    REQUIRE(flat_cfg.in_degree(flat_cfg.entry()) == 0);
+    REQUIRE(flat_cfg.out_degree(flat_cfg.exit()) == 0);
+}
+
+TEST_CASE("cfg statistics count the branches of jumps apart from joins", "[cfg]") {
+    cfg_t cfg;
+    for (int i = 1; i <= 4; i++) {
+        cfg.insert(label_t(i));
+    }
+    cfg.get_node(label_t(2)).insert(Assume{{.op = Condition::Op::EQ, .left = Reg{1}, .right = Imm{0}}});
+    cfg.get_node(label_t(3)).insert(Assume{{.op = Condition::Op::NE, .left = Reg{1}, .right = Imm{0}}});
+    cfg.get_node(label_t::entry) >> cfg.get_node(label_t(1));
+    cfg.get_node(label_t(1)) >> cfg.get_node(label_t(2));
+    cfg.get_node(label_t(1)) >> cfg.get_node(label_t(3));
+    cfg.get_node(label_t(2)) >> cfg.get_node(label_t(4));
+    cfg.get_node(label_t(3)) >> cfg.get_node(label_t(4));
+    cfg.get_node(label_t(4)) >> cfg.get_node(label_t::exit);
+
+    const std::map<std::string, int> stats = collect_stats(flat_cfg_t(cfg));
+    REQUIRE(stats.at("basic_blocks") == 6);
+    REQUIRE(stats.at("jumps") == 2);
+    REQUIRE(stats.at("joins") == 1);
+}
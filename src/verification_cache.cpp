@@ -0,0 +1,176 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+#include "crab_utils/sha256.hpp"
+#include "crab_verifier.hpp"
+#include "platform.hpp"
+#include "verification_cache.hpp"
+
+// Bump this whenever a change to the verifier or to the format of the entries may change what is stored for some
+// program, so that entries written by older versions are no longer found.
+constexpr int cache_format_version = 2;
+
+static const char* const cache_magic = "prevail-verification-cache";
+
+verification_cache_t::verification_cache_t(std::filesystem::path directory) : _directory(std::move(directory)) {
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+}
+
+std::string verification_cache_t::setup_key(const program_info& info, const ebpf_verifier_options_t& options) {
+    crab::sha256_t sha;
+    // Platforms that do not name themselves all share one name.
+    sha.update_string(info.platform && info.platform->name ? info.platform->name : "");
+    sha.update_value(info.map_descriptors.size());
+    for (const EbpfMapDescriptor& map : info.map_descriptors) {
+        sha.update_value(map.original_fd);
+        sha.update_value(map.type);
+        sha.update_value(map.key_size);
+        sha.update_value(map.value_size);
+        sha.update_value(map.max_entries);
+        sha.update_value(map.inner_map_fd);
+    }
+
+    const EbpfProgramType& type = info.type;
+    sha.update_string(type.name);
+    sha.update_value(type.platform_specific_data);
+    sha.update_value(type.is_privileged);
+    const bool has_context = type.context_descriptor != nullptr;
+    sha.update_value(has_context);
+    if (has_context) {
+        sha.update_value(type.context_descriptor->size);
+        sha.update_value(type.context_descriptor->data);
+        sha.update_value(type.context_descriptor->end);
+        sha.update_value(type.context_descriptor->meta);
+    }
+
+    // The other options only choose what is printed, and the report of failures is always stored.
+    sha.update_value(options.check_termination);
+    sha.update_value(options.assume_assertions);
+    sha.update_value(options.no_simplify);
+    sha.update_value(options.mock_map_fds);
+    sha.update_value(options.strict);
+    sha.update_value(options.print_line_info);
+    sha.update_value(options.numeric_domain);
+    sha.update_value(options.tiered);
+    sha.update_value(options.widening_delay);
+    sha.update_value(options.descending_iterations);
+    sha.update_value(options.adaptive_narrowing);
+    return sha.hex_digest();
+}
+
+std::string verification_cache_t::key(const raw_program& raw_prog, const ebpf_verifier_options_t& options) {
+    crab::sha256_t sha;
+    sha.update_string(cache_magic);
+    sha.update_value(cache_format_version);
+    sha.update_string(setup_key(raw_prog.info, options));
+
+    sha.update_value(raw_prog.prog.size());
+    sha.update(raw_prog.prog.data(), raw_prog.prog.size() * sizeof(ebpf_inst));
+
+    if (options.print_line_info) {
+        for (const btf_line_info_t& line : raw_prog.line_info) {
+            sha.update_string(line.file_name);
+            sha.update_string(line.source_line);
+            sha.update_value(line.line_number);
+            sha.update_value(line.column_number);
+        }
+    }
+    return sha.hex_digest();
+}
+
+std::optional<verification_cache_entry_t> verification_cache_t::lookup(const std::string& key) const {
+    std::ifstream in(_directory / key, std::ios::binary);
+    if (!in) {
+        return {};
+    }
+    std::string magic;
+    int version{};
+    int tier{};
+    verification_cache_entry_t entry;
+    in >> magic >> version >> entry.pass >> entry.total_unreachable >> entry.total_warnings >>
+        entry.max_instruction_count >> tier;
+    if (!in || magic != cache_magic || version != cache_format_version || in.get() != '\n' ||
+        (tier != (int)numeric_domain_t::zones && tier != (int)numeric_domain_t::intervals)) {
+        return {};
+    }
+    entry.tier = (numeric_domain_t)tier;
+    entry.report.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return entry;
+}
+
+void verification_cache_t::store(const std::string& key, const verification_cache_entry_t& entry) const {
+    const std::filesystem::path path = _directory / key;
+    std::filesystem::path tmp = path;
+    tmp += ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out << cache_magic << " " << cache_format_version << "\n"
+            << entry.pass << " " << entry.total_unreachable << " " << entry.total_warnings << " "
+            << entry.max_instruction_count << " " << (int)entry.tier << "\n"
+            << entry.report;
+        if (!out.flush()) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    // The cache is only an optimization, so failing to fill it is not an error.
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+    }
+}
+
+bool ebpf_verify_program(std::ostream& os, const raw_program& raw_prog, const InstructionSeq& prog,
+                         const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats,
+                         const verification_cache_t& cache) {
+    if (options == nullptr)
+        options = &ebpf_verifier_default_options;
+    if (options->print_invariants) {
+        return ebpf_verify_program(os, prog, raw_prog.info, options, stats);
+    }
+
+    const std::string key = verification_cache_t::key(raw_prog, *options);
+    std::optional<verification_cache_entry_t> entry = cache.lookup(key);
+    ebpf_verifier_stats_t verifier_stats{};
+    if (!entry) {
+        ebpf_verifier_options_t report_options = *options;
+        report_options.print_failures = true;
+        std::ostringstream report;
+        const bool pass = ebpf_verify_program(report, prog, raw_prog.info, &report_options, &verifier_stats);
+        entry = verification_cache_entry_t{
+            .pass = pass,
+            .total_unreachable = verifier_stats.total_unreachable,
+            .total_warnings = verifier_stats.total_warnings,
+            .max_instruction_count = verifier_stats.max_instruction_count,
+            .tier = verifier_stats.tier,
+            .report = report.str(),
+        };
+        // A verification that timed out did not decide anything, and another attempt may have more time.
+        if (!verifier_stats.timed_out) {
+            cache.store(key, *entry);
+        }
+    } else {
+        verifier_stats = ebpf_verifier_stats_t{
+            .total_unreachable = entry->total_unreachable,
+            .total_warnings = entry->total_warnings,
+            .max_instruction_count = entry->max_instruction_count,
+            .tier = entry->tier,
+        };
+    }
+
+    if (options->print_failures) {
+        os << entry->report;
+    }
+    if (stats) {
+        *stats = verifier_stats;
+    }
+    return entry->pass;
+}
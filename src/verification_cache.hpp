@@ -0,0 +1,56 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "asm_syntax.hpp"
+#include "config.hpp"
+#include "spec_type_descriptors.hpp"
+
+// Result of a verification, as stored in the cache.
+struct verification_cache_entry_t {
+    bool pass{};
+    int total_unreachable{};
+    int total_warnings{};
+    int max_instruction_count{};
+    numeric_domain_t tier{};
+    // The report of failures, as printed with print_failures.
+    std::string report;
+};
+
+// On-disk cache of verification results, so that a program that is verified again,
+// on the same platform, with the same maps, program type and options, gets its result without being analyzed.
+//
+// Each result is one small file in the cache directory, named after its key. Files are written
+// to a temporary name and renamed into place, so that processes sharing the directory
+// never see a partial entry, and a missing or unreadable entry is a miss.
+// The key is a SHA-256 digest of everything that the verdict depends on, and of a format version
+// that must be bumped whenever a change to the verifier may change the verdict of some program.
+class verification_cache_t final {
+    std::filesystem::path _directory;
+
+  public:
+    explicit verification_cache_t(std::filesystem::path directory);
+
+    // Key of a program verified with some options: the raw instructions, the platform, the map descriptors,
+    // the program type, and the options that affect the verdict or the report.
+    static std::string key(const raw_program& raw_prog, const ebpf_verifier_options_t& options);
+
+    // Digest of what the verdict depends on besides the instructions: the platform, the map descriptors,
+    // the program type, and the options that affect the verdict or the report.
+    static std::string setup_key(const program_info& info, const ebpf_verifier_options_t& options);
+
+    [[nodiscard]] std::optional<verification_cache_entry_t> lookup(const std::string& key) const;
+    void store(const std::string& key, const verification_cache_entry_t& entry) const;
+};
+
+// Same as ebpf_verify_program, but return the cached result if the program was already verified
+// with the same options, and store the result otherwise. The cache is not used when printing invariants,
+// which are not stored, and the scratch arena statistics are zero for a cached result.
+bool ebpf_verify_program(std::ostream& os, const raw_program& raw_prog, const InstructionSeq& prog,
+                         const ebpf_verifier_options_t* options, ebpf_verifier_stats_t* stats,
+                         const verification_cache_t& cache);
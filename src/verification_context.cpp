@@ -0,0 +1,37 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include "crab/array_domain.hpp"
+#include "crab/variable.hpp"
+#include "crab_utils/arena.hpp"
+#include "verification_context.hpp"
+
+static thread_local verification_context_t* bound_context = nullptr;
+
+verification_context_t::verification_context_t()
+    : variables(crab::make_variable_table()), array_map(crab::domains::make_array_map()),
+      arena(std::make_shared<crab::arena_t>()) {}
+
+void verification_context_t::reset(program_info new_info, const ebpf_verifier_options_t& new_options) {
+    info = std::move(new_info);
+    options = new_options;
+    crab::clear_variable_table(*variables);
+    crab::domains::clear_array_map(*array_map);
+    arena->reset();
+    arena->clear_stats();
+}
+
+verification_context_t& verification_context_t::current() {
+    if (bound_context != nullptr) {
+        return *bound_context;
+    }
+    static thread_local verification_context_t thread_context;
+    return thread_context;
+}
+
+crab::arena_t& crab::scratch_arena() { return *verification_context_t::current().arena; }
+
+verification_context_t::scope_t::scope_t(verification_context_t& context) : previous(bound_context) {
+    bound_context = &context;
+}
+
+verification_context_t::scope_t::~scope_t() { bound_context = previous; }
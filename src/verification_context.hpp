@@ -0,0 +1,74 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "config.hpp"
+#include "spec_type_descriptors.hpp"
+
+namespace crab {
+class arena_t;
+struct variable_table_t;
+namespace domains {
+struct array_map_t;
+}
+} // namespace crab
+
+// Thrown out of the analysis when the deadline of the verification passes, or when it is cancelled.
+// It is not a std::runtime_error, so that it is not mistaken for a failure of the program.
+class verification_timeout_t final : public std::exception {
+  public:
+    std::string loop_head; // The innermost loop being analyzed, if any.
+    std::vector<loop_stats_t> loops; // The iterations of the loops analyzed until then.
+
+    [[nodiscard]] const char* what() const noexcept override { return "verification timed out"; }
+};
+
+// State of one verification: the program being verified, the options it is verified with,
+// the tables of variables and array cells that its invariants refer to,
+// and the arena that the domain operations take their temporaries from.
+//
+// The analysis reaches the context through verification_context_t::current(), which is the context
+// bound to the calling thread by a scope_t, or a per-thread default context if none is bound.
+// A context is not tied to a thread: many contexts can be kept warm and bound in turn to whichever
+// worker thread (or coroutine) runs the next verification, as long as one context is used by one thread at a time.
+class verification_context_t final {
+  public:
+    program_info info;
+    ebpf_verifier_options_t options{};
+    std::shared_ptr<crab::variable_table_t> variables;
+    std::shared_ptr<crab::domains::array_map_t> array_map;
+    std::shared_ptr<crab::arena_t> arena;
+
+    verification_context_t();
+
+    // Start a new verification: forget the variables and cells of the previous one,
+    // keeping the fixed register ids and the allocated capacity of the tables and of the arena.
+    void reset(program_info new_info, const ebpf_verifier_options_t& new_options);
+
+    static verification_context_t& current();
+
+    // Throw a verification_timeout_t if the deadline of the verification has passed or it was cancelled.
+    void check_deadline() const {
+        if ((options.cancelled && options.cancelled->load(std::memory_order_relaxed)) ||
+            (options.deadline && std::chrono::steady_clock::now() >= *options.deadline)) {
+            throw verification_timeout_t{};
+        }
+    }
+
+    // Binds a context to the calling thread for the lifetime of the scope. Scopes can be nested.
+    class scope_t final {
+        verification_context_t* previous;
+
+      public:
+        explicit scope_t(verification_context_t& context);
+        ~scope_t();
+        scope_t(const scope_t&) = delete;
+        scope_t& operator=(const scope_t&) = delete;
+    };
+};